@@ -70,6 +70,8 @@
 #define DEFAULT_URL                    "localhost:5555"
 #define DEFAULT_TIMEOUT                30
 #define DEFAULT_QOS_DSCP               0
+#define DEFAULT_MAX_QUEUE_BYTES        0
+#define DEFAULT_LEAKY                  GST_CURL_BASE_SINK_LEAKY_NO
 
 #define DSCP_MIN                       0
 #define DSCP_MAX                       63
@@ -91,9 +93,41 @@ enum
   PROP_USER_PASSWD,
   PROP_FILE_NAME,
   PROP_TIMEOUT,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_MAX_QUEUE_BYTES,
+  PROP_LEAKY,
+  PROP_STATS
 };
 
+/* An entry of the queue between render and the transfer thread. Either a
+ * buffer to send or, with @buffer NULL, the file name to switch to once
+ * everything queued before it has been sent */
+typedef struct
+{
+  GstBuffer *buffer;
+  gchar *file_name;
+} GstCurlBaseSinkQueueItem;
+
+#define GST_TYPE_CURL_BASE_SINK_LEAKY (gst_curl_base_sink_leaky_get_type ())
+static GType
+gst_curl_base_sink_leaky_get_type (void)
+{
+  static GType leaky_type = 0;
+  static const GEnumValue leaky[] = {
+    {GST_CURL_BASE_SINK_LEAKY_NO, "Not Leaky", "no"},
+    {GST_CURL_BASE_SINK_LEAKY_UPSTREAM, "Leaky on upstream (new buffers)",
+        "upstream"},
+    {GST_CURL_BASE_SINK_LEAKY_DOWNSTREAM, "Leaky on downstream (old buffers)",
+        "downstream"},
+    {0, NULL, NULL},
+  };
+
+  if (!leaky_type) {
+    leaky_type = g_enum_register_static ("GstCurlBaseSinkLeaky", leaky);
+  }
+  return leaky_type;
+}
+
 /* Object class function declarations */
 static void gst_curl_base_sink_finalize (GObject * gobject);
 static void gst_curl_base_sink_set_property (GObject * object, guint prop_id,
@@ -138,8 +172,15 @@ static gboolean gst_curl_base_sink_wait_for_data_unlocked
     (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_new_file_notify_unlocked
     (GstCurlBaseSink * sink);
-static void gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
-    (GstCurlBaseSink * sink);
+static GstFlowReturn gst_curl_base_sink_queue_buffer_unlocked
+    (GstCurlBaseSink * sink, GstBuffer * buf);
+static void gst_curl_base_sink_queue_pop_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_queue_flush_unlocked (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_release_buffer_unlocked (GstCurlBaseSink *
+    sink);
+static GstStructure *gst_curl_base_sink_create_stats (GstCurlBaseSink * sink);
+static void gst_curl_base_sink_update_stats_unlocked (GstCurlBaseSink * sink,
+    size_t bytes_sent);
 static void gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_wait_for_response (GstCurlBaseSink * sink);
 static void gst_curl_base_sink_got_response_notify (GstCurlBaseSink * sink);
@@ -154,7 +195,7 @@ G_DEFINE_TYPE (GstCurlBaseSink, gst_curl_base_sink, GST_TYPE_BASE_SINK);
 static gboolean
 gst_curl_base_sink_default_has_buffered_data_unlocked (GstCurlBaseSink * sink)
 {
-  return sink->transfer_buf->len > 0;
+  return sink->transfer_buf->len > 0 || sink->queued_bytes > 0;
 }
 
 static gboolean
@@ -234,6 +275,22 @@ gst_curl_base_sink_class_init (GstCurlBaseSinkClass * klass)
           "Quality of Service, differentiated services code point (0 default)",
           DSCP_MIN, DSCP_MAX, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint ("max-queue-bytes", "Max. queue bytes",
+          "Number of bytes that can be queued for the transfer thread "
+          "(0 = wait until each buffer has been sent)",
+          0, G_MAXUINT, DEFAULT_MAX_QUEUE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_LEAKY,
+      g_param_spec_enum ("leaky", "Leaky",
+          "Where the queue leaks, if at all, when max-queue-bytes is reached",
+          GST_TYPE_CURL_BASE_SINK_LEAKY, DEFAULT_LEAKY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Upload statistics (bytes and buffers sent, buffers dropped, "
+          "queue level and average bitrate)", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (element_class, &sinktemplate);
 }
@@ -255,6 +312,9 @@ gst_curl_base_sink_init (GstCurlBaseSink * sink)
   sink->error = NULL;
   sink->flow_ret = GST_FLOW_OK;
   sink->is_live = FALSE;
+  g_queue_init (&sink->queue);
+  sink->max_queue_bytes = DEFAULT_MAX_QUEUE_BYTES;
+  sink->leaky = DEFAULT_LEAKY;
 }
 
 static void
@@ -268,6 +328,8 @@ gst_curl_base_sink_finalize (GObject * gobject)
   }
 
   gst_curl_base_sink_transfer_cleanup (this);
+  gst_curl_base_sink_queue_flush_unlocked (this);
+  gst_curl_base_sink_release_buffer_unlocked (this);
   g_cond_clear (&this->transfer_cond->cond);
   g_free (this->transfer_cond);
   g_free (this->transfer_buf);
@@ -334,13 +396,202 @@ gst_curl_base_sink_is_live (GstCurlBaseSink * sink)
   return result;
 }
 
+static void
+gst_curl_base_sink_queue_item_free (GstCurlBaseSinkQueueItem * item)
+{
+  if (item->buffer != NULL) {
+    gst_buffer_unref (item->buffer);
+  }
+  g_free (item->file_name);
+  g_slice_free (GstCurlBaseSinkQueueItem, item);
+}
+
+/* Drops the oldest queued buffer, file name changes stay in the queue */
+static gboolean
+gst_curl_base_sink_queue_drop_oldest_unlocked (GstCurlBaseSink * sink)
+{
+  GList *l;
+
+  for (l = sink->queue.head; l != NULL; l = l->next) {
+    GstCurlBaseSinkQueueItem *item = l->data;
+
+    if (item->buffer != NULL) {
+      GST_DEBUG_OBJECT (sink, "queue full, dropping oldest buffer");
+      sink->queued_bytes -= gst_buffer_get_size (item->buffer);
+      sink->buffers_dropped++;
+      g_queue_delete_link (&sink->queue, l);
+      gst_curl_base_sink_queue_item_free (item);
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+static GstFlowReturn
+gst_curl_base_sink_queue_buffer_unlocked (GstCurlBaseSink * sink,
+    GstBuffer * buf)
+{
+  GstCurlBaseSinkQueueItem *item;
+  gsize size = gst_buffer_get_size (buf);
+
+  /* an empty queue always accepts a buffer, so that buffers bigger than
+   * max-queue-bytes still get through */
+  while (sink->max_queue_bytes > 0 && sink->queued_bytes > 0 &&
+      (guint64) sink->queued_bytes + size > sink->max_queue_bytes) {
+    if (sink->leaky == GST_CURL_BASE_SINK_LEAKY_UPSTREAM) {
+      GST_DEBUG_OBJECT (sink, "queue full, dropping new buffer");
+      sink->buffers_dropped++;
+      return GST_FLOW_OK;
+    }
+
+    if (sink->leaky == GST_CURL_BASE_SINK_LEAKY_DOWNSTREAM &&
+        gst_curl_base_sink_queue_drop_oldest_unlocked (sink)) {
+      continue;
+    }
+
+    if (sink->flushing) {
+      return GST_FLOW_FLUSHING;
+    }
+    if (sink->flow_ret != GST_FLOW_OK) {
+      return sink->flow_ret;
+    }
+
+    GST_LOG ("queue full (%u bytes), waiting", sink->queued_bytes);
+    g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
+  }
+
+  item = g_slice_new0 (GstCurlBaseSinkQueueItem);
+  item->buffer = gst_buffer_ref (buf);
+  g_queue_push_tail (&sink->queue, item);
+  sink->queued_bytes += size;
+
+  GST_LOG ("queued %" G_GSIZE_FORMAT " bytes, %u bytes in queue", size,
+      sink->queued_bytes);
+
+  sink->transfer_cond->wait_for_response = TRUE;
+  g_cond_broadcast (&sink->transfer_cond->cond);
+
+  return GST_FLOW_OK;
+}
+
+/* Called by the transfer thread to take the next entry of the queue */
+static void
+gst_curl_base_sink_queue_pop_unlocked (GstCurlBaseSink * sink)
+{
+  GstCurlBaseSinkQueueItem *item = g_queue_pop_head (&sink->queue);
+
+  if (item->buffer != NULL) {
+    sink->queued_bytes -= gst_buffer_get_size (item->buffer);
+
+    g_assert (sink->transfer_buffer == NULL);
+    if (gst_buffer_map (item->buffer, &sink->transfer_map, GST_MAP_READ)) {
+      sink->transfer_buffer = gst_buffer_ref (item->buffer);
+      sink->transfer_buf->ptr = sink->transfer_map.data;
+      sink->transfer_buf->len = sink->transfer_map.size;
+      sink->transfer_buf->offset = 0;
+      gst_curl_base_sink_transfer_thread_notify_unlocked (sink);
+    } else {
+      GST_WARNING_OBJECT (sink, "failed to map buffer, dropping it");
+      sink->buffers_dropped++;
+    }
+  } else {
+    g_free (sink->file_name);
+    sink->file_name = g_strdup (item->file_name);
+    GST_DEBUG_OBJECT (sink, "file_name set to %s", sink->file_name);
+    gst_curl_base_sink_new_file_notify_unlocked (sink);
+  }
+
+  gst_curl_base_sink_queue_item_free (item);
+
+  /* there is room in the queue again */
+  g_cond_broadcast (&sink->transfer_cond->cond);
+}
+
+static void
+gst_curl_base_sink_release_buffer_unlocked (GstCurlBaseSink * sink)
+{
+  if (sink->transfer_buffer != NULL) {
+    gst_buffer_unmap (sink->transfer_buffer, &sink->transfer_map);
+    gst_buffer_unref (sink->transfer_buffer);
+    sink->transfer_buffer = NULL;
+  }
+
+  sink->transfer_buf->ptr = NULL;
+  sink->transfer_buf->len = 0;
+  sink->transfer_buf->offset = 0;
+}
+
+/* Discards all queued buffers. The buffer the transfer thread is sending
+ * is left alone, the read callback accesses it without holding the lock.
+ * Queued file name changes are applied right away so they don't get lost. */
+static void
+gst_curl_base_sink_queue_flush_unlocked (GstCurlBaseSink * sink)
+{
+  GstCurlBaseSinkQueueItem *item;
+
+  while ((item = g_queue_pop_head (&sink->queue)) != NULL) {
+    if (item->file_name != NULL) {
+      g_free (sink->file_name);
+      sink->file_name = item->file_name;
+      item->file_name = NULL;
+      GST_DEBUG_OBJECT (sink, "file_name set to %s", sink->file_name);
+      gst_curl_base_sink_new_file_notify_unlocked (sink);
+    }
+    gst_curl_base_sink_queue_item_free (item);
+  }
+  sink->queued_bytes = 0;
+
+  /* wake up a render waiting for room in the queue */
+  g_cond_broadcast (&sink->transfer_cond->cond);
+}
+
+static void
+gst_curl_base_sink_update_stats_unlocked (GstCurlBaseSink * sink,
+    size_t bytes_sent)
+{
+  gint64 now;
+
+  if (bytes_sent == 0 || bytes_sent == CURL_READFUNC_ABORT ||
+      bytes_sent == CURL_READFUNC_PAUSE) {
+    return;
+  }
+
+  now = g_get_monotonic_time ();
+  if (sink->bytes_sent == 0) {
+    sink->first_send_time = now;
+  }
+  sink->last_send_time = now;
+  sink->bytes_sent += bytes_sent;
+}
+
+static GstStructure *
+gst_curl_base_sink_create_stats (GstCurlBaseSink * sink)
+{
+  GstStructure *s;
+  guint64 bitrate = 0;
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->last_send_time > sink->first_send_time) {
+    bitrate = gst_util_uint64_scale (sink->bytes_sent * 8, G_USEC_PER_SEC,
+        sink->last_send_time - sink->first_send_time);
+  }
+
+  s = gst_structure_new ("application/x-curl-base-sink-stats",
+      "bytes-sent", G_TYPE_UINT64, sink->bytes_sent,
+      "buffers-sent", G_TYPE_UINT64, sink->buffers_sent,
+      "buffers-dropped", G_TYPE_UINT64, sink->buffers_dropped,
+      "queued-bytes", G_TYPE_UINT, sink->queued_bytes,
+      "bitrate", G_TYPE_UINT64, bitrate, NULL);
+  GST_OBJECT_UNLOCK (sink);
+
+  return s;
+}
+
 static GstFlowReturn
 gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
   GstCurlBaseSink *sink;
-  GstMapInfo map;
-  guint8 *data;
-  size_t size;
   GstFlowReturn ret;
   gchar *error;
 
@@ -348,12 +599,7 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   sink = GST_CURL_BASE_SINK (bsink);
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
-  data = map.data;
-  size = map.size;
-
-  if (size == 0) {
-    gst_buffer_unmap (buf, &map);
+  if (gst_buffer_get_size (buf) == 0) {
     return GST_FLOW_OK;
   }
 
@@ -362,37 +608,39 @@ gst_curl_base_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   /* check if the transfer thread has encountered problems while the
    * pipeline thread was working elsewhere */
   if (sink->flow_ret != GST_FLOW_OK) {
+    ret = sink->flow_ret;
     goto done;
   }
 
-  g_assert (sink->transfer_cond->data_available == FALSE);
-
   /* if there is no transfer thread created, lets create one */
   if (sink->transfer_thread == NULL) {
     if (!gst_curl_base_sink_transfer_start_unlocked (sink)) {
       sink->flow_ret = GST_FLOW_ERROR;
+      ret = sink->flow_ret;
       goto done;
     }
   }
 
   /* make data available for the transfer thread and notify */
-  sink->transfer_buf->ptr = data;
-  sink->transfer_buf->len = size;
-  sink->transfer_buf->offset = 0;
-  gst_curl_base_sink_transfer_thread_notify_unlocked (sink);
+  ret = gst_curl_base_sink_queue_buffer_unlocked (sink, buf);
 
-  /* wait for the transfer thread to send the data. This will be notified
-   * either when transfer is completed by the curl read callback or by
-   * the thread function if an error has occurred. */
-  gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked (sink);
+  /* without a queue, wait for the transfer thread to send the data. This
+   * will be notified either when transfer is completed by the curl read
+   * callback or by the thread function if an error has occurred. */
+  if (ret == GST_FLOW_OK && sink->max_queue_bytes == 0) {
+    gst_curl_base_sink_drain_unlocked (sink);
+  }
 
-done:
-  gst_buffer_unmap (buf, &map);
+  if (ret == GST_FLOW_OK && sink->flushing) {
+    ret = GST_FLOW_FLUSHING;
+  } else if (ret == GST_FLOW_OK) {
+    ret = sink->flow_ret;
+  }
 
+done:
   /* Hand over error from transfer thread to streaming thread */
   error = sink->error;
   sink->error = NULL;
-  ret = sink->flow_ret;
   GST_OBJECT_UNLOCK (sink);
 
   if (error != NULL) {
@@ -411,12 +659,29 @@ gst_curl_base_sink_event (GstBaseSink * bsink, GstEvent * event)
 {
   GstCurlBaseSink *sink = GST_CURL_BASE_SINK (bsink);
   GstCurlBaseSinkClass *klass = GST_CURL_BASE_SINK_GET_CLASS (sink);
+  gchar *error;
 
   switch (event->type) {
     case GST_EVENT_EOS:
       GST_DEBUG_OBJECT (sink, "received EOS");
+      /* send whatever is still queued before closing the transfer */
+      GST_OBJECT_LOCK (sink);
+      gst_curl_base_sink_drain_unlocked (sink);
+      GST_OBJECT_UNLOCK (sink);
+
       gst_curl_base_sink_transfer_thread_close (sink);
       gst_curl_base_sink_wait_for_response (sink);
+
+      /* errors of queued buffers have no render call to report them */
+      GST_OBJECT_LOCK (sink);
+      error = sink->error;
+      sink->error = NULL;
+      GST_OBJECT_UNLOCK (sink);
+      if (error != NULL) {
+        GST_ERROR_OBJECT (sink, "%s", error);
+        GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, ("%s", error), (NULL));
+        g_free (error);
+      }
       break;
     case GST_EVENT_CAPS:
       if (klass->set_mime_type) {
@@ -446,6 +711,12 @@ gst_curl_base_sink_start (GstBaseSink * bsink)
   sink->transfer_thread_close = FALSE;
   sink->new_file = TRUE;
   sink->flow_ret = GST_FLOW_OK;
+  sink->flushing = FALSE;
+  sink->bytes_sent = 0;
+  sink->buffers_sent = 0;
+  sink->buffers_dropped = 0;
+  sink->first_send_time = 0;
+  sink->last_send_time = 0;
 
   if ((sink->fdset = gst_poll_new (TRUE)) == NULL) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
@@ -469,6 +740,17 @@ gst_curl_base_sink_stop (GstBaseSink * bsink)
     sink->fdset = NULL;
   }
 
+  GST_OBJECT_LOCK (sink);
+  if (sink->queued_bytes > 0) {
+    GST_WARNING_OBJECT (sink, "discarding %u queued bytes",
+        sink->queued_bytes);
+  }
+  gst_curl_base_sink_queue_flush_unlocked (sink);
+  /* the transfer thread is gone, release the buffer it was sending */
+  gst_curl_base_sink_release_buffer_unlocked (sink);
+  sink->transfer_cond->data_available = FALSE;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -482,6 +764,15 @@ gst_curl_base_sink_unlock (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "Flushing");
   gst_poll_set_flushing (sink->fdset, TRUE);
 
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = TRUE;
+  /* data queued before the flush must not be sent after it */
+  if (sink->queued_bytes > 0) {
+    GST_DEBUG_OBJECT (sink, "discarding %u queued bytes", sink->queued_bytes);
+  }
+  gst_curl_base_sink_queue_flush_unlocked (sink);
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -495,6 +786,10 @@ gst_curl_base_sink_unlock_stop (GstBaseSink * bsink)
   GST_LOG_OBJECT (sink, "No longer flushing");
   gst_poll_set_flushing (sink->fdset, FALSE);
 
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = FALSE;
+  GST_OBJECT_UNLOCK (sink);
+
   return TRUE;
 }
 
@@ -542,6 +837,15 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
         gst_curl_base_sink_setup_dscp_unlocked (sink);
         GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
         break;
+      case PROP_MAX_QUEUE_BYTES:
+        sink->max_queue_bytes = g_value_get_uint (value);
+        GST_DEBUG_OBJECT (sink, "max queue bytes set to %u",
+            sink->max_queue_bytes);
+        break;
+      case PROP_LEAKY:
+        sink->leaky = g_value_get_enum (value);
+        GST_DEBUG_OBJECT (sink, "leaky set to %d", sink->leaky);
+        break;
       default:
         GST_DEBUG_OBJECT (sink, "invalid property id %d", prop_id);
         break;
@@ -557,6 +861,20 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_FILE_NAME:
+      if (!g_queue_is_empty (&sink->queue) ||
+          sink->transfer_cond->data_available) {
+        GstCurlBaseSinkQueueItem *item;
+
+        item = g_slice_new0 (GstCurlBaseSinkQueueItem);
+
+        /* the data queued so far still belongs to the current file, the
+         * transfer thread switches to the new one once it has been sent */
+        item->file_name = g_value_dup_string (value);
+        GST_DEBUG_OBJECT (sink, "queueing file_name %s", item->file_name);
+        g_queue_push_tail (&sink->queue, item);
+        g_cond_broadcast (&sink->transfer_cond->cond);
+        break;
+      }
       g_free (sink->file_name);
       sink->file_name = g_value_dup_string (value);
       GST_DEBUG_OBJECT (sink, "file_name set to %s", sink->file_name);
@@ -571,6 +889,17 @@ gst_curl_base_sink_set_property (GObject * object, guint prop_id,
       gst_curl_base_sink_setup_dscp_unlocked (sink);
       GST_DEBUG_OBJECT (sink, "dscp set to %d", sink->qos_dscp);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      sink->max_queue_bytes = g_value_get_uint (value);
+      GST_DEBUG_OBJECT (sink, "max queue bytes set to %u",
+          sink->max_queue_bytes);
+      g_cond_broadcast (&sink->transfer_cond->cond);
+      break;
+    case PROP_LEAKY:
+      sink->leaky = g_value_get_enum (value);
+      GST_DEBUG_OBJECT (sink, "leaky set to %d", sink->leaky);
+      g_cond_broadcast (&sink->transfer_cond->cond);
+      break;
     default:
       GST_WARNING_OBJECT (sink, "cannot set property when PLAYING");
       break;
@@ -607,6 +936,15 @@ gst_curl_base_sink_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, sink->qos_dscp);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      g_value_set_uint (value, sink->max_queue_bytes);
+      break;
+    case PROP_LEAKY:
+      g_value_set_enum (value, sink->leaky);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_curl_base_sink_create_stats (sink));
+      break;
     default:
       GST_DEBUG_OBJECT (sink, "invalid property id");
       break;
@@ -833,6 +1171,7 @@ gst_curl_base_sink_transfer_read_cb (void *curl_ptr, size_t size, size_t nmemb,
     if (klass->flush_data_unlocked) {
       bytes_to_send = klass->flush_data_unlocked (sink, curl_ptr,
           max_bytes_to_send, sink->new_file, sink->transfer_thread_close);
+      gst_curl_base_sink_update_stats_unlocked (sink, bytes_to_send);
 
       GST_OBJECT_UNLOCK (sink);
 
@@ -850,6 +1189,13 @@ gst_curl_base_sink_transfer_read_cb (void *curl_ptr, size_t size, size_t nmemb,
   bytes_to_send = klass->transfer_data_buffer (sink, curl_ptr,
       max_bytes_to_send, &last_chunk);
 
+  GST_OBJECT_LOCK (sink);
+  gst_curl_base_sink_update_stats_unlocked (sink, bytes_to_send);
+  if (last_chunk && sink->transfer_buffer != NULL) {
+    sink->buffers_sent++;
+  }
+  GST_OBJECT_UNLOCK (sink);
+
   /* the last data chunk */
   if (last_chunk) {
     gst_curl_base_sink_data_sent_notify (sink);
@@ -1299,6 +1645,10 @@ gst_curl_base_sink_wait_for_data_unlocked (GstCurlBaseSink * sink)
   GST_LOG ("waiting for data");
   while (!sink->transfer_cond->data_available &&
       !sink->transfer_thread_close && !sink->new_file) {
+    if (!g_queue_is_empty (&sink->queue)) {
+      gst_curl_base_sink_queue_pop_unlocked (sink);
+      continue;
+    }
     g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
   }
 
@@ -1322,17 +1672,20 @@ gst_curl_base_sink_new_file_notify_unlocked (GstCurlBaseSink * sink)
   g_cond_signal (&sink->transfer_cond->cond);
 }
 
-static void
-    gst_curl_base_sink_wait_for_transfer_thread_to_send_unlocked
-    (GstCurlBaseSink * sink)
+/* Wait until everything queued so far has been sent, the transfer thread
+ * has failed or the sink is flushing */
+void
+gst_curl_base_sink_drain_unlocked (GstCurlBaseSink * sink)
 {
   GST_LOG ("waiting for buffer send to complete");
 
   /* this function should not check if the transfer thread is set to be closed
    * since that flag only can be set by the EOS event (by the pipeline thread).
    * This can therefore never happen while this function is running since this
-   * function also is called by the pipeline thread (in the render function) */
-  while (!sink->transfer_cond->data_sent) {
+   * function also is called by the pipeline thread */
+  while ((!g_queue_is_empty (&sink->queue) ||
+          sink->transfer_cond->data_available) &&
+      sink->flow_ret == GST_FLOW_OK && !sink->flushing) {
     g_cond_wait (&sink->transfer_cond->cond, GST_OBJECT_GET_LOCK (sink));
   }
   GST_LOG ("buffer send completed");
@@ -1343,9 +1696,10 @@ gst_curl_base_sink_data_sent_notify (GstCurlBaseSink * sink)
 {
   GST_LOG ("transfer completed");
   GST_OBJECT_LOCK (sink);
+  gst_curl_base_sink_release_buffer_unlocked (sink);
   sink->transfer_cond->data_available = FALSE;
   sink->transfer_cond->data_sent = TRUE;
-  g_cond_signal (&sink->transfer_cond->cond);
+  g_cond_broadcast (&sink->transfer_cond->cond);
   GST_OBJECT_UNLOCK (sink);
 }
 
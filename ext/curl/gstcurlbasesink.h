@@ -43,6 +43,13 @@ typedef struct _GstCurlBaseSinkClass GstCurlBaseSinkClass;
 typedef struct _TransferBuffer TransferBuffer;
 typedef struct _TransferCondition TransferCondition;
 
+typedef enum
+{
+  GST_CURL_BASE_SINK_LEAKY_NO,
+  GST_CURL_BASE_SINK_LEAKY_UPSTREAM,
+  GST_CURL_BASE_SINK_LEAKY_DOWNSTREAM
+} GstCurlBaseSinkLeaky;
+
 struct _TransferBuffer
 {
   guint8 *ptr;
@@ -83,6 +90,23 @@ struct _GstCurlBaseSink
   gboolean transfer_thread_close;
   gboolean new_file;
   gboolean is_live;
+
+  /* buffers (and file name changes) waiting for the transfer thread */
+  GQueue queue;
+  guint queued_bytes;
+  guint max_queue_bytes;
+  GstCurlBaseSinkLeaky leaky;
+  gboolean flushing;
+  /* the buffer transfer_buf currently points into */
+  GstBuffer *transfer_buffer;
+  GstMapInfo transfer_map;
+
+  /* statistics */
+  guint64 bytes_sent;
+  guint64 buffers_sent;
+  guint64 buffers_dropped;
+  gint64 first_send_time;
+  gint64 last_send_time;
 };
 
 struct _GstCurlBaseSinkClass
@@ -112,6 +136,7 @@ GType gst_curl_base_sink_get_type (void);
 void gst_curl_base_sink_transfer_thread_notify_unlocked
     (GstCurlBaseSink * sink);
 void gst_curl_base_sink_transfer_thread_close (GstCurlBaseSink * sink);
+void gst_curl_base_sink_drain_unlocked (GstCurlBaseSink * sink);
 void gst_curl_base_sink_set_live (GstCurlBaseSink * sink, gboolean live);
 gboolean gst_curl_base_sink_is_live (GstCurlBaseSink * sink);
 
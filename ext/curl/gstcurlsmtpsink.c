@@ -201,6 +201,10 @@ gst_curl_smtp_sink_event (GstBaseSink * bsink, GstEvent * event)
   switch (event->type) {
     case GST_EVENT_EOS:
       GST_DEBUG_OBJECT (sink, "received EOS");
+      /* the final boundary goes after everything still queued */
+      GST_OBJECT_LOCK (sink);
+      gst_curl_base_sink_drain_unlocked (bcsink);
+      GST_OBJECT_UNLOCK (sink);
       gst_curl_base_sink_set_live (bcsink, FALSE);
 
       GST_OBJECT_LOCK (sink);
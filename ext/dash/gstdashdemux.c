@@ -959,7 +959,12 @@ gst_dash_demux_setup_streams (GstAdaptiveDemux * demux)
     /* get period index for period encompassing the current time */
     g_now = gst_dash_demux_get_server_now_utc (dashdemux);
     now = gst_date_time_new_from_g_date_time (g_now);
-    if (dashdemux->client->mpd_node->suggestedPresentationDelay != -1) {
+    if (demux->low_latency) {
+      GstDateTime *target = gst_mpd_client_add_time_difference (now,
+          (gint64) GST_TIME_AS_USECONDS (demux->target_latency) * -1);
+      gst_date_time_unref (now);
+      now = target;
+    } else if (dashdemux->client->mpd_node->suggestedPresentationDelay != -1) {
       GstDateTime *target = gst_mpd_client_add_time_difference (now,
           dashdemux->client->mpd_node->suggestedPresentationDelay * -1000);
       gst_date_time_unref (now);
@@ -2540,8 +2545,21 @@ gst_dash_demux_stream_get_fragment_waiting_time (GstAdaptiveDemuxStream *
     /* subtract the server's clock drift, so that if the server's
        time is behind our idea of UTC, we need to sleep for longer
        before requesting a fragment */
-    return diff -
-        gst_dash_demux_get_clock_compensation (dashdemux) * GST_USECOND;
+    diff -= gst_dash_demux_get_clock_compensation (dashdemux) * GST_USECOND;
+
+    /* in low-latency mode, request the segment as soon as the server
+     * starts making it available, and receive its chunks while they are
+     * being produced */
+    if (stream->demux->low_latency) {
+      GstClockTime offset =
+          gst_mpd_client_get_availability_time_offset (dashdemux->client,
+          active_stream);
+
+      if (!GST_CLOCK_TIME_IS_VALID (offset))
+        return 0;
+      diff -= (gint64) offset;
+    }
+    return diff;
   }
   return 0;
 }
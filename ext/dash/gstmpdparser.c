@@ -25,6 +25,7 @@
  */
 
 #include <string.h>
+#include <math.h>
 #include <libxml/parser.h>
 #include <libxml/tree.h>
 #include "gstmpdparser.h"
@@ -2082,6 +2083,12 @@ gst_mpdparser_parse_segment_template_node (GstSegmentTemplateNode ** pointer,
         xmlMemStrdup (parent->bitstreamSwitching);
   }
 
+  if (!gst_mpdparser_get_xml_prop_double (a_node, "availabilityTimeOffset",
+          &new_segment_template->availabilityTimeOffset) && parent) {
+    new_segment_template->availabilityTimeOffset =
+        parent->availabilityTimeOffset;
+  }
+
   *pointer = new_segment_template;
   return TRUE;
 
@@ -6000,6 +6007,31 @@ gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client,
   return rv;
 }
 
+/* Returns how long before its announced availability time the next segment
+ * of @stream may already be requested (MPD@availabilityTimeOffset), or
+ * GST_CLOCK_TIME_NONE if segments are available as soon as they appear in
+ * the manifest ("INF") */
+GstClockTime
+gst_mpd_client_get_availability_time_offset (GstMpdClient * client,
+    GstActiveStream * stream)
+{
+  gdouble offset;
+
+  g_return_val_if_fail (client != NULL, 0);
+  g_return_val_if_fail (stream != NULL, 0);
+
+  if (stream->cur_seg_template == NULL)
+    return 0;
+
+  offset = stream->cur_seg_template->availabilityTimeOffset;
+  if (isinf (offset))
+    return GST_CLOCK_TIME_NONE;
+  if (offset <= 0)
+    return 0;
+
+  return (GstClockTime) (offset * GST_SECOND);
+}
+
 gboolean
 gst_mpd_client_seek_to_time (GstMpdClient * client, GDateTime * time)
 {
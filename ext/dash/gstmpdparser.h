@@ -206,6 +206,9 @@ struct _GstSegmentTemplateNode
   gchar *index;
   gchar *initialization;
   gchar *bitstreamSwitching;
+  /* how much earlier than announced segments can be requested (seconds),
+   * used for low-latency chunked delivery */
+  gdouble availabilityTimeOffset;
 };
 
 struct _GstSegmentURLNode
@@ -582,6 +585,7 @@ gboolean gst_mpd_client_has_next_segment (GstMpdClient * client, GstActiveStream
 GstFlowReturn gst_mpd_client_advance_segment (GstMpdClient * client, GstActiveStream * stream, gboolean forward);
 void gst_mpd_client_seek_to_first_segment (GstMpdClient * client);
 GstDateTime *gst_mpd_client_get_next_segment_availability_start_time (GstMpdClient * client, GstActiveStream * stream);
+GstClockTime gst_mpd_client_get_availability_time_offset (GstMpdClient * client, GstActiveStream * stream);
 
 /* Get audio/video stream parameters (caps, width, height, rate, number of channels) */
 GstCaps * gst_mpd_client_get_stream_caps (GstActiveStream * stream);
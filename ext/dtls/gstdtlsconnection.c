@@ -96,6 +96,13 @@ struct _GstDtlsConnectionPrivate
 
   GClosure *send_closure;
 
+  /* records written while sending messages with a max datagram size, they
+   * are passed to the send closure together */
+  gint max_datagram_size;
+  guint8 *send_buffer;
+  gint send_buffer_len;
+  gint send_buffer_size;
+
   gboolean timeout_pending;
   GThreadPool *thread_pool;
 };
@@ -107,6 +114,7 @@ static void gst_dtls_connection_set_property (GObject *, guint prop_id,
 static void log_state (GstDtlsConnection *, const gchar * str);
 static void export_srtp_keys (GstDtlsConnection *);
 static void openssl_poll (GstDtlsConnection *);
+static void flush_send_buffer (GstDtlsConnection *);
 static int openssl_verify_callback (int preverify_ok,
     X509_STORE_CTX * x509_ctx);
 
@@ -182,6 +190,11 @@ gst_dtls_connection_init (GstDtlsConnection * self)
   priv->bio_buffer_len = 0;
   priv->bio_buffer_offset = 0;
 
+  priv->max_datagram_size = 0;
+  priv->send_buffer = NULL;
+  priv->send_buffer_len = 0;
+  priv->send_buffer_size = 0;
+
   g_mutex_init (&priv->mutex);
   g_cond_init (&priv->condition);
 
@@ -210,6 +223,9 @@ gst_dtls_connection_finalize (GObject * gobject)
     priv->send_closure = NULL;
   }
 
+  g_free (priv->send_buffer);
+  priv->send_buffer = NULL;
+
   g_mutex_clear (&priv->mutex);
   g_cond_clear (&priv->condition);
 
@@ -583,6 +599,168 @@ gst_dtls_connection_send (GstDtlsConnection * self, gpointer data, gint len)
   return ret;
 }
 
+static gboolean
+ssl_has_pending (SSL * ssl)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  return SSL_has_pending (ssl);
+#else
+  /* no way to tell if there are unprocessed records left, read until
+   * SSL_read() fails */
+  return TRUE;
+#endif
+}
+
+static guint
+process_datagram (GstDtlsConnection * self, guint index,
+    GstDtlsConnectionDatagram * datagram, GArray * records)
+{
+  GstDtlsConnectionPrivate *priv = self->priv;
+  GstDtlsConnectionRecord record;
+  guint n_records = 0;
+  gint offset = 0;
+  gint result;
+
+  priv->bio_buffer = (gpointer) datagram->data;
+  priv->bio_buffer_len = datagram->length;
+  priv->bio_buffer_offset = 0;
+
+  /* the ciphertext is copied into the read buffer of OpenSSL, so the
+   * plaintext of all records in the datagram fits in its length */
+  do {
+    result = SSL_read (priv->ssl, (guint8 *) datagram->out + offset,
+        datagram->length - offset);
+    if (result <= 0)
+      break;
+
+    record.index = index;
+    record.offset = offset;
+    record.length = result;
+    g_array_append_val (records, record);
+
+    offset += result;
+    n_records++;
+  } while (offset < datagram->length && ssl_has_pending (priv->ssl));
+
+  GST_LOG_OBJECT (self, "datagram %u with length %d had %u records", index,
+      datagram->length, n_records);
+
+  return n_records;
+}
+
+guint
+gst_dtls_connection_process_datagrams (GstDtlsConnection * self,
+    GstDtlsConnectionDatagram * datagrams, guint n_datagrams,
+    GArray * records)
+{
+  GstDtlsConnectionPrivate *priv;
+  gboolean polled = FALSE;
+  guint n_records = 0;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_DTLS_CONNECTION (self), 0);
+  g_return_val_if_fail (self->priv->ssl, 0);
+  g_return_val_if_fail (self->priv->bio, 0);
+  g_return_val_if_fail (records, 0);
+
+  priv = self->priv;
+
+  GST_TRACE_OBJECT (self, "locking @ process_datagrams");
+  g_mutex_lock (&priv->mutex);
+  GST_TRACE_OBJECT (self, "locked @ process_datagrams");
+
+  g_warn_if_fail (!priv->bio_buffer);
+
+  if (SSL_want_write (priv->ssl)) {
+    openssl_poll (self);
+    log_state (self, "process datagrams want write, after poll");
+  }
+
+  for (i = 0; i < n_datagrams; i++) {
+    gboolean handshaking = !SSL_is_init_finished (priv->ssl);
+
+    n_records += process_datagram (self, i, &datagrams[i], records);
+
+    /* the handshake needs to go on after every flight, once it is done a
+     * single poll for the whole batch is enough */
+    polled = handshaking;
+    if (handshaking) {
+      openssl_poll (self);
+      log_state (self, "process datagrams after poll");
+    }
+
+    priv->bio_buffer = NULL;
+    priv->bio_buffer_len = 0;
+    priv->bio_buffer_offset = 0;
+  }
+
+  if (!polled)
+    openssl_poll (self);
+
+  GST_DEBUG_OBJECT (self, "processed %u datagrams, %u records", n_datagrams,
+      n_records);
+
+  GST_TRACE_OBJECT (self, "unlocking @ process_datagrams");
+  g_mutex_unlock (&priv->mutex);
+
+  return n_records;
+}
+
+guint
+gst_dtls_connection_send_messages (GstDtlsConnection * self,
+    const GstDtlsConnectionMessage * messages, guint n_messages,
+    gint max_datagram_size)
+{
+  GstDtlsConnectionPrivate *priv;
+  guint n_sent = 0;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_DTLS_CONNECTION (self), 0);
+  g_return_val_if_fail (self->priv->ssl, 0);
+  g_return_val_if_fail (self->priv->bio, 0);
+
+  priv = self->priv;
+
+  GST_TRACE_OBJECT (self, "locking @ send_messages");
+  g_mutex_lock (&priv->mutex);
+  GST_TRACE_OBJECT (self, "locked @ send_messages");
+
+  if (!SSL_is_init_finished (priv->ssl)) {
+    GST_WARNING_OBJECT (self,
+        "tried to send data before handshake was complete");
+    goto done;
+  }
+
+  if (max_datagram_size > priv->send_buffer_size) {
+    priv->send_buffer = g_realloc (priv->send_buffer, max_datagram_size);
+    priv->send_buffer_size = max_datagram_size;
+  }
+  priv->max_datagram_size = MAX (max_datagram_size, 0);
+
+  for (i = 0; i < n_messages; i++) {
+    gint ret;
+
+    ret = SSL_write (priv->ssl, messages[i].data, messages[i].length);
+    if (ret != messages[i].length) {
+      GST_WARNING_OBJECT (self, "failed to send message %u: input was %d B, "
+          "output is %d B", i, messages[i].length, ret);
+      break;
+    }
+    n_sent++;
+  }
+
+  flush_send_buffer (self);
+  priv->max_datagram_size = 0;
+
+  GST_DEBUG_OBJECT (self, "sent %u/%u messages", n_sent, n_messages);
+
+done:
+  GST_TRACE_OBJECT (self, "unlocking @ send_messages");
+  g_mutex_unlock (&priv->mutex);
+
+  return n_sent;
+}
+
 /*
      ######   #######  ##    ##
     ##    ## ##     ## ###   ##
@@ -865,13 +1043,9 @@ BIO_s_gst_dtls_connection (void)
 }
 #endif
 
-static int
-bio_method_write (BIO * bio, const char *data, int size)
+static void
+send_datagram (GstDtlsConnection * self, const char *data, int size)
 {
-  GstDtlsConnection *self = GST_DTLS_CONNECTION (BIO_get_data (bio));
-
-  GST_LOG_OBJECT (self, "BIO: writing %d", size);
-
   if (self->priv->send_closure) {
     GValue values[3] = { G_VALUE_INIT };
 
@@ -886,6 +1060,43 @@ bio_method_write (BIO * bio, const char *data, int size)
 
     g_closure_invoke (self->priv->send_closure, NULL, 3, values, NULL);
   }
+}
+
+static void
+flush_send_buffer (GstDtlsConnection * self)
+{
+  GstDtlsConnectionPrivate *priv = self->priv;
+
+  if (priv->send_buffer_len > 0) {
+    GST_LOG_OBJECT (self, "BIO: sending %d coalesced bytes",
+        priv->send_buffer_len);
+    send_datagram (self, (const char *) priv->send_buffer,
+        priv->send_buffer_len);
+    priv->send_buffer_len = 0;
+  }
+}
+
+static int
+bio_method_write (BIO * bio, const char *data, int size)
+{
+  GstDtlsConnection *self = GST_DTLS_CONNECTION (BIO_get_data (bio));
+  GstDtlsConnectionPrivate *priv = self->priv;
+
+  GST_LOG_OBJECT (self, "BIO: writing %d", size);
+
+  if (size < priv->max_datagram_size) {
+    if (priv->send_buffer_len + size > priv->max_datagram_size)
+      flush_send_buffer (self);
+
+    memcpy (priv->send_buffer + priv->send_buffer_len, data, size);
+    priv->send_buffer_len += size;
+
+    return size;
+  }
+
+  /* keep the records in order */
+  flush_send_buffer (self);
+  send_datagram (self, data, size);
 
   return size;
 }
@@ -112,12 +112,56 @@ void gst_dtls_connection_set_send_callback(GstDtlsConnection *, GClosure *);
  */
 gint gst_dtls_connection_process(GstDtlsConnection *, gpointer ptr, gint len);
 
+/*
+ * A received datagram for gst_dtls_connection_process_datagrams().
+ * The plaintext is written to out, which must be at least length bytes and
+ * may be the same memory as data.
+ */
+typedef struct {
+    gconstpointer data;
+    gint length;
+    gpointer out;
+} GstDtlsConnectionDatagram;
+
+/*
+ * A record of plaintext data decoded by gst_dtls_connection_process_datagrams(),
+ * found at offset in the out memory of datagram number index.
+ */
+typedef struct {
+    guint index;
+    gint offset;
+    gint length;
+} GstDtlsConnectionRecord;
+
+/*
+ * Processes a batch of received datagrams while taking the connection lock only once.
+ * A datagram can carry several records, a GstDtlsConnectionRecord is appended to the records
+ * GArray for each of them. Returns the number of records that were appended.
+ */
+guint gst_dtls_connection_process_datagrams(GstDtlsConnection *, GstDtlsConnectionDatagram *datagrams, guint n_datagrams, GArray *records);
+
 /*
  * If the DTLS handshake is completed this function will encode the given data.
  * Returns the length of the data sent, or 0 if the DTLS handshake is not completed.
  */
 gint gst_dtls_connection_send(GstDtlsConnection *, gpointer ptr, gint len);
 
+/*
+ * A message for gst_dtls_connection_send_messages().
+ */
+typedef struct {
+    gconstpointer data;
+    gint length;
+} GstDtlsConnectionMessage;
+
+/*
+ * Encodes a batch of messages while taking the connection lock only once, one record per message.
+ * If max_datagram_size is larger than 0, records are packed together into datagrams of up to
+ * max_datagram_size bytes before they are passed to the send callback.
+ * Returns the number of messages sent, 0 if the DTLS handshake is not completed.
+ */
+guint gst_dtls_connection_send_messages(GstDtlsConnection *, const GstDtlsConnectionMessage *messages, guint n_messages, gint max_datagram_size);
+
 G_END_DECLS
 
 #endif /* gstdtlsconnection_h */
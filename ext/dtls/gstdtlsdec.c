@@ -80,6 +80,42 @@ static GParamSpec *properties[NUM_PROPERTIES];
 #define DEFAULT_SRTP_CIPHER 0
 #define DEFAULT_SRTP_AUTH 0
 
+/* datagrams up to this size are decoded into buffers from the pool */
+#define POOL_BUFFER_SIZE 2048
+/* number of datagrams passed to the connection at once */
+#define MAX_BATCH_SIZE 32
+
+/* Output buffers are shrunk to the decoded record, the pool restores their
+ * size when they come back so that they are not discarded */
+typedef GstBufferPool GstDtlsDecPool;
+typedef GstBufferPoolClass GstDtlsDecPoolClass;
+
+static GType gst_dtls_dec_pool_get_type (void);
+G_DEFINE_TYPE (GstDtlsDecPool, gst_dtls_dec_pool, GST_TYPE_BUFFER_POOL);
+
+static void
+gst_dtls_dec_pool_reset_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  gsize offset, maxsize;
+
+  gst_buffer_get_sizes (buffer, &offset, &maxsize);
+  if (maxsize >= POOL_BUFFER_SIZE)
+    gst_buffer_resize (buffer, -(gssize) offset, POOL_BUFFER_SIZE);
+
+  GST_BUFFER_POOL_CLASS (gst_dtls_dec_pool_parent_class)->reset_buffer (pool,
+      buffer);
+}
+
+static void
+gst_dtls_dec_pool_class_init (GstDtlsDecPoolClass * klass)
+{
+  klass->reset_buffer = gst_dtls_dec_pool_reset_buffer;
+}
+
+static void
+gst_dtls_dec_pool_init (GstDtlsDecPool * pool)
+{
+}
 
 static void gst_dtls_dec_finalize (GObject *);
 static void gst_dtls_dec_dispose (GObject *);
@@ -194,6 +230,10 @@ gst_dtls_dec_init (GstDtlsDec * self)
   self->srtp_cipher = DEFAULT_SRTP_CIPHER;
   self->srtp_auth = DEFAULT_SRTP_AUTH;
 
+  self->pool = NULL;
+  self->records = g_array_sized_new (FALSE, FALSE,
+      sizeof (GstDtlsConnectionRecord), MAX_BATCH_SIZE);
+
   g_mutex_init (&self->src_mutex);
 
   self->src = NULL;
@@ -223,6 +263,9 @@ gst_dtls_dec_finalize (GObject * object)
   g_free (self->peer_pem);
   self->peer_pem = NULL;
 
+  g_array_free (self->records, TRUE);
+  self->records = NULL;
+
   g_mutex_clear (&self->src_mutex);
 
   GST_LOG_OBJECT (self, "finalized");
@@ -326,12 +369,38 @@ gst_dtls_dec_change_state (GstElement * element, GstStateChange transition)
         return GST_STATE_CHANGE_FAILURE;
       }
       break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:{
+      GstStructure *config;
+
+      self->pool = g_object_new (gst_dtls_dec_pool_get_type (), NULL);
+      config = gst_buffer_pool_get_config (self->pool);
+      gst_buffer_pool_config_set_params (config, NULL, POOL_BUFFER_SIZE, 0, 0);
+      if (!gst_buffer_pool_set_config (self->pool, config) ||
+          !gst_buffer_pool_set_active (self->pool, TRUE)) {
+        GST_WARNING_OBJECT (self, "failed to activate buffer pool");
+        gst_object_unref (self->pool);
+        self->pool = NULL;
+      }
+      break;
+    }
     default:
       break;
   }
 
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      if (self->pool) {
+        gst_buffer_pool_set_active (self->pool, FALSE);
+        gst_object_unref (self->pool);
+        self->pool = NULL;
+      }
+      break;
+    default:
+      break;
+  }
+
   return ret;
 }
 
@@ -476,57 +545,112 @@ on_peer_certificate_received (GstDtlsConnection * connection, gchar * pem,
   return TRUE;
 }
 
-static gint
-process_buffer (GstDtlsDec * self, GstBuffer * buffer)
+static GstBuffer *
+acquire_output_buffer (GstDtlsDec * self, gsize size)
+{
+  GstBuffer *buffer = NULL;
+
+  if (self->pool && size <= POOL_BUFFER_SIZE &&
+      gst_buffer_pool_acquire_buffer (self->pool, &buffer, NULL) ==
+      GST_FLOW_OK)
+    return buffer;
+
+  return gst_buffer_new_allocate (NULL, size, NULL);
+}
+
+/* Decodes the datagrams in @buffers into output buffers, one for every
+ * record, and adds them to @list */
+static void
+decode_buffers (GstDtlsDec * self, GstBuffer ** buffers, guint n_buffers,
+    GstBufferList * list)
 {
-  GstMapInfo map_info;
-  gint size;
+  GstDtlsConnectionDatagram datagrams[MAX_BATCH_SIZE];
+  GstBuffer *in_buffers[MAX_BATCH_SIZE];
+  GstMapInfo in_maps[MAX_BATCH_SIZE];
+  GstMapInfo out_maps[MAX_BATCH_SIZE];
+  GstBuffer *out_buffers[MAX_BATCH_SIZE];
+  guint i, n = 0, r = 0;
 
-  if (!gst_buffer_map (buffer, &map_info, GST_MAP_READWRITE))
-    return 0;
+  g_return_if_fail (n_buffers <= MAX_BATCH_SIZE);
 
-  if (!map_info.size) {
-    gst_buffer_unmap (buffer, &map_info);
-    return 0;
+  for (i = 0; i < n_buffers; i++) {
+    gsize size = gst_buffer_get_size (buffers[i]);
+    GstBuffer *out;
+
+    if (!size)
+      continue;
+
+    out = acquire_output_buffer (self, size);
+    gst_buffer_copy_into (out, buffers[i], GST_BUFFER_COPY_METADATA, 0, -1);
+
+    if (!gst_buffer_map (buffers[i], &in_maps[n], GST_MAP_READ)) {
+      gst_buffer_unref (out);
+      continue;
+    }
+    if (!gst_buffer_map (out, &out_maps[n], GST_MAP_WRITE)) {
+      gst_buffer_unmap (buffers[i], &in_maps[n]);
+      gst_buffer_unref (out);
+      continue;
+    }
+
+    datagrams[n].data = in_maps[n].data;
+    datagrams[n].length = size;
+    datagrams[n].out = out_maps[n].data;
+    out_buffers[n] = out;
+    in_buffers[n] = buffers[i];
+    n++;
   }
 
-  size =
-      gst_dtls_connection_process (self->connection, map_info.data,
-      map_info.size);
-  gst_buffer_unmap (buffer, &map_info);
+  if (!n)
+    return;
 
-  if (size <= 0)
-    return size;
+  g_array_set_size (self->records, 0);
+  gst_dtls_connection_process_datagrams (self->connection, datagrams, n,
+      self->records);
 
-  gst_buffer_set_size (buffer, size);
+  for (i = 0; i < n; i++) {
+    gst_buffer_unmap (in_buffers[i], &in_maps[i]);
+    gst_buffer_unmap (out_buffers[i], &out_maps[i]);
+  }
 
-  return size;
-}
+  for (i = 0; i < n; i++) {
+    GstDtlsConnectionRecord *record;
+    guint first = r;
 
-static gboolean
-process_buffer_from_list (GstBuffer ** buffer, guint idx, gpointer user_data)
-{
-  GstDtlsDec *self = GST_DTLS_DEC (user_data);
-  gint size;
+    while (r < self->records->len &&
+        g_array_index (self->records, GstDtlsConnectionRecord, r).index == i)
+      r++;
 
-  *buffer = gst_buffer_make_writable (*buffer);
-  size = process_buffer (self, *buffer);
-  if (size <= 0)
-    gst_buffer_replace (buffer, NULL);
+    if (r - first == 1) {
+      record = &g_array_index (self->records, GstDtlsConnectionRecord, first);
+      gst_buffer_resize (out_buffers[i], record->offset, record->length);
+      gst_buffer_list_add (list, out_buffers[i]);
+      continue;
+    }
 
-  return TRUE;
+    /* several records in one datagram share its memory, unless it is a
+     * pool buffer that must come back to the pool unshared */
+    for (; first < r; first++) {
+      GstBufferCopyFlags flags =
+          GST_BUFFER_COPY_METADATA | GST_BUFFER_COPY_MEMORY;
+
+      if (out_buffers[i]->pool)
+        flags |= GST_BUFFER_COPY_DEEP;
+
+      record = &g_array_index (self->records, GstDtlsConnectionRecord, first);
+      gst_buffer_list_add (list, gst_buffer_copy_region (out_buffers[i],
+              flags, record->offset, record->length));
+    }
+    gst_buffer_unref (out_buffers[i]);
+  }
 }
 
 static GstFlowReturn
-sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+push_decoded (GstDtlsDec * self, GstBufferList * list)
 {
-  GstDtlsDec *self = GST_DTLS_DEC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *other_pad;
 
-  list = gst_buffer_list_make_writable (list);
-  gst_buffer_list_foreach (list, process_buffer_from_list, self);
-
   if (gst_buffer_list_length (list) == 0) {
     GST_DEBUG_OBJECT (self, "Not produced any buffers");
     gst_buffer_list_unref (list);
@@ -541,9 +665,18 @@ sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
   g_mutex_unlock (&self->src_mutex);
 
   if (other_pad) {
-    GST_LOG_OBJECT (self, "decoded buffer list with length %u, pushing",
-        gst_buffer_list_length (list));
-    ret = gst_pad_push_list (other_pad, list);
+    if (gst_buffer_list_length (list) == 1) {
+      GstBuffer *buffer = gst_buffer_ref (gst_buffer_list_get (list, 0));
+
+      gst_buffer_list_unref (list);
+      GST_LOG_OBJECT (self, "decoded buffer with length %" G_GSIZE_FORMAT
+          ", pushing", gst_buffer_get_size (buffer));
+      ret = gst_pad_push (other_pad, buffer);
+    } else {
+      GST_LOG_OBJECT (self, "decoded buffer list with length %u, pushing",
+          gst_buffer_list_length (list));
+      ret = gst_pad_push_list (other_pad, list);
+    }
     gst_object_unref (other_pad);
   } else {
     GST_LOG_OBJECT (self, "dropped buffer list with length %d, not linked",
@@ -554,13 +687,35 @@ sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
   return ret;
 }
 
+static GstFlowReturn
+sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstDtlsDec *self = GST_DTLS_DEC (parent);
+  GstBuffer *buffers[MAX_BATCH_SIZE];
+  GstBufferList *out_list;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  out_list = gst_buffer_list_new_sized (len);
+
+  for (i = 0; i < len; i += MAX_BATCH_SIZE) {
+    guint j, n = MIN (len - i, MAX_BATCH_SIZE);
+
+    for (j = 0; j < n; j++)
+      buffers[j] = gst_buffer_list_get (list, i + j);
+    decode_buffers (self, buffers, n, out_list);
+  }
+
+  gst_buffer_list_unref (list);
+
+  return push_decoded (self, out_list);
+}
+
 static GstFlowReturn
 sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstDtlsDec *self = GST_DTLS_DEC (parent);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint size;
-  GstPad *other_pad;
+  GstBufferList *out_list;
 
   if (!self->agent) {
     gst_buffer_unref (buffer);
@@ -571,31 +726,11 @@ sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       "received buffer from %s with length %" G_GSIZE_FORMAT,
       self->connection_id, gst_buffer_get_size (buffer));
 
-  buffer = gst_buffer_make_writable (buffer);
-  size = process_buffer (self, buffer);
-
-  if (size <= 0) {
-    gst_buffer_unref (buffer);
-
-    return GST_FLOW_OK;
-  }
-
-  g_mutex_lock (&self->src_mutex);
-  other_pad = self->src;
-  if (other_pad)
-    gst_object_ref (other_pad);
-  g_mutex_unlock (&self->src_mutex);
-
-  if (other_pad) {
-    GST_LOG_OBJECT (self, "decoded buffer with length %d, pushing", size);
-    ret = gst_pad_push (other_pad, buffer);
-    gst_object_unref (other_pad);
-  } else {
-    GST_LOG_OBJECT (self, "dropped buffer with length %d, not linked", size);
-    gst_buffer_unref (buffer);
-  }
+  out_list = gst_buffer_list_new_sized (1);
+  decode_buffers (self, &buffer, 1, out_list);
+  gst_buffer_unref (buffer);
 
-  return ret;
+  return push_decoded (self, out_list);
 }
 
 static GHashTable *agent_table = NULL;
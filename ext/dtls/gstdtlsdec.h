@@ -63,6 +63,9 @@ struct _GstDtlsDec {
     GstBuffer *decoder_key;
     guint srtp_cipher;
     guint srtp_auth;
+
+    GstBufferPool *pool;
+    GArray *records;
 };
 
 struct _GstDtlsDecClass {
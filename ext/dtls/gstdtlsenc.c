@@ -62,6 +62,7 @@ enum
   PROP_0,
   PROP_CONNECTION_ID,
   PROP_IS_CLIENT,
+  PROP_MAX_DATAGRAM_SIZE,
 
   PROP_ENCODER_KEY,
   PROP_SRTP_CIPHER,
@@ -73,6 +74,7 @@ static GParamSpec *properties[NUM_PROPERTIES];
 
 #define DEFAULT_CONNECTION_ID NULL
 #define DEFAULT_IS_CLIENT FALSE
+#define DEFAULT_MAX_DATAGRAM_SIZE 0
 
 #define DEFAULT_ENCODER_KEY NULL
 #define DEFAULT_SRTP_CIPHER 0
@@ -80,6 +82,9 @@ static GParamSpec *properties[NUM_PROPERTIES];
 
 #define INITIAL_QUEUE_SIZE 64
 
+/* number of buffers passed to the connection at once */
+#define MAX_BATCH_SIZE 32
+
 static void gst_dtls_enc_finalize (GObject *);
 static void gst_dtls_enc_set_property (GObject *, guint prop_id,
     const GValue *, GParamSpec *);
@@ -96,6 +101,7 @@ static gboolean src_activate_mode (GstPad *, GstObject *, GstPadMode,
 static void src_task_loop (GstPad *);
 
 static GstFlowReturn sink_chain (GstPad *, GstObject *, GstBuffer *);
+static GstFlowReturn sink_chain_list (GstPad *, GstObject *, GstBufferList *);
 
 static void on_key_received (GstDtlsConnection *, gpointer key, guint cipher,
     guint auth, GstDtlsEnc *);
@@ -138,6 +144,15 @@ gst_dtls_enc_class_init (GstDtlsEncClass * klass)
       DEFAULT_IS_CLIENT,
       GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  properties[PROP_MAX_DATAGRAM_SIZE] =
+      g_param_spec_int ("max-datagram-size",
+      "Max datagram size",
+      "Pack the records of buffer lists together into datagrams of up to "
+      "this size, 0 sends every record in its own datagram. The receiver "
+      "needs to read all records of a datagram",
+      0, G_MAXINT, DEFAULT_MAX_DATAGRAM_SIZE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   properties[PROP_ENCODER_KEY] =
       g_param_spec_boxed ("encoder-key",
       "Encoder key",
@@ -179,6 +194,7 @@ gst_dtls_enc_init (GstDtlsEnc * self)
   self->connection = NULL;
 
   self->is_client = DEFAULT_IS_CLIENT;
+  self->max_datagram_size = DEFAULT_MAX_DATAGRAM_SIZE;
 
   self->encoder_key = NULL;
   self->srtp_cipher = DEFAULT_SRTP_CIPHER;
@@ -242,6 +258,9 @@ gst_dtls_enc_set_property (GObject * object, guint prop_id,
     case PROP_IS_CLIENT:
       self->is_client = g_value_get_boolean (value);
       break;
+    case PROP_MAX_DATAGRAM_SIZE:
+      self->max_datagram_size = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
   }
@@ -260,6 +279,9 @@ gst_dtls_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_IS_CLIENT:
       g_value_set_boolean (value, self->is_client);
       break;
+    case PROP_MAX_DATAGRAM_SIZE:
+      g_value_set_int (value, self->max_datagram_size);
+      break;
     case PROP_ENCODER_KEY:
       g_value_set_boxed (value, self->encoder_key);
       break;
@@ -355,6 +377,7 @@ gst_dtls_enc_request_new_pad (GstElement * element,
   }
 
   gst_pad_set_chain_function (sink, GST_DEBUG_FUNCPTR (sink_chain));
+  gst_pad_set_chain_list_function (sink, GST_DEBUG_FUNCPTR (sink_chain_list));
 
   ret = gst_pad_set_active (sink, TRUE);
   g_warn_if_fail (ret);
@@ -406,7 +429,8 @@ src_task_loop (GstPad * pad)
 {
   GstDtlsEnc *self = GST_DTLS_ENC (GST_PAD_PARENT (pad));
   GstFlowReturn ret;
-  GstBuffer *buffer;
+  GstBuffer *buffer = NULL;
+  GstBufferList *list = NULL;
   gboolean check_connection_timeout = FALSE;
 
   GST_TRACE_OBJECT (self, "src loop: acquiring lock");
@@ -434,7 +458,14 @@ src_task_loop (GstPad * pad)
   }
   GST_TRACE_OBJECT (self, "src loop: queue has element");
 
-  buffer = g_queue_pop_head (&self->queue);
+  /* push everything that was queued in the meantime in one go */
+  if (g_queue_get_length (&self->queue) > 1) {
+    list = gst_buffer_list_new_sized (g_queue_get_length (&self->queue));
+    while ((buffer = g_queue_pop_head (&self->queue)))
+      gst_buffer_list_add (list, buffer);
+  } else {
+    buffer = g_queue_pop_head (&self->queue);
+  }
   g_mutex_unlock (&self->queue_lock);
 
   if (self->send_initial_events) {
@@ -456,7 +487,10 @@ src_task_loop (GstPad * pad)
 
   GST_TRACE_OBJECT (self, "src loop: releasing lock");
 
-  ret = gst_pad_push (self->src, buffer);
+  if (list)
+    ret = gst_pad_push_list (self->src, list);
+  else
+    ret = gst_pad_push (self->src, buffer);
   if (check_connection_timeout)
     gst_dtls_connection_check_timeout (self->connection);
 
@@ -493,6 +527,54 @@ sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+sink_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstDtlsEnc *self = GST_DTLS_ENC (parent);
+  GstDtlsConnectionMessage messages[MAX_BATCH_SIZE];
+  GstMapInfo maps[MAX_BATCH_SIZE];
+  GstBuffer *buffers[MAX_BATCH_SIZE];
+  guint i = 0, j, n, sent, len;
+
+  len = gst_buffer_list_length (list);
+
+  while (i < len) {
+    for (n = 0; i < len && n < MAX_BATCH_SIZE; i++) {
+      GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+      if (!gst_buffer_map (buffer, &maps[n], GST_MAP_READ))
+        continue;
+      if (!maps[n].size) {
+        gst_buffer_unmap (buffer, &maps[n]);
+        continue;
+      }
+
+      buffers[n] = buffer;
+      messages[n].data = maps[n].data;
+      messages[n].length = maps[n].size;
+      n++;
+    }
+
+    if (!n)
+      break;
+
+    sent = gst_dtls_connection_send_messages (self->connection, messages, n,
+        self->max_datagram_size);
+    if (sent != n) {
+      GST_WARNING_OBJECT (self,
+          "error sending data: %u buffers were sent, expected value was %u",
+          sent, n);
+    }
+
+    for (j = 0; j < n; j++)
+      gst_buffer_unmap (buffers[j], &maps[j]);
+  }
+
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
 static void
 on_key_received (GstDtlsConnection * connection, gpointer key, guint cipher,
     guint auth, GstDtlsEnc * self)
@@ -56,6 +56,7 @@ struct _GstDtlsEnc {
     gchar *connection_id;
 
     gboolean is_client;
+    gint max_datagram_size;
 
     GstBuffer *encoder_key;
     guint srtp_cipher;
@@ -61,6 +61,10 @@ GST_DEBUG_CATEGORY (gst_hls_demux_debug);
 #define GST_M3U8_CLIENT_LOCK(l) /* FIXME */
 #define GST_M3U8_CLIENT_UNLOCK(l)       /* FIXME */
 
+/* Minimum amount of encrypted data handed to the cipher in one go. Must be
+ * a multiple of the AES block size */
+#define GST_HLS_DEMUX_DECRYPT_BATCH_SIZE (64 * 1024)
+
 /* GObject */
 static void gst_hls_demux_finalize (GObject * obj);
 
@@ -77,6 +81,8 @@ static gboolean gst_hls_demux_change_playlist (GstHLSDemux * demux,
     guint max_bitrate, gboolean * changed);
 static GstBuffer *gst_hls_demux_decrypt_fragment (GstHLSDemux * demux,
     GstHLSDemuxStream * stream, GstBuffer * encrypted_buffer, GError ** err);
+static void gst_hls_demux_stream_decrypt_func (gpointer data,
+    gpointer user_data);
 static gboolean
 gst_hls_demux_stream_decrypt_start (GstHLSDemuxStream * stream,
     const guint8 * key_data, const guint8 * iv_data);
@@ -249,12 +255,55 @@ gst_hls_demux_get_bitrate (GstHLSDemux * hlsdemux)
   return 0;
 }
 
+/* Waits until all batches queued for decryption have been processed.
+ * Returns TRUE if decryption failed */
+static gboolean
+gst_hls_demux_stream_decrypt_wait (GstHLSDemuxStream * hls_stream)
+{
+  gboolean failed;
+
+  g_mutex_lock (&hls_stream->decrypt_lock);
+  while (hls_stream->decrypt_pending > 0)
+    g_cond_wait (&hls_stream->decrypt_cond, &hls_stream->decrypt_lock);
+  failed = hls_stream->decrypt_failed;
+  g_mutex_unlock (&hls_stream->decrypt_lock);
+
+  return failed;
+}
+
+/* Marks decryption as failed and posts an error, unless that was already
+ * done for this failure */
+static void
+gst_hls_demux_stream_decrypt_error (GstHLSDemux * demux,
+    GstHLSDemuxStream * hls_stream)
+{
+  gboolean post;
+
+  g_mutex_lock (&hls_stream->decrypt_lock);
+  hls_stream->decrypt_failed = TRUE;
+  post = !hls_stream->decrypt_error_posted;
+  hls_stream->decrypt_error_posted = TRUE;
+  g_mutex_unlock (&hls_stream->decrypt_lock);
+
+  if (post)
+    GST_ELEMENT_ERROR (demux, STREAM, DECODE, ("Failed to decrypt buffer"),
+        ("decryption failed"));
+}
+
 static void
 gst_hls_demux_stream_clear_pending_data (GstHLSDemuxStream * hls_stream)
 {
+  gst_hls_demux_stream_decrypt_wait (hls_stream);
+
   if (hls_stream->pending_encrypted_data)
     gst_adapter_clear (hls_stream->pending_encrypted_data);
-  gst_buffer_replace (&hls_stream->pending_decrypted_buffer, NULL);
+  g_queue_foreach (&hls_stream->decrypted_buffers, (GFunc) gst_buffer_unref,
+      NULL);
+  g_queue_clear (&hls_stream->decrypted_buffers);
+  g_mutex_lock (&hls_stream->decrypt_lock);
+  hls_stream->decrypt_failed = FALSE;
+  hls_stream->decrypt_error_posted = FALSE;
+  g_mutex_unlock (&hls_stream->decrypt_lock);
   gst_buffer_replace (&hls_stream->pending_typefind_buffer, NULL);
   gst_buffer_replace (&hls_stream->pending_pcr_buffer, NULL);
   hls_stream->current_offset = -1;
@@ -505,6 +554,15 @@ create_stream_for_playlist (GstAdaptiveDemux * demux, GstM3U8 * playlist,
 
   hlsdemux_stream->do_typefind = TRUE;
   hlsdemux_stream->reset_pts = TRUE;
+
+  g_mutex_init (&hlsdemux_stream->decrypt_lock);
+  g_cond_init (&hlsdemux_stream->decrypt_cond);
+  g_queue_init (&hlsdemux_stream->decrypted_buffers);
+  /* Limited to a single thread so batches are processed in order, as CBC
+   * decryption requires */
+  hlsdemux_stream->decrypt_pool =
+      g_thread_pool_new (gst_hls_demux_stream_decrypt_func, hlsdemux_stream,
+      1, FALSE, NULL);
 }
 
 static gboolean
@@ -657,6 +715,26 @@ gst_hls_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
       return FALSE;
     }
   }
+
+  if (demux->low_latency && hlsdemux->current_variant) {
+    GstHLSVariantStream *current = hlsdemux->current_variant;
+    gint i;
+
+    GST_DEBUG_OBJECT (demux, "Starting %" GST_TIME_FORMAT
+        " from the live edge", GST_TIME_ARGS (demux->target_latency));
+    gst_m3u8_set_live_start_distance (current->m3u8, demux->target_latency);
+    for (i = 0; i < GST_HLS_N_MEDIA_TYPES; ++i) {
+      GList *mlist;
+
+      for (mlist = current->media[i]; mlist != NULL; mlist = mlist->next) {
+        GstHLSMedia *media = mlist->data;
+
+        if (media->uri != NULL)
+          gst_m3u8_set_live_start_distance (media->playlist,
+              demux->target_latency);
+      }
+    }
+  }
   GST_M3U8_CLIENT_UNLOCK (self);
 
   return gst_hls_demux_setup_streams (demux);
@@ -900,31 +978,61 @@ gst_hls_demux_finish_fragment (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);   // FIXME: pass HlsStream into function
+  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
   GstFlowReturn ret = GST_FLOW_OK;
 
-  if (hls_stream->current_key)
+  if (hls_stream->current_key) {
+    gboolean decrypt_failed = gst_hls_demux_stream_decrypt_wait (hls_stream);
+
+    /* Decrypt whatever is left over from the last batch directly, the
+     * worker is idle now so the cipher state is ours */
+    if (stream->last_ret == GST_FLOW_OK && !decrypt_failed
+        && hls_stream->pending_encrypted_data) {
+      gsize size =
+          gst_adapter_available (hls_stream->pending_encrypted_data) & (~0xF);
+
+      if (size > 0) {
+        GstBuffer *buffer;
+
+        buffer =
+            gst_adapter_take_buffer (hls_stream->pending_encrypted_data, size);
+        buffer =
+            gst_hls_demux_decrypt_fragment (hlsdemux, hls_stream, buffer,
+            NULL);
+        if (buffer == NULL)
+          decrypt_failed = TRUE;
+        else
+          g_queue_push_tail (&hls_stream->decrypted_buffers, buffer);
+      }
+    }
+
     gst_hls_demux_stream_decrypt_end (hls_stream);
 
-  if (stream->last_ret == GST_FLOW_OK) {
-    if (hls_stream->pending_decrypted_buffer) {
-      if (hls_stream->current_key) {
+    if (decrypt_failed) {
+      gst_hls_demux_stream_decrypt_error (hlsdemux, hls_stream);
+      ret = GST_FLOW_ERROR;
+    }
+  }
+
+  if (stream->last_ret == GST_FLOW_OK && ret == GST_FLOW_OK) {
+    while (ret == GST_FLOW_OK
+        && !g_queue_is_empty (&hls_stream->decrypted_buffers)) {
+      GstBuffer *buffer = g_queue_pop_head (&hls_stream->decrypted_buffers);
+      gboolean at_eos = g_queue_is_empty (&hls_stream->decrypted_buffers);
+
+      if (at_eos) {
         GstMapInfo info;
         gssize unpadded_size;
 
         /* Handle pkcs7 unpadding here */
-        gst_buffer_map (hls_stream->pending_decrypted_buffer, &info,
-            GST_MAP_READ);
+        gst_buffer_map (buffer, &info, GST_MAP_READ);
         unpadded_size = info.size - info.data[info.size - 1];
-        gst_buffer_unmap (hls_stream->pending_decrypted_buffer, &info);
+        gst_buffer_unmap (buffer, &info);
 
-        gst_buffer_resize (hls_stream->pending_decrypted_buffer, 0,
-            unpadded_size);
+        gst_buffer_resize (buffer, 0, unpadded_size);
       }
 
-      ret =
-          gst_hls_demux_handle_buffer (demux, stream,
-          hls_stream->pending_decrypted_buffer, TRUE);
-      hls_stream->pending_decrypted_buffer = NULL;
+      ret = gst_hls_demux_handle_buffer (demux, stream, buffer, at_eos);
     }
 
     if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED) {
@@ -962,16 +1070,15 @@ gst_hls_demux_data_received (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
   GstHLSDemuxStream *hls_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
-  GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
 
   if (hls_stream->current_offset == -1)
     hls_stream->current_offset = 0;
 
   /* Is it encrypted? */
   if (hls_stream->current_key) {
-    GError *err = NULL;
+    GstFlowReturn ret = GST_FLOW_OK;
+    GList *ready = NULL, *walk;
     gsize size;
-    GstBuffer *tmp_buffer;
 
     if (hls_stream->pending_encrypted_data == NULL)
       hls_stream->pending_encrypted_data = gst_adapter_new ();
@@ -982,23 +1089,47 @@ gst_hls_demux_data_received (GstAdaptiveDemux * demux,
     /* must be a multiple of 16 */
     size &= (~0xF);
 
-    if (size == 0) {
+    if (size < GST_HLS_DEMUX_DECRYPT_BATCH_SIZE) {
       return GST_FLOW_OK;
     }
 
     buffer = gst_adapter_take_buffer (hls_stream->pending_encrypted_data, size);
-    buffer =
-        gst_hls_demux_decrypt_fragment (hlsdemux, hls_stream, buffer, &err);
-    if (buffer == NULL) {
-      GST_ELEMENT_ERROR (demux, STREAM, DECODE, ("Failed to decrypt buffer"),
-          ("decryption failed %s", err->message));
-      g_error_free (err);
+
+    g_mutex_lock (&hls_stream->decrypt_lock);
+    hls_stream->decrypt_pending++;
+    g_thread_pool_push (hls_stream->decrypt_pool, buffer, NULL);
+
+    /* Let the batch we just queued be decrypted while we push out the
+     * previous ones and go back to downloading */
+    while (hls_stream->decrypt_pending > 1)
+      g_cond_wait (&hls_stream->decrypt_cond, &hls_stream->decrypt_lock);
+
+    if (hls_stream->decrypt_failed) {
+      g_mutex_unlock (&hls_stream->decrypt_lock);
+      gst_hls_demux_stream_decrypt_error (GST_HLS_DEMUX_CAST (demux),
+          hls_stream);
       return GST_FLOW_ERROR;
     }
 
-    tmp_buffer = hls_stream->pending_decrypted_buffer;
-    hls_stream->pending_decrypted_buffer = buffer;
-    buffer = tmp_buffer;
+    /* If nothing is pending anymore, the newest batch might be the last
+     * one of the fragment, so keep it for unpadding */
+    while (g_queue_get_length (&hls_stream->decrypted_buffers) >
+        (hls_stream->decrypt_pending > 0 ? 0 : 1))
+      ready =
+          g_list_prepend (ready,
+          g_queue_pop_head (&hls_stream->decrypted_buffers));
+    g_mutex_unlock (&hls_stream->decrypt_lock);
+
+    ready = g_list_reverse (ready);
+    for (walk = ready; walk; walk = walk->next) {
+      if (ret == GST_FLOW_OK)
+        ret = gst_hls_demux_handle_buffer (demux, stream, walk->data, FALSE);
+      else
+        gst_buffer_unref (walk->data);
+    }
+    g_list_free (ready);
+
+    return ret;
   }
 
   return gst_hls_demux_handle_buffer (demux, stream, buffer, FALSE);
@@ -1014,10 +1145,19 @@ gst_hls_demux_stream_free (GstAdaptiveDemuxStream * stream)
     hls_stream->playlist = NULL;
   }
 
+  if (hls_stream->decrypt_pool) {
+    g_thread_pool_free (hls_stream->decrypt_pool, FALSE, TRUE);
+    hls_stream->decrypt_pool = NULL;
+  }
+  g_queue_foreach (&hls_stream->decrypted_buffers, (GFunc) gst_buffer_unref,
+      NULL);
+  g_queue_clear (&hls_stream->decrypted_buffers);
+  g_mutex_clear (&hls_stream->decrypt_lock);
+  g_cond_clear (&hls_stream->decrypt_cond);
+
   if (hls_stream->pending_encrypted_data)
     g_object_unref (hls_stream->pending_encrypted_data);
 
-  gst_buffer_replace (&hls_stream->pending_decrypted_buffer, NULL);
   gst_buffer_replace (&hls_stream->pending_typefind_buffer, NULL);
   gst_buffer_replace (&hls_stream->pending_pcr_buffer, NULL);
 
@@ -1752,8 +1892,13 @@ decrypt_fragment (GstHLSDemuxStream * stream, gsize length,
 {
   gcry_error_t err = 0;
 
-  err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
-      encrypted_data, length);
+  /* libgcrypt wants NULL input for in-place operation */
+  if (encrypted_data == decrypted_data)
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length, NULL,
+        0);
+  else
+    err = gcry_cipher_decrypt (stream->aes_ctx, decrypted_data, length,
+        encrypted_data, length);
 
   return err == 0;
 }
@@ -1768,46 +1913,76 @@ gst_hls_demux_stream_decrypt_end (GstHLSDemuxStream * stream)
 }
 #endif
 
+/* Decrypts @encrypted_buffer in place. The data taken out of the adapter
+ * is usually not shared, so no copy happens here */
 static GstBuffer *
 gst_hls_demux_decrypt_fragment (GstHLSDemux * demux, GstHLSDemuxStream * stream,
     GstBuffer * encrypted_buffer, GError ** err)
 {
-  GstBuffer *decrypted_buffer = NULL;
-  GstMapInfo encrypted_info, decrypted_info;
+  GstBuffer *buffer;
+  GstMapInfo info;
 
-  decrypted_buffer =
-      gst_buffer_new_allocate (NULL, gst_buffer_get_size (encrypted_buffer),
-      NULL);
+  buffer = gst_buffer_make_writable (encrypted_buffer);
 
-  gst_buffer_map (encrypted_buffer, &encrypted_info, GST_MAP_READ);
-  gst_buffer_map (decrypted_buffer, &decrypted_info, GST_MAP_WRITE);
+  if (!gst_buffer_map (buffer, &info, GST_MAP_READWRITE))
+    goto map_error;
 
-  if (!decrypt_fragment (stream, encrypted_info.size,
-          encrypted_info.data, decrypted_info.data))
+  if (!decrypt_fragment (stream, info.size, info.data, info.data))
     goto decrypt_error;
 
+  gst_buffer_unmap (buffer, &info);
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
-
-  return decrypted_buffer;
+  return buffer;
 
 decrypt_error:
+  gst_buffer_unmap (buffer, &info);
+map_error:
   GST_ERROR_OBJECT (demux, "Failed to decrypt fragment");
   g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_DECRYPT,
       "Failed to decrypt fragment");
 
-  gst_buffer_unmap (decrypted_buffer, &decrypted_info);
-  gst_buffer_unmap (encrypted_buffer, &encrypted_info);
-
-  gst_buffer_unref (encrypted_buffer);
-  gst_buffer_unref (decrypted_buffer);
+  gst_buffer_unref (buffer);
 
   return NULL;
 }
 
+static void
+gst_hls_demux_stream_decrypt_func (gpointer data, gpointer user_data)
+{
+  GstHLSDemuxStream *stream = user_data;
+  GstHLSDemux *demux =
+      GST_HLS_DEMUX_CAST (GST_ADAPTIVE_DEMUX_STREAM_CAST (stream)->demux);
+  GstBuffer *buffer = data;
+  GError *err = NULL;
+  gboolean failed;
+
+  g_mutex_lock (&stream->decrypt_lock);
+  failed = stream->decrypt_failed;
+  g_mutex_unlock (&stream->decrypt_lock);
+
+  /* Once the cipher state is broken, there is no point in continuing */
+  if (failed) {
+    gst_buffer_unref (buffer);
+    buffer = NULL;
+  } else {
+    buffer = gst_hls_demux_decrypt_fragment (demux, stream, buffer, &err);
+  }
+
+  g_mutex_lock (&stream->decrypt_lock);
+  if (buffer) {
+    g_queue_push_tail (&stream->decrypted_buffers, buffer);
+  } else {
+    if (err)
+      GST_WARNING_OBJECT (demux, "decryption failed: %s", err->message);
+    stream->decrypt_failed = TRUE;
+  }
+  stream->decrypt_pending--;
+  g_cond_broadcast (&stream->decrypt_cond);
+  g_mutex_unlock (&stream->decrypt_lock);
+
+  g_clear_error (&err);
+}
+
 static gint64
 gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
 {
@@ -94,8 +94,19 @@ struct _GstHLSDemuxStream
   GstBuffer *pending_typefind_buffer; /* for collecting data until typefind succeeds */
 
   GstAdapter *pending_encrypted_data;  /* for chunking data into 16 byte multiples for decryption */
-  GstBuffer *pending_decrypted_buffer; /* last decrypted buffer for pkcs7 unpadding.
-                                          We only know that it is the last at EOS */
+
+  /* Encrypted data is decrypted in place, in batches of at least
+   * GST_HLS_DEMUX_DECRYPT_BATCH_SIZE bytes, on a worker thread so that
+   * decryption of one batch overlaps with downloading the next one */
+  GThreadPool *decrypt_pool;
+  GMutex     decrypt_lock;
+  GCond      decrypt_cond;
+  guint      decrypt_pending;          /* batches queued to decrypt_pool */
+  gboolean   decrypt_failed;           /* protected by decrypt_lock */
+  gboolean   decrypt_error_posted;     /* protected by decrypt_lock */
+  GQueue     decrypted_buffers;        /* decrypted batches in stream order. The
+                                          last one is kept for pkcs7 unpadding
+                                          as we only know that it is the last at EOS */
   guint64 current_offset;              /* offset we're currently at */
   gboolean reset_pts;
 
@@ -87,6 +87,7 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans);
 static GstPad *gst_hls_sink2_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 static void gst_hls_sink2_release_pad (GstElement * element, GstPad * pad);
+static void gst_hls_sink2_io_func (gpointer data, gpointer user_data);
 
 static void
 gst_hls_sink2_dispose (GObject * object)
@@ -110,6 +111,15 @@ gst_hls_sink2_finalize (GObject * object)
   g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
   g_queue_clear (&sink->old_locations);
 
+  /* waits for pending I/O to complete */
+  g_thread_pool_free (sink->io_pool, FALSE, TRUE);
+  g_free (sink->io_playlist);
+  g_free (sink->io_playlist_location);
+  g_queue_foreach (&sink->io_removals, (GFunc) g_free, NULL);
+  g_queue_clear (&sink->io_removals);
+  g_mutex_clear (&sink->io_lock);
+  g_cond_clear (&sink->io_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) sink);
 }
 
@@ -191,6 +201,13 @@ gst_hls_sink2_init (GstHlsSink2 * sink)
   sink->target_duration = DEFAULT_TARGET_DURATION;
   g_queue_init (&sink->old_locations);
 
+  g_mutex_init (&sink->io_lock);
+  g_cond_init (&sink->io_cond);
+  g_queue_init (&sink->io_removals);
+  /* a single thread, so that playlists are published in order */
+  sink->io_pool =
+      g_thread_pool_new (gst_hls_sink2_io_func, sink, 1, FALSE, NULL);
+
   sink->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
   gst_bin_add (GST_BIN (sink), sink->splitmuxsink);
 
@@ -220,22 +237,87 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
 }
 
 static void
-gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
+gst_hls_sink2_io_func (gpointer data, gpointer user_data)
+{
+  GstHlsSink2 *sink = user_data;
+
+  g_mutex_lock (&sink->io_lock);
+  while (sink->io_playlist || !g_queue_is_empty (&sink->io_removals)) {
+    gchar *playlist_content = sink->io_playlist;
+    gchar *playlist_location = sink->io_playlist_location;
+    GQueue removals = sink->io_removals;
+    gchar *old_location;
+
+    /* only the most recent playlist is written if several were queued
+     * in the meantime */
+    sink->io_playlist = NULL;
+    sink->io_playlist_location = NULL;
+    g_queue_init (&sink->io_removals);
+    g_mutex_unlock (&sink->io_lock);
+
+    if (playlist_content) {
+      GError *error = NULL;
+
+      /* g_file_set_contents() writes to a temporary file and renames it,
+       * so clients never see a partially written playlist */
+      if (!g_file_set_contents (playlist_location, playlist_content, -1,
+              &error)) {
+        GST_ERROR ("Failed to write playlist: %s", error->message);
+        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+            (("Failed to write playlist '%s'."), error->message), (NULL));
+        g_error_free (error);
+        error = NULL;
+      }
+      g_free (playlist_content);
+      g_free (playlist_location);
+    }
+
+    /* segments are only removed once a playlist not referencing them
+     * anymore was published */
+    while ((old_location = g_queue_pop_head (&removals))) {
+      g_remove (old_location);
+      g_free (old_location);
+    }
+
+    g_mutex_lock (&sink->io_lock);
+  }
+  sink->io_scheduled = FALSE;
+  g_cond_broadcast (&sink->io_cond);
+  g_mutex_unlock (&sink->io_lock);
+}
+
+/* Takes ownership of @old_locations' contents */
+static void
+gst_hls_sink2_write_playlist (GstHlsSink2 * sink, GQueue * old_locations)
 {
   char *playlist_content;
-  GError *error = NULL;
+  gchar *old_location;
 
   playlist_content = gst_m3u8_playlist_render (sink->playlist);
-  if (!g_file_set_contents (sink->playlist_location,
-          playlist_content, -1, &error)) {
-    GST_ERROR ("Failed to write playlist: %s", error->message);
-    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
-        (("Failed to write playlist '%s'."), error->message), (NULL));
-    g_error_free (error);
-    error = NULL;
+
+  g_mutex_lock (&sink->io_lock);
+  g_free (sink->io_playlist);
+  g_free (sink->io_playlist_location);
+  sink->io_playlist = playlist_content;
+  sink->io_playlist_location = g_strdup (sink->playlist_location);
+  while (old_locations && (old_location = g_queue_pop_head (old_locations)))
+    g_queue_push_tail (&sink->io_removals, old_location);
+
+  if (!sink->io_scheduled) {
+    sink->io_scheduled = TRUE;
+    g_thread_pool_push (sink->io_pool, GINT_TO_POINTER (1), NULL);
   }
-  g_free (playlist_content);
+  g_mutex_unlock (&sink->io_lock);
+}
 
+/* Waits until all queued playlists and segment removals are done */
+static void
+gst_hls_sink2_wait_io (GstHlsSink2 * sink)
+{
+  g_mutex_lock (&sink->io_lock);
+  while (sink->io_scheduled)
+    g_cond_wait (&sink->io_cond, &sink->io_lock);
+  g_mutex_unlock (&sink->io_lock);
 }
 
 static void
@@ -257,6 +339,7 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
         } else if (gst_structure_has_name (s, "splitmuxsink-fragment-closed")) {
           GstClockTime running_time;
           gchar *entry_location;
+          GQueue removals = G_QUEUE_INIT;
 
           g_assert (strcmp (sink->current_location, gst_structure_get_string (s,
                       "location")) == 0);
@@ -277,24 +360,25 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
               sink->index++, FALSE);
           g_free (entry_location);
 
-          gst_hls_sink2_write_playlist (sink);
-
           g_queue_push_tail (&sink->old_locations,
               g_strdup (sink->current_location));
 
           while (g_queue_get_length (&sink->old_locations) >
               g_queue_get_length (sink->playlist->entries)) {
-            gchar *old_location = g_queue_pop_head (&sink->old_locations);
-            g_remove (old_location);
-            g_free (old_location);
+            g_queue_push_tail (&removals,
+                g_queue_pop_head (&sink->old_locations));
           }
+
+          gst_hls_sink2_write_playlist (sink, &removals);
         }
       }
       break;
     }
     case GST_MESSAGE_EOS:{
       sink->playlist->end_list = TRUE;
-      gst_hls_sink2_write_playlist (sink);
+      gst_hls_sink2_write_playlist (sink, NULL);
+      /* the final playlist is on disk once EOS is posted */
+      gst_hls_sink2_wait_io (sink);
       break;
     }
     default:
@@ -389,6 +473,7 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_hls_sink2_wait_io (sink);
       gst_hls_sink2_reset (sink);
       break;
     default:
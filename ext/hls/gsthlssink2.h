@@ -54,6 +54,17 @@ struct _GstHlsSink2
   gchar *current_location;
   GstClockTime current_running_time_start;
   GQueue old_locations;
+
+  /* Playlist publishing and deletion of old segments happen on a
+   * background thread, so that closing a fragment never waits for
+   * the filesystem */
+  GThreadPool *io_pool;
+  GMutex io_lock;
+  GCond io_cond;
+  gchar *io_playlist;
+  gchar *io_playlist_location;
+  GQueue io_removals;
+  gboolean io_scheduled;
 };
 
 struct _GstHlsSink2Class
@@ -40,6 +40,9 @@ struct _GstM3U8Entry
   gchar *title;
   gchar *url;
   gboolean discontinuous;
+
+  /* length of this entry's lines in the rendered entries */
+  gsize rendered_len;
 };
 
 static GstM3U8Entry *
@@ -80,6 +83,7 @@ gst_m3u8_playlist_new (guint version, guint window_size, gboolean allow_cache)
   playlist->type = GST_M3U8_PLAYLIST_TYPE_EVENT;
   playlist->end_list = FALSE;
   playlist->entries = g_queue_new ();
+  playlist->rendered_entries = g_string_new (NULL);
 
   return playlist;
 }
@@ -91,10 +95,37 @@ gst_m3u8_playlist_free (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_free (playlist->entries);
+  g_string_free (playlist->rendered_entries, TRUE);
   g_free (playlist);
 }
 
 
+static void
+gst_m3u8_playlist_render_entry (GstM3U8Playlist * playlist,
+    GstM3U8Entry * entry)
+{
+  GString *str = playlist->rendered_entries;
+  gsize start = str->len;
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  if (entry->discontinuous)
+    g_string_append (str, "#EXT-X-DISCONTINUITY\n");
+
+  if (playlist->version < 3) {
+    g_string_append_printf (str, "#EXTINF:%d,%s\n",
+        (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
+        entry->title ? entry->title : "");
+  } else {
+    g_string_append_printf (str, "#EXTINF:%s,%s\n",
+        g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
+        entry->title ? entry->title : "");
+  }
+
+  g_string_append_printf (str, "%s\n", entry->url);
+
+  entry->rendered_len = str->len - start;
+}
+
 gboolean
 gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
     const gchar * url, const gchar * title,
@@ -116,6 +147,7 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
       GstM3U8Entry *old_entry;
 
       old_entry = g_queue_pop_head (playlist->entries);
+      g_string_erase (playlist->rendered_entries, 0, old_entry->rendered_len);
       gst_m3u8_entry_free (old_entry);
     }
   }
@@ -123,6 +155,10 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
   playlist->sequence_number = index + 1;
   g_queue_push_tail (playlist->entries, entry);
 
+  /* Entries are rendered only once, when they are added, so that
+   * rendering the whole playlist after each new fragment stays cheap */
+  gst_m3u8_playlist_render_entry (playlist, entry);
+
   return TRUE;
 }
 
@@ -146,11 +182,11 @@ gchar *
 gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 {
   GString *playlist_str;
-  GList *l;
 
   g_return_val_if_fail (playlist != NULL, NULL);
 
-  playlist_str = g_string_new ("#EXTM3U\n");
+  playlist_str = g_string_sized_new (playlist->rendered_entries->len + 256);
+  g_string_append (playlist_str, "#EXTM3U\n");
 
   g_string_append_printf (playlist_str, "#EXT-X-VERSION:%d\n",
       playlist->version);
@@ -166,25 +202,8 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
   g_string_append (playlist_str, "\n");
 
   /* Entries */
-  for (l = playlist->entries->head; l != NULL; l = l->next) {
-    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
-    GstM3U8Entry *entry = l->data;
-
-    if (entry->discontinuous)
-      g_string_append (playlist_str, "#EXT-X-DISCONTINUITY\n");
-
-    if (playlist->version < 3) {
-      g_string_append_printf (playlist_str, "#EXTINF:%d,%s\n",
-          (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
-          entry->title ? entry->title : "");
-    } else {
-      g_string_append_printf (playlist_str, "#EXTINF:%s,%s\n",
-          g_ascii_dtostr (buf, sizeof (buf), entry->duration / GST_SECOND),
-          entry->title ? entry->title : "");
-    }
-
-    g_string_append_printf (playlist_str, "%s\n", entry->url);
-  }
+  g_string_append_len (playlist_str, playlist->rendered_entries->str,
+      playlist->rendered_entries->len);
 
   if (playlist->end_list)
     g_string_append (playlist_str, "#EXT-X-ENDLIST");
@@ -39,6 +39,7 @@ struct _GstM3U8Playlist
 
   /*< Private >*/
   GQueue *entries;
+  GString *rendered_entries;
 };
 
 
@@ -48,6 +48,7 @@ gst_m3u8_new (void)
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->live_start_distance = GST_CLOCK_TIME_NONE;
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -441,6 +442,48 @@ gst_m3u8_update_check_consistent_media_seqnums (GstM3U8 * self,
   return TRUE;
 }
 
+/* call with M3U8_LOCK held */
+static GList *
+gst_m3u8_find_live_start_file (GstM3U8 * self, GstClockTime * position)
+{
+  GList *file;
+  GstClockTime sequence_pos = 0;
+
+  file = g_list_last (self->files);
+
+  if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
+    sequence_pos =
+        self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (self->live_start_distance)) {
+    GstClockTime distance = GST_M3U8_MEDIA_FILE (file->data)->duration;
+
+    /* start with as little data ahead of us as the requested distance to
+     * the end of the playlist allows */
+    while (distance < self->live_start_distance && file->prev &&
+        GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos) {
+      file = file->prev;
+      sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+      distance += GST_M3U8_MEDIA_FILE (file->data)->duration;
+    }
+  } else {
+    gint i;
+
+    /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
+     * the end of the playlist. See section 6.3.3 of HLS draft */
+    for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
+        GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
+        ++i) {
+      file = file->prev;
+      sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
+    }
+  }
+
+  *position = sequence_pos;
+  return file;
+}
+
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
@@ -762,25 +805,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
     GList *file;
 
     if (GST_M3U8_IS_LIVE (self)) {
-      gint i;
-      GstClockTime sequence_pos = 0;
-
-      file = g_list_last (self->files);
-
-      if (self->last_file_end >= GST_M3U8_MEDIA_FILE (file->data)->duration) {
-        sequence_pos =
-            self->last_file_end - GST_M3U8_MEDIA_FILE (file->data)->duration;
-      }
-
-      /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
-       * the end of the playlist. See section 6.3.3 of HLS draft */
-      for (i = 0; i < GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE && file->prev &&
-          GST_M3U8_MEDIA_FILE (file->prev->data)->duration <= sequence_pos;
-          ++i) {
-        file = file->prev;
-        sequence_pos -= GST_M3U8_MEDIA_FILE (file->data)->duration;
-      }
-      self->sequence_position = sequence_pos;
+      file = gst_m3u8_find_live_start_file (self, &self->sequence_position);
     } else {
       file = g_list_first (self->files);
       self->sequence_position = 0;
@@ -1175,6 +1200,28 @@ out:
   return (duration > 0);
 }
 
+/* Makes live playback start @distance from the end of the playlist. Must be
+ * called before the first fragment is requested; if the playlist was already
+ * parsed, its initial position is moved accordingly */
+void
+gst_m3u8_set_live_start_distance (GstM3U8 * m3u8, GstClockTime distance)
+{
+  g_return_if_fail (m3u8 != NULL);
+
+  GST_M3U8_LOCK (m3u8);
+  m3u8->live_start_distance = distance;
+
+  if (GST_M3U8_IS_LIVE (m3u8) && m3u8->files && m3u8->sequence != -1) {
+    GList *file;
+
+    file = gst_m3u8_find_live_start_file (m3u8, &m3u8->sequence_position);
+    m3u8->current_file = file;
+    m3u8->sequence = GST_M3U8_MEDIA_FILE (file->data)->sequence;
+    GST_DEBUG ("new first sequence: %u", (guint) m3u8->sequence);
+  }
+  GST_M3U8_UNLOCK (m3u8);
+}
+
 GstHLSMedia *
 gst_hls_media_ref (GstHLSMedia * media)
 {
@@ -75,6 +75,8 @@ struct _GstM3U8
   GstClockTime last_file_end;         /* timecode of the end of the last fragment in the current media playlist */
   GstClockTime duration;              /* cached total duration */
   gint discont_sequence;              /* currently expected EXT-X-DISCONTINUITY-SEQUENCE */
+  GstClockTime live_start_distance;   /* if valid, start live playback this far from the end
+                                       * instead of GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE fragments */
 
   /*< private > */
   gchar *last_data;
@@ -138,6 +140,9 @@ gboolean           gst_m3u8_get_seek_range       (GstM3U8 * m3u8,
                                                   gint64  * start,
                                                   gint64  * stop);
 
+void               gst_m3u8_set_live_start_distance (GstM3U8      * m3u8,
+                                                     GstClockTime   distance);
+
 typedef enum
 {
   GST_HLS_MEDIA_TYPE_INVALID = -1,
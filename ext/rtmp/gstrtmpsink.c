@@ -28,6 +28,15 @@
  * for librtmp, such as 'flashver=version'. See the librtmp documentation
  * for more detail
  *
+ * The data is written to the server from a separate thread. By default every
+ * buffer is still only acknowledged once it has been written. With
+ * #GstRTMPSink:max-queue-bytes set, buffers are queued instead, so that a
+ * stalled connection does not block upstream until the queue is full. What
+ * happens then is up to #GstRTMPSink:drop-policy: upstream waits, or video
+ * inter frames, and then other tags, are dropped. Everything that was queued
+ * while a write was ongoing is sent with the next write. The
+ * #GstRTMPSink:stats property reports the queue level and the send rate.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v videotestsrc ! ffenc_flv ! flvmux ! rtmpsink location='rtmp://localhost/path/to/stream live=1'
@@ -49,17 +58,66 @@
 
 #include <stdlib.h>
 
+#ifndef G_OS_WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_rtmp_sink_debug);
 #define GST_CAT_DEFAULT gst_rtmp_sink_debug
 
 #define DEFAULT_LOCATION NULL
+#define DEFAULT_MAX_QUEUE_BYTES 0
+#define DEFAULT_DROP_POLICY GST_RTMP_SINK_DROP_NONE
+
+/* upper limit for the tags written with a single RTMP_Write () call */
+#define MAX_BATCH_BYTES (64 * 1024)
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_MAX_QUEUE_BYTES,
+  PROP_DROP_POLICY,
+  PROP_STATS
 };
 
+/* What a queued buffer carries, as far as dropping it is concerned */
+typedef enum
+{
+  GST_RTMP_SINK_TAG_OTHER,
+  GST_RTMP_SINK_TAG_AUDIO,
+  GST_RTMP_SINK_TAG_VIDEO_KEY,
+  GST_RTMP_SINK_TAG_VIDEO_DELTA
+} GstRTMPSinkTagKind;
+
+typedef struct
+{
+  GstBuffer *buffer;
+  GstRTMPSinkTagKind kind;
+} GstRTMPSinkQueueItem;
+
+#define GST_TYPE_RTMP_SINK_DROP_POLICY (gst_rtmp_sink_drop_policy_get_type ())
+static GType
+gst_rtmp_sink_drop_policy_get_type (void)
+{
+  static GType drop_policy_type = 0;
+  static const GEnumValue drop_policy[] = {
+    {GST_RTMP_SINK_DROP_NONE, "Never drop, wait for the queue", "none"},
+    {GST_RTMP_SINK_DROP_DELTA, "Drop video inter frames", "delta"},
+    {GST_RTMP_SINK_DROP_ALL,
+        "Drop video inter frames, then audio and video keyframes", "all"},
+    {0, NULL, NULL},
+  };
+
+  if (!drop_policy_type) {
+    drop_policy_type =
+        g_enum_register_static ("GstRTMPSinkDropPolicy", drop_policy);
+  }
+  return drop_policy_type;
+}
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -75,6 +133,8 @@ static void gst_rtmp_sink_get_property (GObject * object, guint prop_id,
 static void gst_rtmp_sink_finalize (GObject * object);
 static gboolean gst_rtmp_sink_stop (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_start (GstBaseSink * sink);
+static gboolean gst_rtmp_sink_unlock (GstBaseSink * sink);
+static gboolean gst_rtmp_sink_unlock_stop (GstBaseSink * sink);
 static gboolean gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event);
 static gboolean gst_rtmp_sink_setcaps (GstBaseSink * sink, GstCaps * caps);
 static GstFlowReturn gst_rtmp_sink_render (GstBaseSink * sink, GstBuffer * buf);
@@ -103,6 +163,22 @@ gst_rtmp_sink_class_init (GstRTMPSinkClass * klass)
   g_object_class_install_property (gobject_class, PROP_LOCATION,
       g_param_spec_string ("location", "RTMP Location", "RTMP url",
           DEFAULT_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint ("max-queue-bytes", "Max. queue bytes",
+          "Number of bytes that can be queued for the writer thread "
+          "(0 = wait until each buffer has been written)",
+          0, G_MAXUINT, DEFAULT_MAX_QUEUE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_DROP_POLICY,
+      g_param_spec_enum ("drop-policy", "Drop policy",
+          "What to drop, if anything, when max-queue-bytes is reached",
+          GST_TYPE_RTMP_SINK_DROP_POLICY, DEFAULT_DROP_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Send statistics (bytes and buffers sent, buffers dropped, number "
+          "of writes, queue level and average bitrate)", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "RTMP output sink",
@@ -113,6 +189,9 @@ gst_rtmp_sink_class_init (GstRTMPSinkClass * klass)
 
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_rtmp_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_rtmp_sink_stop);
+  gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_rtmp_sink_unlock);
+  gstbasesink_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_rtmp_sink_unlock_stop);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_rtmp_sink_render);
   gstbasesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_rtmp_sink_setcaps);
   gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_rtmp_sink_event);
@@ -134,6 +213,12 @@ gst_rtmp_sink_init (GstRTMPSink * sink)
     GST_ERROR_OBJECT (sink, "WSAStartup failed: 0x%08x", WSAGetLastError ());
   }
 #endif
+
+  g_cond_init (&sink->queue_cond);
+  g_queue_init (&sink->queue);
+  sink->max_queue_bytes = DEFAULT_MAX_QUEUE_BYTES;
+  sink->drop_policy = DEFAULT_DROP_POLICY;
+  sink->batch = g_byte_array_new ();
 }
 
 static void
@@ -145,11 +230,407 @@ gst_rtmp_sink_finalize (GObject * object)
   WSACleanup ();
 #endif
   g_free (sink->uri);
+  g_cond_clear (&sink->queue_cond);
+  g_byte_array_unref (sink->batch);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 
+static void
+gst_rtmp_sink_queue_item_free (GstRTMPSinkQueueItem * item)
+{
+  gst_buffer_unref (item->buffer);
+  g_slice_free (GstRTMPSinkQueueItem, item);
+}
+
+/* Buffers from flvmux hold one FLV tag each, look at the tag type and, for
+ * video, at the frame type in the upper nibble of the first body byte */
+static GstRTMPSinkTagKind
+gst_rtmp_sink_get_tag_kind (GstBuffer * buf)
+{
+  guint8 data[12];
+
+  if (gst_buffer_extract (buf, 0, data, sizeof (data)) < sizeof (data))
+    return GST_RTMP_SINK_TAG_OTHER;
+
+  switch (data[0] & 0x1f) {
+    case 8:
+      return GST_RTMP_SINK_TAG_AUDIO;
+    case 9:
+      /* 2 = inter frame, 3 = disposable inter frame */
+      if ((data[11] >> 4) == 2 || (data[11] >> 4) == 3)
+        return GST_RTMP_SINK_TAG_VIDEO_DELTA;
+      return GST_RTMP_SINK_TAG_VIDEO_KEY;
+    default:
+      return GST_RTMP_SINK_TAG_OTHER;
+  }
+}
+
+static void
+gst_rtmp_sink_queue_remove_unlocked (GstRTMPSink * sink, GList * link)
+{
+  GstRTMPSinkQueueItem *item = link->data;
+
+  sink->queued_bytes -= gst_buffer_get_size (item->buffer);
+  sink->buffers_dropped++;
+  g_queue_delete_link (&sink->queue, link);
+  gst_rtmp_sink_queue_item_free (item);
+}
+
+/* Drops the oldest queued video inter frame or, unless @delta_only, the
+ * oldest audio tag or video keyframe. The inter frames following a dropped
+ * video frame go as well, up to the next keyframe. Returns FALSE if there
+ * was nothing to drop */
+static gboolean
+gst_rtmp_sink_queue_drop_unlocked (GstRTMPSink * sink, gboolean delta_only)
+{
+  GstRTMPSinkQueueItem *item = NULL;
+  GList *l, *next;
+  gboolean video;
+
+  for (l = sink->queue.head; l != NULL; l = l->next) {
+    item = l->data;
+
+    if (item->kind == GST_RTMP_SINK_TAG_VIDEO_DELTA)
+      break;
+    if (!delta_only && (item->kind == GST_RTMP_SINK_TAG_AUDIO ||
+            item->kind == GST_RTMP_SINK_TAG_VIDEO_KEY))
+      break;
+  }
+
+  if (l == NULL)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (sink, "queue full, dropping %s",
+      item->kind == GST_RTMP_SINK_TAG_AUDIO ? "audio tag" :
+      item->kind == GST_RTMP_SINK_TAG_VIDEO_KEY ? "video keyframe" :
+      "video inter frame");
+
+  video = item->kind != GST_RTMP_SINK_TAG_AUDIO;
+  next = l->next;
+  gst_rtmp_sink_queue_remove_unlocked (sink, l);
+
+  if (video) {
+    for (l = next; l != NULL; l = next) {
+      item = l->data;
+      next = l->next;
+
+      if (item->kind == GST_RTMP_SINK_TAG_VIDEO_KEY)
+        break;
+      if (item->kind == GST_RTMP_SINK_TAG_VIDEO_DELTA)
+        gst_rtmp_sink_queue_remove_unlocked (sink, l);
+    }
+
+    /* no keyframe queued, drop new inter frames until the next one */
+    if (l == NULL)
+      sink->skip_to_keyframe = TRUE;
+  }
+
+  return TRUE;
+}
+
+/* Takes ownership of @buf */
+static GstFlowReturn
+gst_rtmp_sink_queue_buffer_unlocked (GstRTMPSink * sink, GstBuffer * buf,
+    GstRTMPSinkTagKind kind)
+{
+  GstRTMPSinkQueueItem *item;
+  gsize size = gst_buffer_get_size (buf);
+
+  if (kind == GST_RTMP_SINK_TAG_VIDEO_DELTA && sink->skip_to_keyframe)
+    goto drop;
+
+  /* an empty queue always accepts a buffer, so that buffers bigger than
+   * max-queue-bytes still get through */
+  while (sink->max_queue_bytes > 0 && sink->queued_bytes > 0 &&
+      (guint64) sink->queued_bytes + size > sink->max_queue_bytes) {
+    if (sink->drop_policy != GST_RTMP_SINK_DROP_NONE) {
+      /* nothing queued depends on a new inter frame */
+      if (kind == GST_RTMP_SINK_TAG_VIDEO_DELTA) {
+        sink->skip_to_keyframe = TRUE;
+        goto drop;
+      }
+      if (gst_rtmp_sink_queue_drop_unlocked (sink, TRUE))
+        continue;
+      if (sink->drop_policy == GST_RTMP_SINK_DROP_ALL &&
+          gst_rtmp_sink_queue_drop_unlocked (sink, FALSE))
+        continue;
+    }
+
+    if (sink->flushing) {
+      gst_buffer_unref (buf);
+      return GST_FLOW_FLUSHING;
+    }
+    if (sink->have_write_error) {
+      gst_buffer_unref (buf);
+      return GST_FLOW_ERROR;
+    }
+
+    GST_LOG_OBJECT (sink, "queue full (%u bytes), waiting",
+        sink->queued_bytes);
+    g_cond_wait (&sink->queue_cond, GST_OBJECT_GET_LOCK (sink));
+  }
+
+  if (kind == GST_RTMP_SINK_TAG_VIDEO_KEY)
+    sink->skip_to_keyframe = FALSE;
+
+  item = g_slice_new (GstRTMPSinkQueueItem);
+  item->buffer = buf;
+  item->kind = kind;
+  g_queue_push_tail (&sink->queue, item);
+  sink->queued_bytes += size;
+
+  GST_LOG_OBJECT (sink, "queued %" G_GSIZE_FORMAT " bytes, %u bytes in queue",
+      size, sink->queued_bytes);
+
+  g_cond_broadcast (&sink->queue_cond);
+
+  return GST_FLOW_OK;
+
+drop:
+  GST_LOG_OBJECT (sink, "dropping video inter frame");
+  sink->buffers_dropped++;
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static void
+gst_rtmp_sink_queue_flush_unlocked (GstRTMPSink * sink)
+{
+  GstRTMPSinkQueueItem *item;
+
+  while ((item = g_queue_pop_head (&sink->queue)) != NULL)
+    gst_rtmp_sink_queue_item_free (item);
+  sink->queued_bytes = 0;
+  sink->skip_to_keyframe = FALSE;
+}
+
+/* Waits until the writer thread has written everything queued */
+static void
+gst_rtmp_sink_drain_unlocked (GstRTMPSink * sink)
+{
+  while ((sink->writing || !g_queue_is_empty (&sink->queue)) &&
+      !sink->flushing && !sink->have_write_error)
+    g_cond_wait (&sink->queue_cond, GST_OBJECT_GET_LOCK (sink));
+}
+
+static gboolean
+gst_rtmp_sink_connect (GstRTMPSink * sink)
+{
+  RTMP *rtmp;
+  gboolean stopping;
+
+  if (sink->rtmp == NULL) {
+    /* Do not crash */
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
+    return FALSE;
+  }
+
+  if (RTMP_IsConnected (sink->rtmp))
+    return TRUE;
+
+  if (!RTMP_Connect (sink->rtmp, NULL)
+      || !RTMP_ConnectStream (sink->rtmp, 0)) {
+    /* stop () might be looking at the socket */
+    GST_OBJECT_LOCK (sink);
+    stopping = sink->writer_stop;
+    rtmp = sink->rtmp;
+    sink->rtmp = NULL;
+    GST_OBJECT_UNLOCK (sink);
+    /* not an error if stop () interrupted the connect */
+    if (!stopping)
+      GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+          ("Could not connect to RTMP stream \"%s\" for writing",
+              sink->uri));
+    RTMP_Free (rtmp);
+    g_free (sink->rtmp_uri);
+    sink->rtmp_uri = NULL;
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (sink, "Opened connection to %s", sink->rtmp_uri);
+
+  return TRUE;
+}
+
+/* Holds back partial segments while a batch is written, so that the small
+ * packets librtmp sends for every tag leave in as few segments as possible */
+static void
+gst_rtmp_sink_set_cork (GstRTMPSink * sink, gint cork)
+{
+#ifdef TCP_CORK
+  if (setsockopt (RTMP_Socket (sink->rtmp), IPPROTO_TCP, TCP_CORK, &cork,
+          sizeof (cork)) < 0)
+    GST_LOG_OBJECT (sink, "Could not set TCP_CORK to %d", cork);
+#endif
+}
+
+/* Writes the buffers in @batch with a single RTMP_Write () call, copying
+ * them together if there is more than one */
+static gboolean
+gst_rtmp_sink_write_batch (GstRTMPSink * sink, GQueue * batch)
+{
+  GstRTMPSinkQueueItem *item;
+  GstMapInfo map;
+  GList *l;
+  gboolean ret;
+
+  if (batch->length == 1) {
+    item = batch->head->data;
+
+    if (!gst_buffer_map (item->buffer, &map, GST_MAP_READ))
+      return FALSE;
+
+    GST_LOG_OBJECT (sink, "Sending %" G_GSIZE_FORMAT " bytes to RTMP server",
+        map.size);
+    ret = RTMP_Write (sink->rtmp, (char *) map.data, map.size) > 0;
+    gst_buffer_unmap (item->buffer, &map);
+
+    return ret;
+  }
+
+  g_byte_array_set_size (sink->batch, 0);
+  for (l = batch->head; l != NULL; l = l->next) {
+    item = l->data;
+
+    if (!gst_buffer_map (item->buffer, &map, GST_MAP_READ))
+      return FALSE;
+    g_byte_array_append (sink->batch, map.data, map.size);
+    gst_buffer_unmap (item->buffer, &map);
+  }
+
+  GST_LOG_OBJECT (sink, "Sending %u buffers, %u bytes to RTMP server",
+      batch->length, sink->batch->len);
+
+  gst_rtmp_sink_set_cork (sink, 1);
+  ret = RTMP_Write (sink->rtmp, (char *) sink->batch->data,
+      sink->batch->len) > 0;
+  gst_rtmp_sink_set_cork (sink, 0);
+
+  return ret;
+}
+
+static gpointer
+gst_rtmp_sink_writer_thread (gpointer data)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (data);
+  GQueue batch = G_QUEUE_INIT;
+  GstRTMPSinkQueueItem *item;
+  gboolean connected = FALSE;
+  gsize size;
+  gboolean ret;
+  gint64 now;
+
+  GST_DEBUG_OBJECT (sink, "writer thread started");
+
+  GST_OBJECT_LOCK (sink);
+  for (;;) {
+    while (!sink->writer_stop && g_queue_is_empty (&sink->queue))
+      g_cond_wait (&sink->queue_cond, GST_OBJECT_GET_LOCK (sink));
+
+    if (sink->writer_stop)
+      break;
+
+    sink->writing = TRUE;
+
+    if (!connected) {
+      GST_OBJECT_UNLOCK (sink);
+      ret = connected = gst_rtmp_sink_connect (sink);
+      GST_OBJECT_LOCK (sink);
+      /* stop () might have interrupted the connect */
+      if (sink->writer_stop) {
+        sink->writing = FALSE;
+        break;
+      }
+      if (!ret)
+        goto error;
+    }
+
+    /* take everything queued in the meantime, up to MAX_BATCH_BYTES */
+    size = 0;
+    while ((item = g_queue_peek_head (&sink->queue)) != NULL) {
+      gsize item_size = gst_buffer_get_size (item->buffer);
+
+      if (batch.length > 0 && size + item_size > MAX_BATCH_BYTES)
+        break;
+
+      g_queue_push_tail (&batch, g_queue_pop_head (&sink->queue));
+      sink->queued_bytes -= item_size;
+      size += item_size;
+    }
+
+    /* there is room in the queue again */
+    g_cond_broadcast (&sink->queue_cond);
+    GST_OBJECT_UNLOCK (sink);
+
+    ret = gst_rtmp_sink_write_batch (sink, &batch);
+
+    GST_OBJECT_LOCK (sink);
+    if (ret) {
+      now = g_get_monotonic_time ();
+      if (sink->bytes_sent == 0)
+        sink->first_send_time = now;
+      sink->last_send_time = now;
+      sink->bytes_sent += size;
+      sink->buffers_sent += batch.length;
+      sink->writes++;
+    }
+
+    while ((item = g_queue_pop_head (&batch)) != NULL)
+      gst_rtmp_sink_queue_item_free (item);
+
+    if (!ret) {
+      GST_OBJECT_UNLOCK (sink);
+      GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+          ("Failed to write data"));
+      GST_OBJECT_LOCK (sink);
+      goto error;
+    }
+
+    sink->writing = FALSE;
+    g_cond_broadcast (&sink->queue_cond);
+    continue;
+
+  error:
+    /* render () does not queue anything until the error is cleared */
+    sink->have_write_error = TRUE;
+    gst_rtmp_sink_queue_flush_unlocked (sink);
+    sink->writing = FALSE;
+    g_cond_broadcast (&sink->queue_cond);
+  }
+  GST_OBJECT_UNLOCK (sink);
+
+  GST_DEBUG_OBJECT (sink, "writer thread stopped");
+
+  return NULL;
+}
+
+static GstStructure *
+gst_rtmp_sink_create_stats (GstRTMPSink * sink)
+{
+  GstStructure *s;
+  guint64 bitrate = 0;
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->last_send_time > sink->first_send_time) {
+    bitrate = gst_util_uint64_scale (sink->bytes_sent * 8, G_USEC_PER_SEC,
+        sink->last_send_time - sink->first_send_time);
+  }
+
+  s = gst_structure_new ("application/x-rtmp-sink-stats",
+      "bytes-sent", G_TYPE_UINT64, sink->bytes_sent,
+      "buffers-sent", G_TYPE_UINT64, sink->buffers_sent,
+      "buffers-dropped", G_TYPE_UINT64, sink->buffers_dropped,
+      "writes", G_TYPE_UINT64, sink->writes,
+      "queued-bytes", G_TYPE_UINT, sink->queued_bytes,
+      "queued-buffers", G_TYPE_UINT, sink->queue.length,
+      "bitrate", G_TYPE_UINT64, bitrate, NULL);
+  GST_OBJECT_UNLOCK (sink);
+
+  return s;
+}
+
 static gboolean
 gst_rtmp_sink_start (GstBaseSink * basesink)
 {
@@ -184,6 +665,19 @@ gst_rtmp_sink_start (GstBaseSink * basesink)
   sink->first = TRUE;
   sink->have_write_error = FALSE;
 
+  sink->flushing = FALSE;
+  sink->writer_stop = FALSE;
+  sink->skip_to_keyframe = FALSE;
+  sink->bytes_sent = 0;
+  sink->buffers_sent = 0;
+  sink->buffers_dropped = 0;
+  sink->writes = 0;
+  sink->first_send_time = 0;
+  sink->last_send_time = 0;
+
+  sink->writer_thread = g_thread_new ("rtmpsink-writer",
+      gst_rtmp_sink_writer_thread, sink);
+
   return TRUE;
 
 error:
@@ -201,6 +695,32 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
 {
   GstRTMPSink *sink = GST_RTMP_SINK (basesink);
 
+  if (sink->writer_thread) {
+    GST_OBJECT_LOCK (sink);
+    sink->writer_stop = TRUE;
+    g_cond_broadcast (&sink->queue_cond);
+    /* unblock a connect or a write stuck on a stalled connection. The socket
+     * is valid as soon as a connect is in progress */
+    if (sink->writing && sink->rtmp && RTMP_Socket (sink->rtmp) != -1) {
+      GST_DEBUG_OBJECT (sink, "Shutting down the connection");
+#ifdef G_OS_WIN32
+      shutdown (RTMP_Socket (sink->rtmp), SD_BOTH);
+#else
+      shutdown (RTMP_Socket (sink->rtmp), SHUT_RDWR);
+#endif
+    }
+    GST_OBJECT_UNLOCK (sink);
+
+    g_thread_join (sink->writer_thread);
+    sink->writer_thread = NULL;
+  }
+
+  GST_OBJECT_LOCK (sink);
+  if (sink->queued_bytes > 0)
+    GST_WARNING_OBJECT (sink, "discarding %u queued bytes", sink->queued_bytes);
+  gst_rtmp_sink_queue_flush_unlocked (sink);
+  GST_OBJECT_UNLOCK (sink);
+
   if (sink->header) {
     gst_buffer_unref (sink->header);
     sink->header = NULL;
@@ -218,78 +738,84 @@ gst_rtmp_sink_stop (GstBaseSink * basesink)
   return TRUE;
 }
 
+static gboolean
+gst_rtmp_sink_unlock (GstBaseSink * basesink)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (basesink);
+
+  GST_LOG_OBJECT (sink, "Flushing");
+
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = TRUE;
+  g_cond_broadcast (&sink->queue_cond);
+  GST_OBJECT_UNLOCK (sink);
+
+  return TRUE;
+}
+
+static gboolean
+gst_rtmp_sink_unlock_stop (GstBaseSink * basesink)
+{
+  GstRTMPSink *sink = GST_RTMP_SINK (basesink);
+
+  GST_LOG_OBJECT (sink, "No longer flushing");
+
+  GST_OBJECT_LOCK (sink);
+  sink->flushing = FALSE;
+  GST_OBJECT_UNLOCK (sink);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_rtmp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
   GstRTMPSink *sink = GST_RTMP_SINK (bsink);
-  gboolean need_unref = FALSE;
-  GstMapInfo map = GST_MAP_INFO_INIT;
-
-  if (sink->rtmp == NULL) {
-    /* Do not crash */
-    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
-    return GST_FLOW_ERROR;
-  }
+  GstRTMPSinkTagKind kind;
+  GstFlowReturn ret;
 
   /* Ignore buffers that are in the stream headers (caps) */
   if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER)) {
     return GST_FLOW_OK;
   }
 
-  if (sink->first) {
-    /* open the connection */
-    if (!RTMP_IsConnected (sink->rtmp)) {
-      if (!RTMP_Connect (sink->rtmp, NULL)
-          || !RTMP_ConnectStream (sink->rtmp, 0)) {
-        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
-            ("Could not connect to RTMP stream \"%s\" for writing", sink->uri));
-        RTMP_Free (sink->rtmp);
-        sink->rtmp = NULL;
-        g_free (sink->rtmp_uri);
-        sink->rtmp_uri = NULL;
-        sink->have_write_error = TRUE;
-        return GST_FLOW_ERROR;
-      }
-      GST_DEBUG_OBJECT (sink, "Opened connection to %s", sink->rtmp_uri);
-    }
+  kind = gst_rtmp_sink_get_tag_kind (buf);
 
-    /* Prepend the header from the caps to the first non header buffer */
-    if (sink->header) {
-      buf = gst_buffer_append (gst_buffer_ref (sink->header),
-          gst_buffer_ref (buf));
-      need_unref = TRUE;
-    }
-
-    sink->first = FALSE;
+  if (sink->first && sink->header) {
+    /* Prepend the header from the caps to the first non header buffer,
+     * which must never be dropped */
+    buf = gst_buffer_append (gst_buffer_ref (sink->header),
+        gst_buffer_ref (buf));
+    kind = GST_RTMP_SINK_TAG_OTHER;
+  } else {
+    gst_buffer_ref (buf);
   }
+  sink->first = FALSE;
 
-  if (sink->have_write_error)
-    goto write_failed;
+  GST_OBJECT_LOCK (sink);
+  if (sink->have_write_error) {
+    /* already posted by the writer thread */
+    gst_buffer_unref (buf);
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
 
-  GST_LOG_OBJECT (sink, "Sending %" G_GSIZE_FORMAT " bytes to RTMP server",
-      gst_buffer_get_size (buf));
+  ret = gst_rtmp_sink_queue_buffer_unlocked (sink, buf, kind);
 
-  gst_buffer_map (buf, &map, GST_MAP_READ);
+  /* without a queue, wait for the writer thread to write the data, so that
+   * errors show up on the buffer that caused them */
+  if (ret == GST_FLOW_OK && sink->max_queue_bytes == 0)
+    gst_rtmp_sink_drain_unlocked (sink);
 
-  if (RTMP_Write (sink->rtmp, (char *) map.data, map.size) <= 0)
-    goto write_failed;
+  if (ret == GST_FLOW_OK && sink->flushing)
+    ret = GST_FLOW_FLUSHING;
+  else if (ret == GST_FLOW_OK && sink->have_write_error)
+    ret = GST_FLOW_ERROR;
 
-  gst_buffer_unmap (buf, &map);
-  if (need_unref)
-    gst_buffer_unref (buf);
+done:
+  GST_OBJECT_UNLOCK (sink);
 
-  return GST_FLOW_OK;
-
-  /* ERRORS */
-write_failed:
-  {
-    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL), ("Failed to write data"));
-    gst_buffer_unmap (buf, &map);
-    if (need_unref)
-      gst_buffer_unref (buf);
-    sink->have_write_error = TRUE;
-    return GST_FLOW_ERROR;
-  }
+  return ret;
 }
 
 /*
@@ -386,6 +912,19 @@ gst_rtmp_sink_set_property (GObject * object, guint prop_id,
       gst_rtmp_sink_uri_set_uri (GST_URI_HANDLER (sink),
           g_value_get_string (value), NULL);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      GST_OBJECT_LOCK (sink);
+      sink->max_queue_bytes = g_value_get_uint (value);
+      /* a render () waiting for room might not have to anymore */
+      g_cond_broadcast (&sink->queue_cond);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_DROP_POLICY:
+      GST_OBJECT_LOCK (sink);
+      sink->drop_policy = g_value_get_enum (value);
+      g_cond_broadcast (&sink->queue_cond);
+      GST_OBJECT_UNLOCK (sink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -442,7 +981,15 @@ gst_rtmp_sink_event (GstBaseSink * sink, GstEvent * event)
 
   switch (event->type) {
     case GST_EVENT_FLUSH_STOP:
+      GST_OBJECT_LOCK (rtmpsink);
       rtmpsink->have_write_error = FALSE;
+      GST_OBJECT_UNLOCK (rtmpsink);
+      break;
+    case GST_EVENT_EOS:
+      /* write whatever is still queued before EOS is posted */
+      GST_OBJECT_LOCK (rtmpsink);
+      gst_rtmp_sink_drain_unlocked (rtmpsink);
+      GST_OBJECT_UNLOCK (rtmpsink);
       break;
     default:
       break;
@@ -461,6 +1008,19 @@ gst_rtmp_sink_get_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       g_value_set_string (value, sink->uri);
       break;
+    case PROP_MAX_QUEUE_BYTES:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_uint (value, sink->max_queue_bytes);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_DROP_POLICY:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_enum (value, sink->drop_policy);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_rtmp_sink_create_stats (sink));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
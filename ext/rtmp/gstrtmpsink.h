@@ -44,6 +44,13 @@ G_BEGIN_DECLS
 typedef struct _GstRTMPSink      GstRTMPSink;
 typedef struct _GstRTMPSinkClass GstRTMPSinkClass;
 
+typedef enum
+{
+  GST_RTMP_SINK_DROP_NONE,
+  GST_RTMP_SINK_DROP_DELTA,
+  GST_RTMP_SINK_DROP_ALL
+} GstRTMPSinkDropPolicy;
+
 struct _GstRTMPSink {
   GstBaseSink parent;
 
@@ -56,6 +63,27 @@ struct _GstRTMPSink {
   GstBuffer *header;
   gboolean first;
   gboolean have_write_error;
+
+  /* tags waiting for the writer thread, protected by the object lock */
+  GThread *writer_thread;
+  GCond queue_cond;
+  GQueue queue;
+  guint queued_bytes;
+  guint max_queue_bytes;
+  GstRTMPSinkDropPolicy drop_policy;
+  gboolean skip_to_keyframe;
+  gboolean writing;
+  gboolean flushing;
+  gboolean writer_stop;
+  GByteArray *batch;
+
+  /* statistics */
+  guint64 bytes_sent;
+  guint64 buffers_sent;
+  guint64 buffers_dropped;
+  guint64 writes;
+  gint64 first_send_time;
+  gint64 last_send_time;
 };
 
 struct _GstRTMPSinkClass {
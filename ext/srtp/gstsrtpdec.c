@@ -210,6 +210,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * buf_list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -373,6 +377,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -396,6 +402,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -658,13 +666,12 @@ init_session_stream (GstSrtpDec * filter, guint32 ssrc,
   return ret;
 }
 
-/* Return a stream structure for a given buffer
+/* Get the SSRC of a buffer and whether it is RTCP
  */
-static GstSrtpDecSsrcStream *
-validate_buffer (GstSrtpDec * filter, GstBuffer * buf, guint32 * ssrc,
+static gboolean
+get_buffer_ssrc (GstSrtpDec * filter, GstBuffer * buf, guint32 * ssrc,
     gboolean * is_rtcp)
 {
-  GstSrtpDecSsrcStream *stream = NULL;
   GstRTPBuffer rtpbuf = GST_RTP_BUFFER_INIT;
 
   if (gst_rtp_buffer_map (buf,
@@ -675,7 +682,7 @@ validate_buffer (GstSrtpDec * filter, GstBuffer * buf, guint32 * ssrc,
 
       gst_rtp_buffer_unmap (&rtpbuf);
       *is_rtcp = FALSE;
-      goto have_ssrc;
+      return TRUE;
     }
     gst_rtp_buffer_unmap (&rtpbuf);
   }
@@ -684,10 +691,22 @@ validate_buffer (GstSrtpDec * filter, GstBuffer * buf, guint32 * ssrc,
     *is_rtcp = TRUE;
   } else {
     GST_WARNING_OBJECT (filter, "No SSRC found in buffer");
-    return NULL;
+    return FALSE;
   }
 
-have_ssrc:
+  return TRUE;
+}
+
+/* Return a stream structure for a given buffer
+ */
+static GstSrtpDecSsrcStream *
+validate_buffer (GstSrtpDec * filter, GstBuffer * buf, guint32 * ssrc,
+    gboolean * is_rtcp)
+{
+  GstSrtpDecSsrcStream *stream = NULL;
+
+  if (!get_buffer_ssrc (filter, buf, ssrc, is_rtcp))
+    return NULL;
 
   stream = find_stream_by_ssrc (filter, *ssrc);
 
@@ -1130,30 +1149,31 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 }
 
 /*
- * This function should be called while holding the filter lock
+ * This function should be called while holding the filter lock, and after
+ * gst_srtp_init_event_reporter(). The lock is only released temporarily if
+ * decoding fails. @buffer is replaced by a writable buffer if needed.
  */
 static gboolean
-gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer ** buffer, gboolean is_rtcp, guint32 ssrc)
 {
+  GstBuffer *buf;
   GstMapInfo map;
   err_status_t err;
   gint size;
 
   GST_LOG_OBJECT (pad, "Received %s buffer of size %" G_GSIZE_FORMAT
-      " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
-      ssrc);
+      " with SSRC = %u", is_rtcp ? "RTCP" : "RTP",
+      gst_buffer_get_size (*buffer), ssrc);
 
   /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  buf = *buffer = gst_buffer_make_writable (*buffer);
 
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
 
 unprotect:
 
-  gst_srtp_init_event_reporter ();
-
   if (is_rtcp)
     err = srtp_unprotect_rtcp (filter->session, map.data, &size);
   else {
@@ -1184,9 +1204,9 @@ unprotect:
     err = srtp_unprotect (filter->session, map.data, &size);
   }
 
-  GST_OBJECT_UNLOCK (filter);
-
   if (err != err_status_ok) {
+    GST_OBJECT_UNLOCK (filter);
+
     GST_WARNING_OBJECT (pad,
         "Unable to unprotect buffer (unprotect failed code %d)", err);
 
@@ -1231,10 +1251,28 @@ unprotect:
 
   gst_buffer_set_size (buf, size);
 
-  GST_OBJECT_LOCK (filter);
   return TRUE;
 }
 
+/* Returns the source pad for @is_rtcp, after pushing the sticky events
+ * downstream if that didn't happen yet
+ */
+static GstPad *
+gst_srtp_dec_get_src_pad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  if (is_rtcp) {
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
+  } else {
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
+  }
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1260,7 +1298,9 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
+  gst_srtp_init_event_reporter ();
+
+  if (!gst_srtp_dec_decode_buffer (filter, pad, &buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
   }
@@ -1273,17 +1313,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
+  otherpad = gst_srtp_dec_get_src_pad (filter, is_rtcp);
   ret = gst_pad_push (otherpad, buf);
 
   return ret;
@@ -1296,6 +1326,151 @@ drop_buffer:
   return ret;
 }
 
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+
+  /* last looked up stream, only valid while the lock is held */
+  gboolean have_stream;
+  guint32 ssrc;
+  gboolean has_crypto;
+
+  GArray *soft_limit_ssrcs;
+  /* RTCP packets received on the RTP pad, or the other way around */
+  GstBufferList *other_list;
+} DecodeBufferItData;
+
+/* Called with the filter lock held, which is only released when a key has
+ * to be requested or decoding fails
+ */
+static gboolean
+decode_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
+{
+  DecodeBufferItData *data = user_data;
+  GstSrtpDec *filter = data->filter;
+  gboolean is_rtcp = data->is_rtcp;
+  guint32 ssrc = 0;
+
+  if (!get_buffer_ssrc (filter, *buffer, &ssrc, &is_rtcp))
+    goto drop_buffer;
+
+  /* Consecutive packets usually belong to the same stream */
+  if (!data->have_stream || ssrc != data->ssrc) {
+    GstSrtpDecSsrcStream *stream;
+
+    stream = find_stream_by_ssrc (filter, ssrc);
+    if (!stream) {
+      GstCaps *caps;
+
+      /* Don't emit the signal with the lock held, the handler may well call
+       * back into the element */
+      GST_OBJECT_UNLOCK (filter);
+      caps = signal_get_srtp_params (filter, ssrc, SIGNAL_REQUEST_KEY);
+      GST_OBJECT_LOCK (filter);
+
+      /* The stream might have been added in the meantime, in which case
+       * it is kept if the key is the same */
+      if (caps) {
+        stream = update_session_stream_from_caps (filter, ssrc, caps);
+        gst_caps_unref (caps);
+      }
+      if (!stream)
+        GST_WARNING_OBJECT (filter, "Could not get a key for SSRC %u", ssrc);
+    }
+    if (!stream) {
+      data->have_stream = FALSE;
+      goto drop_buffer;
+    }
+
+    data->have_stream = TRUE;
+    data->ssrc = ssrc;
+    data->has_crypto = STREAM_HAS_CRYPTO (stream);
+  }
+
+  if (data->has_crypto) {
+    if (!gst_srtp_dec_decode_buffer (filter, data->pad, buffer, is_rtcp,
+            ssrc)) {
+      /* The streams might have changed while the lock was released */
+      data->have_stream = FALSE;
+      goto drop_buffer;
+    }
+
+    if (gst_srtp_get_soft_limit_reached ()) {
+      g_array_append_val (data->soft_limit_ssrcs, ssrc);
+      gst_srtp_init_event_reporter ();
+    }
+  }
+
+  if (is_rtcp != data->is_rtcp) {
+    if (!data->other_list)
+      data->other_list = gst_buffer_list_new ();
+    gst_buffer_list_add (data->other_list, *buffer);
+    *buffer = NULL;
+  }
+
+  return TRUE;
+
+drop_buffer:
+  GST_WARNING_OBJECT (filter, "Invalid buffer, dropping");
+  gst_buffer_unref (*buffer);
+  *buffer = NULL;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  DecodeBufferItData data;
+  guint i;
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
+      gst_buffer_list_length (buf_list));
+
+  memset (&data, 0, sizeof (DecodeBufferItData));
+  data.filter = filter;
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  /* Decode all buffers in place, removing the ones that are dropped */
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  GST_OBJECT_LOCK (filter);
+  gst_srtp_init_event_reporter ();
+  gst_buffer_list_foreach (buf_list, decode_buffer_it, &data);
+  GST_OBJECT_UNLOCK (filter);
+
+  /* If all is well, we may have reached soft limit */
+  for (i = 0; i < data.soft_limit_ssrcs->len; i++)
+    request_key_with_signal (filter,
+        g_array_index (data.soft_limit_ssrcs, guint32, i), SIGNAL_SOFT_LIMIT);
+  g_array_free (data.soft_limit_ssrcs, TRUE);
+
+  if (gst_buffer_list_length (buf_list) > 0)
+    ret = gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, is_rtcp),
+        buf_list);
+  else
+    gst_buffer_list_unref (buf_list);
+
+  if (data.other_list) {
+    GstFlowReturn other_ret;
+
+    other_ret =
+        gst_pad_push_list (gst_srtp_dec_get_src_pad (filter, !is_rtcp),
+        data.other_list);
+    if (ret == GST_FLOW_OK)
+      ret = other_ret;
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1308,6 +1483,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
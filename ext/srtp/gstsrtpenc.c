@@ -164,11 +164,20 @@ enum
   PROP_STATS
 };
 
+/* Size of the output buffers that packets which can't be protected in place
+ * are copied into, enough for MTU sized packets */
+#define OUTPUT_POOL_BUFFER_SIZE (1500 + SRTP_MAX_TRAILER_LEN + 10)
+
+/* Usage limits of the master key, the defaults of libsrtp. Every session
+ * only counts its own packets, so they are enforced on the packets of all
+ * sessions here */
+#define KEY_HARD_LIMIT G_GUINT64_CONSTANT (0xffffffffffff)
+#define KEY_SOFT_LIMIT (KEY_HARD_LIMIT - 0x10000)
+
 typedef struct ProcessBufferItData
 {
   GstSrtpEnc *filter;
   GstPad *pad;
-  GstBufferList *out_list;
   gboolean is_rtcp;
 } ProcessBufferItData;
 
@@ -209,6 +218,7 @@ G_DEFINE_TYPE (GstSrtpEnc, gst_srtp_enc, GST_TYPE_ELEMENT);
 static guint gst_srtp_enc_signals[LAST_SIGNAL] = { 0 };
 
 static void gst_srtp_enc_dispose (GObject * object);
+static void gst_srtp_enc_finalize (GObject * object);
 
 static void gst_srtp_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -278,6 +288,7 @@ gst_srtp_enc_class_init (GstSrtpEncClass * klass)
   gobject_class->set_property = gst_srtp_enc_set_property;
   gobject_class->get_property = gst_srtp_enc_get_property;
   gobject_class->dispose = gst_srtp_enc_dispose;
+  gobject_class->finalize = gst_srtp_enc_finalize;
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_srtp_enc_request_new_pad);
   gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_srtp_enc_release_pad);
@@ -346,6 +357,8 @@ gst_srtp_enc_class_init (GstSrtpEncClass * klass)
 static void
 gst_srtp_enc_init (GstSrtpEnc * filter)
 {
+  guint i;
+
   filter->key_changed = TRUE;
   filter->first_session = TRUE;
   filter->key = DEFAULT_MASTER_KEY;
@@ -355,6 +368,9 @@ gst_srtp_enc_init (GstSrtpEnc * filter)
   filter->rtcp_auth = DEFAULT_RTCP_AUTH;
   filter->replay_window_size = DEFAULT_REPLAY_WINDOW_SIZE;
   filter->allow_repeat_tx = DEFAULT_ALLOW_REPEAT_TX;
+
+  for (i = 0; i < GST_SRTP_ENC_N_SESSIONS; i++)
+    g_mutex_init (&filter->sessions[i].lock);
 }
 
 static guint
@@ -368,7 +384,7 @@ max_cipher_key_size (GstSrtpEnc * filter)
   return (rtp_size > rtcp_size) ? rtp_size : rtcp_size;
 }
 
-/* Create stream
+/* Create stream, in every session
  *
  * Should be called with the filter locked
  */
@@ -379,6 +395,7 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
   srtp_policy_t policy;
   GstMapInfo map;
   guchar tmp[1];
+  guint i;
 
   memset (&policy, 0, sizeof (srtp_policy_t));
 
@@ -430,11 +447,36 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
   policy.window_size = filter->replay_window_size;
   policy.allow_repeat_tx = filter->allow_repeat_tx;
 
-  /* If it is the first stream, create the session
-   * If not, add the stream to the session
+  /* All sessions use the same policy, every SSRC always ends up in the
+   * same one
    */
-  ret = srtp_create (&filter->session, &policy);
-  filter->first_session = FALSE;
+  for (i = 0; i < GST_SRTP_ENC_N_SESSIONS; i++) {
+    GstSrtpEncSession *session = &filter->sessions[i];
+
+    g_mutex_lock (&session->lock);
+    ret = srtp_create (&session->session, &policy);
+    if (ret != err_status_ok)
+      session->session = NULL;
+    g_mutex_unlock (&session->lock);
+
+    if (ret != err_status_ok)
+      break;
+  }
+
+  if (ret == err_status_ok) {
+    filter->first_session = FALSE;
+  } else {
+    /* don't leave some sessions created and others not, the next attempt
+     * creates them all again */
+    while (i-- > 0) {
+      GstSrtpEncSession *session = &filter->sessions[i];
+
+      g_mutex_lock (&session->lock);
+      srtp_dealloc (session->session);
+      session->session = NULL;
+      g_mutex_unlock (&session->lock);
+    }
+  }
 
   if (HAS_CRYPTO (filter))
     gst_buffer_unmap (filter->key, &map);
@@ -447,11 +489,23 @@ gst_srtp_enc_create_session (GstSrtpEnc * filter)
 static void
 gst_srtp_enc_reset_no_lock (GstSrtpEnc * filter)
 {
-  if (!filter->first_session)
-    srtp_dealloc (filter->session);
+  guint i;
+
+  /* Packets might be protected in other threads without the filter lock */
+  for (i = 0; i < GST_SRTP_ENC_N_SESSIONS; i++) {
+    GstSrtpEncSession *session = &filter->sessions[i];
+
+    g_mutex_lock (&session->lock);
+    if (session->session)
+      srtp_dealloc (session->session);
+    session->session = NULL;
+    g_mutex_unlock (&session->lock);
+  }
 
   filter->first_session = TRUE;
   filter->key_changed = FALSE;
+  filter->key_usage = 0;
+  filter->soft_limit_pending = FALSE;
 }
 
 static void
@@ -580,6 +634,18 @@ gst_srtp_enc_request_new_pad (GstElement * element,
 
 /* Dispose
  */
+static void
+gst_srtp_enc_finalize (GObject * object)
+{
+  GstSrtpEnc *filter = GST_SRTP_ENC (object);
+  guint i;
+
+  for (i = 0; i < GST_SRTP_ENC_N_SESSIONS; i++)
+    g_mutex_clear (&filter->sessions[i].lock);
+
+  G_OBJECT_CLASS (gst_srtp_enc_parent_class)->finalize (object);
+}
+
 static void
 gst_srtp_enc_dispose (GObject * object)
 {
@@ -611,14 +677,19 @@ gst_srtp_enc_create_stats (GstSrtpEnc * filter)
   GstStructure *s;
   GValue va = G_VALUE_INIT;
   GValue v = G_VALUE_INIT;
+  guint i;
 
   s = gst_structure_new_empty ("application/x-srtp-encoder-stats");
 
   g_value_init (&va, GST_TYPE_ARRAY);
   g_value_init (&v, GST_TYPE_STRUCTURE);
 
-  if (filter->session) {
-    srtp_stream_t stream = filter->session->stream_list;
+  for (i = 0; i < GST_SRTP_ENC_N_SESSIONS; i++) {
+    GstSrtpEncSession *session = &filter->sessions[i];
+    srtp_stream_t stream;
+
+    g_mutex_lock (&session->lock);
+    stream = session->session ? session->session->stream_list : NULL;
     while (stream) {
       GstStructure *ss;
       guint32 ssrc = GUINT32_FROM_BE (stream->ssrc);
@@ -632,6 +703,7 @@ gst_srtp_enc_create_stats (GstSrtpEnc * filter)
 
       stream = stream->next;
     }
+    g_mutex_unlock (&session->lock);
   }
 
   gst_structure_take_value (s, "streams", &va);
@@ -894,6 +966,40 @@ gst_srtp_enc_sink_query (GstPad * pad, GstObject * parent, GstQuery * query,
 
       return TRUE;
     }
+    case GST_QUERY_ALLOCATION:
+    {
+      GstAllocationParams params;
+      GstAllocator *allocator;
+      GstPad *otherpad;
+      guint i, n;
+
+      /* Let downstream answer first, so that its pools, allocators and
+       * metas are kept */
+      otherpad = get_rtp_other_pad (pad);
+      if (otherpad)
+        gst_pad_peer_query (otherpad, query);
+
+      /* Ask upstream to leave room for the SRTP trailer after the packets,
+       * so that they can be protected in place */
+      n = gst_query_get_n_allocation_params (query);
+      for (i = 0; i < n; i++) {
+        gst_query_parse_nth_allocation_param (query, i, &allocator, &params);
+        if (params.padding < SRTP_MAX_TRAILER_LEN) {
+          params.padding = SRTP_MAX_TRAILER_LEN;
+          gst_query_set_nth_allocation_param (query, i, allocator, &params);
+        }
+        if (allocator)
+          gst_object_unref (allocator);
+      }
+
+      if (n == 0) {
+        gst_allocation_params_init (&params);
+        params.padding = SRTP_MAX_TRAILER_LEN;
+        gst_query_add_allocation_param (query, NULL, &params);
+      }
+
+      return TRUE;
+    }
     default:
       return gst_pad_query_default (pad, parent, query);
   }
@@ -1016,6 +1122,27 @@ gst_srtp_enc_check_set_caps (GstSrtpEnc * filter, GstPad * pad,
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_srtp_enc_can_protect_in_place (GstBuffer * buf)
+{
+  GstMemory *mem;
+  gsize size, offset, maxsize;
+
+  if (!gst_buffer_is_writable (buf) || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
+
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (GST_MEMORY_IS_READONLY (mem) || !gst_memory_is_writable (mem))
+    return FALSE;
+
+  size = gst_memory_get_sizes (mem, &offset, &maxsize);
+
+  return maxsize - offset - size >= SRTP_MAX_TRAILER_LEN;
+}
+
+/* Takes ownership of @buf, which is protected in place if its memory has
+ * room for the trailer and is copied into a bigger buffer otherwise
+ */
 static GstBuffer *
 gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
     GstBuffer * buf, gboolean is_rtcp)
@@ -1023,45 +1150,97 @@ gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
   gint size_max, size;
   GstBuffer *bufout = NULL;
   GstMapInfo mapout;
+  GstSrtpEncSession *session;
+  guint32 ssrc;
   err_status_t err;
+  gboolean recreated = FALSE;
 
-  /* Create a bigger buffer to add protection */
   size = gst_buffer_get_size (buf);
-  size_max = size + SRTP_MAX_TRAILER_LEN + 10;
-  bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
 
-  gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  if (gst_srtp_enc_can_protect_in_place (buf)) {
+    bufout = buf;
+    gst_buffer_set_size (bufout, size + SRTP_MAX_TRAILER_LEN);
 
-  gst_buffer_extract (buf, 0, mapout.data, size);
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+  } else {
+    /* Create a bigger buffer to add protection */
+    size_max = size + SRTP_MAX_TRAILER_LEN + 10;
+    if (size_max > OUTPUT_POOL_BUFFER_SIZE || !filter->output_pool ||
+        gst_buffer_pool_acquire_buffer (filter->output_pool, &bufout,
+            NULL) != GST_FLOW_OK)
+      bufout = gst_buffer_new_allocate (NULL, size_max, NULL);
+    else
+      gst_buffer_set_size (bufout, size_max);
+
+    gst_buffer_map (bufout, &mapout, GST_MAP_READWRITE);
+
+    gst_buffer_extract (buf, 0, mapout.data, size);
+    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+    gst_buffer_unref (buf);
+  }
+
+  /* Only the session of the SSRC is locked */
+  ssrc = 0;
+  if (is_rtcp && size >= 8)
+    ssrc = GST_READ_UINT32_BE (mapout.data + 4);
+  else if (!is_rtcp && size >= 12)
+    ssrc = GST_READ_UINT32_BE (mapout.data + 8);
+  session = &filter->sessions[ssrc % GST_SRTP_ENC_N_SESSIONS];
 
+  /* The usage of the master key is counted before taking the session lock,
+   * key changes take the session locks with the filter locked */
   GST_OBJECT_LOCK (filter);
+  if (filter->key_usage >= KEY_HARD_LIMIT) {
+    GST_OBJECT_UNLOCK (filter);
+    gst_buffer_unmap (bufout, &mapout);
+    goto key_expired;
+  }
+  if (++filter->key_usage == KEY_SOFT_LIMIT)
+    filter->soft_limit_pending = TRUE;
+  GST_OBJECT_UNLOCK (filter);
+
+protect:
+  g_mutex_lock (&session->lock);
+
+  if (session->session == NULL) {
+    g_mutex_unlock (&session->lock);
+
+    /* Reset by a key change in another thread, create the sessions again,
+     * but only once */
+    if (recreated) {
+      GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
+          ("Unable to protect buffer (no SRTP session)"));
+      gst_buffer_unmap (bufout, &mapout);
+      goto fail;
+    }
+    if (gst_srtp_enc_check_set_caps (filter, pad, is_rtcp) != GST_FLOW_OK) {
+      gst_buffer_unmap (bufout, &mapout);
+      goto fail;
+    }
+    recreated = TRUE;
+    goto protect;
+  }
 
   gst_srtp_init_event_reporter ();
 
   if (is_rtcp)
-    err = srtp_protect_rtcp (filter->session, mapout.data, &size);
+    err = srtp_protect_rtcp (session->session, mapout.data, &size);
   else
-    err = srtp_protect (filter->session, mapout.data, &size);
+    err = srtp_protect (session->session, mapout.data, &size);
 
-  GST_OBJECT_UNLOCK (filter);
+  g_mutex_unlock (&session->lock);
 
   gst_buffer_unmap (bufout, &mapout);
 
   if (err == err_status_ok) {
     /* Buffer protected */
     gst_buffer_set_size (bufout, size);
-    gst_buffer_copy_into (bufout, buf, GST_BUFFER_COPY_METADATA, 0, -1);
 
     GST_LOG_OBJECT (pad, "Encoding %s buffer of size %d",
         is_rtcp ? "RTCP" : "RTP", size);
 
   } else if (err == err_status_key_expired) {
-
-    GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
-        ("Key usage limit has been reached"),
-        ("Unable to protect buffer (hard key usage limit reached)"));
-    goto fail;
-
+    goto key_expired;
   } else {
     /* srtp_protect failed */
     GST_ELEMENT_ERROR (filter, LIBRARY, FAILED, (NULL),
@@ -1071,6 +1250,10 @@ gst_srtp_enc_process_buffer (GstSrtpEnc * filter, GstPad * pad,
 
   return bufout;
 
+key_expired:
+  GST_ELEMENT_ERROR (GST_ELEMENT_CAST (filter), STREAM, ENCODE,
+      ("Key usage limit has been reached"),
+      ("Unable to protect buffer (hard key usage limit reached)"));
 fail:
   gst_buffer_unref (bufout);
   return NULL;
@@ -1099,7 +1282,10 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   GST_OBJECT_UNLOCK (filter);
 
-  if ((bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp))) {
+  bufout = gst_srtp_enc_process_buffer (filter, pad, buf, is_rtcp);
+  buf = NULL;
+
+  if (bufout) {
     /* Push buffer to source pad */
     otherpad = get_rtp_other_pad (pad);
     ret = gst_pad_push (otherpad, bufout);
@@ -1113,7 +1299,8 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
   GST_OBJECT_LOCK (filter);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
+  if (filter->soft_limit_pending || gst_srtp_get_soft_limit_reached ()) {
+    filter->soft_limit_pending = FALSE;
     GST_OBJECT_UNLOCK (filter);
     g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
     GST_OBJECT_LOCK (filter);
@@ -1125,7 +1312,8 @@ gst_srtp_enc_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 out:
 
-  gst_buffer_unref (buf);
+  if (buf)
+    gst_buffer_unref (buf);
 
   return ret;
 
@@ -1138,15 +1326,12 @@ static gboolean
 process_buffer_it (GstBuffer ** buffer, guint index, gpointer user_data)
 {
   ProcessBufferItData *data = user_data;
-  GstBuffer *bufout;
 
-  if ((bufout =
-          gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
-              data->is_rtcp))) {
-    gst_buffer_list_add (data->out_list, bufout);
-  } else {
+  /* Replaces the buffer in the list, or removes it */
+  *buffer = gst_srtp_enc_process_buffer (data->filter, data->pad, *buffer,
+      data->is_rtcp);
+  if (*buffer == NULL)
     GST_WARNING_OBJECT (data->filter, "Error encoding buffer, dropping");
-  }
 
   return TRUE;
 }
@@ -1158,7 +1343,6 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   GstSrtpEnc *filter = GST_SRTP_ENC (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   GstPad *otherpad;
-  GstBufferList *out_list = NULL;
   ProcessBufferItData process_data;
 
   GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
@@ -1180,17 +1364,16 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
   GST_OBJECT_UNLOCK (filter);
 
-  out_list = gst_buffer_list_new ();
+  /* The buffers are protected in the list itself, in place if possible */
+  buf_list = gst_buffer_list_make_writable (buf_list);
 
   process_data.filter = filter;
   process_data.pad = pad;
   process_data.is_rtcp = is_rtcp;
-  process_data.out_list = out_list;
 
   gst_buffer_list_foreach (buf_list, process_buffer_it, &process_data);
 
-  if (!gst_buffer_list_length (out_list)) {
-    gst_buffer_list_unref (out_list);
+  if (!gst_buffer_list_length (buf_list)) {
     ret = GST_FLOW_OK;
     goto out;
   }
@@ -1199,7 +1382,8 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
   otherpad = get_rtp_other_pad (pad);
   GST_LOG_OBJECT (pad, "Pushing buffer chain of %d",
       gst_buffer_list_length (buf_list));
-  ret = gst_pad_push_list (otherpad, out_list);
+  ret = gst_pad_push_list (otherpad, buf_list);
+  buf_list = NULL;
 
   if (ret != GST_FLOW_OK) {
     goto out;
@@ -1207,7 +1391,8 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
   GST_OBJECT_LOCK (filter);
 
-  if (gst_srtp_get_soft_limit_reached ()) {
+  if (filter->soft_limit_pending || gst_srtp_get_soft_limit_reached ()) {
+    filter->soft_limit_pending = FALSE;
     GST_OBJECT_UNLOCK (filter);
     g_signal_emit (filter, gst_srtp_enc_signals[SIGNAL_SOFT_LIMIT], 0);
     GST_OBJECT_LOCK (filter);
@@ -1219,7 +1404,8 @@ gst_srtp_enc_chain_list (GstPad * pad, GstObject * parent,
 
 out:
 
-  gst_buffer_list_unref (buf_list);
+  if (buf_list)
+    gst_buffer_list_unref (buf_list);
 
   return ret;
 }
@@ -1287,8 +1473,17 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
         gst_srtp_enc_reset_no_lock (filter);
       GST_OBJECT_UNLOCK (filter);
       break;
-    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_READY_TO_PAUSED:{
+      GstStructure *config;
+
+      filter->output_pool = gst_buffer_pool_new ();
+      config = gst_buffer_pool_get_config (filter->output_pool);
+      gst_buffer_pool_config_set_params (config, NULL,
+          OUTPUT_POOL_BUFFER_SIZE, 0, 0);
+      gst_buffer_pool_set_config (filter->output_pool, config);
+      gst_buffer_pool_set_active (filter->output_pool, TRUE);
       break;
+    }
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
     default:
@@ -1303,6 +1498,11 @@ gst_srtp_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_srtp_enc_reset (filter);
+      if (filter->output_pool) {
+        gst_buffer_pool_set_active (filter->output_pool, FALSE);
+        gst_object_unref (filter->output_pool);
+        filter->output_pool = NULL;
+      }
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -66,6 +66,16 @@ G_BEGIN_DECLS
 typedef struct _GstSrtpEnc      GstSrtpEnc;
 typedef struct _GstSrtpEncClass GstSrtpEncClass;
 
+/* The streams are spread over several sessions by SSRC, each with its own
+ * lock, so that packets of different SSRCs can be protected in parallel */
+#define GST_SRTP_ENC_N_SESSIONS 8
+
+typedef struct
+{
+  GMutex lock;
+  srtp_t session;
+} GstSrtpEncSession;
+
 struct _GstSrtpEnc
 {
   GstElement element;
@@ -78,12 +88,18 @@ struct _GstSrtpEnc
   guint rtcp_cipher;
   guint rtcp_auth;
 
-  srtp_t session;
+  GstSrtpEncSession sessions[GST_SRTP_ENC_N_SESSIONS];
   gboolean first_session;
   gboolean key_changed;
 
+  /* packets protected with the master key by all sessions */
+  guint64 key_usage;
+  gboolean soft_limit_pending;
+
   guint replay_window_size;
   gboolean allow_repeat_tx;
+
+  GstBufferPool *output_pool;
 };
 
 struct _GstSrtpEncClass
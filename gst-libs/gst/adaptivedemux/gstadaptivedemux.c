@@ -134,8 +134,15 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_LOW_LATENCY FALSE
+#define DEFAULT_TARGET_LATENCY (3 * GST_SECOND)
+#define DEFAULT_FRAGMENT_CACHE_SIZE 0
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
+/* In low-latency mode, a pause longer than this between two buffers of the
+ * same fragment is considered to be the server waiting for the encoder to
+ * produce the next chunk and is not counted as download time */
+#define LOW_LATENCY_IDLE_GAP (50 * GST_MSECOND)
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -162,6 +169,9 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_LOW_LATENCY,
+  PROP_TARGET_LATENCY,
+  PROP_FRAGMENT_CACHE_SIZE,
   PROP_LAST
 };
 
@@ -210,8 +220,25 @@ struct _GstAdaptiveDemuxPrivate
    * without needing to stop tasks when they just want to
    * update the segment boundaries */
   GMutex segment_lock;
+
+  /* LRU cache of downloaded fragments, shared by all streams and keyed by
+   * URI and byte range. Most recently used entries are at the head of
+   * cache_lru, cache_entries maps keys to their link in cache_lru.
+   * All protected by manifest_lock */
+  GHashTable *cache_entries;
+  GQueue cache_lru;
+  guint64 cache_size;
+  guint64 cache_max_size;
+  guint64 cache_hits;
+  guint64 cache_misses;
 };
 
+typedef struct _GstAdaptiveDemuxCacheEntry
+{
+  gchar *key;
+  GstBuffer *buffer;
+} GstAdaptiveDemuxCacheEntry;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   volatile gint ref_count;
@@ -247,6 +274,8 @@ static void gst_adaptive_demux_updates_loop (GstAdaptiveDemux * demux);
 static void gst_adaptive_demux_stream_download_loop (GstAdaptiveDemuxStream *
     stream);
 static void gst_adaptive_demux_reset (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_cache_trim (GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_cache_clear (GstAdaptiveDemux * demux);
 static gboolean gst_adaptive_demux_prepare_streams (GstAdaptiveDemux * demux,
     gboolean first_and_live);
 static gboolean gst_adaptive_demux_expose_streams (GstAdaptiveDemux * demux);
@@ -354,6 +383,18 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_LOW_LATENCY:
+      demux->low_latency = g_value_get_boolean (value);
+      break;
+    case PROP_TARGET_LATENCY:
+      demux->target_latency = g_value_get_uint64 (value);
+      break;
+    case PROP_FRAGMENT_CACHE_SIZE:
+      /* the manifest lock is held, so this doesn't race with the streaming
+       * threads using the cache */
+      demux->priv->cache_max_size = g_value_get_uint64 (value);
+      gst_adaptive_demux_cache_trim (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,6 +419,15 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, demux->low_latency);
+      break;
+    case PROP_TARGET_LATENCY:
+      g_value_set_uint64 (value, demux->target_latency);
+      break;
+    case PROP_FRAGMENT_CACHE_SIZE:
+      g_value_set_uint64 (value, demux->priv->cache_max_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -421,6 +471,26 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Play live streams close to the live edge, requesting fragments"
+          " before they are complete and estimating bandwidth from chunk"
+          " arrival times", DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TARGET_LATENCY,
+      g_param_spec_uint64 ("target-latency", "Target latency",
+          "Distance to the live edge to aim for in low-latency mode (in ns)",
+          0, G_MAXUINT64, DEFAULT_TARGET_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENT_CACHE_SIZE,
+      g_param_spec_uint64 ("fragment-cache-size", "Fragment cache size",
+          "Maximum amount of downloaded fragment data to keep in memory for"
+          " re-use, e.g. when seeking back (in bytes, 0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_FRAGMENT_CACHE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -500,6 +570,10 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   g_cond_init (&demux->priv->preroll_cond);
   g_mutex_init (&demux->priv->preroll_lock);
 
+  demux->priv->cache_entries = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&demux->priv->cache_lru);
+  demux->priv->cache_max_size = DEFAULT_FRAGMENT_CACHE_SIZE;
+
   pad_template =
       gst_element_class_get_pad_template (GST_ELEMENT_CLASS (klass), "sink");
   g_return_if_fail (pad_template != NULL);
@@ -513,6 +587,8 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->low_latency = DEFAULT_LOW_LATENCY;
+  demux->target_latency = DEFAULT_TARGET_LATENCY;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -545,6 +621,9 @@ gst_adaptive_demux_finalize (GObject * object)
   g_cond_clear (&demux->priv->preroll_cond);
   g_mutex_clear (&demux->priv->preroll_lock);
 
+  gst_adaptive_demux_cache_clear (demux);
+  g_hash_table_unref (priv->cache_entries);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -822,6 +901,8 @@ gst_adaptive_demux_reset (GstAdaptiveDemux * demux)
   gst_adapter_clear (demux->priv->input_adapter);
   demux->priv->have_manifest = FALSE;
 
+  gst_adaptive_demux_cache_clear (demux);
+
   gst_segment_init (&demux->segment, GST_FORMAT_TIME);
 
   demux->have_group_id = FALSE;
@@ -1389,6 +1470,11 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
 
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
 
+  if (stream->cache_buffer) {
+    gst_buffer_unref (stream->cache_buffer);
+    stream->cache_buffer = NULL;
+  }
+
   if (stream->pending_segment) {
     gst_event_unref (stream->pending_segment);
     stream->pending_segment = NULL;
@@ -2483,16 +2569,31 @@ gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
   return TRUE;
 }
 
+/* Gets the size of the data being downloaded, either from the source
+ * element or, when replaying from the fragment cache, from the buffer that
+ * holds the whole download */
+static gboolean
+gst_adaptive_demux_stream_query_download_size (GstAdaptiveDemuxStream *
+    stream, GstBuffer * buffer, gint64 * size)
+{
+  if (stream->cache_replay) {
+    *size = gst_buffer_get_size (buffer);
+    return TRUE;
+  }
+
+  return gst_element_query_duration (stream->uri_handler, GST_FORMAT_BYTES,
+      size);
+}
+
+/* Handles data downloaded for @stream, coming either from the source
+ * element or from the fragment cache */
 static GstFlowReturn
-_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_adaptive_demux_stream_chain (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
-  GstAdaptiveDemuxStream *stream;
-  GstAdaptiveDemux *demux;
   GstAdaptiveDemuxClass *klass;
   GstFlowReturn ret = GST_FLOW_OK;
 
-  demux = GST_ADAPTIVE_DEMUX_CAST (parent);
-  stream = gst_pad_get_element_private (pad);
   klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
 
   GST_MANIFEST_LOCK (demux);
@@ -2508,6 +2609,20 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   }
   g_mutex_unlock (&stream->fragment_download_lock);
 
+  /* record the downloaded data for the fragment cache, as long as it fits */
+  if (stream->cache_buffer) {
+    if (gst_buffer_get_size (stream->cache_buffer) +
+        gst_buffer_get_size (buffer) <= demux->priv->cache_max_size) {
+      stream->cache_buffer =
+          gst_buffer_append (stream->cache_buffer, gst_buffer_ref (buffer));
+    } else {
+      GST_DEBUG_OBJECT (stream->pad,
+          "Download too big for the fragment cache");
+      gst_buffer_unref (stream->cache_buffer);
+      stream->cache_buffer = NULL;
+    }
+  }
+
   /* starting_fragment is set to TRUE at the beginning of
    * _stream_download_fragment()
    * /!\ If there is a header/index being downloaded, then this will
@@ -2570,7 +2685,7 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
        * can work it out from the fragment size and duration */
       if (stream->fragment.bitrate == 0 &&
           stream->fragment.duration != 0 &&
-          gst_element_query_duration (stream->uri_handler, GST_FORMAT_BYTES,
+          gst_adaptive_demux_stream_query_download_size (stream, buffer,
               &chunk_size)) {
         guint bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (chunk_size,
                 8 * GST_SECOND, stream->fragment.duration));
@@ -2645,6 +2760,13 @@ error:
   return ret;
 }
 
+static GstFlowReturn
+_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  return gst_adaptive_demux_stream_chain (GST_ADAPTIVE_DEMUX_CAST (parent),
+      gst_pad_get_element_private (pad), buffer);
+}
+
 /* must be called with manifest_lock taken */
 static void
 gst_adaptive_demux_stream_fragment_download_finish (GstAdaptiveDemuxStream *
@@ -2743,14 +2865,23 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
 
   if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
     GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime now = gst_adaptive_demux_get_monotonic_time (stream->demux);
+
     if (stream->fragment_bytes_downloaded == 0) {
-      stream->last_latency =
-          gst_adaptive_demux_get_monotonic_time (stream->demux) -
-          (stream->download_start_time * GST_USECOND);
+      stream->last_latency = now - (stream->download_start_time * GST_USECOND);
       GST_DEBUG_OBJECT (pad,
           "FIRST BYTE since download_start %" GST_TIME_FORMAT,
           GST_TIME_ARGS (stream->last_latency));
+      stream->chunk_active_time = 0;
+      stream->chunk_active_bytes = 0;
+    } else if (now - stream->last_chunk_time <= LOW_LATENCY_IDLE_GAP) {
+      /* Only count data that arrived back-to-back with the previous buffer.
+       * The first buffer after an idle gap (and the request latency) mostly
+       * measure how long the server waited for the chunk to be produced */
+      stream->chunk_active_time += now - stream->last_chunk_time;
+      stream->chunk_active_bytes += gst_buffer_get_size (buf);
     }
+    stream->last_chunk_time = now;
     stream->fragment_bytes_downloaded += gst_buffer_get_size (buf);
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
@@ -2769,14 +2900,25 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
         stream->last_download_time =
             gst_adaptive_demux_get_monotonic_time (stream->demux) -
             (stream->download_start_time * GST_USECOND);
-        stream->last_bitrate =
-            gst_util_uint64_scale (stream->fragment_bytes_downloaded,
-            8 * GST_SECOND, stream->last_download_time);
-        GST_DEBUG_OBJECT (pad,
-            "EOS since download_start %" GST_TIME_FORMAT " bitrate %"
-            G_GUINT64_FORMAT " bps", GST_TIME_ARGS (stream->last_download_time),
-            stream->last_bitrate);
-        /* Calculate bitrate since URI request */
+        if (stream->demux->low_latency && stream->chunk_active_time > 0) {
+          /* Calculate bitrate from the time spent actually transferring */
+          stream->last_bitrate =
+              gst_util_uint64_scale (stream->chunk_active_bytes,
+              8 * GST_SECOND, stream->chunk_active_time);
+          GST_DEBUG_OBJECT (pad,
+              "EOS after %" GST_TIME_FORMAT " of active transfer, bitrate %"
+              G_GUINT64_FORMAT " bps", GST_TIME_ARGS (stream->chunk_active_time),
+              stream->last_bitrate);
+        } else {
+          /* Calculate bitrate since URI request */
+          stream->last_bitrate =
+              gst_util_uint64_scale (stream->fragment_bytes_downloaded,
+              8 * GST_SECOND, stream->last_download_time);
+          GST_DEBUG_OBJECT (pad,
+              "EOS since download_start %" GST_TIME_FORMAT " bitrate %"
+              G_GUINT64_FORMAT " bps",
+              GST_TIME_ARGS (stream->last_download_time), stream->last_bitrate);
+        }
       }
         break;
       default:
@@ -3070,23 +3212,174 @@ uritype (GstAdaptiveDemuxStream * s)
 }
 #endif
 
+static void
+gst_adaptive_demux_cache_entry_free (GstAdaptiveDemuxCacheEntry * entry)
+{
+  g_free (entry->key);
+  gst_buffer_unref (entry->buffer);
+  g_slice_free (GstAdaptiveDemuxCacheEntry, entry);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_cache_remove (GstAdaptiveDemux * demux, GList * link)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GstAdaptiveDemuxCacheEntry *entry = link->data;
+
+  g_hash_table_remove (priv->cache_entries, entry->key);
+  g_queue_delete_link (&priv->cache_lru, link);
+  priv->cache_size -= gst_buffer_get_size (entry->buffer);
+  gst_adaptive_demux_cache_entry_free (entry);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_cache_trim (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+
+  while (priv->cache_size > priv->cache_max_size) {
+    GST_LOG_OBJECT (demux, "Evicting %s from the fragment cache",
+        ((GstAdaptiveDemuxCacheEntry *) priv->cache_lru.tail->data)->key);
+    gst_adaptive_demux_cache_remove (demux, priv->cache_lru.tail);
+  }
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_cache_clear (GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+
+  while (priv->cache_lru.tail)
+    gst_adaptive_demux_cache_remove (demux, priv->cache_lru.tail);
+  priv->cache_hits = 0;
+  priv->cache_misses = 0;
+}
+
+/* must be called with manifest_lock taken.
+ * Returns a writable copy of the cached buffer for @key, sharing its memory,
+ * or NULL */
+static GstBuffer *
+gst_adaptive_demux_cache_lookup (GstAdaptiveDemux * demux, const gchar * key)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GList *link;
+
+  link = g_hash_table_lookup (priv->cache_entries, key);
+  if (link == NULL) {
+    priv->cache_misses++;
+    return NULL;
+  }
+
+  priv->cache_hits++;
+  /* move to the most recently used end */
+  g_queue_unlink (&priv->cache_lru, link);
+  g_queue_push_head_link (&priv->cache_lru, link);
+
+  return gst_buffer_copy (((GstAdaptiveDemuxCacheEntry *) link->data)->buffer);
+}
+
+/* must be called with manifest_lock taken. Takes ownership of @key and
+ * @buffer */
+static void
+gst_adaptive_demux_cache_insert (GstAdaptiveDemux * demux, gchar * key,
+    GstBuffer * buffer)
+{
+  GstAdaptiveDemuxPrivate *priv = demux->priv;
+  GstAdaptiveDemuxCacheEntry *entry;
+  GList *link;
+
+  link = g_hash_table_lookup (priv->cache_entries, key);
+  if (link)
+    gst_adaptive_demux_cache_remove (demux, link);
+
+  entry = g_slice_new (GstAdaptiveDemuxCacheEntry);
+  entry->key = key;
+  entry->buffer = buffer;
+  g_queue_push_head (&priv->cache_lru, entry);
+  g_hash_table_insert (priv->cache_entries, entry->key, priv->cache_lru.head);
+  priv->cache_size += gst_buffer_get_size (buffer);
+
+  GST_LOG_OBJECT (demux, "Cached %s, %" G_GSIZE_FORMAT " bytes", key,
+      gst_buffer_get_size (buffer));
+
+  gst_adaptive_demux_cache_trim (demux);
+}
+
+static void
+gst_adaptive_demux_cache_post_statistics (GstAdaptiveDemux * demux,
+    const gchar * uri, gboolean hit)
+{
+  gst_element_post_message (GST_ELEMENT_CAST (demux),
+      gst_message_new_element (GST_OBJECT_CAST (demux),
+          gst_structure_new (GST_ADAPTIVE_DEMUX_CACHE_STATISTICS_MESSAGE_NAME,
+              "uri", G_TYPE_STRING, uri, "hit", G_TYPE_BOOLEAN, hit,
+              "hits", G_TYPE_UINT64, demux->priv->cache_hits,
+              "misses", G_TYPE_UINT64, demux->priv->cache_misses,
+              "cache-size", G_TYPE_UINT64, demux->priv->cache_size, NULL)));
+}
+
+/* must be called with manifest_lock taken.
+ * Temporarily releases manifest_lock
+ *
+ * Feeds @buffer, the complete data of a cached download, to the stream as
+ * if it had been received from the source element */
+static GstFlowReturn
+gst_adaptive_demux_stream_replay_cached (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
+{
+  GstFlowReturn ret;
+
+  stream->download_start_time =
+      GST_TIME_AS_USECONDS (gst_adaptive_demux_get_monotonic_time (demux));
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  stream->cache_replay = TRUE;
+
+  /* like data coming from the source, the chain function takes the lock
+   * itself and must be able to release it while pushing downstream */
+  GST_MANIFEST_UNLOCK (demux);
+  ret = gst_adaptive_demux_stream_chain (demux, stream, buffer);
+  GST_MANIFEST_LOCK (demux);
+
+  stream->cache_replay = FALSE;
+
+  /* the chain function finishes the download itself if it didn't take all
+   * the data, otherwise behave as if the source had reached EOS */
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    return stream->last_ret = GST_FLOW_FLUSHING;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  GST_DEBUG_OBJECT (stream->pad, "%s replayed from cache: %d %s",
+      uritype (stream), stream->last_ret,
+      gst_flow_get_name (stream->last_ret));
+
+  return stream->last_ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  *
  * Will return when URI is fully downloaded (or aborted/errored)
  */
 static GstFlowReturn
-gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
+gst_adaptive_demux_stream_fetch_uri (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 start,
     gint64 end, guint * http_status)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  GST_DEBUG_OBJECT (stream->pad,
-      "Downloading %s uri: %s, range:%" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
-      uritype (stream), uri, start, end);
-
-  if (http_status)
-    *http_status = 200;         /* default to ok if no further information */
 
   if (!gst_adaptive_demux_stream_update_source (stream, uri, NULL, FALSE, TRUE)) {
     ret = stream->last_ret = GST_FLOW_ERROR;
@@ -3233,6 +3526,61 @@ gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
   return ret;
 }
 
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Will return when URI is fully downloaded (or aborted/errored), or served
+ * from the fragment cache
+ */
+static GstFlowReturn
+gst_adaptive_demux_stream_download_uri (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, const gchar * uri, gint64 start,
+    gint64 end, guint * http_status)
+{
+  GstFlowReturn ret;
+  GstBuffer *cached;
+  gchar *key;
+
+  GST_DEBUG_OBJECT (stream->pad,
+      "Downloading %s uri: %s, range:%" G_GINT64_FORMAT " - %" G_GINT64_FORMAT,
+      uritype (stream), uri, start, end);
+
+  if (http_status)
+    *http_status = 200;         /* default to ok if no further information */
+
+  if (demux->priv->cache_max_size == 0)
+    return gst_adaptive_demux_stream_fetch_uri (demux, stream, uri, start, end,
+        http_status);
+
+  key = g_strdup_printf ("%s|%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT, uri,
+      start, end);
+  cached = gst_adaptive_demux_cache_lookup (demux, key);
+  gst_adaptive_demux_cache_post_statistics (demux, uri, cached != NULL);
+
+  if (cached) {
+    GST_DEBUG_OBJECT (stream->pad, "Serving %s from the fragment cache", key);
+    g_free (key);
+    return gst_adaptive_demux_stream_replay_cached (demux, stream, cached);
+  }
+
+  gst_buffer_replace (&stream->cache_buffer, NULL);
+  stream->cache_buffer = gst_buffer_new ();
+
+  ret = gst_adaptive_demux_stream_fetch_uri (demux, stream, uri, start, end,
+      http_status);
+
+  if (ret == GST_FLOW_OK && stream->cache_buffer
+      && gst_buffer_get_size (stream->cache_buffer) > 0) {
+    gst_adaptive_demux_cache_insert (demux, key, stream->cache_buffer);
+    stream->cache_buffer = NULL;
+  } else {
+    g_free (key);
+    gst_buffer_replace (&stream->cache_buffer, NULL);
+  }
+
+  return ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -4130,7 +4478,9 @@ gst_adaptive_demux_stream_advance_fragment_unlocked (GstAdaptiveDemux * demux,
               "fragment-stop-time", GST_TYPE_CLOCK_TIME,
               gst_util_get_timestamp (), "fragment-size", G_TYPE_UINT64,
               stream->download_total_bytes, "fragment-download-time",
-              GST_TYPE_CLOCK_TIME, stream->last_download_time, NULL)));
+              GST_TYPE_CLOCK_TIME, stream->last_download_time,
+              "fragment-bitrate", G_TYPE_UINT64, stream->last_bitrate,
+              NULL)));
 
   /* Don't update to the end of the segment if in reverse playback */
   GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
@@ -74,6 +74,16 @@ G_BEGIN_DECLS
  */
 #define GST_ADAPTIVE_DEMUX_STATISTICS_MESSAGE_NAME "adaptive-streaming-statistics"
 
+/**
+ * GST_ADAPTIVE_DEMUX_CACHE_STATISTICS_MESSAGE_NAME:
+ *
+ * Name of the ELEMENT type messages posted with fragment cache hit/miss
+ * statistics when the fragment cache is enabled.
+ *
+ * Since: 1.14
+ */
+#define GST_ADAPTIVE_DEMUX_CACHE_STATISTICS_MESSAGE_NAME "adaptive-streaming-cache-statistics"
+
 #define GST_ELEMENT_ERROR_FROM_ERROR(el, msg, err) G_STMT_START { \
   gchar *__dbg = g_strdup_printf ("%s: %s", msg, err->message);         \
   GST_WARNING_OBJECT (el, "error: %s", __dbg);                          \
@@ -166,6 +176,11 @@ struct _GstAdaptiveDemuxStream
   gboolean first_fragment_buffer;
   gint64 download_start_time;
   gint64 download_total_bytes;
+  /* fragment cache: data received for the current download, to be stored
+   * once it completes, and whether the current download is served from
+   * the cache */
+  GstBuffer *cache_buffer;
+  gboolean cache_replay;
   guint64 current_download_rate;
 
   /* amount of data downloaded in current fragment (pre-queue2) */
@@ -176,6 +191,12 @@ struct _GstAdaptiveDemuxStream
    * of previous fragment (pre-queue2) */
   GstClockTime last_latency;
   GstClockTime last_download_time;
+  /* low-latency mode: arrival time of the previous buffer, and the
+   * time/bytes spent transferring the current fragment, excluding idle gaps
+   * between chunks (pre-queue2) */
+  GstClockTime last_chunk_time;
+  GstClockTime chunk_active_time;
+  guint64 chunk_active_bytes;
 
   /* Average for the last fragments */
   guint64 moving_bitrate;
@@ -226,6 +247,8 @@ struct _GstAdaptiveDemux
   /* Properties */
   gfloat bitrate_limit;         /* limit of the available bitrate to use */
   guint connection_speed;
+  gboolean low_latency;         /* play live streams close to the live edge */
+  GstClockTime target_latency;  /* distance to the live edge in low-latency mode */
 
   gboolean have_group_id;
   guint group_id;
@@ -377,6 +377,200 @@ gst_h264_sps_copy (GstH264SPS * dst_sps, const GstH264SPS * src_sps)
   return TRUE;
 }
 
+/* A parameter set and the NAL unit it was parsed from. These are never
+ * modified once stored, so that the parser and its snapshots can share
+ * them */
+typedef struct
+{
+  gint ref_count;
+
+  /* the NAL unit, header included, NULL if unknown */
+  guint8 *nal;
+  guint nal_size;
+  gboolean parse_vui_params;
+
+  gboolean is_pps;
+  union
+  {
+    GstH264SPS sps;
+    GstH264PPS pps;
+  } u;
+} GstH264ParamSetRef;
+
+struct _GstH264NalParserSnapshot
+{
+  GstH264NalParser *nalparser;
+  GstH264ParamSetRef *sps[GST_H264_MAX_SPS_COUNT];
+  GstH264ParamSetRef *pps[GST_H264_MAX_PPS_COUNT];
+  gint last_sps_id;
+  gint last_pps_id;
+};
+
+static GstH264ParamSetRef *
+gst_h264_param_set_ref_new (GstH264NalUnit * nalu, gboolean parse_vui_params)
+{
+  GstH264ParamSetRef *ref = g_slice_new0 (GstH264ParamSetRef);
+
+  ref->ref_count = 1;
+  if (nalu) {
+    ref->nal = g_memdup (nalu->data + nalu->offset, nalu->size);
+    ref->nal_size = nalu->size;
+  }
+  ref->parse_vui_params = parse_vui_params;
+
+  return ref;
+}
+
+static GstH264ParamSetRef *
+gst_h264_param_set_ref_ref (GstH264ParamSetRef * ref)
+{
+  g_atomic_int_inc (&ref->ref_count);
+  return ref;
+}
+
+static void
+gst_h264_param_set_ref_unref (GstH264ParamSetRef * ref)
+{
+  if (!g_atomic_int_dec_and_test (&ref->ref_count))
+    return;
+
+  if (ref->is_pps)
+    gst_h264_pps_clear (&ref->u.pps);
+  else
+    gst_h264_sps_clear (&ref->u.sps);
+  g_free (ref->nal);
+  g_slice_free (GstH264ParamSetRef, ref);
+}
+
+static void
+gst_h264_param_set_ref_replace (gpointer * ptr, GstH264ParamSetRef * ref)
+{
+  GstH264ParamSetRef *old = *ptr;
+
+  if (old == ref)
+    return;
+  if (ref)
+    gst_h264_param_set_ref_ref (ref);
+  *ptr = ref;
+  if (old)
+    gst_h264_param_set_ref_unref (old);
+}
+
+/* Whether @nalu is the NAL unit @ref was parsed from */
+static gboolean
+gst_h264_param_set_ref_matches (GstH264ParamSetRef * ref,
+    GstH264NalUnit * nalu, gboolean parse_vui_params)
+{
+  return ref && ref->nal && ref->nal_size == nalu->size &&
+      (ref->parse_vui_params || !parse_vui_params) &&
+      memcmp (ref->nal, nalu->data + nalu->offset, nalu->size) == 0;
+}
+
+/* Reads the id of a SPS or PPS without parsing the rest of it */
+static gboolean
+gst_h264_parser_peek_param_set_id (GstH264NalUnit * nalu, guint32 * id)
+{
+  NalReader nr;
+
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  if (nalu->type == GST_H264_NAL_PPS)
+    return nal_reader_get_ue (&nr, id) && *id < GST_H264_MAX_PPS_COUNT;
+
+  /* profile_idc, constraint flags and level_idc come first in a SPS */
+  return nal_reader_skip (&nr, 24) && nal_reader_get_ue (&nr, id) &&
+      *id < GST_H264_MAX_SPS_COUNT;
+}
+
+/* Fills @sps from the stored copy if @nalu is the same SPS as last time */
+static gboolean
+gst_h264_parser_reuse_sps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264SPS * sps, gboolean parse_vui_params)
+{
+  GstH264ParamSetRef *ref;
+  guint32 id;
+
+  if (!gst_h264_parser_peek_param_set_id (nalu, &id))
+    return FALSE;
+
+  ref = nalparser->sps_refs[id];
+  if (!gst_h264_param_set_ref_matches (ref, nalu, parse_vui_params))
+    return FALSE;
+
+  GST_DEBUG ("sequence parameter set with id: %d did not change", id);
+
+  /* the copy clears the destination first */
+  sps->extension_type = GST_H264_NAL_EXTENSION_NONE;
+  if (!gst_h264_sps_copy (sps, &ref->u.sps))
+    return FALSE;
+  nalparser->last_sps = &nalparser->sps[id];
+
+  return TRUE;
+}
+
+static void
+gst_h264_parser_store_sps_ref (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, gboolean parse_vui_params)
+{
+  GstH264SPS *sps = nalparser->last_sps;
+  GstH264ParamSetRef *ref;
+  guint i;
+
+  ref = gst_h264_param_set_ref_new (nalu, parse_vui_params);
+  gst_h264_sps_copy (&ref->u.sps, sps);
+  gst_h264_param_set_ref_replace (&nalparser->sps_refs[sps->id], ref);
+  gst_h264_param_set_ref_unref (ref);
+
+  /* the PPS using it have to be parsed again when they are resent */
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
+    GstH264ParamSetRef *pps_ref = nalparser->pps_refs[i];
+
+    if (pps_ref && pps_ref->u.pps.sequence == sps)
+      gst_h264_param_set_ref_replace (&nalparser->pps_refs[i], NULL);
+  }
+}
+
+/* Fills @pps from the stored copy if @nalu is the same PPS as last time */
+static gboolean
+gst_h264_parser_reuse_pps (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GstH264PPS * pps)
+{
+  GstH264ParamSetRef *ref;
+  guint32 id;
+
+  if (!gst_h264_parser_peek_param_set_id (nalu, &id))
+    return FALSE;
+
+  ref = nalparser->pps_refs[id];
+  if (!gst_h264_param_set_ref_matches (ref, nalu, FALSE))
+    return FALSE;
+
+  GST_DEBUG ("picture parameter set with id: %d did not change", id);
+
+  /* the copy clears the destination first */
+  pps->slice_group_id = NULL;
+  if (!gst_h264_pps_copy (pps, &ref->u.pps))
+    return FALSE;
+  nalparser->last_pps = &nalparser->pps[id];
+
+  return TRUE;
+}
+
+static void
+gst_h264_parser_store_pps_ref (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu)
+{
+  GstH264PPS *pps = nalparser->last_pps;
+  GstH264ParamSetRef *ref;
+
+  ref = gst_h264_param_set_ref_new (nalu, FALSE);
+  ref->is_pps = TRUE;
+  gst_h264_pps_copy (&ref->u.pps, pps);
+  gst_h264_param_set_ref_replace (&nalparser->pps_refs[pps->id], ref);
+  gst_h264_param_set_ref_unref (ref);
+}
+
 /****** Parsing functions *****/
 
 static gboolean
@@ -1033,6 +1227,85 @@ error:
   return GST_H264_PARSER_ERROR;
 }
 
+/* Reads the @payload_size remaining bytes of a SEI message, the emulation
+ * prevention bytes being removed */
+static guint8 *
+gst_h264_parser_read_sei_payload_bytes (NalReader * nr, guint payload_size,
+    guint * size)
+{
+  guint8 *data;
+  guint i;
+
+  *size = MIN (payload_size, nal_reader_get_remaining (nr) / 8);
+  data = g_malloc (*size ? *size : 1);
+
+  for (i = 0; i < *size; i++) {
+    if (!nal_reader_get_bits_uint8 (nr, &data[i], 8)) {
+      g_free (data);
+      return NULL;
+    }
+  }
+
+  return data;
+}
+
+static GstH264ParserResult
+gst_h264_parser_parse_registered_user_data (GstH264NalParser * nalparser,
+    GstH264RegisteredUserData * rud, NalReader * nr, guint payload_size)
+{
+  GST_DEBUG ("parsing \"Registered user data\"");
+
+  if (payload_size < 1)
+    goto error;
+
+  READ_UINT8 (nr, rud->country_code, 8);
+  payload_size--;
+
+  if (rud->country_code == 0xff) {
+    if (payload_size < 1)
+      goto error;
+    READ_UINT8 (nr, rud->country_code_extension, 8);
+    payload_size--;
+  }
+
+  rud->data = gst_h264_parser_read_sei_payload_bytes (nr, payload_size,
+      &rud->size);
+  if (!rud->data)
+    goto error;
+
+  return GST_H264_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Registered user data\"");
+  return GST_H264_PARSER_ERROR;
+}
+
+static GstH264ParserResult
+gst_h264_parser_parse_user_data_unregistered (GstH264NalParser * nalparser,
+    GstH264UserDataUnregistered * udu, NalReader * nr, guint payload_size)
+{
+  guint i;
+
+  GST_DEBUG ("parsing \"User data unregistered\"");
+
+  if (payload_size < 16)
+    goto error;
+
+  for (i = 0; i < 16; i++)
+    READ_UINT8 (nr, udu->uuid[i], 8);
+
+  udu->data = gst_h264_parser_read_sei_payload_bytes (nr, payload_size - 16,
+      &udu->size);
+  if (!udu->data)
+    goto error;
+
+  return GST_H264_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"User data unregistered\"");
+  return GST_H264_PARSER_ERROR;
+}
+
 /* Parse SEI stereo_video_info() message */
 static GstH264ParserResult
 gst_h264_parser_parse_stereo_video_info (GstH264NalParser * nalparser,
@@ -1157,6 +1430,14 @@ gst_h264_parser_parse_sei_message (GstH264NalParser * nalparser,
       res = gst_h264_parser_parse_pic_timing (nalparser,
           &sei->payload.pic_timing, nr);
       break;
+    case GST_H264_SEI_REGISTERED_USER_DATA:
+      res = gst_h264_parser_parse_registered_user_data (nalparser,
+          &sei->payload.registered_user_data, nr, payloadSize);
+      break;
+    case GST_H264_SEI_USER_DATA_UNREGISTERED:
+      res = gst_h264_parser_parse_user_data_unregistered (nalparser,
+          &sei->payload.user_data_unregistered, nr, payloadSize);
+      break;
     case GST_H264_SEI_RECOVERY_POINT:
       res = gst_h264_parser_parse_recovery_point (nalparser,
           &sei->payload.recovery_point, nr);
@@ -1202,6 +1483,23 @@ error:
   return GST_H264_PARSER_ERROR;
 }
 
+static void
+gst_h264_sei_clear (GstH264SEIMessage * sei)
+{
+  switch (sei->payloadType) {
+    case GST_H264_SEI_REGISTERED_USER_DATA:
+      g_free ((guint8 *) sei->payload.registered_user_data.data);
+      sei->payload.registered_user_data.data = NULL;
+      break;
+    case GST_H264_SEI_USER_DATA_UNREGISTERED:
+      g_free ((guint8 *) sei->payload.user_data_unregistered.data);
+      sei->payload.user_data_unregistered.data = NULL;
+      break;
+    default:
+      break;
+  }
+}
+
 /******** API *************/
 
 /**
@@ -1234,15 +1532,174 @@ gst_h264_nal_parser_free (GstH264NalParser * nalparser)
 {
   guint i;
 
-  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++)
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
     gst_h264_sps_clear (&nalparser->sps[i]);
-  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++)
+    gst_h264_param_set_ref_replace (&nalparser->sps_refs[i], NULL);
+  }
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
     gst_h264_pps_clear (&nalparser->pps[i]);
+    gst_h264_param_set_ref_replace (&nalparser->pps_refs[i], NULL);
+  }
   g_slice_free (GstH264NalParser, nalparser);
 
   nalparser = NULL;
 }
 
+/**
+ * GstH264NalParserSnapshot:
+ *
+ * The parameter sets known by a #GstH264NalParser at some point
+ * (opaque structure).
+ *
+ * Since: 1.14
+ */
+
+/**
+ * gst_h264_nal_parser_snapshot:
+ * @nalparser: a #GstH264NalParser
+ *
+ * Saves the parameter sets currently known by @nalparser, so that they can
+ * be brought back later with gst_h264_nal_parser_restore(), e.g. when
+ * going back to a splice point.
+ *
+ * The parameter sets are shared between @nalparser and its snapshots and
+ * are not copied, so this is cheap.
+ *
+ * Returns: (transfer full): a new #GstH264NalParserSnapshot, free with
+ *     gst_h264_nal_parser_snapshot_free()
+ *
+ * Since: 1.14
+ */
+GstH264NalParserSnapshot *
+gst_h264_nal_parser_snapshot (GstH264NalParser * nalparser)
+{
+  GstH264NalParserSnapshot *snapshot;
+  guint i;
+
+  g_return_val_if_fail (nalparser != NULL, NULL);
+
+  snapshot = g_slice_new0 (GstH264NalParserSnapshot);
+  snapshot->nalparser = nalparser;
+
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
+    if (!nalparser->sps[i].valid)
+      continue;
+
+    if (!nalparser->sps_refs[i]) {
+      GstH264ParamSetRef *ref = gst_h264_param_set_ref_new (NULL, FALSE);
+
+      gst_h264_sps_copy (&ref->u.sps, &nalparser->sps[i]);
+      nalparser->sps_refs[i] = ref;
+    }
+    snapshot->sps[i] = gst_h264_param_set_ref_ref (nalparser->sps_refs[i]);
+  }
+
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
+    if (!nalparser->pps[i].valid)
+      continue;
+
+    /* the stored copy was dropped if its SPS changed */
+    if (!nalparser->pps_refs[i]) {
+      GstH264ParamSetRef *ref = gst_h264_param_set_ref_new (NULL, FALSE);
+
+      ref->is_pps = TRUE;
+      gst_h264_pps_copy (&ref->u.pps, &nalparser->pps[i]);
+      nalparser->pps_refs[i] = ref;
+    }
+    snapshot->pps[i] = gst_h264_param_set_ref_ref (nalparser->pps_refs[i]);
+  }
+
+  snapshot->last_sps_id =
+      nalparser->last_sps ? nalparser->last_sps - nalparser->sps : -1;
+  snapshot->last_pps_id =
+      nalparser->last_pps ? nalparser->last_pps - nalparser->pps : -1;
+
+  return snapshot;
+}
+
+/**
+ * gst_h264_nal_parser_restore:
+ * @nalparser: a #GstH264NalParser
+ * @snapshot: a #GstH264NalParserSnapshot of @nalparser
+ *
+ * Brings the parameter sets of @nalparser back to what they were when
+ * @snapshot was taken. Only the parameter sets that changed since then
+ * are copied back.
+ *
+ * Since: 1.14
+ */
+void
+gst_h264_nal_parser_restore (GstH264NalParser * nalparser,
+    GstH264NalParserSnapshot * snapshot)
+{
+  guint i;
+
+  g_return_if_fail (nalparser != NULL);
+  g_return_if_fail (snapshot != NULL);
+  g_return_if_fail (snapshot->nalparser == nalparser);
+
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
+    GstH264ParamSetRef *ref = snapshot->sps[i];
+
+    if (ref == nalparser->sps_refs[i] && (ref || !nalparser->sps[i].valid))
+      continue;
+
+    if (ref) {
+      gst_h264_sps_copy (&nalparser->sps[i], &ref->u.sps);
+    } else {
+      gst_h264_sps_clear (&nalparser->sps[i]);
+      memset (&nalparser->sps[i], 0, sizeof (GstH264SPS));
+    }
+    gst_h264_param_set_ref_replace (&nalparser->sps_refs[i], ref);
+  }
+
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
+    GstH264ParamSetRef *ref = snapshot->pps[i];
+
+    if (ref == nalparser->pps_refs[i] && (ref || !nalparser->pps[i].valid))
+      continue;
+
+    if (ref) {
+      gst_h264_pps_copy (&nalparser->pps[i], &ref->u.pps);
+    } else {
+      gst_h264_pps_clear (&nalparser->pps[i]);
+      memset (&nalparser->pps[i], 0, sizeof (GstH264PPS));
+    }
+    gst_h264_param_set_ref_replace (&nalparser->pps_refs[i], ref);
+  }
+
+  nalparser->last_sps = snapshot->last_sps_id >= 0 ?
+      &nalparser->sps[snapshot->last_sps_id] : NULL;
+  nalparser->last_pps = snapshot->last_pps_id >= 0 ?
+      &nalparser->pps[snapshot->last_pps_id] : NULL;
+}
+
+/**
+ * gst_h264_nal_parser_snapshot_free:
+ * @snapshot: the #GstH264NalParserSnapshot to free
+ *
+ * Frees @snapshot.
+ *
+ * Since: 1.14
+ */
+void
+gst_h264_nal_parser_snapshot_free (GstH264NalParserSnapshot * snapshot)
+{
+  guint i;
+
+  g_return_if_fail (snapshot != NULL);
+
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
+    if (snapshot->sps[i])
+      gst_h264_param_set_ref_unref (snapshot->sps[i]);
+  }
+  for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
+    if (snapshot->pps[i])
+      gst_h264_param_set_ref_unref (snapshot->pps[i]);
+  }
+  g_slice_free (GstH264NalParserSnapshot, snapshot);
+}
+
 /**
  * gst_h264_parser_identify_nalu_unchecked:
  * @nalparser: a #GstH264NalParser
@@ -1469,7 +1926,13 @@ GstH264ParserResult
 gst_h264_parser_parse_sps (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
     GstH264SPS * sps, gboolean parse_vui_params)
 {
-  GstH264ParserResult res = gst_h264_parse_sps (nalu, sps, parse_vui_params);
+  GstH264ParserResult res;
+
+  /* parameter sets are usually resent unchanged before every keyframe */
+  if (gst_h264_parser_reuse_sps (nalparser, nalu, sps, parse_vui_params))
+    return GST_H264_PARSER_OK;
+
+  res = gst_h264_parse_sps (nalu, sps, parse_vui_params);
 
   if (res == GST_H264_PARSER_OK) {
     GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
@@ -1477,6 +1940,7 @@ gst_h264_parser_parse_sps (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
     if (!gst_h264_sps_copy (&nalparser->sps[sps->id], sps))
       return GST_H264_PARSER_ERROR;
     nalparser->last_sps = &nalparser->sps[sps->id];
+    gst_h264_parser_store_sps_ref (nalparser, nalu, parse_vui_params);
   }
   return res;
 }
@@ -1792,6 +2256,9 @@ gst_h264_parser_parse_subset_sps (GstH264NalParser * nalparser,
 {
   GstH264ParserResult res;
 
+  if (gst_h264_parser_reuse_sps (nalparser, nalu, sps, parse_vui_params))
+    return GST_H264_PARSER_OK;
+
   res = gst_h264_parse_subset_sps (nalu, sps, parse_vui_params);
   if (res == GST_H264_PARSER_OK) {
     GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
@@ -1801,6 +2268,7 @@ gst_h264_parser_parse_subset_sps (GstH264NalParser * nalparser,
       return GST_H264_PARSER_ERROR;
     }
     nalparser->last_sps = &nalparser->sps[sps->id];
+    gst_h264_parser_store_sps_ref (nalparser, nalu, parse_vui_params);
   }
   return res;
 }
@@ -2011,7 +2479,12 @@ GstH264ParserResult
 gst_h264_parser_parse_pps (GstH264NalParser * nalparser,
     GstH264NalUnit * nalu, GstH264PPS * pps)
 {
-  GstH264ParserResult res = gst_h264_parse_pps (nalparser, nalu, pps);
+  GstH264ParserResult res;
+
+  if (gst_h264_parser_reuse_pps (nalparser, nalu, pps))
+    return GST_H264_PARSER_OK;
+
+  res = gst_h264_parse_pps (nalparser, nalu, pps);
 
   if (res == GST_H264_PARSER_OK) {
     GST_DEBUG ("adding picture parameter set with id: %d to array", pps->id);
@@ -2019,6 +2492,7 @@ gst_h264_parser_parse_pps (GstH264NalParser * nalparser,
     if (!gst_h264_pps_copy (&nalparser->pps[pps->id], pps))
       return GST_H264_PARSER_ERROR;
     nalparser->last_pps = &nalparser->pps[pps->id];
+    gst_h264_parser_store_pps_ref (nalparser, nalu);
   }
 
   return res;
@@ -2279,6 +2753,8 @@ gst_h264_sps_clear (GstH264SPS * sps)
  * Parses @nalu containing one or more Supplementary Enhancement Information messages,
  * and allocates and fills the @messages array.
  *
+ * The user data of the messages is only valid until @messages is freed.
+ *
  * Returns: a #GstH264ParserResult
  */
 GstH264ParserResult
@@ -2293,13 +2769,16 @@ gst_h264_parser_parse_sei (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
   nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
       nalu->size - nalu->header_bytes);
   *messages = g_array_new (FALSE, FALSE, sizeof (GstH264SEIMessage));
+  g_array_set_clear_func (*messages, (GDestroyNotify) gst_h264_sei_clear);
 
   do {
     res = gst_h264_parser_parse_sei_message (nalparser, &nr, &sei);
-    if (res == GST_H264_PARSER_OK)
+    if (res == GST_H264_PARSER_OK) {
       g_array_append_val (*messages, sei);
-    else
+    } else {
+      gst_h264_sei_clear (&sei);
       break;
+    }
   } while (nal_reader_has_more_data (&nr));
 
   return res;
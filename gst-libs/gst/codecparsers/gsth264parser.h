@@ -227,6 +227,10 @@ typedef enum
  * GstH264SEIPayloadType:
  * @GST_H264_SEI_BUF_PERIOD: Buffering Period SEI Message
  * @GST_H264_SEI_PIC_TIMING: Picture Timing SEI Message
+ * @GST_H264_SEI_REGISTERED_USER_DATA: Registered user data (D.2.5)
+ *     (Since: 1.14)
+ * @GST_H264_SEI_USER_DATA_UNREGISTERED: Unregistered user data (D.2.6)
+ *     (Since: 1.14)
  * @GST_H264_SEI_RECOVERY_POINT: Recovery Point SEI Message (D.2.7)
  * @GST_H264_SEI_STEREO_VIDEO_INFO: stereo video info SEI message (Since: 1.6)
  * @GST_H264_SEI_FRAME_PACKING: Frame Packing Arrangement (FPA) message that
@@ -239,6 +243,8 @@ typedef enum
 {
   GST_H264_SEI_BUF_PERIOD = 0,
   GST_H264_SEI_PIC_TIMING = 1,
+  GST_H264_SEI_REGISTERED_USER_DATA = 4,
+  GST_H264_SEI_USER_DATA_UNREGISTERED = 5,
   GST_H264_SEI_RECOVERY_POINT = 6,
   GST_H264_SEI_STEREO_VIDEO_INFO = 21,
   GST_H264_SEI_FRAME_PACKING = 45
@@ -295,6 +301,7 @@ typedef enum
 } GstH264SliceType;
 
 typedef struct _GstH264NalParser              GstH264NalParser;
+typedef struct _GstH264NalParserSnapshot      GstH264NalParserSnapshot;
 
 typedef struct _GstH264NalUnit                GstH264NalUnit;
 typedef struct _GstH264NalUnitExtensionMVC    GstH264NalUnitExtensionMVC;
@@ -319,6 +326,8 @@ typedef struct _GstH264ClockTimestamp         GstH264ClockTimestamp;
 typedef struct _GstH264PicTiming              GstH264PicTiming;
 typedef struct _GstH264BufferingPeriod        GstH264BufferingPeriod;
 typedef struct _GstH264RecoveryPoint          GstH264RecoveryPoint;
+typedef struct _GstH264RegisteredUserData     GstH264RegisteredUserData;
+typedef struct _GstH264UserDataUnregistered   GstH264UserDataUnregistered;
 typedef struct _GstH264StereoVideoInfo        GstH264StereoVideoInfo;
 typedef struct _GstH264FramePacking           GstH264FramePacking;
 typedef struct _GstH264SEIMessage             GstH264SEIMessage;
@@ -987,6 +996,46 @@ struct _GstH264RecoveryPoint
   guint8 changing_slice_group_idc;
 };
 
+/**
+ * GstH264RegisteredUserData:
+ * @country_code: an itu_t_t35_country_code
+ * @country_code_extension: an itu_t_t35_country_code_extension_byte, only
+ *     meaningful if @country_code is 0xff
+ * @data: the itu_t_t35_payload_bytes, without the country code
+ * @size: the size of @data in bytes
+ *
+ * User data registered by Rec. ITU-T T.35 SEI message, e.g. the ATSC A/53
+ * closed captions. @data belongs to the #GstH264SEIMessage array it was
+ * parsed in.
+ *
+ * Since: 1.14
+ */
+struct _GstH264RegisteredUserData
+{
+  guint8 country_code;
+  guint8 country_code_extension;
+  const guint8 *data;
+  guint size;
+};
+
+/**
+ * GstH264UserDataUnregistered:
+ * @uuid: the uuid_iso_iec_11578 identifying the user data
+ * @data: the user_data_payload_bytes
+ * @size: the size of @data in bytes
+ *
+ * Unregistered user data SEI message. @data belongs to the
+ * #GstH264SEIMessage array it was parsed in.
+ *
+ * Since: 1.14
+ */
+struct _GstH264UserDataUnregistered
+{
+  guint8 uuid[16];
+  const guint8 *data;
+  guint size;
+};
+
 struct _GstH264SEIMessage
 {
   GstH264SEIPayloadType payloadType;
@@ -994,6 +1043,8 @@ struct _GstH264SEIMessage
   union {
     GstH264BufferingPeriod buffering_period;
     GstH264PicTiming pic_timing;
+    GstH264RegisteredUserData registered_user_data;
+    GstH264UserDataUnregistered user_data_unregistered;
     GstH264RecoveryPoint recovery_point;
     GstH264StereoVideoInfo stereo_video_info;
     GstH264FramePacking frame_packing;
@@ -1013,6 +1064,11 @@ struct _GstH264NalParser
   GstH264PPS pps[GST_H264_MAX_PPS_COUNT];
   GstH264SPS *last_sps;
   GstH264PPS *last_pps;
+
+  /* immutable copies of the parameter sets and of the NAL units they come
+   * from, shared with the snapshots */
+  gpointer sps_refs[GST_H264_MAX_SPS_COUNT];
+  gpointer pps_refs[GST_H264_MAX_PPS_COUNT];
 };
 
 GstH264NalParser *gst_h264_nal_parser_new             (void);
@@ -1050,6 +1106,13 @@ GstH264ParserResult gst_h264_parser_parse_sei         (GstH264NalParser *nalpars
 
 void gst_h264_nal_parser_free                         (GstH264NalParser *nalparser);
 
+GstH264NalParserSnapshot * gst_h264_nal_parser_snapshot (GstH264NalParser *nalparser);
+
+void gst_h264_nal_parser_restore                      (GstH264NalParser *nalparser,
+                                                       GstH264NalParserSnapshot *snapshot);
+
+void gst_h264_nal_parser_snapshot_free                (GstH264NalParserSnapshot *snapshot);
+
 GstH264ParserResult gst_h264_parse_subset_sps         (GstH264NalUnit *nalu,
                                                        GstH264SPS *sps, gboolean parse_vui_params);
 
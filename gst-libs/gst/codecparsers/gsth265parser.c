@@ -1086,6 +1086,227 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/* A parameter set and the NAL unit it was parsed from. These are never
+ * modified once stored, so that the parser and its snapshots can share
+ * them */
+typedef struct
+{
+  gint ref_count;
+
+  /* the NAL unit, header included, NULL if unknown */
+  guint8 *nal;
+  guint nal_size;
+  gboolean parse_vui_params;
+
+  union
+  {
+    GstH265VPS vps;
+    GstH265SPS sps;
+    GstH265PPS pps;
+  } u;
+} GstH265ParamSetRef;
+
+struct _GstH265ParserSnapshot
+{
+  GstH265Parser *parser;
+  GstH265ParamSetRef *vps[GST_H265_MAX_VPS_COUNT];
+  GstH265ParamSetRef *sps[GST_H265_MAX_SPS_COUNT];
+  GstH265ParamSetRef *pps[GST_H265_MAX_PPS_COUNT];
+  gint last_vps_id;
+  gint last_sps_id;
+  gint last_pps_id;
+};
+
+static GstH265ParamSetRef *
+gst_h265_param_set_ref_new (GstH265NalUnit * nalu, gboolean parse_vui_params)
+{
+  GstH265ParamSetRef *ref = g_slice_new0 (GstH265ParamSetRef);
+
+  ref->ref_count = 1;
+  if (nalu) {
+    ref->nal = g_memdup (nalu->data + nalu->offset, nalu->size);
+    ref->nal_size = nalu->size;
+  }
+  ref->parse_vui_params = parse_vui_params;
+
+  return ref;
+}
+
+static GstH265ParamSetRef *
+gst_h265_param_set_ref_ref (GstH265ParamSetRef * ref)
+{
+  g_atomic_int_inc (&ref->ref_count);
+  return ref;
+}
+
+static void
+gst_h265_param_set_ref_unref (GstH265ParamSetRef * ref)
+{
+  if (!g_atomic_int_dec_and_test (&ref->ref_count))
+    return;
+
+  g_free (ref->nal);
+  g_slice_free (GstH265ParamSetRef, ref);
+}
+
+/* Takes ownership of @ref */
+static void
+gst_h265_param_set_ref_take (gpointer * ptr, GstH265ParamSetRef * ref)
+{
+  GstH265ParamSetRef *old = *ptr;
+
+  *ptr = ref;
+  if (old)
+    gst_h265_param_set_ref_unref (old);
+}
+
+/* Whether @nalu is the NAL unit @ref was parsed from */
+static gboolean
+gst_h265_param_set_ref_matches (GstH265ParamSetRef * ref,
+    GstH265NalUnit * nalu, gboolean parse_vui_params)
+{
+  return ref && ref->nal && ref->nal_size == nalu->size &&
+      (ref->parse_vui_params || !parse_vui_params) &&
+      memcmp (ref->nal, nalu->data + nalu->offset, nalu->size) == 0;
+}
+
+/* Reads the id of a VPS, SPS or PPS without parsing the rest of it */
+static gboolean
+gst_h265_parser_peek_param_set_id (GstH265NalUnit * nalu, guint32 * id)
+{
+  NalReader nr;
+  GstH265ProfileTierLevel ptl;
+  guint8 max_sub_layers_minus1;
+
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  switch (nalu->type) {
+    case GST_H265_NAL_VPS:
+      return nal_reader_get_bits_uint32 (&nr, id, 4);
+    case GST_H265_NAL_SPS:
+      /* vps id, sub layers and profile come first */
+      if (!nal_reader_skip (&nr, 4) ||
+          !nal_reader_get_bits_uint8 (&nr, &max_sub_layers_minus1, 3) ||
+          !nal_reader_skip (&nr, 1) ||
+          !gst_h265_parse_profile_tier_level (&ptl, &nr,
+              max_sub_layers_minus1))
+        return FALSE;
+      return nal_reader_get_ue (&nr, id) && *id < GST_H265_MAX_SPS_COUNT;
+    case GST_H265_NAL_PPS:
+      return nal_reader_get_ue (&nr, id) && *id < GST_H265_MAX_PPS_COUNT;
+    default:
+      return FALSE;
+  }
+}
+
+/* The reuse functions fill the parameter set from the stored copy if
+ * @nalu is the same parameter set as last time */
+static gboolean
+gst_h265_parser_reuse_vps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265VPS * vps)
+{
+  guint32 id;
+
+  if (!gst_h265_parser_peek_param_set_id (nalu, &id) ||
+      !gst_h265_param_set_ref_matches (parser->vps_refs[id], nalu, FALSE))
+    return FALSE;
+
+  GST_DEBUG ("video parameter set with id: %d did not change", id);
+  *vps = parser->vps[id];
+  parser->last_vps = &parser->vps[id];
+
+  return TRUE;
+}
+
+static gboolean
+gst_h265_parser_reuse_sps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265SPS * sps, gboolean parse_vui_params)
+{
+  guint32 id;
+
+  if (!gst_h265_parser_peek_param_set_id (nalu, &id) ||
+      !gst_h265_param_set_ref_matches (parser->sps_refs[id], nalu,
+          parse_vui_params))
+    return FALSE;
+
+  GST_DEBUG ("sequence parameter set with id: %d did not change", id);
+  *sps = parser->sps[id];
+  parser->last_sps = &parser->sps[id];
+
+  return TRUE;
+}
+
+static gboolean
+gst_h265_parser_reuse_pps (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265PPS * pps)
+{
+  guint32 id;
+
+  if (!gst_h265_parser_peek_param_set_id (nalu, &id) ||
+      !gst_h265_param_set_ref_matches (parser->pps_refs[id], nalu, FALSE))
+    return FALSE;
+
+  GST_DEBUG ("picture parameter set with id: %d did not change", id);
+  *pps = parser->pps[id];
+  parser->last_pps = &parser->pps[id];
+
+  return TRUE;
+}
+
+static void
+gst_h265_parser_store_vps_ref (GstH265Parser * parser, GstH265NalUnit * nalu)
+{
+  GstH265VPS *vps = parser->last_vps;
+  GstH265ParamSetRef *ref;
+  guint i;
+
+  ref = gst_h265_param_set_ref_new (nalu, FALSE);
+  ref->u.vps = *vps;
+  gst_h265_param_set_ref_take (&parser->vps_refs[vps->id], ref);
+
+  /* SPS parsed before any VPS have to be parsed again to be linked to it,
+   * the others only point to it and don't depend on its content */
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
+    GstH265ParamSetRef *sps_ref = parser->sps_refs[i];
+
+    if (sps_ref && sps_ref->u.sps.vps == NULL)
+      gst_h265_param_set_ref_take (&parser->sps_refs[i], NULL);
+  }
+}
+
+static void
+gst_h265_parser_store_sps_ref (GstH265Parser * parser, GstH265NalUnit * nalu,
+    gboolean parse_vui_params)
+{
+  GstH265SPS *sps = parser->last_sps;
+  GstH265ParamSetRef *ref;
+  guint i;
+
+  ref = gst_h265_param_set_ref_new (nalu, parse_vui_params);
+  ref->u.sps = *sps;
+  gst_h265_param_set_ref_take (&parser->sps_refs[sps->id], ref);
+
+  /* the PPS using it have to be parsed again when they are resent */
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
+    GstH265ParamSetRef *pps_ref = parser->pps_refs[i];
+
+    if (pps_ref && pps_ref->u.pps.sps == sps)
+      gst_h265_param_set_ref_take (&parser->pps_refs[i], NULL);
+  }
+}
+
+static void
+gst_h265_parser_store_pps_ref (GstH265Parser * parser, GstH265NalUnit * nalu)
+{
+  GstH265PPS *pps = parser->last_pps;
+  GstH265ParamSetRef *ref;
+
+  ref = gst_h265_param_set_ref_new (nalu, FALSE);
+  ref->u.pps = *pps;
+  gst_h265_param_set_ref_take (&parser->pps_refs[pps->id], ref);
+}
+
 /******** API *************/
 
 /**
@@ -1116,10 +1337,177 @@ gst_h265_parser_new (void)
 void
 gst_h265_parser_free (GstH265Parser * parser)
 {
+  guint i;
+
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++)
+    gst_h265_param_set_ref_take (&parser->vps_refs[i], NULL);
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++)
+    gst_h265_param_set_ref_take (&parser->sps_refs[i], NULL);
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
+    gst_h265_param_set_ref_take (&parser->pps_refs[i], NULL);
   g_slice_free (GstH265Parser, parser);
   parser = NULL;
 }
 
+/**
+ * GstH265ParserSnapshot:
+ *
+ * The parameter sets known by a #GstH265Parser at some point
+ * (opaque structure).
+ *
+ * Since: 1.14
+ */
+
+/* Returns a reference to the stored copy of @param_set, creating it if
+ * needed, e.g. when it was dropped because a parameter set it depends on
+ * changed */
+static GstH265ParamSetRef *
+gst_h265_parser_snapshot_ref (gpointer * ref_ptr, gconstpointer param_set,
+    gsize size)
+{
+  if (*ref_ptr == NULL) {
+    GstH265ParamSetRef *ref = gst_h265_param_set_ref_new (NULL, FALSE);
+
+    memcpy (&ref->u, param_set, size);
+    *ref_ptr = ref;
+  }
+
+  return gst_h265_param_set_ref_ref (*ref_ptr);
+}
+
+/**
+ * gst_h265_parser_snapshot:
+ * @parser: a #GstH265Parser
+ *
+ * Saves the parameter sets currently known by @parser, so that they can
+ * be brought back later with gst_h265_parser_restore(), e.g. when going
+ * back to a splice point.
+ *
+ * The parameter sets are shared between @parser and its snapshots and
+ * are not copied, so this is cheap.
+ *
+ * Returns: (transfer full): a new #GstH265ParserSnapshot, free with
+ *     gst_h265_parser_snapshot_free()
+ *
+ * Since: 1.14
+ */
+GstH265ParserSnapshot *
+gst_h265_parser_snapshot (GstH265Parser * parser)
+{
+  GstH265ParserSnapshot *snapshot;
+  guint i;
+
+  g_return_val_if_fail (parser != NULL, NULL);
+
+  snapshot = g_slice_new0 (GstH265ParserSnapshot);
+  snapshot->parser = parser;
+
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
+    if (parser->vps[i].valid)
+      snapshot->vps[i] = gst_h265_parser_snapshot_ref (&parser->vps_refs[i],
+          &parser->vps[i], sizeof (GstH265VPS));
+  }
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
+    if (parser->sps[i].valid)
+      snapshot->sps[i] = gst_h265_parser_snapshot_ref (&parser->sps_refs[i],
+          &parser->sps[i], sizeof (GstH265SPS));
+  }
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
+    if (parser->pps[i].valid)
+      snapshot->pps[i] = gst_h265_parser_snapshot_ref (&parser->pps_refs[i],
+          &parser->pps[i], sizeof (GstH265PPS));
+  }
+
+  snapshot->last_vps_id =
+      parser->last_vps ? parser->last_vps - parser->vps : -1;
+  snapshot->last_sps_id =
+      parser->last_sps ? parser->last_sps - parser->sps : -1;
+  snapshot->last_pps_id =
+      parser->last_pps ? parser->last_pps - parser->pps : -1;
+
+  return snapshot;
+}
+
+/* Copies @ref back into @param_set, if it changed */
+static void
+gst_h265_parser_restore_param_set (gpointer * ref_ptr, GstH265ParamSetRef * ref,
+    gpointer param_set, gboolean valid, gsize size)
+{
+  if (ref == *ref_ptr && (ref || !valid))
+    return;
+
+  if (ref)
+    memcpy (param_set, &ref->u, size);
+  else
+    memset (param_set, 0, size);
+
+  gst_h265_param_set_ref_take (ref_ptr,
+      ref ? gst_h265_param_set_ref_ref (ref) : NULL);
+}
+
+/**
+ * gst_h265_parser_restore:
+ * @parser: a #GstH265Parser
+ * @snapshot: a #GstH265ParserSnapshot of @parser
+ *
+ * Brings the parameter sets of @parser back to what they were when
+ * @snapshot was taken. Only the parameter sets that changed since then
+ * are copied back.
+ *
+ * Since: 1.14
+ */
+void
+gst_h265_parser_restore (GstH265Parser * parser,
+    GstH265ParserSnapshot * snapshot)
+{
+  guint i;
+
+  g_return_if_fail (parser != NULL);
+  g_return_if_fail (snapshot != NULL);
+  g_return_if_fail (snapshot->parser == parser);
+
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++)
+    gst_h265_parser_restore_param_set (&parser->vps_refs[i], snapshot->vps[i],
+        &parser->vps[i], parser->vps[i].valid, sizeof (GstH265VPS));
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++)
+    gst_h265_parser_restore_param_set (&parser->sps_refs[i], snapshot->sps[i],
+        &parser->sps[i], parser->sps[i].valid, sizeof (GstH265SPS));
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
+    gst_h265_parser_restore_param_set (&parser->pps_refs[i], snapshot->pps[i],
+        &parser->pps[i], parser->pps[i].valid, sizeof (GstH265PPS));
+
+  parser->last_vps = snapshot->last_vps_id >= 0 ?
+      &parser->vps[snapshot->last_vps_id] : NULL;
+  parser->last_sps = snapshot->last_sps_id >= 0 ?
+      &parser->sps[snapshot->last_sps_id] : NULL;
+  parser->last_pps = snapshot->last_pps_id >= 0 ?
+      &parser->pps[snapshot->last_pps_id] : NULL;
+}
+
+/**
+ * gst_h265_parser_snapshot_free:
+ * @snapshot: the #GstH265ParserSnapshot to free
+ *
+ * Frees @snapshot.
+ *
+ * Since: 1.14
+ */
+void
+gst_h265_parser_snapshot_free (GstH265ParserSnapshot * snapshot)
+{
+  guint i;
+
+  g_return_if_fail (snapshot != NULL);
+
+  for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++)
+    gst_h265_param_set_ref_take ((gpointer *) & snapshot->vps[i], NULL);
+  for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++)
+    gst_h265_param_set_ref_take ((gpointer *) & snapshot->sps[i], NULL);
+  for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
+    gst_h265_param_set_ref_take ((gpointer *) & snapshot->pps[i], NULL);
+  g_slice_free (GstH265ParserSnapshot, snapshot);
+}
+
 /**
  * gst_h265_parser_identify_nalu_unchecked:
  * @parser: a #GstH265Parser
@@ -1345,13 +1733,20 @@ GstH265ParserResult
 gst_h265_parser_parse_vps (GstH265Parser * parser, GstH265NalUnit * nalu,
     GstH265VPS * vps)
 {
-  GstH265ParserResult res = gst_h265_parse_vps (nalu, vps);
+  GstH265ParserResult res;
+
+  /* parameter sets are usually resent unchanged before every keyframe */
+  if (gst_h265_parser_reuse_vps (parser, nalu, vps))
+    return GST_H265_PARSER_OK;
+
+  res = gst_h265_parse_vps (nalu, vps);
 
   if (res == GST_H265_PARSER_OK) {
     GST_DEBUG ("adding video parameter set with id: %d to array", vps->id);
 
     parser->vps[vps->id] = *vps;
     parser->last_vps = &parser->vps[vps->id];
+    gst_h265_parser_store_vps_ref (parser, nalu);
   }
 
   return res;
@@ -1480,14 +1875,19 @@ GstH265ParserResult
 gst_h265_parser_parse_sps (GstH265Parser * parser, GstH265NalUnit * nalu,
     GstH265SPS * sps, gboolean parse_vui_params)
 {
-  GstH265ParserResult res =
-      gst_h265_parse_sps (parser, nalu, sps, parse_vui_params);
+  GstH265ParserResult res;
+
+  if (gst_h265_parser_reuse_sps (parser, nalu, sps, parse_vui_params))
+    return GST_H265_PARSER_OK;
+
+  res = gst_h265_parse_sps (parser, nalu, sps, parse_vui_params);
 
   if (res == GST_H265_PARSER_OK) {
     GST_DEBUG ("adding sequence parameter set with id: %d to array", sps->id);
 
     parser->sps[sps->id] = *sps;
     parser->last_sps = &parser->sps[sps->id];
+    gst_h265_parser_store_sps_ref (parser, nalu, parse_vui_params);
   }
 
   return res;
@@ -1864,12 +2264,18 @@ GstH265ParserResult
 gst_h265_parser_parse_pps (GstH265Parser * parser,
     GstH265NalUnit * nalu, GstH265PPS * pps)
 {
-  GstH265ParserResult res = gst_h265_parse_pps (parser, nalu, pps);
+  GstH265ParserResult res;
+
+  if (gst_h265_parser_reuse_pps (parser, nalu, pps))
+    return GST_H265_PARSER_OK;
+
+  res = gst_h265_parse_pps (parser, nalu, pps);
   if (res == GST_H265_PARSER_OK) {
     GST_DEBUG ("adding picture parameter set with id: %d to array", pps->id);
 
     parser->pps[pps->id] = *pps;
     parser->last_pps = &parser->pps[pps->id];
+    gst_h265_parser_store_pps_ref (parser, nalu);
   }
 
   return res;
@@ -2174,6 +2580,147 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/* Reads the @payload_size remaining bytes of a SEI message, the emulation
+ * prevention bytes being removed */
+static guint8 *
+gst_h265_parser_read_sei_payload_bytes (NalReader * nr, guint payload_size,
+    guint * size)
+{
+  guint8 *data;
+  guint i;
+
+  *size = MIN (payload_size, nal_reader_get_remaining (nr) / 8);
+  data = g_malloc (*size ? *size : 1);
+
+  for (i = 0; i < *size; i++) {
+    if (!nal_reader_get_bits_uint8 (nr, &data[i], 8)) {
+      g_free (data);
+      return NULL;
+    }
+  }
+
+  return data;
+}
+
+static GstH265ParserResult
+gst_h265_parser_parse_registered_user_data (GstH265Parser * parser,
+    GstH265RegisteredUserData * rud, NalReader * nr, guint payload_size)
+{
+  GST_DEBUG ("parsing \"Registered user data\"");
+
+  if (payload_size < 1)
+    goto error;
+
+  READ_UINT8 (nr, rud->country_code, 8);
+  payload_size--;
+
+  if (rud->country_code == 0xff) {
+    if (payload_size < 1)
+      goto error;
+    READ_UINT8 (nr, rud->country_code_extension, 8);
+    payload_size--;
+  }
+
+  rud->data = gst_h265_parser_read_sei_payload_bytes (nr, payload_size,
+      &rud->size);
+  if (!rud->data)
+    goto error;
+
+  return GST_H265_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Registered user data\"");
+  return GST_H265_PARSER_ERROR;
+}
+
+static GstH265ParserResult
+gst_h265_parser_parse_user_data_unregistered (GstH265Parser * parser,
+    GstH265UserDataUnregistered * udu, NalReader * nr, guint payload_size)
+{
+  guint i;
+
+  GST_DEBUG ("parsing \"User data unregistered\"");
+
+  if (payload_size < 16)
+    goto error;
+
+  for (i = 0; i < 16; i++)
+    READ_UINT8 (nr, udu->uuid[i], 8);
+
+  udu->data = gst_h265_parser_read_sei_payload_bytes (nr, payload_size - 16,
+      &udu->size);
+  if (!udu->data)
+    goto error;
+
+  return GST_H265_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"User data unregistered\"");
+  return GST_H265_PARSER_ERROR;
+}
+
+static GstH265ParserResult
+gst_h265_parser_parse_time_code (GstH265Parser * parser,
+    GstH265TimeCode * tc, NalReader * nr)
+{
+  guint i;
+
+  GST_DEBUG ("parsing \"Time code\"");
+
+  READ_UINT8 (nr, tc->num_clock_ts, 2);
+  if (tc->num_clock_ts > 3)
+    goto error;
+
+  for (i = 0; i < tc->num_clock_ts; i++) {
+    READ_UINT8 (nr, tc->clock_timestamp_flag[i], 1);
+    if (!tc->clock_timestamp_flag[i])
+      continue;
+
+    READ_UINT8 (nr, tc->units_field_based_flag[i], 1);
+    READ_UINT8 (nr, tc->counting_type[i], 5);
+    READ_UINT8 (nr, tc->full_timestamp_flag[i], 1);
+    READ_UINT8 (nr, tc->discontinuity_flag[i], 1);
+    READ_UINT8 (nr, tc->cnt_dropped_flag[i], 1);
+    READ_UINT16 (nr, tc->n_frames[i], 9);
+
+    if (tc->full_timestamp_flag[i]) {
+      tc->seconds_flag[i] = tc->minutes_flag[i] = tc->hours_flag[i] = 1;
+      READ_UINT8 (nr, tc->seconds_value[i], 6);
+      READ_UINT8 (nr, tc->minutes_value[i], 6);
+      READ_UINT8 (nr, tc->hours_value[i], 5);
+    } else {
+      READ_UINT8 (nr, tc->seconds_flag[i], 1);
+      if (tc->seconds_flag[i]) {
+        READ_UINT8 (nr, tc->seconds_value[i], 6);
+        READ_UINT8 (nr, tc->minutes_flag[i], 1);
+        if (tc->minutes_flag[i]) {
+          READ_UINT8 (nr, tc->minutes_value[i], 6);
+          READ_UINT8 (nr, tc->hours_flag[i], 1);
+          if (tc->hours_flag[i])
+            READ_UINT8 (nr, tc->hours_value[i], 5);
+        }
+      }
+    }
+
+    READ_UINT8 (nr, tc->time_offset_length[i], 5);
+    if (tc->time_offset_length[i] > 0) {
+      guint32 value;
+
+      READ_UINT32 (nr, value, tc->time_offset_length[i]);
+      /* sign extend the i(v) value */
+      tc->time_offset_value[i] = (gint32) (value <<
+          (32 - tc->time_offset_length[i])) >> (32 -
+          tc->time_offset_length[i]);
+    }
+  }
+
+  return GST_H265_PARSER_OK;
+
+error:
+  GST_WARNING ("error parsing \"Time code\"");
+  return GST_H265_PARSER_ERROR;
+}
+
 static gboolean
 nal_reader_has_more_data_in_payload (NalReader * nr,
     guint32 payload_start_pos_bit, guint32 payloadSize)
@@ -2230,6 +2777,18 @@ gst_h265_parser_parse_sei_message (GstH265Parser * parser,
         res = gst_h265_parser_parse_pic_timing (parser,
             &sei->payload.pic_timing, nr);
         break;
+      case GST_H265_SEI_REGISTERED_USER_DATA:
+        res = gst_h265_parser_parse_registered_user_data (parser,
+            &sei->payload.registered_user_data, nr, payloadSize);
+        break;
+      case GST_H265_SEI_USER_DATA_UNREGISTERED:
+        res = gst_h265_parser_parse_user_data_unregistered (parser,
+            &sei->payload.user_data_unregistered, nr, payloadSize);
+        break;
+      case GST_H265_SEI_TIME_CODE:
+        res = gst_h265_parser_parse_time_code (parser,
+            &sei->payload.time_code, nr);
+        break;
       default:
         /* Just consume payloadSize bytes, which does not account for
            emulation prevention bytes */
@@ -2240,6 +2799,14 @@ gst_h265_parser_parse_sei_message (GstH265Parser * parser,
     }
   } else if (nal_type == GST_H265_NAL_SUFFIX_SEI) {
     switch (sei->payloadType) {
+      case GST_H265_SEI_REGISTERED_USER_DATA:
+        res = gst_h265_parser_parse_registered_user_data (parser,
+            &sei->payload.registered_user_data, nr, payloadSize);
+        break;
+      case GST_H265_SEI_USER_DATA_UNREGISTERED:
+        res = gst_h265_parser_parse_user_data_unregistered (parser,
+            &sei->payload.user_data_unregistered, nr, payloadSize);
+        break;
       default:
         /* Just consume payloadSize bytes, which does not account for
            emulation prevention bytes */
@@ -2366,6 +2933,14 @@ gst_h265_sei_copy (GstH265SEIMessage * dst_sei,
             src_pic_timing->du_cpb_removal_delay_increment_minus1[i];
       }
     }
+  } else if (dst_sei->payloadType == GST_H265_SEI_REGISTERED_USER_DATA) {
+    GstH265RegisteredUserData *rud = &dst_sei->payload.registered_user_data;
+
+    rud->data = g_memdup (rud->data, rud->size);
+  } else if (dst_sei->payloadType == GST_H265_SEI_USER_DATA_UNREGISTERED) {
+    GstH265UserDataUnregistered *udu = &dst_sei->payload.user_data_unregistered;
+
+    udu->data = g_memdup (udu->data, udu->size);
   }
 
   return TRUE;
@@ -2390,6 +2965,12 @@ gst_h265_sei_free (GstH265SEIMessage * sei)
     }
     pic_timing->num_nalus_in_du_minus1 = 0;
     pic_timing->du_cpb_removal_delay_increment_minus1 = 0;
+  } else if (sei->payloadType == GST_H265_SEI_REGISTERED_USER_DATA) {
+    g_free ((guint8 *) sei->payload.registered_user_data.data);
+    sei->payload.registered_user_data.data = NULL;
+  } else if (sei->payloadType == GST_H265_SEI_USER_DATA_UNREGISTERED) {
+    g_free ((guint8 *) sei->payload.user_data_unregistered.data);
+    sei->payload.user_data_unregistered.data = NULL;
   }
 }
 
@@ -2419,10 +3000,12 @@ gst_h265_parser_parse_sei (GstH265Parser * nalparser, GstH265NalUnit * nalu,
 
   do {
     res = gst_h265_parser_parse_sei_message (nalparser, nalu->type, &nr, &sei);
-    if (res == GST_H265_PARSER_OK)
+    if (res == GST_H265_PARSER_OK) {
       g_array_append_val (*messages, sei);
-    else
+    } else {
+      gst_h265_sei_free (&sei);
       break;
+    }
   } while (nal_reader_has_more_data (&nr));
 
   return res;
@@ -155,6 +155,11 @@ typedef enum
  * GstH265SEIPayloadType:
  * @GST_H265_SEI_BUF_PERIOD: Buffering Period SEI Message
  * @GST_H265_SEI_PIC_TIMING: Picture Timing SEI Message
+ * @GST_H265_SEI_REGISTERED_USER_DATA: Registered user data (D.2.6)
+ *     (Since: 1.14)
+ * @GST_H265_SEI_USER_DATA_UNREGISTERED: Unregistered user data (D.2.7)
+ *     (Since: 1.14)
+ * @GST_H265_SEI_TIME_CODE: Time code SEI message (D.2.27) (Since: 1.14)
  * ...
  *
  * The type of SEI message.
@@ -162,7 +167,10 @@ typedef enum
 typedef enum
 {
   GST_H265_SEI_BUF_PERIOD = 0,
-  GST_H265_SEI_PIC_TIMING = 1
+  GST_H265_SEI_PIC_TIMING = 1,
+  GST_H265_SEI_REGISTERED_USER_DATA = 4,
+  GST_H265_SEI_USER_DATA_UNREGISTERED = 5,
+  GST_H265_SEI_TIME_CODE = 136
       /* and more...  */
 } GstH265SEIPayloadType;
 
@@ -229,6 +237,7 @@ typedef enum
 } GstH265QuantMatrixSize;
 
 typedef struct _GstH265Parser                   GstH265Parser;
+typedef struct _GstH265ParserSnapshot           GstH265ParserSnapshot;
 
 typedef struct _GstH265NalUnit                  GstH265NalUnit;
 
@@ -248,6 +257,9 @@ typedef struct _GstH265SliceHdr                 GstH265SliceHdr;
 
 typedef struct _GstH265PicTiming                GstH265PicTiming;
 typedef struct _GstH265BufferingPeriod          GstH265BufferingPeriod;
+typedef struct _GstH265RegisteredUserData       GstH265RegisteredUserData;
+typedef struct _GstH265UserDataUnregistered     GstH265UserDataUnregistered;
+typedef struct _GstH265TimeCode                 GstH265TimeCode;
 typedef struct _GstH265SEIMessage               GstH265SEIMessage;
 
 /**
@@ -970,6 +982,88 @@ struct _GstH265BufferingPeriod
   guint8 vcl_initial_alt_cpb_removal_offset[32];
 };
 
+/**
+ * GstH265RegisteredUserData:
+ * @country_code: an itu_t_t35_country_code
+ * @country_code_extension: an itu_t_t35_country_code_extension_byte, only
+ *     meaningful if @country_code is 0xff
+ * @data: the itu_t_t35_payload_bytes, without the country code
+ * @size: the size of @data in bytes
+ *
+ * User data registered by Rec. ITU-T T.35 SEI message, e.g. the ATSC A/53
+ * closed captions.
+ *
+ * Since: 1.14
+ */
+struct _GstH265RegisteredUserData
+{
+  guint8 country_code;
+  guint8 country_code_extension;
+  const guint8 *data;
+  guint size;
+};
+
+/**
+ * GstH265UserDataUnregistered:
+ * @uuid: the uuid_iso_iec_11578 identifying the user data
+ * @data: the user_data_payload_bytes
+ * @size: the size of @data in bytes
+ *
+ * Unregistered user data SEI message.
+ *
+ * Since: 1.14
+ */
+struct _GstH265UserDataUnregistered
+{
+  guint8 uuid[16];
+  const guint8 *data;
+  guint size;
+};
+
+/**
+ * GstH265TimeCode:
+ * @num_clock_ts: the number of valid entries in the arrays, at most 3
+ * @clock_timestamp_flag: whether the other fields of the entry are present
+ * @units_field_based_flag: whether @n_frames counts fields
+ * @counting_type: the counting_type, 4 meaning dropped frames
+ * @full_timestamp_flag: whether all of @seconds_value, @minutes_value and
+ *     @hours_value are present
+ * @discontinuity_flag: the discontinuity_flag
+ * @cnt_dropped_flag: the cnt_dropped_flag
+ * @n_frames: the n_frames
+ * @seconds_flag: whether @seconds_value is present
+ * @seconds_value: the seconds_value
+ * @minutes_flag: whether @minutes_value is present
+ * @minutes_value: the minutes_value
+ * @hours_flag: whether @hours_value is present
+ * @hours_value: the hours_value
+ * @time_offset_length: the size of @time_offset_value in bits
+ * @time_offset_value: the time_offset_value
+ *
+ * Time code SEI message, with up to one time code per field.
+ *
+ * Since: 1.14
+ */
+struct _GstH265TimeCode
+{
+  guint8 num_clock_ts;
+  guint8 clock_timestamp_flag[3];
+  guint8 units_field_based_flag[3];
+  guint8 counting_type[3];
+  guint8 full_timestamp_flag[3];
+  guint8 discontinuity_flag[3];
+  guint8 cnt_dropped_flag[3];
+  guint16 n_frames[3];
+  guint8 seconds_flag[3];
+  guint8 seconds_value[3];
+  guint8 minutes_flag[3];
+  guint8 minutes_value[3];
+  guint8 hours_flag[3];
+  guint8 hours_value[3];
+  guint8 time_offset_length[3];
+  gint32 time_offset_value[3];
+};
+
 struct _GstH265SEIMessage
 {
   GstH265SEIPayloadType payloadType;
@@ -977,6 +1071,9 @@ struct _GstH265SEIMessage
   union {
     GstH265BufferingPeriod buffering_period;
     GstH265PicTiming pic_timing;
+    GstH265RegisteredUserData registered_user_data;
+    GstH265UserDataUnregistered user_data_unregistered;
+    GstH265TimeCode time_code;
     /* ... could implement more */
   } payload;
 };
@@ -995,6 +1092,12 @@ struct _GstH265Parser
   GstH265VPS *last_vps;
   GstH265SPS *last_sps;
   GstH265PPS *last_pps;
+
+  /* immutable copies of the parameter sets and of the NAL units they come
+   * from, shared with the snapshots */
+  gpointer vps_refs[GST_H265_MAX_VPS_COUNT];
+  gpointer sps_refs[GST_H265_MAX_SPS_COUNT];
+  gpointer pps_refs[GST_H265_MAX_PPS_COUNT];
 };
 
 GstH265Parser *     gst_h265_parser_new               (void);
@@ -1044,6 +1147,13 @@ GstH265ParserResult gst_h265_parser_parse_sei       (GstH265Parser   * parser,
 
 void                gst_h265_parser_free            (GstH265Parser  * parser);
 
+GstH265ParserSnapshot * gst_h265_parser_snapshot    (GstH265Parser  * parser);
+
+void                gst_h265_parser_restore         (GstH265Parser  * parser,
+                                                     GstH265ParserSnapshot * snapshot);
+
+void                gst_h265_parser_snapshot_free   (GstH265ParserSnapshot * snapshot);
+
 GstH265ParserResult gst_h265_parse_vps              (GstH265NalUnit * nalu,
                                                      GstH265VPS     * vps);
 
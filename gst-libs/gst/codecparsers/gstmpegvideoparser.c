@@ -1061,6 +1061,243 @@ gst_mpeg_video_quant_matrix_get_zigzag_from_raster (guint8 out_quant[64],
     out_quant[i] = quant[mpeg_zigzag_8x8[i]];
 }
 
+/* Data and results of one of the ranges gst_mpeg_video_parse_frames()
+ * splits its input into */
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+  /* the start codes starting in [start, end) are handled by this range */
+  guint start;
+  guint end;
+
+  /* GstMpegVideoFrameInfo of the pictures starting in this range */
+  GArray *frames;
+
+  /* picture structure of a picture extension found before any header in
+   * this range, it belongs to the last picture of a previous range */
+  guint8 leading_picture_structure;
+
+  /* headers found after the last picture of this range, they are part of
+   * the first picture of a following range */
+  guint pending_offset;
+  gboolean pending_sequence_header;
+  gboolean pending_gop;
+} FramesRange;
+
+#define NO_OFFSET G_MAXUINT
+
+/* 1MiB per thread at least, below that starting threads costs more than
+ * scanning the data */
+#define MIN_FRAMES_RANGE_SIZE (1024 * 1024)
+
+static gpointer
+parse_frames_range (FramesRange * range)
+{
+  GstMpegVideoPacket packet;
+  GstMpegVideoFrameInfo *last = NULL;
+  guint offset = range->start;
+
+  range->leading_picture_structure = 0;
+  range->pending_offset = NO_OFFSET;
+  range->pending_sequence_header = FALSE;
+  range->pending_gop = FALSE;
+
+  while (offset < range->end &&
+      gst_mpeg_video_parse (&packet, range->data, range->size, offset)) {
+    guint code_offset = packet.offset - 4;
+
+    if (code_offset >= range->end)
+      break;
+
+    /* continue after the packet, it was already scanned for the next start
+     * code */
+    offset = packet.size > 0 ? packet.offset + packet.size : packet.offset;
+    if (packet.size < 0)
+      packet.size = range->size - packet.offset;
+
+    switch (packet.type) {
+      case GST_MPEG_VIDEO_PACKET_SEQUENCE:
+      case GST_MPEG_VIDEO_PACKET_GOP:
+        if (range->pending_offset == NO_OFFSET)
+          range->pending_offset = code_offset;
+        if (packet.type == GST_MPEG_VIDEO_PACKET_SEQUENCE)
+          range->pending_sequence_header = TRUE;
+        else
+          range->pending_gop = TRUE;
+        break;
+      case GST_MPEG_VIDEO_PACKET_PICTURE:{
+        GstMpegVideoFrameInfo frame = { 0, };
+        GstMpegVideoPictureHdr hdr;
+
+        /* a corrupted picture is kept as part of the previous one */
+        if (!gst_mpeg_video_packet_parse_picture_header (&packet, &hdr))
+          break;
+
+        frame.offset = range->pending_offset != NO_OFFSET ?
+            range->pending_offset : code_offset;
+        frame.pic_type = hdr.pic_type;
+        frame.tsn = hdr.tsn;
+        frame.picture_structure = GST_MPEG_VIDEO_PICTURE_STRUCTURE_FRAME;
+        frame.sequence_header = range->pending_sequence_header;
+        frame.gop = range->pending_gop;
+        g_array_append_val (range->frames, frame);
+        last = &g_array_index (range->frames, GstMpegVideoFrameInfo,
+            range->frames->len - 1);
+
+        range->pending_offset = NO_OFFSET;
+        range->pending_sequence_header = FALSE;
+        range->pending_gop = FALSE;
+        break;
+      }
+      case GST_MPEG_VIDEO_PACKET_EXTENSION:{
+        GstMpegVideoPictureExt ext;
+
+        /* extensions after a sequence or GOP header are not about a
+         * picture */
+        if (range->pending_offset != NO_OFFSET ||
+            !gst_mpeg_video_packet_parse_picture_extension (&packet, &ext))
+          break;
+
+        if (last)
+          last->picture_structure = ext.picture_structure;
+        else
+          range->leading_picture_structure = ext.picture_structure;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * gst_mpeg_video_parse_frames:
+ * @data: MPEG-1 or MPEG-2 video elementary stream
+ * @size: The size of @data
+ * @n_threads: the number of threads to use, or 0 to use one per processor
+ *
+ * Finds all the pictures of the elementary stream in @data and parses
+ * their headers. This is meant for indexing complete streams: @data is
+ * split in up to @n_threads ranges which are parsed in parallel, the
+ * calling thread parsing the first one.
+ *
+ * Each field of a field-coded frame is returned as a separate picture.
+ *
+ * Returns: (transfer full) (element-type GstMpegVideoFrameInfo): an array
+ *     of #GstMpegVideoFrameInfo, in stream order.
+ *
+ * Since: 1.14
+ */
+GArray *
+gst_mpeg_video_parse_frames (const guint8 * data, gsize size,
+    guint n_threads)
+{
+  FramesRange *ranges;
+  GThread **threads;
+  GArray *frames;
+  FramesRange *prev = NULL;
+  guint range_size, i, j;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+  g_return_val_if_fail (size < G_MAXUINT, NULL);
+
+  INITIALIZE_DEBUG_CATEGORY;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  n_threads = CLAMP (size / MIN_FRAMES_RANGE_SIZE, 1, n_threads);
+  range_size = size / n_threads;
+
+  GST_DEBUG ("parsing frames of %" G_GSIZE_FORMAT " bytes with %u threads",
+      size, n_threads);
+
+  ranges = g_new0 (FramesRange, n_threads);
+  threads = g_new0 (GThread *, n_threads);
+
+  for (i = 0; i < n_threads; i++) {
+    ranges[i].data = data;
+    ranges[i].size = size;
+    ranges[i].start = i * range_size;
+    ranges[i].end = (i == n_threads - 1) ? size : (i + 1) * range_size;
+    ranges[i].frames = g_array_new (FALSE, FALSE,
+        sizeof (GstMpegVideoFrameInfo));
+
+    if (i > 0)
+      threads[i] = g_thread_new ("mpegvideoparse",
+          (GThreadFunc) parse_frames_range, &ranges[i]);
+  }
+
+  parse_frames_range (&ranges[0]);
+  for (i = 1; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  /* stitch the ranges back together: headers found at the end of a range
+   * start the first picture of the next range that has one, and picture
+   * extensions found at the start of a range complete the last picture
+   * of the previous ones */
+  frames = ranges[0].frames;
+  for (i = 0; i < n_threads; i++) {
+    FramesRange *range = &ranges[i];
+
+    if (i > 0) {
+      if (range->leading_picture_structure && prev == NULL &&
+          frames->len > 0)
+        g_array_index (frames, GstMpegVideoFrameInfo,
+            frames->len - 1).picture_structure =
+            range->leading_picture_structure;
+
+      if (prev && range->frames->len > 0) {
+        GstMpegVideoFrameInfo *first =
+            &g_array_index (range->frames, GstMpegVideoFrameInfo, 0);
+
+        first->offset = prev->pending_offset;
+        first->sequence_header |= prev->pending_sequence_header;
+        first->gop |= prev->pending_gop;
+        prev = NULL;
+      }
+
+      g_array_append_vals (frames, range->frames->data, range->frames->len);
+      g_array_free (range->frames, TRUE);
+    }
+
+    if (range->pending_offset != NO_OFFSET) {
+      if (prev == NULL)
+        prev = range;
+      else {
+        prev->pending_sequence_header |= range->pending_sequence_header;
+        prev->pending_gop |= range->pending_gop;
+      }
+    }
+  }
+
+  /* each picture goes up to the next one, the last one up to the trailing
+   * headers if any */
+  for (j = 0; j < frames->len; j++) {
+    GstMpegVideoFrameInfo *frame =
+        &g_array_index (frames, GstMpegVideoFrameInfo, j);
+    guint end;
+
+    if (j + 1 < frames->len)
+      end = g_array_index (frames, GstMpegVideoFrameInfo, j + 1).offset;
+    else if (prev)
+      end = prev->pending_offset;
+    else
+      end = size;
+
+    frame->size = end - frame->offset;
+  }
+
+  g_free (threads);
+  g_free (ranges);
+
+  GST_DEBUG ("found %u frames", frames->len);
+
+  return frames;
+}
+
 /****** Deprecated API *******/
 
 /**
@@ -199,6 +199,7 @@ typedef struct _GstMpegVideoPictureExt      GstMpegVideoPictureExt;
 typedef struct _GstMpegVideoQuantMatrixExt  GstMpegVideoQuantMatrixExt;
 typedef struct _GstMpegVideoSliceHdr        GstMpegVideoSliceHdr;
 typedef struct _GstMpegVideoPacket          GstMpegVideoPacket;
+typedef struct _GstMpegVideoFrameInfo       GstMpegVideoFrameInfo;
 
 /**
  * GstMpegVideoSequenceHdr:
@@ -501,6 +502,32 @@ struct _GstMpegVideoPacket
   gint   size;
 };
 
+/**
+ * GstMpegVideoFrameInfo:
+ * @offset: the offset in bytes of the picture, that is of the sequence or
+ *     GOP header preceding it if any, or of its picture start code
+ * @size: the size in bytes of the picture, up to the next one
+ * @pic_type: the #GstMpegVideoPictureType of the picture
+ * @tsn: the temporal sequence number of the picture
+ * @picture_structure: the #GstMpegVideoPictureStructure of the picture
+ * @sequence_header: %TRUE if the picture is preceded by a sequence header
+ * @gop: %TRUE if the picture is preceded by a GOP header
+ *
+ * A picture found by gst_mpeg_video_parse_frames().
+ *
+ * Since: 1.14
+ */
+struct _GstMpegVideoFrameInfo
+{
+  guint offset;
+  guint size;
+  guint8 pic_type;
+  guint16 tsn;
+  guint8 picture_structure;
+  gboolean sequence_header;
+  gboolean gop;
+};
+
 gboolean gst_mpeg_video_parse                         (GstMpegVideoPacket * packet,
                                                        const guint8 * data, gsize size, guint offset);
 
@@ -533,6 +560,9 @@ gboolean gst_mpeg_video_packet_parse_slice_header       (const GstMpegVideoPacke
 gboolean gst_mpeg_video_packet_parse_quant_matrix_extension (const GstMpegVideoPacket * packet,
                                                          GstMpegVideoQuantMatrixExt * quant);
 
+GArray * gst_mpeg_video_parse_frames                  (const guint8 * data, gsize size,
+                                                       guint n_threads);
+
 /* seqext and displayext may be NULL if not received */
 gboolean gst_mpeg_video_finalise_mpeg2_sequence_header (GstMpegVideoSequenceHdr *hdr,
    GstMpegVideoSequenceExt *seqext, GstMpegVideoSequenceDisplayExt *displayext);
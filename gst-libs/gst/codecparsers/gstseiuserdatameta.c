@@ -0,0 +1,201 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstseiuserdatameta
+ * @title: GstSEIUserDataMeta
+ * @short_description: H.264 and H.265 user data SEI messages
+ *
+ * The h264parse and h265parse elements attach one #GstSEIUserDataMeta
+ * per registered or unregistered user data SEI message found in an
+ * access unit to the buffer of that access unit.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstseiuserdatameta.h"
+
+GST_DEBUG_CATEGORY (sei_user_data_meta_debug);
+#define GST_CAT_DEFAULT sei_user_data_meta_debug
+
+static gboolean
+gst_sei_user_data_meta_init (GstSEIUserDataMeta * meta, gpointer params,
+    GstBuffer * buffer)
+{
+  meta->type = GST_SEI_USER_DATA_REGISTERED;
+  meta->country_code = meta->country_code_extension = 0;
+  memset (meta->uuid, 0, sizeof (meta->uuid));
+  meta->data = NULL;
+  meta->size = 0;
+
+  return TRUE;
+}
+
+static void
+gst_sei_user_data_meta_free (GstSEIUserDataMeta * meta, GstBuffer * buffer)
+{
+  g_free (meta->data);
+}
+
+static gboolean
+gst_sei_user_data_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstSEIUserDataMeta *smeta = (GstSEIUserDataMeta *) meta;
+  GstSEIUserDataMeta *dmeta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    /* the user data belongs to the whole access unit */
+    if (copy->region)
+      return TRUE;
+
+    if (smeta->type == GST_SEI_USER_DATA_REGISTERED)
+      dmeta = gst_buffer_add_sei_registered_user_data_meta (dest,
+          smeta->country_code, smeta->country_code_extension, smeta->data,
+          smeta->size);
+    else
+      dmeta = gst_buffer_add_sei_unregistered_user_data_meta (dest,
+          smeta->uuid, smeta->data, smeta->size);
+
+    if (!dmeta)
+      return FALSE;
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_sei_user_data_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstSEIUserDataMetaAPI", tags);
+    GST_DEBUG_CATEGORY_INIT (sei_user_data_meta_debug, "seiuserdatameta", 0,
+        "H.264/H.265 SEI user data GstMeta");
+
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_sei_user_data_meta_get_info (void)
+{
+  static const GstMetaInfo *sei_user_data_meta_info = NULL;
+
+  if (g_once_init_enter ((GstMetaInfo **) & sei_user_data_meta_info)) {
+    const GstMetaInfo *meta =
+        gst_meta_register (GST_SEI_USER_DATA_META_API_TYPE,
+        "GstSEIUserDataMeta", sizeof (GstSEIUserDataMeta),
+        (GstMetaInitFunction) gst_sei_user_data_meta_init,
+        (GstMetaFreeFunction) gst_sei_user_data_meta_free,
+        (GstMetaTransformFunction) gst_sei_user_data_meta_transform);
+    g_once_init_leave ((GstMetaInfo **) & sei_user_data_meta_info,
+        (GstMetaInfo *) meta);
+  }
+
+  return sei_user_data_meta_info;
+}
+
+/**
+ * gst_buffer_add_sei_registered_user_data_meta:
+ * @buffer: a #GstBuffer
+ * @country_code: the itu_t_t35_country_code
+ * @country_code_extension: the itu_t_t35_country_code_extension_byte
+ * @data: (array length=size): the payload of the message
+ * @size: the size of @data in bytes
+ *
+ * Adds a #GstSEIUserDataMeta holding a copy of the registered user data
+ * @data to @buffer.
+ *
+ * Returns: (transfer none): the new #GstSEIUserDataMeta
+ *
+ * Since: 1.14
+ */
+GstSEIUserDataMeta *
+gst_buffer_add_sei_registered_user_data_meta (GstBuffer * buffer,
+    guint8 country_code, guint8 country_code_extension, const guint8 * data,
+    gsize size)
+{
+  GstSEIUserDataMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  meta = (GstSEIUserDataMeta *) gst_buffer_add_meta (buffer,
+      GST_SEI_USER_DATA_META_INFO, NULL);
+
+  GST_LOG ("country code 0x%02x/0x%02x, %" G_GSIZE_FORMAT " bytes",
+      country_code, country_code_extension, size);
+
+  meta->type = GST_SEI_USER_DATA_REGISTERED;
+  meta->country_code = country_code;
+  meta->country_code_extension = country_code_extension;
+  meta->data = g_memdup (data, size);
+  meta->size = size;
+
+  return meta;
+}
+
+/**
+ * gst_buffer_add_sei_unregistered_user_data_meta:
+ * @buffer: a #GstBuffer
+ * @uuid: (array fixed-size=16): the uuid_iso_iec_11578
+ * @data: (array length=size): the payload of the message
+ * @size: the size of @data in bytes
+ *
+ * Adds a #GstSEIUserDataMeta holding a copy of the unregistered user data
+ * @data to @buffer.
+ *
+ * Returns: (transfer none): the new #GstSEIUserDataMeta
+ *
+ * Since: 1.14
+ */
+GstSEIUserDataMeta *
+gst_buffer_add_sei_unregistered_user_data_meta (GstBuffer * buffer,
+    const guint8 uuid[16], const guint8 * data, gsize size)
+{
+  GstSEIUserDataMeta *meta;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (uuid != NULL, NULL);
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  meta = (GstSEIUserDataMeta *) gst_buffer_add_meta (buffer,
+      GST_SEI_USER_DATA_META_INFO, NULL);
+
+  GST_LOG ("unregistered user data, %" G_GSIZE_FORMAT " bytes", size);
+
+  meta->type = GST_SEI_USER_DATA_UNREGISTERED;
+  memcpy (meta->uuid, uuid, sizeof (meta->uuid));
+  meta->data = g_memdup (data, size);
+  meta->size = size;
+
+  return meta;
+}
@@ -0,0 +1,99 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SEI_USER_DATA_META_H__
+#define __GST_SEI_USER_DATA_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The codec parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstSEIUserDataMeta GstSEIUserDataMeta;
+
+GType gst_sei_user_data_meta_api_get_type (void);
+#define GST_SEI_USER_DATA_META_API_TYPE  (gst_sei_user_data_meta_api_get_type())
+#define GST_SEI_USER_DATA_META_INFO  (gst_sei_user_data_meta_get_info())
+const GstMetaInfo * gst_sei_user_data_meta_get_info (void);
+
+/**
+ * GstSEIUserDataType:
+ * @GST_SEI_USER_DATA_REGISTERED: user data registered by Rec. ITU-T T.35
+ * @GST_SEI_USER_DATA_UNREGISTERED: user data identified by an UUID
+ *
+ * The kind of user data SEI message a #GstSEIUserDataMeta comes from.
+ *
+ * Since: 1.14
+ */
+typedef enum {
+  GST_SEI_USER_DATA_REGISTERED,
+  GST_SEI_USER_DATA_UNREGISTERED
+} GstSEIUserDataType;
+
+/**
+ * GstSEIUserDataMeta:
+ * @meta: parent #GstMeta
+ * @type: the #GstSEIUserDataType
+ * @country_code: the itu_t_t35_country_code, for registered user data
+ * @country_code_extension: the itu_t_t35_country_code_extension_byte, for
+ *     registered user data with a @country_code of 0xff
+ * @uuid: the uuid_iso_iec_11578, for unregistered user data
+ * @data: the payload of the message, without the fields above
+ * @size: the size of @data in bytes
+ *
+ * Extra buffer metadata holding the user data SEI message of a H.264 or
+ * H.265 access unit, e.g. ATSC A/53 closed captions, which are registered
+ * user data with a @country_code of 0xb5 (USA). There is one meta per
+ * message.
+ *
+ * Since: 1.14
+ */
+struct _GstSEIUserDataMeta {
+  GstMeta            meta;
+
+  GstSEIUserDataType type;
+  guint8             country_code;
+  guint8             country_code_extension;
+  guint8             uuid[16];
+
+  guint8            *data;
+  gsize              size;
+};
+
+#define gst_buffer_get_sei_user_data_meta(b) ((GstSEIUserDataMeta*)gst_buffer_get_meta((b),GST_SEI_USER_DATA_META_API_TYPE))
+
+GstSEIUserDataMeta *
+gst_buffer_add_sei_registered_user_data_meta (GstBuffer * buffer,
+                                              guint8 country_code,
+                                              guint8 country_code_extension,
+                                              const guint8 * data,
+                                              gsize size);
+
+GstSEIUserDataMeta *
+gst_buffer_add_sei_unregistered_user_data_meta (GstBuffer * buffer,
+                                                const guint8 uuid[16],
+                                                const guint8 * data,
+                                                gsize size);
+
+G_END_DECLS
+
+#endif /* __GST_SEI_USER_DATA_META_H__ */
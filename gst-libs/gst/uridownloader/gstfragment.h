@@ -50,7 +50,10 @@ struct _GstFragment
   gchar * name;                 /* Name of the fragment */
   gboolean completed;           /* Whether the fragment is complete or not */
   guint64 download_start_time;  /* Epoch time when the download started */
+  guint64 download_first_byte_time; /* Epoch time when the first byte was received */
   guint64 download_stop_time;   /* Epoch time when the download finished */
+  gboolean reused_source;       /* Whether an already opened source element
+                                   (and its kept-alive connection) was used */
   guint64 start_time;           /* Start time of the fragment */
   guint64 stop_time;            /* Stop time of the fragment */
   gboolean index;               /* Index of the fragment */
@@ -48,8 +48,50 @@ struct _GstUriDownloaderPrivate
 
   GCond cond;
   gboolean cancelled;
+
+  /* Whether the last gst_uri_downloader_ensure_src() kept the source */
+  gboolean reused_src;
+
+  /* Asynchronous fetches. Each request is run by a thread of @requests on
+   * a child downloader of the request's host. A child owns a persistent
+   * source element, so keeping children per host lets the source keep its
+   * connection alive between requests */
+  GMutex pool_lock;
+  GThreadPool *requests;
+  GHashTable *hosts;            /* "scheme://host:port" -> GstUriDownloaderHost */
+  guint max_connections_per_host;
+  guint generation;             /* incremented on cancel */
 };
 
+typedef struct
+{
+  GQueue idle;                  /* child downloaders, most recently used first */
+  GList *busy;
+  guint n_children;
+  GQueue pending;               /* requests waiting for a child */
+} GstUriDownloaderHost;
+
+typedef struct
+{
+  gchar *uri;
+  gchar *host;
+  gchar *referer;
+  gboolean compress;
+  gboolean refresh;
+  gboolean allow_cache;
+  gint64 range_start;
+  gint64 range_end;
+  guint generation;
+  GstUriDownloader *child;      /* NULL if the request was cancelled */
+
+  GstUriDownloaderFetchCallback callback;
+  gpointer user_data;
+  GDestroyNotify notify;
+} GstUriDownloaderRequest;
+
+#define DEFAULT_MAX_CONNECTIONS_PER_HOST 2
+#define MAX_ASYNC_REQUESTS 8
+
 static void gst_uri_downloader_finalize (GObject * object);
 static void gst_uri_downloader_dispose (GObject * object);
 
@@ -63,6 +105,8 @@ static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
 static gboolean gst_uri_downloader_ensure_src (GstUriDownloader * downloader,
     const gchar * uri);
 static void gst_uri_downloader_destroy_src (GstUriDownloader * downloader);
+static void gst_uri_downloader_cancel_async (GstUriDownloader * downloader);
+static void gst_uri_downloader_host_free (GstUriDownloaderHost * host);
 
 static GstStaticPadTemplate sinkpadtemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -111,6 +155,12 @@ gst_uri_downloader_init (GstUriDownloader * downloader)
 
   g_mutex_init (&downloader->priv->download_lock);
   g_cond_init (&downloader->priv->cond);
+
+  g_mutex_init (&downloader->priv->pool_lock);
+  downloader->priv->hosts = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gst_uri_downloader_host_free);
+  downloader->priv->max_connections_per_host =
+      DEFAULT_MAX_CONNECTIONS_PER_HOST;
 }
 
 static void
@@ -118,6 +168,17 @@ gst_uri_downloader_dispose (GObject * object)
 {
   GstUriDownloader *downloader = GST_URI_DOWNLOADER (object);
 
+  /* pending asynchronous requests complete with a cancellation error */
+  if (downloader->priv->requests) {
+    gst_uri_downloader_cancel_async (downloader);
+    g_thread_pool_free (downloader->priv->requests, FALSE, TRUE);
+    downloader->priv->requests = NULL;
+  }
+  if (downloader->priv->hosts) {
+    g_hash_table_unref (downloader->priv->hosts);
+    downloader->priv->hosts = NULL;
+  }
+
   gst_uri_downloader_destroy_src (downloader);
 
   if (downloader->priv->bus != NULL) {
@@ -147,6 +208,7 @@ gst_uri_downloader_finalize (GObject * object)
 
   g_mutex_clear (&downloader->priv->download_lock);
   g_cond_clear (&downloader->priv->cond);
+  g_mutex_clear (&downloader->priv->pool_lock);
 
   G_OBJECT_CLASS (gst_uri_downloader_parent_class)->finalize (object);
 }
@@ -336,6 +398,9 @@ gst_uri_downloader_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   GST_LOG_OBJECT (downloader, "The uri fetcher received a new buffer "
       "of size %" G_GSIZE_FORMAT, gst_buffer_get_size (buf));
+  if (!downloader->priv->got_buffer)
+    downloader->priv->download->download_first_byte_time =
+        gst_util_get_timestamp ();
   downloader->priv->got_buffer = TRUE;
   if (!gst_fragment_add_buffer (downloader->priv->download, buf)) {
     GST_WARNING_OBJECT (downloader, "Could not add buffer to fragment");
@@ -362,6 +427,8 @@ gst_uri_downloader_reset (GstUriDownloader * downloader)
 void
 gst_uri_downloader_cancel (GstUriDownloader * downloader)
 {
+  gst_uri_downloader_cancel_async (downloader);
+
   GST_OBJECT_LOCK (downloader);
   if (downloader->priv->download != NULL) {
     GST_DEBUG_OBJECT (downloader, "Cancelling download");
@@ -403,6 +470,8 @@ gst_uri_downloader_set_range (GstUriDownloader * downloader,
 static gboolean
 gst_uri_downloader_ensure_src (GstUriDownloader * downloader, const gchar * uri)
 {
+  downloader->priv->reused_src = FALSE;
+
   if (downloader->priv->urisrc) {
     gchar *old_protocol, *new_protocol;
     gchar *old_uri;
@@ -425,6 +494,8 @@ gst_uri_downloader_ensure_src (GstUriDownloader * downloader, const gchar * uri)
             "Failed to re-use old source element: %s", err->message);
         g_clear_error (&err);
         gst_uri_downloader_destroy_src (downloader);
+      } else {
+        downloader->priv->reused_src = TRUE;
       }
     }
     g_free (old_uri);
@@ -585,6 +656,7 @@ gst_uri_downloader_fetch_uri_with_range (GstUriDownloader *
   downloader->priv->download = gst_fragment_new ();
   downloader->priv->download->range_start = range_start;
   downloader->priv->download->range_end = range_end;
+  downloader->priv->download->reused_source = downloader->priv->reused_src;
   GST_OBJECT_UNLOCK (downloader);
   ret = gst_element_set_state (downloader->priv->urisrc, GST_STATE_READY);
   GST_OBJECT_LOCK (downloader);
@@ -721,3 +793,324 @@ quit:
     return download;
   }
 }
+
+static void
+gst_uri_downloader_host_free (GstUriDownloaderHost * host)
+{
+  GstUriDownloader *child;
+
+  /* only idle children are left once the requests pool is gone */
+  g_warn_if_fail (host->busy == NULL);
+  g_warn_if_fail (g_queue_is_empty (&host->pending));
+
+  while ((child = g_queue_pop_head (&host->idle)))
+    gst_object_unref (child);
+  g_slice_free (GstUriDownloaderHost, host);
+}
+
+static void
+gst_uri_downloader_request_free (GstUriDownloaderRequest * request)
+{
+  if (request->notify)
+    request->notify (request->user_data);
+  g_free (request->uri);
+  g_free (request->host);
+  g_free (request->referer);
+  g_slice_free (GstUriDownloaderRequest, request);
+}
+
+/* Port used by @scheme when the URI doesn't give one */
+static guint
+gst_uri_downloader_get_default_port (const gchar * scheme)
+{
+  static const struct
+  {
+    const gchar *scheme;
+    guint port;
+  } default_ports[] = {
+    {"http", 80}, {"https", 443}, {"ftp", 21}, {"rtsp", 554},
+  };
+  gint i;
+
+  if (!scheme)
+    return GST_URI_NO_PORT;
+
+  for (i = 0; i < G_N_ELEMENTS (default_ports); i++) {
+    if (g_ascii_strcasecmp (scheme, default_ports[i].scheme) == 0)
+      return default_ports[i].port;
+  }
+
+  return GST_URI_NO_PORT;
+}
+
+/* Key under which connections to the server of @uri are pooled. URIs that
+ * only differ in whether they give the scheme's default port explicitly
+ * share their connections */
+static gchar *
+gst_uri_downloader_get_host_key (const gchar * uri)
+{
+  GstUri *gst_uri;
+  const gchar *scheme;
+  guint port;
+  gchar *key, *lower;
+
+  gst_uri = gst_uri_from_string (uri);
+  if (!gst_uri)
+    return g_strdup (uri);
+
+  scheme = gst_uri_get_scheme (gst_uri);
+  port = gst_uri_get_port (gst_uri);
+  if (port == GST_URI_NO_PORT)
+    port = gst_uri_downloader_get_default_port (scheme);
+
+  key = g_strdup_printf ("%s://%s:%u", GST_STR_NULL (scheme),
+      GST_STR_NULL (gst_uri_get_host (gst_uri)), port);
+  gst_uri_unref (gst_uri);
+
+  /* schemes and host names are case insensitive */
+  lower = g_ascii_strdown (key, -1);
+  g_free (key);
+
+  return lower;
+}
+
+/* Hands the pending requests of @host to the requests pool for as long as
+ * the host has an idle child downloader or is below its connection limit.
+ * Requests that can't be run yet stay queued on the host, so that a slow
+ * host never holds a thread of the pool that other hosts could use.
+ * Must be called with the pool lock */
+static void
+gst_uri_downloader_dispatch_pending (GstUriDownloader * downloader,
+    GstUriDownloaderHost * host)
+{
+  GstUriDownloaderPrivate *priv = downloader->priv;
+  GstUriDownloaderRequest *request;
+
+  while ((request = g_queue_peek_head (&host->pending))) {
+    GstUriDownloader *child = g_queue_pop_head (&host->idle);
+
+    if (!child) {
+      GstElement *parent;
+
+      if (host->n_children >= priv->max_connections_per_host)
+        break;
+
+      GST_DEBUG_OBJECT (downloader, "Opening connection %u to %s",
+          host->n_children, request->host);
+      child = gst_uri_downloader_new ();
+      parent = g_weak_ref_get (&priv->parent);
+      if (parent) {
+        gst_uri_downloader_set_parent (child, parent);
+        gst_object_unref (parent);
+      }
+      host->n_children++;
+    }
+
+    g_queue_pop_head (&host->pending);
+    /* clear a cancellation that raced with the previous request */
+    gst_uri_downloader_reset (child);
+    host->busy = g_list_prepend (host->busy, child);
+    request->child = child;
+    g_thread_pool_push (priv->requests, request, NULL);
+  }
+}
+
+/* Queues @request on its host and runs it as soon as the host has a child
+ * downloader for it. Must be called with the pool lock */
+static void
+gst_uri_downloader_queue_request (GstUriDownloader * downloader,
+    GstUriDownloaderRequest * request)
+{
+  GstUriDownloaderPrivate *priv = downloader->priv;
+  GstUriDownloaderHost *host;
+
+  host = g_hash_table_lookup (priv->hosts, request->host);
+  if (!host) {
+    host = g_slice_new0 (GstUriDownloaderHost);
+    g_queue_init (&host->idle);
+    g_queue_init (&host->pending);
+    g_hash_table_insert (priv->hosts, g_strdup (request->host), host);
+  }
+
+  g_queue_push_tail (&host->pending, request);
+  gst_uri_downloader_dispatch_pending (downloader, host);
+}
+
+/* Returns the child downloader of a finished request to its host and starts
+ * the next request waiting for the host */
+static void
+gst_uri_downloader_release_child (GstUriDownloader * downloader,
+    GstUriDownloaderRequest * request)
+{
+  GstUriDownloaderPrivate *priv = downloader->priv;
+  GstUriDownloaderHost *host;
+
+  g_mutex_lock (&priv->pool_lock);
+  host = g_hash_table_lookup (priv->hosts, request->host);
+  host->busy = g_list_remove (host->busy, request->child);
+  g_queue_push_head (&host->idle, request->child);
+  request->child = NULL;
+  gst_uri_downloader_dispatch_pending (downloader, host);
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+static void
+gst_uri_downloader_request_func (gpointer data, gpointer user_data)
+{
+  GstUriDownloader *downloader = user_data;
+  GstUriDownloaderRequest *request = data;
+  GstFragment *fragment = NULL;
+  GError *err = NULL;
+  gboolean cancelled;
+
+  g_mutex_lock (&downloader->priv->pool_lock);
+  cancelled = request->generation != downloader->priv->generation;
+  g_mutex_unlock (&downloader->priv->pool_lock);
+
+  if (request->child && !cancelled) {
+    fragment = gst_uri_downloader_fetch_uri_with_range (request->child,
+        request->uri, request->referer, request->compress, request->refresh,
+        request->allow_cache, request->range_start, request->range_end, &err);
+  } else {
+    g_set_error (&err, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ,
+        "Download of '%s' was cancelled", request->uri);
+  }
+  if (request->child)
+    gst_uri_downloader_release_child (downloader, request);
+
+  if (fragment) {
+    GstClockTime first_byte = GST_CLOCK_TIME_NONE;
+
+    if (fragment->download_first_byte_time)
+      first_byte =
+          fragment->download_first_byte_time - fragment->download_start_time;
+    GST_DEBUG_OBJECT (downloader, "Fetched %s: reused source %d, "
+        "first byte after %" GST_TIME_FORMAT ", total %" GST_TIME_FORMAT,
+        request->uri, fragment->reused_source, GST_TIME_ARGS (first_byte),
+        GST_TIME_ARGS (fragment->download_stop_time -
+            fragment->download_start_time));
+  }
+
+  request->callback (downloader, fragment, err, request->user_data);
+
+  g_clear_error (&err);
+  gst_uri_downloader_request_free (request);
+}
+
+/* Fails all queued asynchronous requests and interrupts running ones */
+static void
+gst_uri_downloader_cancel_async (GstUriDownloader * downloader)
+{
+  GstUriDownloaderPrivate *priv = downloader->priv;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_mutex_lock (&priv->pool_lock);
+  priv->generation++;
+  if (!priv->hosts) {
+    g_mutex_unlock (&priv->pool_lock);
+    return;
+  }
+  g_hash_table_iter_init (&iter, priv->hosts);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstUriDownloaderHost *host = value;
+    GstUriDownloaderRequest *request;
+    GList *walk;
+
+    for (walk = host->busy; walk; walk = walk->next)
+      gst_uri_downloader_cancel (walk->data);
+
+    /* waiting requests fail without a child downloader */
+    while ((request = g_queue_pop_head (&host->pending)))
+      g_thread_pool_push (priv->requests, request, NULL);
+  }
+  g_mutex_unlock (&priv->pool_lock);
+}
+
+/**
+ * gst_uri_downloader_set_max_connections_per_host:
+ * @downloader: the #GstUriDownloader
+ * @max_connections: the maximum number of persistent source elements per host
+ *
+ * Sets how many asynchronous fetches to the same host can be run in
+ * parallel, each of them on its own persistent source element.
+ */
+void
+gst_uri_downloader_set_max_connections_per_host (GstUriDownloader *
+    downloader, guint max_connections)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_return_if_fail (max_connections > 0);
+
+  g_mutex_lock (&downloader->priv->pool_lock);
+  downloader->priv->max_connections_per_host = max_connections;
+  /* a raised limit lets waiting requests start right away */
+  g_hash_table_iter_init (&iter, downloader->priv->hosts);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    gst_uri_downloader_dispatch_pending (downloader, value);
+  g_mutex_unlock (&downloader->priv->pool_lock);
+}
+
+/**
+ * gst_uri_downloader_fetch_uri_async:
+ * @downloader: the #GstUriDownloader
+ * @uri: the uri
+ * @referer: (nullable): the value of the Referer header, or %NULL
+ * @compress: whether the server may send the data compressed
+ * @refresh: whether caches on the way to the server must be revalidated
+ * @allow_cache: whether caches on the way to the server may be used
+ * @range_start: the starting byte index
+ * @range_end: the final byte index, use -1 for unspecified
+ * @callback: function to call once the fetch finished
+ * @user_data: data to pass to @callback
+ * @notify: (nullable): function to free @user_data
+ *
+ * Fetches @uri without blocking. Several fetches can be outstanding at the
+ * same time; fetches to the same host re-use a pool of persistent source
+ * elements so that their connections are kept alive.
+ *
+ * The returned #GstFragment carries the request timings in its
+ * download_start_time, download_first_byte_time and download_stop_time
+ * fields.
+ *
+ * gst_uri_downloader_cancel() makes all outstanding fetches fail.
+ */
+void
+gst_uri_downloader_fetch_uri_async (GstUriDownloader * downloader,
+    const gchar * uri, const gchar * referer, gboolean compress,
+    gboolean refresh, gboolean allow_cache, gint64 range_start,
+    gint64 range_end, GstUriDownloaderFetchCallback callback,
+    gpointer user_data, GDestroyNotify notify)
+{
+  GstUriDownloaderRequest *request;
+
+  g_return_if_fail (GST_IS_URI_DOWNLOADER (downloader));
+  g_return_if_fail (uri != NULL);
+  g_return_if_fail (callback != NULL);
+
+  request = g_slice_new0 (GstUriDownloaderRequest);
+  request->uri = g_strdup (uri);
+  request->host = gst_uri_downloader_get_host_key (uri);
+  request->referer = g_strdup (referer);
+  request->compress = compress;
+  request->refresh = refresh;
+  request->allow_cache = allow_cache;
+  request->range_start = range_start;
+  request->range_end = range_end;
+  request->callback = callback;
+  request->user_data = user_data;
+  request->notify = notify;
+
+  GST_DEBUG_OBJECT (downloader, "Queueing fetch of URI %s", uri);
+
+  g_mutex_lock (&downloader->priv->pool_lock);
+  request->generation = downloader->priv->generation;
+  if (!downloader->priv->requests)
+    downloader->priv->requests =
+        g_thread_pool_new (gst_uri_downloader_request_func, downloader,
+        MAX_ASYNC_REQUESTS, FALSE, NULL);
+  gst_uri_downloader_queue_request (downloader, request);
+  g_mutex_unlock (&downloader->priv->pool_lock);
+}
@@ -58,12 +58,27 @@ struct _GstUriDownloaderClass
   gpointer _gst_reserved[GST_PADDING];
 };
 
+/**
+ * GstUriDownloaderFetchCallback:
+ * @downloader: the #GstUriDownloader
+ * @fragment: (transfer full) (nullable): the downloaded #GstFragment, or %NULL
+ *   on failure
+ * @error: (nullable): the error if the download failed or was cancelled
+ * @user_data: user data passed to gst_uri_downloader_fetch_uri_async()
+ *
+ * Called from a downloader thread once an asynchronous fetch finished.
+ */
+typedef void (*GstUriDownloaderFetchCallback) (GstUriDownloader * downloader,
+    GstFragment * fragment, const GError * error, gpointer user_data);
+
 GType gst_uri_downloader_get_type (void);
 
 GstUriDownloader * gst_uri_downloader_new (void);
 void gst_uri_downloader_set_parent (GstUriDownloader * downloader, GstElement * parent);
 GstFragment * gst_uri_downloader_fetch_uri (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, GError ** err);
 GstFragment * gst_uri_downloader_fetch_uri_with_range (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GError ** err);
+void gst_uri_downloader_fetch_uri_async (GstUriDownloader * downloader, const gchar * uri, const gchar * referer, gboolean compress, gboolean refresh, gboolean allow_cache, gint64 range_start, gint64 range_end, GstUriDownloaderFetchCallback callback, gpointer user_data, GDestroyNotify notify);
+void gst_uri_downloader_set_max_connections_per_host (GstUriDownloader * downloader, guint max_connections);
 void gst_uri_downloader_reset (GstUriDownloader *downloader);
 void gst_uri_downloader_cancel (GstUriDownloader *downloader);
 void gst_uri_downloader_free (GstUriDownloader *downloader);
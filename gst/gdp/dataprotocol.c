@@ -364,6 +364,61 @@ static const guint16 gst_dp_crc_table[256] = {
   0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
+/* gst_dp_crc_tables[k][b] is the CRC register after feeding the byte @b
+ * followed by @k zero bytes, which lets gst_dp_crc_update() handle eight
+ * bytes per iteration with eight independent table lookups. The first table
+ * is gst_dp_crc_table */
+static guint16 gst_dp_crc_tables[8][256];
+
+static gpointer
+gst_dp_crc_init_tables (gpointer data)
+{
+  guint i, k;
+
+  for (i = 0; i < 256; i++)
+    gst_dp_crc_tables[0][i] = gst_dp_crc_table[i];
+
+  for (k = 1; k < 8; k++) {
+    for (i = 0; i < 256; i++) {
+      guint16 prev = gst_dp_crc_tables[k - 1][i];
+
+      gst_dp_crc_tables[k][i] = (guint16) ((prev << 8) ^
+          gst_dp_crc_table[prev >> 8]);
+    }
+  }
+
+  return NULL;
+}
+
+static guint16
+gst_dp_crc_update (guint16 crc_register, const guint8 * buffer, gsize length)
+{
+  static GOnce tables_once = G_ONCE_INIT;
+  const guint16 (*t)[256] = (const guint16 (*)[256]) gst_dp_crc_tables;
+
+  g_once (&tables_once, gst_dp_crc_init_tables, NULL);
+
+  /* slicing-by-8: the register is folded into the first two bytes of the
+   * block, every byte then goes through the table matching the number of
+   * bytes that follow it in the block */
+  while (length >= 8) {
+    crc_register = t[7][(crc_register >> 8) ^ buffer[0]] ^
+        t[6][(crc_register & 0xff) ^ buffer[1]] ^
+        t[5][buffer[2]] ^ t[4][buffer[3]] ^
+        t[3][buffer[4]] ^ t[2][buffer[5]] ^
+        t[1][buffer[6]] ^ t[0][buffer[7]];
+    buffer += 8;
+    length -= 8;
+  }
+
+  while (length-- > 0) {
+    crc_register = (guint16) ((crc_register << 8) ^
+        t[0][((crc_register >> 8) & 0x00ff) ^ *buffer++]);
+  }
+
+  return crc_register;
+}
+
 /**
  * gst_dp_crc:
  * @buffer: array of bytes
@@ -378,19 +433,12 @@ static const guint16 gst_dp_crc_table[256] = {
 static guint16
 gst_dp_crc (const guint8 * buffer, guint length)
 {
-  guint16 crc_register = CRC_INIT;
-
   if (length == 0)
     return 0;
 
   g_assert (buffer != NULL);
 
-  /* calc CRC */
-  for (; length--;) {
-    crc_register = (guint16) ((crc_register << 8) ^
-        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-  }
-  return (0xffff ^ crc_register);
+  return (0xffff ^ gst_dp_crc_update (CRC_INIT, buffer, length));
 }
 
 static guint16
@@ -406,15 +454,8 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
 
   /* calc CRC */
   while (n_maps > 0) {
-    guint8 *buffer = maps->data;
-    gsize length = maps->size;
-
-    total_length += length;
-
-    while (length-- > 0) {
-      crc_register = (guint16) ((crc_register << 8) ^
-          gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-    }
+    total_length += maps->size;
+    crc_register = gst_dp_crc_update (crc_register, maps->data, maps->size);
     --n_maps;
     ++maps;
   }
@@ -425,6 +466,38 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
   return (0xffff ^ crc_register);
 }
 
+/* Same as gst_dp_crc() over the first @length bytes of the buffers in
+ * @list, without merging their memories */
+static guint16
+gst_dp_crc_from_buffer_list (GstBufferList * list, gsize length)
+{
+  guint16 crc_register = CRC_INIT;
+  guint i, j, n_buffers;
+
+  if (length == 0)
+    return 0;
+
+  n_buffers = gst_buffer_list_length (list);
+  for (i = 0; i < n_buffers && length > 0; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+    guint n_mems = gst_buffer_n_memory (buffer);
+
+    for (j = 0; j < n_mems && length > 0; j++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffer, j);
+      GstMapInfo map;
+      gsize size;
+
+      gst_memory_map (mem, &map, GST_MAP_READ);
+      size = MIN (map.size, length);
+      crc_register = gst_dp_crc_update (crc_register, map.data, size);
+      length -= size;
+      gst_memory_unmap (mem, &map);
+    }
+  }
+
+  return (0xffff ^ crc_register);
+}
+
 /**
  * gst_dp_init:
  *
@@ -754,6 +827,48 @@ crc_error:
   }
 }
 
+/**
+ * gst_dp_validate_payload_list:
+ * @header_length: the length of the packet header
+ * @header: the byte array of the packet header
+ * @payload: the buffers holding the packet payload
+ *
+ * Same as gst_dp_validate_payload(), for a payload spread over several
+ * buffers, such as the one returned by gst_adapter_get_buffer_list().
+ * The buffers are not merged.
+ *
+ * Returns: %TRUE if the CRC matches, or no CRC checksum is present.
+ */
+gboolean
+gst_dp_validate_payload_list (guint header_length, const guint8 * header,
+    GstBufferList * payload)
+{
+  guint16 crc_read, crc_calculated;
+
+  g_return_val_if_fail (header != NULL, FALSE);
+  g_return_val_if_fail (header_length >= GST_DP_HEADER_LENGTH, FALSE);
+
+  if (!(GST_DP_HEADER_FLAGS (header) & GST_DP_HEADER_FLAG_CRC_PAYLOAD))
+    return TRUE;
+
+  crc_read = GST_DP_HEADER_CRC_PAYLOAD (header);
+  crc_calculated = gst_dp_crc_from_buffer_list (payload,
+      GST_DP_HEADER_PAYLOAD_LENGTH (header));
+  if (crc_read != crc_calculated)
+    goto crc_error;
+
+  GST_LOG ("payload crc validation: %02x", crc_read);
+  return TRUE;
+
+  /* ERRORS */
+crc_error:
+  {
+    GST_WARNING ("payload crc mismatch: read %02x, calculated %02x", crc_read,
+        crc_calculated);
+    return FALSE;
+  }
+}
+
 /**
  * gst_dp_validate_packet:
  * @header_length: the length of the packet header
@@ -104,6 +104,9 @@ gboolean        gst_dp_validate_header          (guint header_length,
 gboolean        gst_dp_validate_payload         (guint header_length,
                                                 const guint8 * header,
                                                 const guint8 * payload);
+gboolean        gst_dp_validate_payload_list    (guint header_length,
+                                                const guint8 * header,
+                                                GstBufferList * payload);
 gboolean        gst_dp_validate_packet          (guint header_length,
                                                 const guint8 * header,
                                                 const guint8 * payload);
@@ -45,9 +45,12 @@
 enum
 {
   PROP_0,
-  PROP_TS_OFFSET
+  PROP_TS_OFFSET,
+  PROP_CHECK_CRC
 };
 
+#define DEFAULT_CHECK_CRC TRUE
+
 static GstStaticPadTemplate gdp_depay_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -106,6 +109,11 @@ gst_gdp_depay_class_init (GstGDPDepayClass * klass)
           G_MININT64, G_MAXINT64, 0,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_CHECK_CRC,
+      g_param_spec_boolean ("check-crc", "Check CRC",
+          "Verify the header and payload CRC checksums, when present",
+          DEFAULT_CHECK_CRC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "GDP Depayloader", "GDP/Depayloader",
       "Depayloads GStreamer Data Protocol buffers",
@@ -141,6 +149,7 @@ gst_gdp_depay_init (GstGDPDepay * gdpdepay)
   gst_element_add_pad (GST_ELEMENT (gdpdepay), gdpdepay->srcpad);
 
   gdpdepay->adapter = gst_adapter_new ();
+  gdpdepay->check_crc = DEFAULT_CHECK_CRC;
 
   gdpdepay->allocator = NULL;
   gst_allocation_params_init (&gdpdepay->allocation_params);
@@ -175,6 +184,9 @@ gst_gdp_depay_set_property (GObject * object, guint prop_id,
     case PROP_TS_OFFSET:
       this->ts_offset = g_value_get_int64 (value);
       break;
+    case PROP_CHECK_CRC:
+      this->check_crc = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -193,6 +205,9 @@ gst_gdp_depay_get_property (GObject * object, guint prop_id,
     case PROP_TS_OFFSET:
       g_value_set_int64 (value, this->ts_offset);
       break;
+    case PROP_CHECK_CRC:
+      g_value_set_boolean (value, this->check_crc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -298,7 +313,8 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
         GST_LOG_OBJECT (this, "reading GDP header from adapter");
         header = gst_adapter_take (this->adapter, GST_DP_HEADER_LENGTH);
-        if (!gst_dp_validate_header (GST_DP_HEADER_LENGTH, header)) {
+        if (this->check_crc &&
+            !gst_dp_validate_header (GST_DP_HEADER_LENGTH, header)) {
           g_free (header);
           goto header_validate_error;
         }
@@ -340,14 +356,17 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto wrong_type;
         }
 
-        if (this->payload_length) {
-          const guint8 *data;
+        if (this->payload_length && this->check_crc) {
+          GstBufferList *payload;
           gboolean res;
 
-          data = gst_adapter_map (this->adapter, this->payload_length);
-          res = gst_dp_validate_payload (GST_DP_HEADER_LENGTH, this->header,
-              data);
-          gst_adapter_unmap (this->adapter);
+          /* don't merge the payload just for checking it, it is copied to
+           * the output buffer later anyway */
+          payload = gst_adapter_get_buffer_list (this->adapter,
+              this->payload_length);
+          res = gst_dp_validate_payload_list (GST_DP_HEADER_LENGTH,
+              this->header, payload);
+          gst_buffer_list_unref (payload);
 
           if (!res)
             goto payload_validate_error;
@@ -68,6 +68,7 @@ struct _GstGDPDepay
   GstDPPayloadType payload_type;
 
   gint64 ts_offset;
+  gboolean check_crc;
 
   GstAllocator *allocator;
   GstAllocationParams allocation_params;
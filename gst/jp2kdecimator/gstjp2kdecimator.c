@@ -32,6 +32,11 @@
  * This pipelines encodes a test image to JPEG2000, only keeps 3 decomposition levels
  * decodes the decimated image again and shows it on the screen.
  *
+ * Tiles are located using the TLM marker segment if there is one, or the
+ * tile part lengths otherwise, and can be decimated in parallel with the
+ * #GstJP2kDecimator:n-threads property. Packets that are kept are not copied,
+ * the output buffer shares the memory of the input buffer for them.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -61,11 +66,22 @@ enum
 {
   PROP_0,
   PROP_MAX_LAYERS,
-  PROP_MAX_DECOMPOSITION_LEVELS
+  PROP_MAX_DECOMPOSITION_LEVELS,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_MAX_LAYERS (0)
 #define DEFAULT_MAX_DECOMPOSITION_LEVELS (-1)
+#define DEFAULT_N_THREADS (1)
+
+typedef struct
+{
+  const MainHeader *header;
+  Tile *tile;
+  GstFlowReturn ret;
+} TileTask;
+
+static void gst_jp2k_decimator_finalize (GObject * object);
 
 static void gst_jp2k_decimator_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -99,6 +115,7 @@ gst_jp2k_decimator_class_init (GstJP2kDecimatorClass * klass)
 
   gobject_class->set_property = gst_jp2k_decimator_set_property;
   gobject_class->get_property = gst_jp2k_decimator_get_property;
+  gobject_class->finalize = gst_jp2k_decimator_finalize;
 
   g_object_class_install_property (gobject_class, PROP_MAX_LAYERS,
       g_param_spec_int ("max-layers", "Maximum Number of Layers",
@@ -111,6 +128,20 @@ gst_jp2k_decimator_class_init (GstJP2kDecimatorClass * klass)
           "Maximum number of decomposition levels to keep (-1 == all)", -1, 32,
           DEFAULT_MAX_DECOMPOSITION_LEVELS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstJP2kDecimator:n-threads:
+   *
+   * Number of threads used to decimate the tiles of an image, 0 for one per
+   * processor.
+   *
+   * Since: 1.14
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of Threads",
+          "Number of threads used to decimate the tiles (0 == automatic)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -118,6 +149,10 @@ gst_jp2k_decimator_init (GstJP2kDecimator * self)
 {
   self->max_layers = DEFAULT_MAX_LAYERS;
   self->max_decomposition_levels = DEFAULT_MAX_DECOMPOSITION_LEVELS;
+  self->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
 
   self->sinkpad = gst_pad_new_from_static_template (&sink_pad_template, "sink");
   GST_PAD_SET_PROXY_CAPS (self->sinkpad);
@@ -132,6 +167,19 @@ gst_jp2k_decimator_init (GstJP2kDecimator * self)
   gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
 }
 
+static void
+gst_jp2k_decimator_finalize (GObject * object)
+{
+  GstJP2kDecimator *self = GST_JP2K_DECIMATOR (object);
+
+  if (self->pool)
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (gst_jp2k_decimator_parent_class)->finalize (object);
+}
+
 static void
 gst_jp2k_decimator_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
@@ -145,6 +193,9 @@ gst_jp2k_decimator_set_property (GObject * object,
     case PROP_MAX_DECOMPOSITION_LEVELS:
       self->max_decomposition_levels = g_value_get_int (value);
       break;
+    case PROP_N_THREADS:
+      self->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -164,12 +215,83 @@ gst_jp2k_decimator_get_property (GObject * object,
     case PROP_MAX_DECOMPOSITION_LEVELS:
       g_value_set_int (value, self->max_decomposition_levels);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_jp2k_decimator_tile_func (gpointer data, gpointer user_data)
+{
+  GstJP2kDecimator *self = user_data;
+  TileTask *task = data;
+
+  task->ret = decimate_tile (self, task->header, task->tile);
+
+  g_mutex_lock (&self->lock);
+  if (--self->n_pending == 0)
+    g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/* Decimates the tiles in parallel, every tile only refers to its own part
+ * of the input */
+static GstFlowReturn
+gst_jp2k_decimator_decimate_tiles (GstJP2kDecimator * self,
+    MainHeader * header)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GError *err = NULL;
+  TileTask *tasks;
+  guint n_threads;
+  gint i;
+
+  n_threads = self->n_threads ? self->n_threads : g_get_num_processors ();
+  if (n_threads == 1 || header->n_tiles < 2)
+    return decimate_main_header (self, header);
+
+  if (!self->pool) {
+    self->pool = g_thread_pool_new (gst_jp2k_decimator_tile_func, self,
+        n_threads, FALSE, &err);
+    if (!self->pool) {
+      GST_WARNING_OBJECT (self, "Could not create thread pool: %s",
+          err->message);
+      g_clear_error (&err);
+      return decimate_main_header (self, header);
+    }
+  } else {
+    g_thread_pool_set_max_threads (self->pool, n_threads, NULL);
+  }
+
+  tasks = g_new (TileTask, header->n_tiles);
+  self->n_pending = header->n_tiles;
+  for (i = 0; i < header->n_tiles; i++) {
+    tasks[i].header = header;
+    tasks[i].tile = &header->tiles[i];
+    tasks[i].ret = GST_FLOW_OK;
+    g_thread_pool_push (self->pool, &tasks[i], NULL);
+  }
+
+  g_mutex_lock (&self->lock);
+  while (self->n_pending > 0)
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+
+  for (i = 0; i < header->n_tiles; i++) {
+    if (tasks[i].ret != GST_FLOW_OK) {
+      ret = tasks[i].ret;
+      break;
+    }
+  }
+  g_free (tasks);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
     GstBuffer ** outbuf_)
@@ -180,7 +302,7 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   GstByteReader reader;
   GstByteWriter writer;
   MainHeader main_header;
-
+  guint n_chunks = 0;
 
   if (!gst_buffer_map (inbuf, &info, GST_MAP_READ)) {
     GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, ("Unable to map memory"),
@@ -190,7 +312,6 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   }
 
   gst_byte_reader_init (&reader, info.data, info.size);
-  gst_byte_writer_init_with_size (&writer, gst_buffer_get_size (inbuf), FALSE);
 
   /* main header */
   memset (&main_header, 0, sizeof (MainHeader));
@@ -198,15 +319,37 @@ gst_jp2k_decimator_decimate_jpc (GstJP2kDecimator * self, GstBuffer * inbuf,
   if (ret != GST_FLOW_OK)
     goto done;
 
-  ret = decimate_main_header (self, &main_header);
+  ret = gst_jp2k_decimator_decimate_tiles (self, &main_header);
   if (ret != GST_FLOW_OK)
     goto done;
 
-  ret = write_main_header (self, &writer, &main_header);
-  if (ret != GST_FLOW_OK)
-    goto done;
+  /* Share the packets that are kept with the input buffer, unless the output
+   * would consist of more memories than a buffer can hold, in which case they
+   * would be merged again anyway */
+  if (gst_buffer_n_memory (inbuf) == 1) {
+    ret = write_main_header_scattered (self, inbuf, info.data, &main_header,
+        NULL, &n_chunks);
+    if (ret != GST_FLOW_OK)
+      goto done;
+  }
+
+  if (n_chunks > 0 && n_chunks <= gst_buffer_get_max_memory ()) {
+    ret = write_main_header_scattered (self, inbuf, info.data, &main_header,
+        &outbuf, NULL);
+    if (ret != GST_FLOW_OK)
+      goto done;
+  } else {
+    gst_byte_writer_init_with_size (&writer,
+        sizeof_main_header (self, &main_header), FALSE);
+    ret = write_main_header (self, &writer, &main_header);
+    if (ret != GST_FLOW_OK) {
+      gst_byte_writer_reset (&writer);
+      goto done;
+    }
+
+    outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
+  }
 
-  outbuf = gst_byte_writer_reset_and_get_buffer (&writer);
   gst_buffer_copy_into (outbuf, inbuf, GST_BUFFER_COPY_METADATA, 0, -1);
 
   GST_DEBUG_OBJECT (self,
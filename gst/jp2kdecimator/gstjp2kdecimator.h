@@ -43,6 +43,13 @@ struct _GstJP2kDecimator
 
   gint max_layers;
   gint max_decomposition_levels;
+  guint n_threads;
+
+  /* decimates the tiles in parallel */
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
 };
 
 struct _GstJP2kDecimatorClass
@@ -711,27 +711,40 @@ parse_plt (GstJP2kDecimator * self, GstByteReader * reader,
   return GST_FLOW_OK;
 }
 
+static guint
+sizeof_plt_length (guint32 len)
+{
+  if (len < (1 << 7))
+    return 1;
+  else if (len < (1 << 14))
+    return 2;
+  else if (len < (1 << 21))
+    return 3;
+  else if (len < (1 << 28))
+    return 4;
+  else
+    return 5;
+}
+
+/* The packet lengths are split over as many PLT marker segments as needed,
+ * each of them at most 65535 bytes long without the marker */
 static guint
 sizeof_plt (GstJP2kDecimator * self, const PacketLengthTilePart * plt)
 {
-  guint size = 2 + 3;
+  guint size = 2 + 3, segment_size = 3;
   gint i, n;
 
   n = plt->packet_lengths->len;
   for (i = 0; i < n; i++) {
     guint32 len = g_array_index (plt->packet_lengths, guint32, i);
+    guint len_size = sizeof_plt_length (len);
 
-    if (len < (1 << 7)) {
-      size += 1;
-    } else if (len < (1 << 14)) {
-      size += 2;
-    } else if (len < (1 << 21)) {
-      size += 3;
-    } else if (len < (1 << 28)) {
-      size += 4;
-    } else {
-      size += 5;
+    if (segment_size + len_size > 65535) {
+      size += 2 + 3;
+      segment_size = 3;
     }
+    segment_size += len_size;
+    size += len_size;
   }
 
   return size;
@@ -746,11 +759,13 @@ reset_plt (GstJP2kDecimator * self, PacketLengthTilePart * plt)
 }
 
 static GstFlowReturn
-write_plt (GstJP2kDecimator * self, GstByteWriter * writer,
-    const PacketLengthTilePart * plt)
+write_plt_segment_start (GstJP2kDecimator * self, GstByteWriter * writer,
+    guint index, guint * plt_start_pos)
 {
-  gint i, n;
-  guint plt_start_pos, plt_end_pos;
+  if (index > 255) {
+    GST_ERROR_OBJECT (self, "Too many PLT marker segments");
+    return GST_FLOW_ERROR;
+  }
 
   if (!gst_byte_writer_ensure_free_space (writer, 2 + 2 + 1)) {
     GST_ERROR_OBJECT (self, "Could not ensure free space");
@@ -758,82 +773,165 @@ write_plt (GstJP2kDecimator * self, GstByteWriter * writer,
   }
 
   gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_PLT);
-  plt_start_pos = gst_byte_writer_get_pos (writer);
+  *plt_start_pos = gst_byte_writer_get_pos (writer);
   gst_byte_writer_put_uint16_be_unchecked (writer, 0);
 
-  gst_byte_writer_put_uint8_unchecked (writer, plt->index);
+  gst_byte_writer_put_uint8_unchecked (writer, index);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+write_plt_segment_end (GstJP2kDecimator * self, GstByteWriter * writer,
+    guint plt_start_pos)
+{
+  guint plt_end_pos;
+
+  plt_end_pos = gst_byte_writer_get_pos (writer);
+  gst_byte_writer_set_pos (writer, plt_start_pos);
+  if (!gst_byte_writer_put_uint16_be (writer, plt_end_pos - plt_start_pos)) {
+    GST_ERROR_OBJECT (self, "Not enough space to write plt size");
+    return GST_FLOW_ERROR;
+  }
+
+  gst_byte_writer_set_pos (writer, plt_end_pos);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+write_plt (GstJP2kDecimator * self, GstByteWriter * writer,
+    const PacketLengthTilePart * plt)
+{
+  GstFlowReturn ret;
+  gint i, n;
+  guint index = plt->index;
+  guint plt_start_pos = 0;
+
+  ret = write_plt_segment_start (self, writer, index++, &plt_start_pos);
+  if (ret != GST_FLOW_OK)
+    return ret;
 
   n = plt->packet_lengths->len;
   for (i = 0; i < n; i++) {
     guint32 len = g_array_index (plt->packet_lengths, guint32, i);
+    guint len_size = sizeof_plt_length (len);
+
+    /* Continue in a new segment if this one would get too big */
+    if (gst_byte_writer_get_pos (writer) - plt_start_pos + len_size > 65535) {
+      ret = write_plt_segment_end (self, writer, plt_start_pos);
+      if (ret != GST_FLOW_OK)
+        return ret;
+      ret = write_plt_segment_start (self, writer, index++, &plt_start_pos);
+      if (ret != GST_FLOW_OK)
+        return ret;
+    }
 
-    /* FIXME: Write multiple plt here */
-    if (gst_byte_writer_get_pos (writer) - plt_start_pos > 65535 - 5) {
-      GST_ERROR_OBJECT (self, "Too big PLT");
+    if (!gst_byte_writer_ensure_free_space (writer, len_size)) {
+      GST_ERROR_OBJECT (self, "Could not ensure free space");
       return GST_FLOW_ERROR;
     }
 
-    if (len < (1 << 7)) {
-      if (!gst_byte_writer_ensure_free_space (writer, 1)) {
-        GST_ERROR_OBJECT (self, "Could not ensure free space");
-        return GST_FLOW_ERROR;
-      }
-      gst_byte_writer_put_uint8_unchecked (writer, (0x00 | (len & 0x7f)));
-    } else if (len < (1 << 14)) {
-      if (!gst_byte_writer_ensure_free_space (writer, 2)) {
-        GST_ERROR_OBJECT (self, "Could not ensure free space");
-        return GST_FLOW_ERROR;
-      }
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 7) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer, (0x00 | (len & 0x7f)));
-    } else if (len < (1 << 21)) {
-      if (!gst_byte_writer_ensure_free_space (writer, 3)) {
-        GST_ERROR_OBJECT (self, "Could not ensure free space");
-        return GST_FLOW_ERROR;
-      }
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 14) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 7) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer, (0x00 | (len & 0x7f)));
-    } else if (len < (1 << 28)) {
-      if (!gst_byte_writer_ensure_free_space (writer, 4)) {
-        GST_ERROR_OBJECT (self, "Could not ensure free space");
-        return GST_FLOW_ERROR;
-      }
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 21) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 14) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 7) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer, (0x00 | (len & 0x7f)));
-    } else {
-      if (!gst_byte_writer_ensure_free_space (writer, 5)) {
-        GST_ERROR_OBJECT (self, "Could not ensure free space");
-        return GST_FLOW_ERROR;
-      }
+    /* 7 bits per byte, most significant first, with the high bit set on
+     * all but the last byte */
+    while (len_size > 1) {
+      len_size--;
       gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 28) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 21) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 14) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer,
-          (0x80 | ((len >> 7) & 0x7f)));
-      gst_byte_writer_put_uint8_unchecked (writer, (0x00 | (len & 0x7f)));
+          0x80 | ((len >> (7 * len_size)) & 0x7f));
     }
+    gst_byte_writer_put_uint8_unchecked (writer, len & 0x7f);
   }
 
-  plt_end_pos = gst_byte_writer_get_pos (writer);
-  gst_byte_writer_set_pos (writer, plt_start_pos);
-  if (!gst_byte_writer_put_uint16_be (writer, plt_end_pos - plt_start_pos)) {
-    GST_ERROR_OBJECT (self, "Not enough space to write plt size");
+  return write_plt_segment_end (self, writer, plt_start_pos);
+}
+
+static GstFlowReturn
+parse_tlm (GstJP2kDecimator * self, GstByteReader * reader,
+    MainHeader * header, guint length)
+{
+  guint8 stlm;
+  guint st, sp, n, i;
+
+  if (length < 4) {
+    GST_ERROR_OBJECT (self, "Invalid TLM");
     return GST_FLOW_ERROR;
   }
 
-  gst_byte_writer_set_pos (writer, plt_end_pos);
+  /* Ztlm, the segments are expected in order */
+  gst_byte_reader_skip_unchecked (reader, 1);
+  stlm = gst_byte_reader_get_uint8_unchecked (reader);
+
+  st = (stlm >> 4) & 0x3;
+  sp = (stlm >> 6) & 0x1;
+  if (st == 3 || (length - 4) % (st + (sp ? 4 : 2)) != 0) {
+    GST_ERROR_OBJECT (self, "Invalid TLM");
+    return GST_FLOW_ERROR;
+  }
+  n = (length - 4) / (st + (sp ? 4 : 2));
+
+  if (!header->tlm)
+    header->tlm = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  for (i = 0; i < n; i++) {
+    guint32 len;
+
+    /* Tile indices are not needed, only one tile part per tile in order
+     * is supported */
+    gst_byte_reader_skip_unchecked (reader, st);
+    if (sp)
+      len = gst_byte_reader_get_uint32_be_unchecked (reader);
+    else
+      len = gst_byte_reader_get_uint16_be_unchecked (reader);
+    g_array_append_val (header->tlm, len);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static guint
+sizeof_tlm (GstJP2kDecimator * self, const MainHeader * header)
+{
+  if (!header->tlm)
+    return 0;
+
+  return 2 + 4 + header->n_tiles * (2 + 4);
+}
+
+/* Tile part sizes change with decimation, so the TLM is rewritten from the
+ * decimated tiles, always with 16 bit tile indices and 32 bit lengths */
+static GstFlowReturn
+write_tlm (GstJP2kDecimator * self, GstByteWriter * writer,
+    const MainHeader * header)
+{
+  gint i;
+
+  if (!header->tlm)
+    return GST_FLOW_OK;
+
+  if (sizeof_tlm (self, header) - 2 > 65535) {
+    GST_ERROR_OBJECT (self, "Too big TLM");
+    return GST_FLOW_ERROR;
+  }
+
+  if (!gst_byte_writer_ensure_free_space (writer,
+          sizeof_tlm (self, header))) {
+    GST_ERROR_OBJECT (self, "Could not ensure free space");
+    return GST_FLOW_ERROR;
+  }
+
+  gst_byte_writer_put_uint16_be_unchecked (writer, MARKER_TLM);
+  gst_byte_writer_put_uint16_be_unchecked (writer,
+      sizeof_tlm (self, header) - 2);
+  gst_byte_writer_put_uint8_unchecked (writer, 0);
+  gst_byte_writer_put_uint8_unchecked (writer, 0x60);
+
+  for (i = 0; i < header->n_tiles; i++) {
+    const Tile *tile = &header->tiles[i];
+
+    gst_byte_writer_put_uint16_be_unchecked (writer, tile->sot.tile_index);
+    gst_byte_writer_put_uint32_be_unchecked (writer,
+        tile->sot.tile_part_size);
+  }
 
   return GST_FLOW_OK;
 }
@@ -852,15 +950,9 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
 
   sop = (tile->cod) ? tile->cod->sop : header->cod.sop;
   eph = (tile->cod) ? tile->cod->eph : header->cod.eph;
-  if (tile->plt) {
-    if (g_list_length (tile->plt) > 1) {
-      GST_ERROR_OBJECT (self,
-          "Only a single PLT per tile is supported currently");
-      ret = GST_FLOW_ERROR;
-      goto done;
-    }
+  /* All PLT segments of the tile part are merged into one */
+  if (tile->plt)
     plt = tile->plt->data;
-  }
 
   if (plt) {
     guint32 length;
@@ -957,12 +1049,14 @@ parse_packet (GstJP2kDecimator * self, GstByteReader * reader,
     packet_start_data = reader->data + reader->byte;
     packet_start_pos = gst_byte_reader_get_pos (reader);
 
-    /* Find end of packet */
+    /* Find end of packet, the reader ends with the tile part */
     while (TRUE) {
-      if (!gst_byte_reader_peek_uint16_be (reader, &marker)) {
-        GST_ERROR_OBJECT (self, "Truncated file");
-        ret = GST_FLOW_ERROR;
-        goto done;
+      if (gst_byte_reader_get_remaining (reader) < 2) {
+        gst_byte_reader_skip_unchecked (reader,
+            gst_byte_reader_get_remaining (reader));
+        marker = MARKER_SOT;
+      } else {
+        marker = gst_byte_reader_peek_uint16_be_unchecked (reader);
       }
 
       if (marker == MARKER_SOP || marker == MARKER_EOC || marker == MARKER_SOT) {
@@ -1039,6 +1133,7 @@ parse_tile (GstJP2kDecimator * self, GstByteReader * reader,
 {
   GstFlowReturn ret = GST_FLOW_OK;
   guint16 marker = 0, length;
+  guint8 last_plt_index = 0;
 
   if (!gst_byte_reader_peek_uint16_be (reader, &marker)) {
     GST_ERROR_OBJECT (self, "Could not read marker");
@@ -1165,15 +1260,37 @@ parse_tile (GstJP2kDecimator * self, GstByteReader * reader,
         ret = GST_FLOW_ERROR;
         goto done;
       case MARKER_PLT:{
-        PacketLengthTilePart *plt = g_slice_new (PacketLengthTilePart);
+        PacketLengthTilePart *plt = g_slice_new0 (PacketLengthTilePart);
 
         ret = parse_plt (self, reader, plt, length);
         if (ret != GST_FLOW_OK) {
+          reset_plt (self, plt);
           g_slice_free (PacketLengthTilePart, plt);
           goto done;
         }
 
-        tile->plt = g_list_append (tile->plt, plt);
+        /* Big tile parts have their packet lengths split over multiple
+         * PLT segments, which are merged here into a single index */
+        if (tile->plt) {
+          PacketLengthTilePart *first = tile->plt->data;
+
+          if (plt->index <= last_plt_index) {
+            GST_ERROR_OBJECT (self, "PLT segments not in order");
+            reset_plt (self, plt);
+            g_slice_free (PacketLengthTilePart, plt);
+            ret = GST_FLOW_ERROR;
+            goto done;
+          }
+
+          g_array_append_vals (first->packet_lengths,
+              plt->packet_lengths->data, plt->packet_lengths->len);
+          last_plt_index = plt->index;
+          reset_plt (self, plt);
+          g_slice_free (PacketLengthTilePart, plt);
+        } else {
+          last_plt_index = plt->index;
+          tile->plt = g_list_append (tile->plt, plt);
+        }
         break;
       }
       case MARKER_QCD:
@@ -1350,9 +1467,10 @@ write_packet (GstJP2kDecimator * self, GstByteWriter * writer,
   return GST_FLOW_OK;
 }
 
+/* Writes everything from the SOT up to and including the SOD */
 static GstFlowReturn
-write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
-    const MainHeader * header, Tile * tile)
+write_tile_header (GstJP2kDecimator * self, GstByteWriter * writer,
+    const MainHeader * header, const Tile * tile)
 {
   GList *l;
   GstFlowReturn ret = GST_FLOW_OK;
@@ -1412,6 +1530,22 @@ write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
     goto done;
   }
 
+done:
+
+  return ret;
+}
+
+static GstFlowReturn
+write_tile (GstJP2kDecimator * self, GstByteWriter * writer,
+    const MainHeader * header, Tile * tile)
+{
+  GList *l;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  ret = write_tile_header (self, writer, header, tile);
+  if (ret != GST_FLOW_OK)
+    goto done;
+
   for (l = tile->packets; l; l = l->next) {
     Packet *p = l->data;
 
@@ -1425,6 +1559,58 @@ done:
   return ret;
 }
 
+/* Finds the tile parts from the TLM if there is one for all tiles, or
+ * otherwise from the length in each SOT, without parsing them */
+static GstFlowReturn
+index_tile_parts (GstJP2kDecimator * self, GstByteReader * reader,
+    MainHeader * header)
+{
+  gboolean use_tlm;
+  guint32 length;
+  gint i;
+
+  use_tlm = header->tlm && header->tlm->len == header->n_tiles;
+
+  for (i = 0; i < header->n_tiles; i++) {
+    Tile *tile = &header->tiles[i];
+
+    if (use_tlm) {
+      length = g_array_index (header->tlm, guint32, i);
+    } else {
+      const guint8 *data;
+
+      if (gst_byte_reader_get_remaining (reader) < 12) {
+        GST_ERROR_OBJECT (self, "Truncated file");
+        return GST_FLOW_ERROR;
+      }
+
+      data = gst_byte_reader_peek_data_unchecked (reader);
+      if (GST_READ_UINT16_BE (data) != MARKER_SOT) {
+        GST_ERROR_OBJECT (self, "Unexpected marker 0x%04x",
+            GST_READ_UINT16_BE (data));
+        return GST_FLOW_ERROR;
+      }
+
+      /* Psot, 0 if the tile part extends to the EOC */
+      length = GST_READ_UINT32_BE (data + 6);
+      if (length == 0 && i == header->n_tiles - 1)
+        length = MAX (gst_byte_reader_get_remaining (reader), 2) - 2;
+    }
+
+    if (length < 12 + 2 || gst_byte_reader_get_remaining (reader) < length) {
+      GST_ERROR_OBJECT (self, "Invalid tile part length %u (available %u)",
+          length, gst_byte_reader_get_remaining (reader));
+      return GST_FLOW_ERROR;
+    }
+
+    tile->tile_part.data = gst_byte_reader_peek_data_unchecked (reader);
+    tile->tile_part.length = length;
+    gst_byte_reader_skip_unchecked (reader, length);
+  }
+
+  return GST_FLOW_OK;
+}
+
 GstFlowReturn
 parse_main_header (GstJP2kDecimator * self, GstByteReader * reader,
     MainHeader * header)
@@ -1526,9 +1712,10 @@ parse_main_header (GstJP2kDecimator * self, GstByteReader * reader,
         ret = GST_FLOW_ERROR;
         goto done;
       case MARKER_TLM:
-        GST_ERROR_OBJECT (self, "TLM marker not supported yet");
-        ret = GST_FLOW_ERROR;
-        goto done;
+        ret = parse_tlm (self, reader, header, length);
+        if (ret != GST_FLOW_OK)
+          goto done;
+        break;
       case MARKER_PLM:
         GST_ERROR_OBJECT (self, "PLM marker not supported yet");
         ret = GST_FLOW_ERROR;
@@ -1591,16 +1778,11 @@ parse_main_header (GstJP2kDecimator * self, GstByteReader * reader,
 
   header->tiles = g_slice_alloc0 (sizeof (Tile) * header->n_tiles);
 
-  /* now at SOT marker, read the tiles */
-  {
-    gint i;
-
-    for (i = 0; i < header->n_tiles; i++) {
-      ret = parse_tile (self, reader, header, &header->tiles[i]);
-      if (ret != GST_FLOW_OK)
-        goto done;
-    }
-  }
+  /* now at SOT marker, find the tiles. They are only parsed when
+   * decimating, which can then happen independently for each tile */
+  ret = index_tile_parts (self, reader, header);
+  if (ret != GST_FLOW_OK)
+    goto done;
 
   /* now there must be the EOC marker */
   if (!gst_byte_reader_get_uint16_be (reader, &marker)
@@ -1641,6 +1823,8 @@ sizeof_main_header (GstJP2kDecimator * self, const MainHeader * header)
     size += 2 + 2 + b->length;
   }
 
+  size += sizeof_tlm (self, header);
+
   for (i = 0; i < header->n_tiles; i++) {
     size += sizeof_tile (self, &header->tiles[i]);
   }
@@ -1676,19 +1860,22 @@ reset_main_header (GstJP2kDecimator * self, MainHeader * header)
     g_slice_free (Buffer, l->data);
   g_list_free (header->crg);
 
+  if (header->tlm)
+    g_array_free (header->tlm, TRUE);
+
   reset_cod (self, &header->cod);
   reset_siz (self, &header->siz);
 
   memset (header, 0, sizeof (MainHeader));
 }
 
-GstFlowReturn
-write_main_header (GstJP2kDecimator * self, GstByteWriter * writer,
+/* Writes everything from the SOC up to the first SOT */
+static GstFlowReturn
+write_main_header_markers (GstJP2kDecimator * self, GstByteWriter * writer,
     const MainHeader * header)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GList *l;
-  gint i;
 
   if (!gst_byte_writer_ensure_free_space (writer, 2)) {
     GST_ERROR_OBJECT (self, "Could not ensure free space");
@@ -1733,6 +1920,23 @@ write_main_header (GstJP2kDecimator * self, GstByteWriter * writer,
       goto done;
   }
 
+  ret = write_tlm (self, writer, header);
+
+done:
+  return ret;
+}
+
+GstFlowReturn
+write_main_header (GstJP2kDecimator * self, GstByteWriter * writer,
+    const MainHeader * header)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint i;
+
+  ret = write_main_header_markers (self, writer, header);
+  if (ret != GST_FLOW_OK)
+    goto done;
+
   for (i = 0; i < header->n_tiles; i++) {
     ret = write_tile (self, writer, header, &header->tiles[i]);
     if (ret != GST_FLOW_OK)
@@ -1750,69 +1954,236 @@ done:
   return ret;
 }
 
+/* Collects the output as a list of chunks: generated data, i.e. marker
+ * segments and empty packets, and packets that are kept as is, which are
+ * shared with the input buffer instead of being copied */
+typedef struct
+{
+  GstBuffer *inbuf;
+  const guint8 *indata;         /* mapped data of inbuf */
+
+  GstBuffer *outbuf;            /* NULL if only counting the chunks */
+  guint n_chunks;
+
+  GstByteWriter writer;         /* pending generated data */
+  guint offset, length;         /* pending input data */
+} ScatterWriter;
+
+static void
+scatter_writer_flush_generated (ScatterWriter * sw)
+{
+  guint size = gst_byte_writer_get_size (&sw->writer);
+  guint8 *data;
+
+  if (size == 0)
+    return;
+
+  data = gst_byte_writer_reset_and_get_data (&sw->writer);
+  if (sw->outbuf) {
+    gst_buffer_append_memory (sw->outbuf,
+        gst_memory_new_wrapped (0, data, size, 0, size, data, g_free));
+  } else {
+    g_free (data);
+  }
+  gst_byte_writer_init (&sw->writer);
+  sw->n_chunks++;
+}
+
+static void
+scatter_writer_flush_input (ScatterWriter * sw)
+{
+  if (sw->length == 0)
+    return;
+
+  if (sw->outbuf) {
+    sw->outbuf = gst_buffer_append (sw->outbuf,
+        gst_buffer_copy_region (sw->inbuf, GST_BUFFER_COPY_MEMORY,
+            sw->offset, sw->length));
+  }
+  sw->length = 0;
+  sw->n_chunks++;
+}
+
+static void
+scatter_writer_add_input (ScatterWriter * sw, const guint8 * data,
+    guint length)
+{
+  guint offset = data - sw->indata;
+
+  scatter_writer_flush_generated (sw);
+
+  if (sw->length > 0 && sw->offset + sw->length == offset) {
+    sw->length += length;
+    return;
+  }
+
+  scatter_writer_flush_input (sw);
+  sw->offset = offset;
+  sw->length = length;
+}
+
+/* Returns the writer for generated data that goes after the pending input
+ * data */
+static GstByteWriter *
+scatter_writer_get_writer (ScatterWriter * sw)
+{
+  scatter_writer_flush_input (sw);
+
+  return &sw->writer;
+}
+
+/* Same output as write_main_header() but packets that are kept are shared
+ * with @inbuf, whose mapped data is @indata. If @outbuf is NULL only the
+ * number of chunks the output would consist of is returned, so that callers
+ * can check if it fits into the memories of a single buffer first */
 GstFlowReturn
-decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
+write_main_header_scattered (GstJP2kDecimator * self, GstBuffer * inbuf,
+    const guint8 * indata, const MainHeader * header, GstBuffer ** outbuf,
+    guint * n_chunks)
 {
   GstFlowReturn ret = GST_FLOW_OK;
+  ScatterWriter sw;
+  GList *l;
   gint i;
 
+  memset (&sw, 0, sizeof (ScatterWriter));
+  sw.inbuf = inbuf;
+  sw.indata = indata;
+  sw.outbuf = outbuf ? gst_buffer_new () : NULL;
+  gst_byte_writer_init (&sw.writer);
+
+  ret = write_main_header_markers (self, &sw.writer, header);
+  if (ret != GST_FLOW_OK)
+    goto done;
+
   for (i = 0; i < header->n_tiles; i++) {
-    Tile *tile = &header->tiles[i];
-    GList *l;
-    PacketIterator it;
-    PacketLengthTilePart *plt = NULL;
+    const Tile *tile = &header->tiles[i];
 
-    if (tile->plt) {
-      if (g_list_length (tile->plt) > 1) {
-        GST_ERROR_OBJECT (self, "Multiple PLT per tile not supported yet");
-        ret = GST_FLOW_ERROR;
-        goto done;
+    ret = write_tile_header (self, scatter_writer_get_writer (&sw), header,
+        tile);
+    if (ret != GST_FLOW_OK)
+      goto done;
+
+    for (l = tile->packets; l; l = l->next) {
+      Packet *p = l->data;
+
+      if (p->data) {
+        /* The SOP marker segment is the same as in the input */
+        scatter_writer_add_input (&sw, p->data - (p->sop ? 6 : 0),
+            sizeof_packet (self, p));
+      } else {
+        ret = write_packet (self, scatter_writer_get_writer (&sw), p);
+        if (ret != GST_FLOW_OK)
+          goto done;
       }
-      plt = g_slice_new (PacketLengthTilePart);
-      plt->index = 0;
-      plt->packet_lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
     }
+  }
 
-    init_packet_iterator (self, &it, header, tile);
+  if (!gst_byte_writer_put_uint16_be (scatter_writer_get_writer (&sw),
+          MARKER_EOC)) {
+    GST_ERROR_OBJECT (self, "Could not ensure free space");
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
 
-    l = tile->packets;
-    while ((it.next (&it))) {
-      Packet *p;
+  scatter_writer_flush_generated (&sw);
 
-      if (l == NULL) {
-        GST_ERROR_OBJECT (self, "Not enough packets");
-        ret = GST_FLOW_ERROR;
-        g_array_free (plt->packet_lengths, TRUE);
-        g_slice_free (PacketLengthTilePart, plt);
-        goto done;
-      }
+  if (n_chunks)
+    *n_chunks = sw.n_chunks;
+  if (outbuf) {
+    *outbuf = sw.outbuf;
+    sw.outbuf = NULL;
+  }
 
-      p = l->data;
+done:
+  gst_byte_writer_reset (&sw.writer);
+  if (sw.outbuf)
+    gst_buffer_unref (sw.outbuf);
 
-      if ((self->max_layers != 0 && it.cur_layer >= self->max_layers) ||
-          (self->max_decomposition_levels != -1
-              && it.cur_resolution > self->max_decomposition_levels)) {
-        p->data = NULL;
-        p->length = 1;
-      }
+  return ret;
+}
 
+/* Parses the tile from its tile part and removes the packets of the layers
+ * and resolutions that are not kept. Only @tile is modified, so this can be
+ * called for different tiles of the same header in parallel */
+GstFlowReturn
+decimate_tile (GstJP2kDecimator * self, const MainHeader * header,
+    Tile * tile)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstByteReader reader;
+  GList *l;
+  PacketIterator it;
+  PacketLengthTilePart *plt = NULL;
+
+  gst_byte_reader_init (&reader, tile->tile_part.data,
+      tile->tile_part.length);
+  ret = parse_tile (self, &reader, header, tile);
+  if (ret != GST_FLOW_OK)
+    goto done;
+
+  if (tile->plt) {
+    plt = g_slice_new (PacketLengthTilePart);
+    plt->index = 0;
+    plt->packet_lengths = g_array_new (FALSE, FALSE, sizeof (guint32));
+  }
+
+  init_packet_iterator (self, &it, header, tile);
+
+  l = tile->packets;
+  while ((it.next (&it))) {
+    Packet *p;
+
+    if (l == NULL) {
+      GST_ERROR_OBJECT (self, "Not enough packets");
+      ret = GST_FLOW_ERROR;
       if (plt) {
-        guint32 len = sizeof_packet (self, p);
-        g_array_append_val (plt->packet_lengths, len);
+        g_array_free (plt->packet_lengths, TRUE);
+        g_slice_free (PacketLengthTilePart, plt);
       }
+      goto done;
+    }
+
+    p = l->data;
 
-      l = l->next;
+    if ((self->max_layers != 0 && it.cur_layer >= self->max_layers) ||
+        (self->max_decomposition_levels != -1
+            && it.cur_resolution > self->max_decomposition_levels)) {
+      p->data = NULL;
+      p->length = 1;
     }
 
     if (plt) {
-      reset_plt (self, tile->plt->data);
-      g_slice_free (PacketLengthTilePart, tile->plt->data);
-      tile->plt->data = plt;
+      guint32 len = sizeof_packet (self, p);
+      g_array_append_val (plt->packet_lengths, len);
     }
 
-    tile->sot.tile_part_size = sizeof_tile (self, tile);
+    l = l->next;
   }
 
+  if (plt) {
+    reset_plt (self, tile->plt->data);
+    g_slice_free (PacketLengthTilePart, tile->plt->data);
+    tile->plt->data = plt;
+  }
+
+  tile->sot.tile_part_size = sizeof_tile (self, tile);
+
 done:
   return ret;
 }
+
+GstFlowReturn
+decimate_main_header (GstJP2kDecimator * self, MainHeader * header)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint i;
+
+  for (i = 0; i < header->n_tiles; i++) {
+    ret = decimate_tile (self, header, &header->tiles[i]);
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+
+  return ret;
+}
@@ -121,7 +121,8 @@ typedef struct
   Buffer *qcd;
   GList *qcc;                   /* list of Buffer */
 
-  GList *plt;                   /* list of PacketLengthTilePart */
+  GList *plt;                   /* list of PacketLengthTilePart, all PLT
+                                 * segments are merged into the first */
 
   GList *com;                   /* list of Buffer */
 
@@ -132,6 +133,8 @@ typedef struct
   /* Calculated value */
   gint tile_x, tile_y;
   gint tx0, tx1, ty0, ty1;      /* tile dimensions */
+
+  Buffer tile_part;             /* the tile part in the input, from SOT */
 } Tile;
 
 typedef struct
@@ -144,7 +147,9 @@ typedef struct
   GList *qcc;                   /* list of Buffer */
   GList *crg, *com;             /* lists of Buffer */
 
-  /* TODO: COC, PPM, TLM, PLM */
+  GArray *tlm;                  /* tile part lengths from TLM, guint32 */
+
+  /* TODO: COC, PPM, PLM */
 
   guint n_tiles_x, n_tiles_y, n_tiles;  /* calculated */
   Tile *tiles;
@@ -188,6 +193,8 @@ GstFlowReturn parse_main_header (GstJP2kDecimator * self, GstByteReader * reader
 guint sizeof_main_header (GstJP2kDecimator * self, const MainHeader * header);
 void reset_main_header (GstJP2kDecimator * self, MainHeader * header);
 GstFlowReturn write_main_header (GstJP2kDecimator * self, GstByteWriter * writer, const MainHeader * header);
+GstFlowReturn write_main_header_scattered (GstJP2kDecimator * self, GstBuffer * inbuf, const guint8 * indata, const MainHeader * header, GstBuffer ** outbuf, guint * n_chunks);
+GstFlowReturn decimate_tile (GstJP2kDecimator * self, const MainHeader * header, Tile * tile);
 GstFlowReturn decimate_main_header (GstJP2kDecimator * self, MainHeader * header);
 
 #endif /* __JP2K_CODESTREAM_H__ */
@@ -64,6 +64,12 @@
 
 #define DURATION_SCAN_LIMIT         4 * 1024 * 1024
 
+/* minimum SCR distance between two entries of the seek index, half a
+ * second in 90kHz units */
+#define SCR_INDEX_INTERVAL          (CLOCK_FREQ / 2)
+
+#define DEFAULT_BUILD_INDEX         TRUE
+
 typedef enum
 {
   SCAN_SCR,
@@ -91,9 +97,15 @@ enum
 enum
 {
   PROP_0,
-  /* FILL ME */
+  PROP_BUILD_INDEX
 };
 
+typedef struct
+{
+  guint64 scr;
+  guint64 offset;
+} GstPsDemuxIndexEntry;
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -139,6 +151,10 @@ static void gst_ps_demux_class_init (GstPsDemuxClass * klass);
 static void gst_ps_demux_init (GstPsDemux * demux);
 static void gst_ps_demux_finalize (GstPsDemux * demux);
 static void gst_ps_demux_reset (GstPsDemux * demux);
+static void gst_ps_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_ps_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
@@ -245,6 +261,14 @@ gst_ps_demux_class_init (GstPsDemuxClass * klass)
   gstelement_class = (GstElementClass *) klass;
 
   gobject_class->finalize = (GObjectFinalizeFunc) gst_ps_demux_finalize;
+  gobject_class->set_property = gst_ps_demux_set_property;
+  gobject_class->get_property = gst_ps_demux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_BUILD_INDEX,
+      g_param_spec_boolean ("build-index", "Build index",
+          "Remember the SCRs found while playing and seeking in pull mode "
+          "and use them to speed up later seeks", DEFAULT_BUILD_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = gst_ps_demux_change_state;
 }
@@ -276,6 +300,10 @@ gst_ps_demux_init (GstPsDemux * demux)
   demux->rev_adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
 
+  demux->build_index = DEFAULT_BUILD_INDEX;
+  demux->scr_index = g_array_new (FALSE, FALSE,
+      sizeof (GstPsDemuxIndexEntry));
+
   gst_ps_demux_reset (demux);
 }
 
@@ -289,10 +317,43 @@ gst_ps_demux_finalize (GstPsDemux * demux)
   gst_flow_combiner_free (demux->flowcombiner);
   g_object_unref (demux->adapter);
   g_object_unref (demux->rev_adapter);
+  g_array_free (demux->scr_index, TRUE);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (demux));
 }
 
+static void
+gst_ps_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstPsDemux *demux = GST_PS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_BUILD_INDEX:
+      demux->build_index = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ps_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstPsDemux *demux = GST_PS_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_BUILD_INDEX:
+      g_value_set_boolean (value, demux->build_index);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_ps_demux_reset (GstPsDemux * demux)
 {
@@ -322,6 +383,7 @@ gst_ps_demux_reset (GstPsDemux * demux)
 
   gst_adapter_clear (demux->adapter);
   gst_adapter_clear (demux->rev_adapter);
+  g_array_set_size (demux->scr_index, 0);
 
   demux->adapter_offset = G_MAXUINT64;
   demux->first_scr = G_MAXUINT64;
@@ -1117,6 +1179,114 @@ not_supported:
   }
 }
 
+/* returns the position of the first index entry after @offset */
+static guint
+gst_ps_demux_index_upper_bound (GstPsDemux * demux, guint64 offset)
+{
+  guint lo = 0, hi = demux->scr_index->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (demux->scr_index, GstPsDemuxIndexEntry,
+            mid).offset <= offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Records that the pack at @offset has @scr, unless there already is an
+ * entry with a close SCR next to it. Only done in pull mode, where offsets
+ * are reliable and seeks can make use of it */
+static void
+gst_ps_demux_index_add (GstPsDemux * demux, guint64 scr, guint64 offset)
+{
+  GstPsDemuxIndexEntry entry = { scr, offset };
+  GstPsDemuxIndexEntry *prev, *next;
+  guint len = demux->scr_index->len;
+  guint pos;
+
+  if (!demux->build_index || !demux->random_access ||
+      scr == G_MAXUINT64 || offset == G_MAXUINT64)
+    return;
+
+  /* when playing, packs come in order, so check the last entry first */
+  if (len > 0) {
+    prev = &g_array_index (demux->scr_index, GstPsDemuxIndexEntry, len - 1);
+    if (offset >= prev->offset && scr >= prev->scr &&
+        scr - prev->scr < SCR_INDEX_INTERVAL)
+      return;
+  }
+
+  pos = gst_ps_demux_index_upper_bound (demux, offset);
+  if (pos > 0) {
+    prev = &g_array_index (demux->scr_index, GstPsDemuxIndexEntry, pos - 1);
+    if (prev->offset == offset || (scr >= prev->scr &&
+            scr - prev->scr < SCR_INDEX_INTERVAL))
+      return;
+  }
+  if (pos < len) {
+    next = &g_array_index (demux->scr_index, GstPsDemuxIndexEntry, pos);
+    if (next->scr >= scr && next->scr - scr < SCR_INDEX_INTERVAL)
+      return;
+  }
+
+  g_array_insert_val (demux->scr_index, pos, entry);
+
+  GST_LOG_OBJECT (demux, "indexed SCR %" G_GUINT64_FORMAT " at offset %"
+      G_GUINT64_FORMAT ", %u entries", scr, offset, demux->scr_index->len);
+}
+
+/* Finds the index entries surrounding @scr and narrows down the given
+ * range with them. SCRs normally grow with the offset, but are not
+ * guaranteed to, so the result is only used if it is consistent */
+static void
+gst_ps_demux_index_lookup (GstPsDemux * demux, guint64 scr,
+    guint64 * min_scr, guint64 * min_scr_offset,
+    guint64 * max_scr, guint64 * max_scr_offset)
+{
+  GstPsDemuxIndexEntry *lower = NULL, *upper = NULL;
+  guint lo = 0, hi = demux->scr_index->len;
+
+  if (hi == 0)
+    return;
+
+  /* first entry with a SCR after the requested one */
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (demux->scr_index, GstPsDemuxIndexEntry, mid).scr <=
+        scr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0)
+    lower = &g_array_index (demux->scr_index, GstPsDemuxIndexEntry, lo - 1);
+  if (lo < demux->scr_index->len)
+    upper = &g_array_index (demux->scr_index, GstPsDemuxIndexEntry, lo);
+
+  if (lower && lower->scr >= *min_scr && lower->scr < *max_scr &&
+      lower->offset > *min_scr_offset && lower->offset < *max_scr_offset) {
+    *min_scr = lower->scr;
+    *min_scr_offset = lower->offset;
+  }
+  if (upper && upper->scr <= *max_scr && upper->scr > *min_scr &&
+      upper->offset > *min_scr_offset && upper->offset < *max_scr_offset) {
+    *max_scr = upper->scr;
+    *max_scr_offset = upper->offset;
+  }
+
+  GST_DEBUG_OBJECT (demux, "index narrowed search for SCR %" G_GUINT64_FORMAT
+      " to %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT " (offsets %"
+      G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT ")", scr, *min_scr, *max_scr,
+      *min_scr_offset, *max_scr_offset);
+}
+
 #define MAX_RECURSION_COUNT 100
 
 /* Binary search for requested SCR */
@@ -1138,8 +1308,10 @@ find_offset (GstPsDemux * demux, guint64 scr,
       MIN (gst_util_uint64_scale (scr - min_scr, scr_rate_n,
           scr_rate_d), demux->sink_segment.stop);
 
-  if (!gst_ps_demux_scan_forward_ts (demux, &offset, SCAN_SCR, &fscr, 0)) {
-    gst_ps_demux_scan_backward_ts (demux, &offset, SCAN_SCR, &fscr, 0);
+  if (gst_ps_demux_scan_forward_ts (demux, &offset, SCAN_SCR, &fscr, 0) ||
+      gst_ps_demux_scan_backward_ts (demux, &offset, SCAN_SCR, &fscr, 0)) {
+    /* keep what we learned for the next seeks */
+    gst_ps_demux_index_add (demux, fscr, offset);
   }
 
   if (fscr == scr || fscr == min_scr || fscr == max_scr) {
@@ -1161,6 +1333,7 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   gboolean found;
   guint64 fscr, offset;
   guint64 scr = GSTTIME_TO_MPEGTIME (seeksegment->position + demux->base_time);
+  guint64 min_scr, min_scr_offset, max_scr, max_scr_offset;
 
   /* In some clips the PTS values are completely unaligned with SCR values.
    * To improve the seek in that situation we apply a factor considering the
@@ -1175,9 +1348,18 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   GST_INFO_OBJECT (demux, "sink segment configured %" GST_SEGMENT_FORMAT
       ", trying to go at SCR: %" G_GUINT64_FORMAT, &demux->sink_segment, scr);
 
+  demux->seek_pulls = 0;
+
+  min_scr = demux->first_scr;
+  min_scr_offset = demux->first_scr_offset;
+  max_scr = demux->last_scr;
+  max_scr_offset = demux->last_scr_offset;
+  gst_ps_demux_index_lookup (demux, scr, &min_scr, &min_scr_offset,
+      &max_scr, &max_scr_offset);
+
   offset =
-      find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
-      demux->last_scr, demux->last_scr_offset, 0);
+      find_offset (demux, scr, min_scr, min_scr_offset, max_scr,
+      max_scr_offset, 0);
 
   if (offset == (guint64) - 1) {
     return FALSE;
@@ -1198,8 +1380,9 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   }
 
   GST_INFO_OBJECT (demux, "doing seek at offset %" G_GUINT64_FORMAT
-      " SCR: %" G_GUINT64_FORMAT " %" GST_TIME_FORMAT,
-      offset, fscr, GST_TIME_ARGS (MPEGTIME_TO_GSTTIME (fscr)));
+      " SCR: %" G_GUINT64_FORMAT " %" GST_TIME_FORMAT ", found after %u pulls",
+      offset, fscr, GST_TIME_ARGS (MPEGTIME_TO_GSTTIME (fscr)),
+      demux->seek_pulls);
 
   gst_segment_set_position (&demux->sink_segment, GST_FORMAT_BYTES, offset);
 
@@ -1721,6 +1904,11 @@ gst_ps_demux_parse_pack_start (GstPsDemux * demux)
   /* scr adjusted is the new scr found + the colected adjustment */
   scr_adjusted = scr + demux->scr_adjust;
 
+  /* the adapter offset is still the one of the pack start code, except
+   * in reverse playback where skipped bytes are kept around */
+  if (demux->sink_segment.rate >= 0.0)
+    gst_ps_demux_index_add (demux, scr, demux->adapter_offset);
+
   GST_LOG_OBJECT (demux,
       "SCR: %" G_GINT64_FORMAT " (%" G_GINT64_FORMAT "), mux_rate %"
       G_GINT64_FORMAT ", GStreamer Time:%" GST_TIME_FORMAT,
@@ -2609,6 +2797,7 @@ gst_ps_demux_scan_forward_ts (GstPsDemux * demux, guint64 * pos,
     /* read some data */
     buffer = NULL;
     ret = gst_pad_pull_range (demux->sinkpad, offset, to_read, &buffer);
+    demux->seek_pulls++;
     if (G_UNLIKELY (ret != GST_FLOW_OK))
       return FALSE;
     gst_buffer_map (buffer, &map, GST_MAP_READ);
@@ -2669,6 +2858,7 @@ gst_ps_demux_scan_backward_ts (GstPsDemux * demux, guint64 * pos,
     /* read some data */
     buffer = NULL;
     ret = gst_pad_pull_range (demux->sinkpad, offset, to_read, &buffer);
+    demux->seek_pulls++;
     if (G_UNLIKELY (ret != GST_FLOW_OK))
       return FALSE;
     gst_buffer_map (buffer, &map, GST_MAP_READ);
@@ -2781,6 +2971,9 @@ gst_ps_sink_get_duration (GstPsDemux * demux)
       }
     }
   }
+  /* The ends are where seeks start from, index them too */
+  gst_ps_demux_index_add (demux, demux->first_scr, demux->first_scr_offset);
+  gst_ps_demux_index_add (demux, demux->last_scr, demux->last_scr_offset);
   /* Set the base_time and avg rate */
   demux->base_time = MPEGTIME_TO_GSTTIME (demux->first_scr);
   demux->scr_rate_n = demux->last_scr_offset - demux->first_scr_offset;
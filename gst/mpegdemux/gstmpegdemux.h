@@ -156,6 +156,12 @@ struct _GstPsDemux
 
   /* Indicates an MPEG-2 stream */
   gboolean is_mpeg2_pack;
+
+  /* sparse SCR index, sorted by offset, used to narrow down seeks */
+  gboolean build_index;
+  GArray *scr_index;
+  /* number of pulls done by the current seek */
+  guint seek_pulls;
 };
 
 struct _GstPsDemuxClass
@@ -115,9 +115,15 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_READ_AHEAD_SIZE
 };
 
+#define DEFAULT_READ_AHEAD_SIZE 0
+
+/* read-ahead blocks start at multiples of this */
+#define READ_AHEAD_ALIGN 4096
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstObject * parent,
@@ -152,6 +158,204 @@ gst_mxf_demux_partition_free (GstMXFDemuxPartition * partition)
   g_free (partition);
 }
 
+static GstMXFDemuxOffsets *
+gst_mxf_demux_offsets_new (void)
+{
+  GstMXFDemuxOffsets *offsets = g_new0 (GstMXFDemuxOffsets, 1);
+
+  offsets->entries = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+  offsets->keyframes = g_array_new (FALSE, FALSE, sizeof (gint64));
+  offsets->runs = g_array_new (FALSE, FALSE, sizeof (GstMXFDemuxIndexRun));
+
+  return offsets;
+}
+
+static void
+gst_mxf_demux_offsets_free (GstMXFDemuxOffsets * offsets)
+{
+  g_array_free (offsets->entries, TRUE);
+  g_array_free (offsets->keyframes, TRUE);
+  g_array_free (offsets->runs, TRUE);
+  g_free (offsets);
+}
+
+/* Index of the first keyframe after @position */
+static guint
+gst_mxf_demux_offsets_keyframes_upper_bound (GstMXFDemuxOffsets * offsets,
+    gint64 position)
+{
+  guint lo = 0, hi = offsets->keyframes->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (offsets->keyframes, gint64, mid) <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* Index of the first run starting after @position */
+static guint
+gst_mxf_demux_offsets_runs_upper_bound (GstMXFDemuxOffsets * offsets,
+    gint64 position)
+{
+  guint lo = 0, hi = offsets->runs->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (offsets->runs, GstMXFDemuxIndexRun, mid).start <=
+        position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static GstMXFDemuxIndex *
+gst_mxf_demux_offsets_get (GstMXFDemuxOffsets * offsets, gint64 position)
+{
+  if (!offsets || position < 0 || position >= offsets->entries->len)
+    return NULL;
+
+  return &g_array_index (offsets->entries, GstMXFDemuxIndex, position);
+}
+
+static void
+gst_mxf_demux_offsets_set (GstMXFDemuxOffsets * offsets, gint64 position,
+    guint64 offset, gboolean keyframe)
+{
+  GstMXFDemuxIndex *idx;
+  GstMXFDemuxIndexRun *run;
+  gboolean is_keyframe;
+  guint i;
+
+  g_return_if_fail (position >= 0 && position < G_MAXINT);
+  g_return_if_fail (offset != 0);
+
+  if (offsets->entries->len <= position)
+    g_array_set_size (offsets->entries, position + 1);
+
+  idx = &g_array_index (offsets->entries, GstMXFDemuxIndex, position);
+  idx->offset = offset;
+  idx->keyframe = keyframe;
+
+  i = gst_mxf_demux_offsets_keyframes_upper_bound (offsets, position);
+  is_keyframe = i > 0
+      && g_array_index (offsets->keyframes, gint64, i - 1) == position;
+  if (keyframe && !is_keyframe)
+    g_array_insert_val (offsets->keyframes, i, position);
+  else if (!keyframe && is_keyframe)
+    g_array_remove_index (offsets->keyframes, i - 1);
+
+  /* Extend or merge the runs around the new entry, entries are usually
+   * added in order so this mostly grows the last run */
+  i = gst_mxf_demux_offsets_runs_upper_bound (offsets, position);
+  if (i > 0) {
+    run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, i - 1);
+    if (position < run->end)
+      return;
+
+    if (position == run->end) {
+      run->end++;
+      if (i < offsets->runs->len
+          && g_array_index (offsets->runs, GstMXFDemuxIndexRun,
+              i).start == run->end) {
+        run->end = g_array_index (offsets->runs, GstMXFDemuxIndexRun, i).end;
+        g_array_remove_index (offsets->runs, i);
+      }
+      return;
+    }
+  }
+
+  if (i < offsets->runs->len) {
+    run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, i);
+    if (run->start == position + 1) {
+      run->start = position;
+      return;
+    }
+  }
+
+  {
+    GstMXFDemuxIndexRun new_run = { position, position + 1 };
+
+    g_array_insert_val (offsets->runs, i, new_run);
+  }
+}
+
+/* Finds the edit unit stored at @offset. Offsets grow with the edit units,
+ * so this is a binary search over the runs and then inside the run */
+static gboolean
+gst_mxf_demux_offsets_find_position (GstMXFDemuxOffsets * offsets,
+    guint64 offset, gint64 * position)
+{
+  GstMXFDemuxIndexRun *run;
+  gint64 lo, hi;
+  guint i, j;
+
+  if (!offsets)
+    return FALSE;
+
+  i = 0;
+  j = offsets->runs->len;
+  while (i < j) {
+    guint mid = i + (j - i) / 2;
+
+    run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, mid);
+    if (g_array_index (offsets->entries, GstMXFDemuxIndex,
+            run->start).offset <= offset)
+      i = mid + 1;
+    else
+      j = mid;
+  }
+
+  if (i == 0)
+    return FALSE;
+
+  run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, i - 1);
+  lo = run->start;
+  hi = run->end;
+  while (lo < hi) {
+    gint64 mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (offsets->entries, GstMXFDemuxIndex, mid).offset <
+        offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == run->end
+      || g_array_index (offsets->entries, GstMXFDemuxIndex, lo).offset !=
+      offset)
+    return FALSE;
+
+  *position = lo;
+  return TRUE;
+}
+
+static GstMXFDemuxIndexTable *
+gst_mxf_demux_find_index_table (GstMXFDemux * demux, guint32 body_sid,
+    guint32 index_sid)
+{
+  GList *l;
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    if (t->body_sid == body_sid && t->index_sid == index_sid)
+      return t;
+  }
+
+  return NULL;
+}
+
 static void
 gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 {
@@ -171,7 +375,7 @@ gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
         &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
 
     if (t->offsets)
-      g_array_free (t->offsets, TRUE);
+      gst_mxf_demux_offsets_free (t->offsets);
 
     g_free (t->mapping_data);
 
@@ -245,6 +449,9 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->footer_partition_pack_offset = 0;
   demux->offset = 0;
 
+  gst_buffer_replace (&demux->read_ahead, NULL);
+  demux->read_ahead_offset = 0;
+
   demux->pull_footer_metadata = TRUE;
 
   demux->run_in = -1;
@@ -284,7 +491,7 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
     for (l = demux->index_tables; l; l = l->next) {
       GstMXFDemuxIndexTable *t = l->data;
-      g_array_free (t->offsets, TRUE);
+      gst_mxf_demux_offsets_free (t->offsets);
       g_free (t);
     }
     g_list_free (demux->index_tables);
@@ -305,7 +512,71 @@ gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
+  guint64 block_offset;
+  gsize block_size;
+
+  if (demux->read_ahead) {
+    block_size = gst_buffer_get_size (demux->read_ahead);
+    if (offset >= demux->read_ahead_offset
+        && offset + size <= demux->read_ahead_offset + block_size) {
+      *buffer =
+          gst_buffer_copy_region (demux->read_ahead, GST_BUFFER_COPY_ALL,
+          offset - demux->read_ahead_offset, size);
+      GST_BUFFER_OFFSET (*buffer) = offset;
+      return GST_FLOW_OK;
+    }
+  }
+
+  /* Read a larger block if the requested range fits into it, small reads
+   * are slow on network storage */
+  block_offset = offset - offset % READ_AHEAD_ALIGN;
+  if (demux->read_ahead_size > 0
+      && offset + size <= block_offset + demux->read_ahead_size) {
+    GstBuffer *block = NULL;
+
+    gst_buffer_replace (&demux->read_ahead, NULL);
+
+    ret =
+        gst_pad_pull_range (demux->sinkpad, block_offset,
+        demux->read_ahead_size, &block);
+    if (ret == GST_FLOW_EOS) {
+      /* some sources refuse ranges crossing the end, read exactly what
+       * was requested then */
+      GST_DEBUG_OBJECT (demux, "read-ahead at offset %" G_GUINT64_FORMAT
+          " failed with EOS", block_offset);
+      goto pull;
+    } else if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      GST_WARNING_OBJECT (demux,
+          "failed when pulling %u bytes from offset %" G_GUINT64_FORMAT ": %s",
+          demux->read_ahead_size, block_offset, gst_flow_get_name (ret));
+      *buffer = NULL;
+      return ret;
+    }
+
+    GST_LOG_OBJECT (demux, "read %" G_GSIZE_FORMAT " bytes ahead at offset %"
+        G_GUINT64_FORMAT, gst_buffer_get_size (block), block_offset);
+
+    demux->read_ahead = block;
+    demux->read_ahead_offset = block_offset;
 
+    block_size = gst_buffer_get_size (block);
+    if (G_UNLIKELY (offset + size > block_offset + block_size)) {
+      GST_WARNING_OBJECT (demux,
+          "partial pull got %" G_GSIZE_FORMAT " bytes from offset %"
+          G_GUINT64_FORMAT " when expecting %u from offset %" G_GUINT64_FORMAT,
+          block_size, block_offset, size, offset);
+      *buffer = NULL;
+      return GST_FLOW_EOS;
+    }
+
+    *buffer =
+        gst_buffer_copy_region (block, GST_BUFFER_COPY_ALL,
+        offset - block_offset, size);
+    GST_BUFFER_OFFSET (*buffer) = offset;
+    return GST_FLOW_OK;
+  }
+
+pull:
   ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_WARNING_OBJECT (demux,
@@ -1675,17 +1946,8 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   if (etrack->position == -1) {
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
-      for (i = 0; i < etrack->offsets->len; i++) {
-        GstMXFDemuxIndex *idx =
-            &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
-
-        if (idx->offset != 0 && idx->offset == demux->offset - demux->run_in) {
-          etrack->position = i;
-          break;
-        }
-      }
-    }
+    gst_mxf_demux_offsets_find_position (etrack->offsets,
+        demux->offset - demux->run_in, &etrack->position);
 
     if (etrack->position == -1) {
       GST_WARNING_OBJECT (demux, "Essence track position not in index");
@@ -1693,10 +1955,10 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     }
   }
 
-  if (etrack->offsets && etrack->offsets->len > etrack->position) {
+  {
     GstMXFDemuxIndex *index =
-        &g_array_index (etrack->offsets, GstMXFDemuxIndex, etrack->position);
-    if (index->offset != 0)
+        gst_mxf_demux_offsets_get (etrack->offsets, etrack->position);
+    if (index && index->offset != 0)
       keyframe = index->keyframe;
   }
 
@@ -1734,24 +1996,14 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
   /* Prefer keyframe information from index tables over everything else */
   if (demux->index_tables && outbuf) {
-    GList *l;
-    GstMXFDemuxIndexTable *index_table = NULL;
+    GstMXFDemuxIndexTable *index_table =
+        gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+        etrack->index_sid);
 
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-
-    if (index_table && index_table->offsets->len > etrack->position) {
+    if (index_table) {
       GstMXFDemuxIndex *index =
-          &g_array_index (index_table->offsets, GstMXFDemuxIndex,
-          etrack->position);
-      if (index->offset != 0) {
+          gst_mxf_demux_offsets_get (index_table->offsets, etrack->position);
+      if (index && index->offset != 0) {
         keyframe = index->keyframe;
 
         if (keyframe)
@@ -1763,25 +2015,11 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   }
 
   if (!etrack->offsets)
-    etrack->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    etrack->offsets = gst_mxf_demux_offsets_new ();
 
-  {
-    if (etrack->offsets->len > etrack->position) {
-      GstMXFDemuxIndex *index =
-          &g_array_index (etrack->offsets, GstMXFDemuxIndex, etrack->position);
-
-      index->offset = demux->offset - demux->run_in;
-      index->keyframe = keyframe;
-    } else if (etrack->position < G_MAXINT) {
-      GstMXFDemuxIndex index;
-
-      index.offset = demux->offset - demux->run_in;
-      index.keyframe = keyframe;
-      if (etrack->offsets->len < etrack->position)
-        g_array_set_size (etrack->offsets, etrack->position);
-      g_array_insert_val (etrack->offsets, etrack->position, index);
-    }
-  }
+  if (etrack->position < G_MAXINT)
+    gst_mxf_demux_offsets_set (etrack->offsets, etrack->position,
+        demux->offset - demux->run_in, keyframe);
 
   if (peek)
     goto out;
@@ -2597,67 +2835,70 @@ gst_mxf_demux_set_partition_for_offset (GstMXFDemux * demux, guint64 offset)
   }
 }
 
+/* Returns the offset of edit unit @position, or of the closest keyframe
+ * before it if @keyframe is set and all entries in-between are known */
 static guint64
-find_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_offset (GstMXFDemuxOffsets * offsets, gint64 * position,
+    gboolean keyframe)
 {
   GstMXFDemuxIndex *idx;
-  guint64 current_offset = -1;
-  gint64 current_position = *position;
+  GstMXFDemuxIndexRun *run;
+  gint64 keyframe_position;
+  guint i;
 
-  if (!offsets || offsets->len <= *position)
+  idx = gst_mxf_demux_offsets_get (offsets, *position);
+  if (!idx || idx->offset == 0)
     return -1;
 
-  idx = &g_array_index (offsets, GstMXFDemuxIndex, *position);
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
-    current_offset = idx->offset;
-  } else if (idx->offset != 0) {
-    current_position--;
-    while (current_position >= 0) {
-      idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-      if (idx->offset == 0) {
-        break;
-      } else if (!idx->keyframe) {
-        current_position--;
-        continue;
-      } else {
-        current_offset = idx->offset;
-        break;
-      }
-    }
-  }
+  if (!keyframe || idx->keyframe)
+    return idx->offset;
 
-  if (current_offset == -1)
+  i = gst_mxf_demux_offsets_keyframes_upper_bound (offsets, *position);
+  if (i == 0)
     return -1;
+  keyframe_position = g_array_index (offsets->keyframes, gint64, i - 1);
 
-  *position = current_position;
-  return current_offset;
+  /* the run of known entries that contains *position */
+  i = gst_mxf_demux_offsets_runs_upper_bound (offsets, *position);
+  run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, i - 1);
+  if (keyframe_position < run->start)
+    return -1;
+
+  *position = keyframe_position;
+  return g_array_index (offsets->entries, GstMXFDemuxIndex,
+      keyframe_position).offset;
 }
 
+/* Returns the offset of the closest known edit unit (or keyframe) at or
+ * before @position */
 static guint64
-find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_closest_offset (GstMXFDemuxOffsets * offsets, gint64 * position,
+    gboolean keyframe)
 {
-  GstMXFDemuxIndex *idx;
-  gint64 current_position = *position;
+  gint64 current_position;
+  guint i;
 
-  if (!offsets || offsets->len == 0)
+  if (!offsets || *position < 0)
     return -1;
 
-  current_position = MIN (current_position, offsets->len - 1);
+  if (keyframe) {
+    i = gst_mxf_demux_offsets_keyframes_upper_bound (offsets, *position);
+    if (i == 0)
+      return -1;
+    current_position = g_array_index (offsets->keyframes, gint64, i - 1);
+  } else {
+    GstMXFDemuxIndexRun *run;
 
-  idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-  while (idx->offset == 0 || (keyframe && !idx->keyframe)) {
-    current_position--;
-    if (current_position < 0)
-      break;
-    idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
+    i = gst_mxf_demux_offsets_runs_upper_bound (offsets, *position);
+    if (i == 0)
+      return -1;
+    run = &g_array_index (offsets->runs, GstMXFDemuxIndexRun, i - 1);
+    current_position = MIN (*position, run->end - 1);
   }
 
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
-    *position = current_position;
-    return idx->offset;
-  }
-
-  return -1;
+  *position = current_position;
+  return g_array_index (offsets->entries, GstMXFDemuxIndex,
+      current_position).offset;
 }
 
 static guint64
@@ -2676,19 +2917,9 @@ gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
       " of track %u with body_sid %u (keyframe %d)", *position,
       etrack->track_number, etrack->body_sid, keyframe);
 
-  if (demux->index_tables) {
-    GList *l;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-  }
+  index_table =
+      gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+      etrack->index_sid);
 
 from_index:
 
@@ -2823,9 +3054,7 @@ from_index:
       /* If we found the position read it from the index again */
       if (((ret == GST_FLOW_OK && etrack->position == *position + 2) ||
               (ret == GST_FLOW_EOS && etrack->position == *position + 1))
-          && etrack->offsets && etrack->offsets->len > *position
-          && g_array_index (etrack->offsets, GstMXFDemuxIndex,
-              *position).offset != 0) {
+          && find_offset (etrack->offsets, position, FALSE) != -1) {
         GST_DEBUG_OBJECT (demux, "Found at offset %" G_GUINT64_FORMAT,
             demux->offset);
         demux->offset = old_offset;
@@ -3515,6 +3744,8 @@ collect_index_table_segments (GstMXFDemux * demux)
 {
   GList *l;
   guint i;
+  GPtrArray *partitions;
+  GArray *body_partitions;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
 
@@ -3537,27 +3768,24 @@ collect_index_table_segments (GstMXFDemux * demux)
   demux->offset = old_offset;
   demux->current_partition = old_partition;
 
+  /* sorted by offset, for looking up the partitions of the entries */
+  partitions = g_ptr_array_new ();
+  for (l = demux->partitions; l; l = l->next)
+    g_ptr_array_add (partitions, l->data);
+  body_partitions = g_array_new (FALSE, FALSE, sizeof (guint));
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
-    GstMXFDemuxIndexTable *t = NULL;
-    GList *k;
+    GstMXFDemuxIndexTable *t;
     guint64 start, end;
 
-    for (k = demux->index_tables; k; k = k->next) {
-      GstMXFDemuxIndexTable *tmp = k->data;
-
-      if (tmp->body_sid == segment->body_sid
-          && tmp->index_sid == segment->index_sid) {
-        t = tmp;
-        break;
-      }
-    }
-
+    t = gst_mxf_demux_find_index_table (demux, segment->body_sid,
+        segment->index_sid);
     if (!t) {
       t = g_new0 (GstMXFDemuxIndexTable, 1);
       t->body_sid = segment->body_sid;
       t->index_sid = segment->index_sid;
-      t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+      t->offsets = gst_mxf_demux_offsets_new ();
       demux->index_tables = g_list_prepend (demux->index_tables, t);
     }
 
@@ -3565,35 +3793,43 @@ collect_index_table_segments (GstMXFDemux * demux)
     end = start + segment->index_duration;
     if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
       demux->index_tables = g_list_remove (demux->index_tables, t);
-      g_array_free (t->offsets, TRUE);
+      gst_mxf_demux_offsets_free (t->offsets);
       g_free (t);
       continue;
     }
 
-    if (t->offsets->len < end)
-      g_array_set_size (t->offsets, end);
+    /* the partitions of this body, their body offsets are increasing */
+    g_array_set_size (body_partitions, 0);
+    for (i = 0; i < partitions->len; i++) {
+      GstMXFDemuxPartition *partition = g_ptr_array_index (partitions, i);
 
-    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
-        i++) {
-      GstMXFDemuxIndex *index =
-          &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+      if (partition->partition.body_sid == t->body_sid)
+        g_array_append_val (body_partitions, i);
+    }
+
+    for (i = 0; i < segment->n_index_entries && start + i < end; i++) {
       guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
       GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+      guint lo = 0, hi = body_partitions->len;
 
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
+      /* last partition of the body starting at or before the entry */
+      while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        GstMXFDemuxPartition *partition = g_ptr_array_index (partitions,
+            g_array_index (body_partitions, guint, mid));
 
-        if (!next_partition && offset_partition)
-          next_partition = partition;
+        if (partition->partition.body_offset <= offset)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
 
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
-          break;
+      if (lo > 0) {
+        guint k = g_array_index (body_partitions, guint, lo - 1);
 
-        offset_partition = partition;
-        next_partition = NULL;
+        offset_partition = g_ptr_array_index (partitions, k);
+        if (k + 1 < partitions->len)
+          next_partition = g_ptr_array_index (partitions, k + 1);
       }
 
       if (offset_partition && offset >= offset_partition->partition.body_offset
@@ -3608,14 +3844,17 @@ collect_index_table_segments (GstMXFDemux * demux)
           GST_ERROR_OBJECT (demux,
               "Invalid index table segment going into next unrelated partition");
         } else {
-          index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
+          gst_mxf_demux_offsets_set (t->offsets, start + i, offset,
+              ! !(segment->index_entries[i].flags & 0x80)
+              || (segment->index_entries[i].key_frame_offset == 0));
         }
       }
     }
   }
 
+  g_array_free (body_partitions, TRUE);
+  g_ptr_array_free (partitions, TRUE);
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *s = l->data;
     mxf_index_table_segment_reset (s);
@@ -4364,6 +4603,14 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_READ_AHEAD_SIZE:
+      demux->read_ahead_size = g_value_get_uint (value);
+      /* blocks start at multiples of READ_AHEAD_ALIGN, smaller ones would
+       * not contain most of the requested ranges */
+      if (demux->read_ahead_size > 0)
+        demux->read_ahead_size =
+            MAX (demux->read_ahead_size, READ_AHEAD_ALIGN);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4383,6 +4630,9 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_READ_AHEAD_SIZE:
+      g_value_set_uint (value, demux->read_ahead_size);
+      break;
     case PROP_STRUCTURE:{
       GstStructure *s;
 
@@ -4475,6 +4725,14 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_SIZE,
+      g_param_spec_uint ("read-ahead-size", "Read-ahead size",
+          "Size of the blocks read in pull mode, KLV packets that fit into "
+          "a block are read from it without copying, at least 4096 bytes "
+          "(0 = disabled)",
+          0, G_MAXINT, DEFAULT_READ_AHEAD_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -4506,6 +4764,7 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = 500 * GST_MSECOND;
+  demux->read_ahead_size = DEFAULT_READ_AHEAD_SIZE;
 
   demux->adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
@@ -62,6 +62,22 @@ typedef struct
   gboolean keyframe;
 } GstMXFDemuxIndex;
 
+typedef struct
+{
+  gint64 start;
+  gint64 end;
+} GstMXFDemuxIndexRun;
+
+/* Edit unit to offset index. The entries can be looked up directly by edit
+ * unit, and the sorted keyframes and runs of known entries allow to find the
+ * closest usable entry of an edit unit with a binary search */
+typedef struct
+{
+  GArray *entries;              /* GstMXFDemuxIndex, offset 0 if unknown */
+  GArray *keyframes;            /* gint64 edit units of known keyframes */
+  GArray *runs;                 /* GstMXFDemuxIndexRun, end exclusive */
+} GstMXFDemuxOffsets;
+
 typedef struct
 {
   guint32 body_sid;
@@ -74,7 +90,7 @@ typedef struct
   gint64 position;
   gint64 duration;
 
-  GArray *offsets;
+  GstMXFDemuxOffsets *offsets;
 
   MXFMetadataSourcePackage *source_package;
   MXFMetadataTimelineTrack *source_track;
@@ -92,7 +108,7 @@ typedef struct
 {
   guint32 body_sid;
   guint32 index_sid;
-  GArray *offsets;
+  GstMXFDemuxOffsets *offsets;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -148,6 +164,10 @@ struct _GstMXFDemux
 
   guint64 offset;
 
+  /* pull mode read-ahead block, KLV packets are sliced out of it */
+  GstBuffer *read_ahead;
+  guint64 read_ahead_offset;
+
   gboolean random_access;
   gboolean flushing;
 
@@ -186,6 +206,7 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  guint read_ahead_size;
 };
 
 struct _GstMXFDemuxClass
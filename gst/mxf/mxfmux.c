@@ -114,13 +114,20 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL
 };
 
+#define DEFAULT_PARTITION_INTERVAL 0
+
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -134,6 +141,7 @@ static GstAggregatorPad *gst_mxf_mux_create_new_pad (GstAggregator * aggregator,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 
 static void gst_mxf_mux_reset (GstMXFMux * mux);
+static GstFlowReturn gst_mxf_mux_split_body_partition (GstMXFMux * mux);
 
 static GstFlowReturn
 gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
@@ -162,6 +170,17 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Close a body partition at the first keyframe after this many "
+          "nanoseconds, repeating the header metadata and writing the index "
+          "of the previous partitions, so that the file can be read while "
+          "it is written (0 = single body partition)", 0, G_MAXUINT64,
+          DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -190,6 +209,8 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->rip = g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
   gst_mxf_mux_reset (mux);
 }
 
@@ -216,9 +237,43 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  g_array_free (mux->rip, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_reset (GstMXFMux * mux)
 {
@@ -265,6 +320,9 @@ gst_mxf_mux_reset (GstMXFMux * mux)
       g_free (g_array_index (mux->index_table, MXFIndexTableSegment,
               n).index_entries);
   g_array_set_size (mux->index_table, 0);
+
+  g_array_set_size (mux->rip, 0);
+  mux->last_partition_timestamp = 0;
 }
 
 static gboolean
@@ -1266,6 +1324,16 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
     MXFIndexTableSegment *segment;
     const gint max_segment_size = G_MAXUINT16 / 11;
 
+    if (mux->partition_interval > 0 && is_keyframe && pad->pos > 0
+        && pad->last_timestamp >=
+        mux->last_partition_timestamp + mux->partition_interval) {
+      if ((ret = gst_mxf_mux_split_body_partition (mux)) != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        return ret;
+      }
+      mux->last_partition_timestamp = pad->last_timestamp;
+    }
+
     if (mux->index_table->len == 0 ||
         g_array_index (mux->index_table, MXFIndexTableSegment,
             mux->index_table->len - 1).index_duration >= max_segment_size) {
@@ -1335,10 +1403,97 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
+static void
+gst_mxf_mux_update_durations (GstMXFMux * mux)
+{
+  GList *l;
+
+  /* Update essence track durations */
+  GST_OBJECT_LOCK (mux);
+  for (l = GST_ELEMENT_CAST (mux)->sinkpads; l; l = l->next) {
+    GstMXFMuxPad *pad = l->data;
+    guint i;
+
+    /* Update durations */
+    pad->source_track->parent.sequence->duration = pad->pos;
+    MXF_METADATA_SOURCE_CLIP (pad->source_track->parent.
+        sequence->structural_components[0])->parent.duration = pad->pos;
+    for (i = 0; i < mux->preface->content_storage->packages[0]->n_tracks; i++) {
+      MXFMetadataTimelineTrack *track;
+
+      if (!MXF_IS_METADATA_TIMELINE_TRACK (mux->preface->
+              content_storage->packages[0]->tracks[i])
+          || !MXF_IS_METADATA_SOURCE_CLIP (mux->preface->
+              content_storage->packages[0]->tracks[i]->sequence->
+              structural_components[0]))
+        continue;
+
+      track =
+          MXF_METADATA_TIMELINE_TRACK (mux->preface->
+          content_storage->packages[0]->tracks[i]);
+      if (MXF_METADATA_SOURCE_CLIP (track->parent.
+              sequence->structural_components[0])->source_track_id ==
+          pad->source_track->parent.track_id) {
+        track->parent.sequence->structural_components[0]->duration = pad->pos;
+        track->parent.sequence->duration = pad->pos;
+      }
+    }
+  }
+  GST_OBJECT_UNLOCK (mux);
+
+  /* Update timecode track duration */
+  {
+    MXFMetadataTimelineTrack *track =
+        MXF_METADATA_TIMELINE_TRACK (mux->preface->
+        content_storage->packages[0]->tracks[0]);
+    MXFMetadataSequence *sequence = track->parent.sequence;
+    MXFMetadataTimecodeComponent *component =
+        MXF_METADATA_TIMECODE_COMPONENT (sequence->structural_components[0]);
+
+    sequence->duration = mux->last_gc_position;
+    component->parent.duration = mux->last_gc_position;
+  }
+
+  {
+    MXFMetadataTimelineTrack *track =
+        MXF_METADATA_TIMELINE_TRACK (mux->preface->
+        content_storage->packages[1]->tracks[0]);
+    MXFMetadataSequence *sequence = track->parent.sequence;
+    MXFMetadataTimecodeComponent *component =
+        MXF_METADATA_TIMECODE_COMPONENT (sequence->structural_components[0]);
+
+    sequence->duration = mux->last_gc_position;
+    component->parent.duration = mux->last_gc_position;
+  }
+}
+
+/* Serializes the index table segments collected so far and frees them */
+static GList *
+gst_mxf_mux_index_table_to_buffers (GstMXFMux * mux, guint * index_byte_count)
+{
+  GList *buffers = NULL;
+  guint i;
+
+  *index_byte_count = 0;
+  for (i = 0; i < mux->index_table->len; i++) {
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+    GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
+
+    *index_byte_count += gst_buffer_get_size (segment_buffer);
+    buffers = g_list_prepend (buffers, segment_buffer);
+    g_free (segment->index_entries);
+  }
+  g_array_set_size (mux->index_table, 0);
+
+  return g_list_reverse (buffers);
+}
+
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
   GstBuffer *buf;
+  MXFRandomIndexPackEntry entry;
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
   mux->partition.closed = TRUE;
@@ -1353,10 +1508,68 @@ gst_mxf_mux_write_body_partition (GstMXFMux * mux)
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
+  entry.offset = mux->offset;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->rip, entry);
+
   buf = mxf_partition_pack_to_buffer (&mux->partition);
   return gst_mxf_mux_push (mux, buf);
 }
 
+/* Starts a new body partition with a copy of the header metadata and the
+ * index table segments of the previous partitions, so that the file can be
+ * read before the footer is written */
+static GstFlowReturn
+gst_mxf_mux_split_body_partition (GstMXFMux * mux)
+{
+  MXFMetadataEssenceContainerData *ecd =
+      mux->preface->content_storage->essence_container_data[0];
+  MXFRandomIndexPackEntry entry;
+  GList *index_buffers, *l;
+  guint index_byte_count;
+  GstFlowReturn ret;
+
+  GST_DEBUG_OBJECT (mux, "Starting new body partition at offset %"
+      G_GUINT64_FORMAT, mux->offset);
+
+  gst_mxf_mux_update_durations (mux);
+  index_buffers = gst_mxf_mux_index_table_to_buffers (mux, &index_byte_count);
+
+  /* durations keep changing until EOS */
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.closed = FALSE;
+  mux->partition.complete = FALSE;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.prev_partition =
+      g_array_index (mux->rip, MXFRandomIndexPackEntry,
+      mux->rip->len - 1).offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count > 0 ? ecd->index_sid : 0;
+  /* body_offset continues where the previous partition ended */
+  mux->partition.body_sid = ecd->body_sid;
+
+  entry.offset = mux->offset;
+  entry.body_sid = ecd->body_sid;
+  g_array_append_val (mux->rip, entry);
+
+  ret = gst_mxf_mux_write_header_metadata (mux);
+
+  for (l = index_buffers; l; l = l->next) {
+    if (ret == GST_FLOW_OK)
+      ret = gst_mxf_mux_push (mux, l->data);
+    else
+      gst_buffer_unref (l->data);
+  }
+  g_list_free (index_buffers);
+
+  if (ret != GST_FLOW_OK)
+    GST_ERROR_OBJECT (mux, "Failed pushing body partition: %s",
+        gst_flow_get_name (ret));
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_mxf_mux_handle_eos (GstMXFMux * mux)
 {
@@ -1412,91 +1625,30 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       gst_util_uint64_scale (mux->last_gc_position * GST_SECOND,
       mux->min_edit_rate.d, mux->min_edit_rate.n);
 
-  /* Update essence track durations */
-  GST_OBJECT_LOCK (mux);
-  for (l = GST_ELEMENT_CAST (mux)->sinkpads; l; l = l->next) {
-    GstMXFMuxPad *pad = l->data;
-    guint i;
-
-    /* Update durations */
-    pad->source_track->parent.sequence->duration = pad->pos;
-    MXF_METADATA_SOURCE_CLIP (pad->source_track->parent.
-        sequence->structural_components[0])->parent.duration = pad->pos;
-    for (i = 0; i < mux->preface->content_storage->packages[0]->n_tracks; i++) {
-      MXFMetadataTimelineTrack *track;
-
-      if (!MXF_IS_METADATA_TIMELINE_TRACK (mux->preface->
-              content_storage->packages[0]->tracks[i])
-          || !MXF_IS_METADATA_SOURCE_CLIP (mux->preface->
-              content_storage->packages[0]->tracks[i]->sequence->
-              structural_components[0]))
-        continue;
-
-      track =
-          MXF_METADATA_TIMELINE_TRACK (mux->preface->
-          content_storage->packages[0]->tracks[i]);
-      if (MXF_METADATA_SOURCE_CLIP (track->parent.
-              sequence->structural_components[0])->source_track_id ==
-          pad->source_track->parent.track_id) {
-        track->parent.sequence->structural_components[0]->duration = pad->pos;
-        track->parent.sequence->duration = pad->pos;
-      }
-    }
-  }
-  GST_OBJECT_UNLOCK (mux);
+  gst_mxf_mux_update_durations (mux);
 
-  /* Update timecode track duration */
   {
-    MXFMetadataTimelineTrack *track =
-        MXF_METADATA_TIMELINE_TRACK (mux->preface->
-        content_storage->packages[0]->tracks[0]);
-    MXFMetadataSequence *sequence = track->parent.sequence;
-    MXFMetadataTimecodeComponent *component =
-        MXF_METADATA_TIMECODE_COMPONENT (sequence->structural_components[0]);
-
-    sequence->duration = mux->last_gc_position;
-    component->parent.duration = mux->last_gc_position;
-  }
-
-  {
-    MXFMetadataTimelineTrack *track =
-        MXF_METADATA_TIMELINE_TRACK (mux->preface->
-        content_storage->packages[1]->tracks[0]);
-    MXFMetadataSequence *sequence = track->parent.sequence;
-    MXFMetadataTimecodeComponent *component =
-        MXF_METADATA_TIMECODE_COMPONENT (sequence->structural_components[0]);
-
-    sequence->duration = mux->last_gc_position;
-    component->parent.duration = mux->last_gc_position;
-  }
-
-  {
-    guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    /* the first body partition directly follows the header partition */
+    guint64 body_partition =
+        g_array_index (mux->rip, MXFRandomIndexPackEntry, 1).offset;
     guint64 footer_partition = mux->offset;
-    GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
     MXFRandomIndexPackEntry entry;
-    GList *index_entries = NULL, *l;
-    guint index_byte_count = 0;
-    guint i;
+    GList *index_entries, *l;
+    guint index_byte_count;
     GstBuffer *buf;
 
-    for (i = 0; i < mux->index_table->len; i++) {
-      MXFIndexTableSegment *segment =
-          &g_array_index (mux->index_table, MXFIndexTableSegment, i);
-      GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
-
-      index_byte_count += gst_buffer_get_size (segment_buffer);
-      index_entries = g_list_prepend (index_entries, segment_buffer);
-    }
+    index_entries =
+        gst_mxf_mux_index_table_to_buffers (mux, &index_byte_count);
 
     mux->partition.type = MXF_PARTITION_PACK_FOOTER;
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
+    mux->partition.prev_partition =
+        g_array_index (mux->rip, MXFRandomIndexPackEntry,
+        mux->rip->len - 1).offset;
     mux->partition.this_partition = mux->offset;
-    mux->partition.prev_partition = body_partition;
     mux->partition.footer_partition = mux->offset;
     mux->partition.header_byte_count = 0;
     mux->partition.index_byte_count = index_byte_count;
@@ -1507,7 +1659,6 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
     gst_mxf_mux_write_header_metadata (mux);
 
-    index_entries = g_list_reverse (index_entries);
     for (l = index_entries; l; l = l->next) {
       if ((ret = gst_mxf_mux_push (mux, l->data)) != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Failed pushing index table segment");
@@ -1515,22 +1666,14 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
     entry.offset = footer_partition;
     entry.body_sid = 0;
-    g_array_append_val (rip, entry);
+    g_array_append_val (mux->rip, entry);
 
-    packet = mxf_random_index_pack_to_buffer (rip);
+    packet = mxf_random_index_pack_to_buffer (mux->rip);
     if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
       GST_ERROR_OBJECT (mux, "Failed pushing random index pack");
     }
-    g_array_free (rip, TRUE);
 
     /* Rewrite header partition with updated values */
     gst_segment_init (&segment, GST_FORMAT_BYTES);
@@ -1655,6 +1798,12 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     if ((ret = gst_mxf_mux_init_partition_pack (mux)) != GST_FLOW_OK)
       goto error;
 
+    {
+      MXFRandomIndexPackEntry entry = { 0, 0 };
+
+      g_array_append_val (mux->rip, entry);
+    }
+
     if ((ret = gst_mxf_mux_write_header_metadata (mux)) != GST_FLOW_OK)
       goto error;
 
@@ -70,6 +70,13 @@ typedef struct _GstMXFMux {
   gchar *application;
 
   GArray *index_table;
+
+  /* MXFRandomIndexPackEntry for every partition written so far */
+  GArray *rip;
+  GstClockTime last_partition_timestamp;
+
+  /* Properties */
+  GstClockTime partition_interval;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
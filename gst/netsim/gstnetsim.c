@@ -29,6 +29,7 @@
 
 #include <string.h>
 #include "gstnetsim.h"
+#include "gstnetsimwheel.h"
 
 GST_DEBUG_CATEGORY (netsim_debug);
 #define GST_CAT_DEFAULT (netsim_debug)
@@ -42,17 +43,46 @@ enum
   ARG_DELAY_PROBABILITY,
   ARG_DROP_PROBABILITY,
   ARG_DUPLICATE_PROBABILITY,
-  ARG_DROP_PACKETS
+  ARG_DROP_PACKETS,
+  ARG_MAX_KBPS,
+  ARG_MAX_BUCKET_SIZE,
+  ARG_QUEUE_SIZE,
+  ARG_ALLOW_REORDERING,
+  ARG_GILBERT_ELLIOTT_P,
+  ARG_GILBERT_ELLIOTT_R,
+  ARG_GILBERT_ELLIOTT_GOOD_LOSS,
+  ARG_GILBERT_ELLIOTT_BAD_LOSS,
+  ARG_SEED
 };
 
 struct _GstNetSimPrivate
 {
   GstPad *sinkpad, *srcpad;
 
+  /* protects everything below, the settings included */
   GMutex loop_mutex;
-  GCond start_cond;
-  GMainLoop *main_loop;
+  GCond cond;
   gboolean running;
+  /* set while the scheduler pushes expired packets without the lock */
+  gboolean pushing;
+
+  /* all times are taken from this clock, latched when the first packet
+   * arrives after activation */
+  GstClock *clock;
+  GstClockID clock_id;
+  guint64 wait_expiry;
+  /* packets waiting for their departure time, in microseconds */
+  GstNetSimWheel *wheel;
+
+  /* token bucket, in bits, and the departure times of the packets queued
+   * in front of it, oldest first starting at queue_head */
+  GstClockTime bucket_time;
+  guint64 bucket_tokens;
+  GArray *queue;
+  guint queue_head;
+
+  GstClockTime last_departure;
+  gboolean gilbert_elliott_bad;
 
   GRand *rand_seed;
   gint min_delay;
@@ -61,6 +91,15 @@ struct _GstNetSimPrivate
   gfloat drop_probability;
   gfloat duplicate_probability;
   guint drop_packets;
+  gint max_kbps;
+  guint max_bucket_size;
+  guint queue_size;
+  gboolean allow_reordering;
+  gfloat gilbert_elliott_p;
+  gfloat gilbert_elliott_r;
+  gfloat gilbert_elliott_good_loss;
+  gfloat gilbert_elliott_bad_loss;
+  guint seed;
 };
 
 /* these numbers are nothing but wild guesses and dont reflect any reality */
@@ -70,6 +109,15 @@ struct _GstNetSimPrivate
 #define DEFAULT_DROP_PROBABILITY 0.0
 #define DEFAULT_DUPLICATE_PROBABILITY 0.0
 #define DEFAULT_DROP_PACKETS 0
+#define DEFAULT_MAX_KBPS -1
+#define DEFAULT_MAX_BUCKET_SIZE 0
+#define DEFAULT_QUEUE_SIZE 0
+#define DEFAULT_ALLOW_REORDERING TRUE
+#define DEFAULT_GILBERT_ELLIOTT_P 0.0
+#define DEFAULT_GILBERT_ELLIOTT_R 1.0
+#define DEFAULT_GILBERT_ELLIOTT_GOOD_LOSS 0.0
+#define DEFAULT_GILBERT_ELLIOTT_BAD_LOSS 1.0
+#define DEFAULT_SEED 0
 
 #define GST_NET_SIM_GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), GST_TYPE_NET_SIM, \
@@ -89,42 +137,67 @@ GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
 
+/* The scheduler: waits on the clock until the next packet in the timer
+ * wheel is due, then pushes everything that expired in the meantime */
 static void
 gst_net_sim_loop (GstNetSim * netsim)
 {
-  GMainLoop *loop;
+  GstNetSimPrivate *priv = netsim->priv;
+  GQueue expired = G_QUEUE_INIT;
+  GstClockTime now;
+  GstBuffer *buf;
+  guint64 expiry = 0;
+
+  g_mutex_lock (&priv->loop_mutex);
+  while (priv->running && (priv->wheel == NULL ||
+          !gst_net_sim_wheel_get_next_expiry (priv->wheel, &expiry)))
+    g_cond_wait (&priv->cond, &priv->loop_mutex);
+  if (!priv->running)
+    goto pause;
+
+  now = gst_clock_get_time (priv->clock);
+  if (expiry * GST_USECOND > now) {
+    GstClock *clock = gst_object_ref (priv->clock);
+    GstClockID id;
+
+    id = gst_clock_new_single_shot_id (clock, expiry * GST_USECOND);
+    priv->clock_id = id;
+    priv->wait_expiry = expiry;
+    g_mutex_unlock (&priv->loop_mutex);
+
+    GST_TRACE_OBJECT (netsim, "TASK: waiting until %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (expiry * GST_USECOND));
+    gst_clock_id_wait (id, NULL);
+
+    g_mutex_lock (&priv->loop_mutex);
+    priv->clock_id = NULL;
+    gst_clock_id_unref (id);
+    now = gst_clock_get_time (clock);
+    gst_object_unref (clock);
+    if (!priv->running)
+      goto pause;
+  }
 
-  GST_TRACE_OBJECT (netsim, "TASK: begin");
+  gst_net_sim_wheel_advance (priv->wheel, now / GST_USECOND, &expired);
+  priv->pushing = !g_queue_is_empty (&expired);
+  g_mutex_unlock (&priv->loop_mutex);
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  loop = g_main_loop_ref (netsim->priv->main_loop);
-  netsim->priv->running = TRUE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal start");
-  g_cond_signal (&netsim->priv->start_cond);
-  g_mutex_unlock (&netsim->priv->loop_mutex);
+  if (g_queue_is_empty (&expired))
+    return;
 
-  GST_TRACE_OBJECT (netsim, "TASK: run");
-  g_main_loop_run (loop);
-  g_main_loop_unref (loop);
+  GST_LOG_OBJECT (netsim, "Pushing %u delayed packets", expired.length);
+  while ((buf = g_queue_pop_head (&expired)))
+    gst_pad_push (priv->srcpad, buf);
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: pause");
-  gst_pad_pause_task (netsim->priv->srcpad);
-  netsim->priv->running = FALSE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal end");
-  g_cond_signal (&netsim->priv->start_cond);
-  g_mutex_unlock (&netsim->priv->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: end");
-}
+  g_mutex_lock (&priv->loop_mutex);
+  priv->pushing = FALSE;
+  g_mutex_unlock (&priv->loop_mutex);
+  return;
 
-static gboolean
-_main_loop_quit_and_remove_source (gpointer user_data)
-{
-  GMainLoop *main_loop = user_data;
-  GST_DEBUG ("MAINLOOP: Quit %p", main_loop);
-  g_main_loop_quit (main_loop);
-  g_assert (!g_main_loop_is_running (main_loop));
-  return FALSE;                 /* Remove source */
+pause:
+  GST_TRACE_OBJECT (netsim, "TASK: pause");
+  gst_pad_pause_task (priv->srcpad);
+  g_mutex_unlock (&priv->loop_mutex);
 }
 
 static gboolean
@@ -132,146 +205,258 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
-  gboolean result = FALSE;
+  GstNetSimPrivate *priv = netsim->priv;
+  gboolean result;
 
-  (void) pad;
   (void) mode;
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
   if (active) {
-    if (netsim->priv->main_loop == NULL) {
-      GMainContext *main_context = g_main_context_new ();
-      netsim->priv->main_loop = g_main_loop_new (main_context, FALSE);
-      g_main_context_unref (main_context);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
-      result = gst_pad_start_task (netsim->priv->srcpad,
-          (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Wait for task to start");
-      g_assert (!netsim->priv->running);
-      while (!netsim->priv->running)
-        g_cond_wait (&netsim->priv->start_cond, &netsim->priv->loop_mutex);
-      GST_TRACE_OBJECT (netsim, "ACT: Task on srcpad started");
-    }
+    g_mutex_lock (&priv->loop_mutex);
+    if (priv->seed != 0)
+      g_rand_set_seed (priv->rand_seed, priv->seed);
+    priv->bucket_time = GST_CLOCK_TIME_NONE;
+    priv->bucket_tokens = 0;
+    g_array_set_size (priv->queue, 0);
+    priv->queue_head = 0;
+    priv->last_departure = GST_CLOCK_TIME_NONE;
+    priv->gilbert_elliott_bad = FALSE;
+    priv->running = TRUE;
+    g_mutex_unlock (&priv->loop_mutex);
+
+    GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
+    result = gst_pad_start_task (pad, (GstTaskFunction) gst_net_sim_loop,
+        netsim, NULL);
   } else {
-    if (netsim->priv->main_loop != NULL) {
-      GSource *source;
-      guint id;
-
-      /* Adds an Idle Source which quits the main loop from within.
-       * This removes the possibility for run/quit race conditions. */
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
-      source = g_idle_source_new ();
-      g_source_set_callback (source, _main_loop_quit_and_remove_source,
-          g_main_loop_ref (netsim->priv->main_loop),
-          (GDestroyNotify) g_main_loop_unref);
-      id = g_source_attach (source,
-          g_main_loop_get_context (netsim->priv->main_loop));
-      g_source_unref (source);
-      g_assert_cmpuint (id, >, 0);
-      g_main_loop_unref (netsim->priv->main_loop);
-      netsim->priv->main_loop = NULL;
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Wait for mainloop and task to pause");
-      g_assert (netsim->priv->running);
-      while (netsim->priv->running)
-        g_cond_wait (&netsim->priv->start_cond, &netsim->priv->loop_mutex);
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
-      result = gst_pad_stop_task (netsim->priv->srcpad);
-      GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
+    GST_TRACE_OBJECT (netsim, "DEACT: Stopping scheduler");
+    g_mutex_lock (&priv->loop_mutex);
+    priv->running = FALSE;
+    if (priv->clock_id)
+      gst_clock_id_unschedule (priv->clock_id);
+    g_cond_signal (&priv->cond);
+    g_mutex_unlock (&priv->loop_mutex);
+
+    result = gst_pad_stop_task (pad);
+
+    g_mutex_lock (&priv->loop_mutex);
+    if (priv->wheel) {
+      gst_net_sim_wheel_free (priv->wheel,
+          (GDestroyNotify) gst_buffer_unref);
+      priv->wheel = NULL;
     }
+    gst_object_replace ((GstObject **) & priv->clock, NULL);
+    g_mutex_unlock (&priv->loop_mutex);
+    GST_TRACE_OBJECT (netsim, "DEACT: Scheduler stopped");
   }
-  g_mutex_unlock (&netsim->priv->loop_mutex);
 
   return result;
 }
 
-typedef struct
+/* Decides whether the next packet is lost. Must be called with the loop
+ * mutex taken */
+static gboolean
+gst_net_sim_drop_packet (GstNetSim * netsim)
 {
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
+  GstNetSimPrivate *priv = netsim->priv;
+  gfloat loss;
+  gboolean drop;
+
+  if (priv->drop_packets > 0) {
+    priv->drop_packets--;
+    GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
+        priv->drop_packets);
+    return TRUE;
+  }
+
+  if (priv->drop_probability > 0 &&
+      g_rand_double (priv->rand_seed) < (gdouble) priv->drop_probability) {
+    GST_DEBUG_OBJECT (netsim, "Dropping packet");
+    return TRUE;
+  }
+
+  /* Gilbert-Elliott burst loss: the loss probability depends on the state
+   * of the channel, which may change after every packet */
+  loss = priv->gilbert_elliott_bad ? priv->gilbert_elliott_bad_loss :
+      priv->gilbert_elliott_good_loss;
+  drop = loss > 0 && g_rand_double (priv->rand_seed) < (gdouble) loss;
+
+  if (priv->gilbert_elliott_bad) {
+    if (g_rand_double (priv->rand_seed) < (gdouble) priv->gilbert_elliott_r)
+      priv->gilbert_elliott_bad = FALSE;
+  } else if (priv->gilbert_elliott_p > 0 &&
+      g_rand_double (priv->rand_seed) < (gdouble) priv->gilbert_elliott_p) {
+    priv->gilbert_elliott_bad = TRUE;
+  }
+
+  if (drop)
+    GST_DEBUG_OBJECT (netsim, "Dropping packet (burst loss)");
+
+  return drop;
+}
 
-G_INLINE_FUNC PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
+/* Returns the number of packets still waiting for the token bucket at
+ * @now */
+static guint
+gst_net_sim_get_queue_level (GstNetSimPrivate * priv, GstClockTime now)
 {
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
+  GArray *queue = priv->queue;
+
+  while (priv->queue_head < queue->len &&
+      g_array_index (queue, GstClockTime, priv->queue_head) <= now)
+    priv->queue_head++;
+
+  if (priv->queue_head == queue->len) {
+    g_array_set_size (queue, 0);
+    priv->queue_head = 0;
+  } else if (priv->queue_head >= 1024 && priv->queue_head * 2 >= queue->len) {
+    g_array_remove_range (queue, 0, priv->queue_head);
+    priv->queue_head = 0;
+  }
+
+  return queue->len - priv->queue_head;
 }
 
-G_INLINE_FUNC void
-push_buffer_ctx_free (PushBufferCtx * ctx)
+/* Returns when a packet of @size bytes arriving at @now gets enough tokens
+ * to leave the bucket. Packets leave the bucket in arrival order */
+static GstClockTime
+gst_net_sim_get_bucket_departure (GstNetSimPrivate * priv,
+    GstClockTime now, gsize size)
 {
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
+  guint64 bits = (guint64) size * 8;
+  guint64 capacity = MAX ((guint64) priv->max_bucket_size * 8, bits);
+  guint64 tokens;
+  GstClockTime departure;
+
+  if (!GST_CLOCK_TIME_IS_VALID (priv->bucket_time)) {
+    priv->bucket_time = now;
+    priv->bucket_tokens = capacity;
   }
+
+  /* kbps are bits per millisecond */
+  departure = MAX (now, priv->bucket_time);
+  tokens = priv->bucket_tokens + gst_util_uint64_scale (departure -
+      priv->bucket_time, priv->max_kbps, GST_MSECOND);
+  tokens = MIN (tokens, capacity);
+
+  if (tokens < bits) {
+    departure += gst_util_uint64_scale_ceil (bits - tokens, GST_MSECOND,
+        priv->max_kbps);
+    tokens = bits;
+  }
+
+  priv->bucket_time = departure;
+  priv->bucket_tokens = tokens - bits;
+
+  return departure;
 }
 
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
+static GstClockTime
+gst_net_sim_get_random_delay (GstNetSimPrivate * priv)
 {
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
+  gdouble delay_us = priv->min_delay * 1000.0;
+
+  if (priv->max_delay > priv->min_delay)
+    delay_us = g_rand_double_range (priv->rand_seed, delay_us,
+        priv->max_delay * 1000.0);
+
+  if (delay_us <= 0)
+    return 0;
+
+  return (GstClockTime) delay_us * GST_USECOND;
 }
 
-static GstFlowReturn
-gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
+/* Runs @buf through the link model and hands it to the scheduler. Returns
+ * TRUE if it is due right away and should be pushed by the caller. Must be
+ * called with the loop mutex taken */
+static gboolean
+gst_net_sim_schedule (GstNetSim * netsim, GstBuffer * buf)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstNetSimPrivate *priv = netsim->priv;
+  GstClockTime now, departure;
+  guint64 expiry;
 
-  g_mutex_lock (&netsim->priv->loop_mutex);
-  if (netsim->priv->main_loop != NULL && netsim->priv->delay_probability > 0 &&
-      g_rand_double (netsim->priv->rand_seed) < netsim->priv->delay_probability)
-  {
-    PushBufferCtx *ctx = push_buffer_ctx_new (netsim->priv->srcpad, buf);
-    gint delay = g_rand_int_range (netsim->priv->rand_seed,
-        netsim->priv->min_delay, netsim->priv->max_delay);
-    GSource *source = g_timeout_source_new (delay);
-
-    GST_DEBUG_OBJECT (netsim, "Delaying packet by %d", delay);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->priv->main_loop));
-    g_source_unref (source);
-  } else {
-    ret = gst_pad_push (netsim->priv->srcpad, gst_buffer_ref (buf));
+  if (!priv->running)
+    return TRUE;
+
+  if (priv->clock == NULL) {
+    priv->clock = gst_element_get_clock (GST_ELEMENT_CAST (netsim));
+    if (priv->clock == NULL)
+      priv->clock = gst_system_clock_obtain ();
   }
-  g_mutex_unlock (&netsim->priv->loop_mutex);
 
-  return ret;
+  now = departure = gst_clock_get_time (priv->clock);
+
+  if (priv->max_kbps > 0) {
+    if (priv->queue_size > 0 &&
+        gst_net_sim_get_queue_level (priv, now) >= priv->queue_size) {
+      GST_DEBUG_OBJECT (netsim, "Queue full, dropping packet");
+      return FALSE;
+    }
+
+    departure = gst_net_sim_get_bucket_departure (priv, now,
+        gst_buffer_get_size (buf));
+    if (priv->queue_size > 0 && departure > now)
+      g_array_append_val (priv->queue, departure);
+  }
+
+  if (priv->delay_probability > 0 &&
+      g_rand_double (priv->rand_seed) < priv->delay_probability)
+    departure += gst_net_sim_get_random_delay (priv);
+
+  if (!priv->allow_reordering) {
+    if (GST_CLOCK_TIME_IS_VALID (priv->last_departure))
+      departure = MAX (departure, priv->last_departure);
+    priv->last_departure = departure;
+  }
+
+  if (departure <= now && (priv->allow_reordering || (!priv->pushing &&
+              (priv->wheel == NULL ||
+                  gst_net_sim_wheel_get_n_timers (priv->wheel) == 0))))
+    return TRUE;
+
+  GST_DEBUG_OBJECT (netsim, "Delaying packet by %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (departure - now));
+
+  if (priv->wheel == NULL)
+    priv->wheel = gst_net_sim_wheel_new (now / GST_USECOND);
+
+  expiry = (departure + GST_USECOND - 1) / GST_USECOND;
+  gst_net_sim_wheel_add (priv->wheel, expiry, gst_buffer_ref (buf));
+
+  if (priv->clock_id && expiry < priv->wait_expiry)
+    gst_clock_id_unschedule (priv->clock_id);
+  g_cond_signal (&priv->cond);
+
+  return FALSE;
 }
 
 static GstFlowReturn
 gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
+  GstNetSimPrivate *priv = netsim->priv;
   GstFlowReturn ret = GST_FLOW_OK;
+  gboolean push[2] = { FALSE, FALSE };
+  guint i, n_copies = 1;
 
   (void) pad;
 
-  if (netsim->priv->drop_packets > 0) {
-    netsim->priv->drop_packets--;
-    GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
-        netsim->priv->drop_packets);
-  } else if (netsim->priv->drop_probability > 0
-      && g_rand_double (netsim->priv->rand_seed) <
-      (gdouble) netsim->priv->drop_probability) {
-    GST_DEBUG_OBJECT (netsim, "Dropping packet");
-  } else if (netsim->priv->duplicate_probability > 0 &&
-      g_rand_double (netsim->priv->rand_seed) <
-      (gdouble) netsim->priv->duplicate_probability) {
-    GST_DEBUG_OBJECT (netsim, "Duplicating packet");
-    gst_net_sim_delay_buffer (netsim, buf);
-    ret = gst_net_sim_delay_buffer (netsim, buf);
-  } else {
-    ret = gst_net_sim_delay_buffer (netsim, buf);
+  g_mutex_lock (&priv->loop_mutex);
+  if (!gst_net_sim_drop_packet (netsim)) {
+    if (priv->duplicate_probability > 0 &&
+        g_rand_double (priv->rand_seed) <
+        (gdouble) priv->duplicate_probability) {
+      GST_DEBUG_OBJECT (netsim, "Duplicating packet");
+      n_copies = 2;
+    }
+
+    for (i = 0; i < n_copies; i++)
+      push[i] = gst_net_sim_schedule (netsim, buf);
+  }
+  g_mutex_unlock (&priv->loop_mutex);
+
+  for (i = 0; i < n_copies; i++) {
+    if (push[i])
+      ret = gst_pad_push (priv->srcpad, gst_buffer_ref (buf));
   }
 
   gst_buffer_unref (buf);
@@ -286,6 +471,7 @@ gst_net_sim_set_property (GObject * object,
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
+  g_mutex_lock (&netsim->priv->loop_mutex);
   switch (prop_id) {
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -308,7 +494,37 @@ gst_net_sim_set_property (GObject * object,
     case ARG_DROP_PACKETS:
       netsim->priv->drop_packets = g_value_get_uint (value);
       break;
+    case ARG_MAX_KBPS:
+      netsim->priv->max_kbps = g_value_get_int (value);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      netsim->priv->max_bucket_size = g_value_get_uint (value);
+      break;
+    case ARG_QUEUE_SIZE:
+      netsim->priv->queue_size = g_value_get_uint (value);
+      break;
+    case ARG_ALLOW_REORDERING:
+      netsim->priv->allow_reordering = g_value_get_boolean (value);
+      break;
+    case ARG_GILBERT_ELLIOTT_P:
+      netsim->priv->gilbert_elliott_p = g_value_get_float (value);
+      break;
+    case ARG_GILBERT_ELLIOTT_R:
+      netsim->priv->gilbert_elliott_r = g_value_get_float (value);
+      break;
+    case ARG_GILBERT_ELLIOTT_GOOD_LOSS:
+      netsim->priv->gilbert_elliott_good_loss = g_value_get_float (value);
+      break;
+    case ARG_GILBERT_ELLIOTT_BAD_LOSS:
+      netsim->priv->gilbert_elliott_bad_loss = g_value_get_float (value);
+      break;
+    case ARG_SEED:
+      netsim->priv->seed = g_value_get_uint (value);
+      if (netsim->priv->seed != 0)
+        g_rand_set_seed (netsim->priv->rand_seed, netsim->priv->seed);
+      break;
   }
+  g_mutex_unlock (&netsim->priv->loop_mutex);
 }
 
 static void
@@ -317,6 +533,7 @@ gst_net_sim_get_property (GObject * object,
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
+  g_mutex_lock (&netsim->priv->loop_mutex);
   switch (prop_id) {
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -339,7 +556,35 @@ gst_net_sim_get_property (GObject * object,
     case ARG_DROP_PACKETS:
       g_value_set_uint (value, netsim->priv->drop_packets);
       break;
+    case ARG_MAX_KBPS:
+      g_value_set_int (value, netsim->priv->max_kbps);
+      break;
+    case ARG_MAX_BUCKET_SIZE:
+      g_value_set_uint (value, netsim->priv->max_bucket_size);
+      break;
+    case ARG_QUEUE_SIZE:
+      g_value_set_uint (value, netsim->priv->queue_size);
+      break;
+    case ARG_ALLOW_REORDERING:
+      g_value_set_boolean (value, netsim->priv->allow_reordering);
+      break;
+    case ARG_GILBERT_ELLIOTT_P:
+      g_value_set_float (value, netsim->priv->gilbert_elliott_p);
+      break;
+    case ARG_GILBERT_ELLIOTT_R:
+      g_value_set_float (value, netsim->priv->gilbert_elliott_r);
+      break;
+    case ARG_GILBERT_ELLIOTT_GOOD_LOSS:
+      g_value_set_float (value, netsim->priv->gilbert_elliott_good_loss);
+      break;
+    case ARG_GILBERT_ELLIOTT_BAD_LOSS:
+      g_value_set_float (value, netsim->priv->gilbert_elliott_bad_loss);
+      break;
+    case ARG_SEED:
+      g_value_set_uint (value, netsim->priv->seed);
+      break;
   }
+  g_mutex_unlock (&netsim->priv->loop_mutex);
 }
 
 
@@ -357,9 +602,9 @@ gst_net_sim_init (GstNetSim * netsim)
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->priv->sinkpad);
 
   g_mutex_init (&netsim->priv->loop_mutex);
-  g_cond_init (&netsim->priv->start_cond);
+  g_cond_init (&netsim->priv->cond);
   netsim->priv->rand_seed = g_rand_new ();
-  netsim->priv->main_loop = NULL;
+  netsim->priv->queue = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
 
   GST_OBJECT_FLAG_SET (netsim->priv->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
@@ -376,8 +621,9 @@ gst_net_sim_finalize (GObject * object)
   GstNetSim *netsim = GST_NET_SIM (object);
 
   g_rand_free (netsim->priv->rand_seed);
+  g_array_free (netsim->priv->queue, TRUE);
   g_mutex_clear (&netsim->priv->loop_mutex);
-  g_cond_clear (&netsim->priv->start_cond);
+  g_cond_clear (&netsim->priv->cond);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->finalize (object);
 }
@@ -387,7 +633,7 @@ gst_net_sim_dispose (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
-  g_assert (netsim->priv->main_loop == NULL);
+  g_assert (netsim->priv->wheel == NULL);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->dispose (object);
 }
@@ -408,8 +654,8 @@ gst_net_sim_class_init (GstNetSimClass * klass)
   gst_element_class_set_metadata (gstelement_class,
       "Network Simulator",
       "Filter/Network",
-      "An element that simulates network jitter, "
-      "packet loss and packet duplication",
+      "An element that simulates network jitter, bandwidth limits, "
+      "packet loss, reordering and packet duplication",
       "Philippe Kalaf <philippe.kalaf@collabora.co.uk>");
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_net_sim_dispose);
@@ -454,6 +700,70 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           0, G_MAXUINT, DEFAULT_DROP_PACKETS,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, ARG_MAX_KBPS,
+      g_param_spec_int ("max-kbps", "Maximum Kbps",
+          "The maximum number of kilobits to let through per second "
+          "(-1 = unlimited)",
+          -1, G_MAXINT, DEFAULT_MAX_KBPS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_MAX_BUCKET_SIZE,
+      g_param_spec_uint ("max-bucket-size", "Maximum Bucket Size (bytes)",
+          "The size of the token bucket, the largest burst let through at "
+          "once when max-kbps is set (0 = one packet)",
+          0, G_MAXUINT, DEFAULT_MAX_BUCKET_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue Size (packets)",
+          "The number of packets that can wait for the bandwidth limit, "
+          "further packets are dropped (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_ALLOW_REORDERING,
+      g_param_spec_boolean ("allow-reordering", "Allow Reordering",
+          "When delaying packets, let them overtake each other",
+          DEFAULT_ALLOW_REORDERING,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_GILBERT_ELLIOTT_P,
+      g_param_spec_float ("gilbert-elliott-p", "Gilbert-Elliott P",
+          "The Probability of moving from the good to the bad state of the "
+          "burst loss model after a packet",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_P,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_GILBERT_ELLIOTT_R,
+      g_param_spec_float ("gilbert-elliott-r", "Gilbert-Elliott R",
+          "The Probability of moving from the bad to the good state of the "
+          "burst loss model after a packet",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_R,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      ARG_GILBERT_ELLIOTT_GOOD_LOSS,
+      g_param_spec_float ("gilbert-elliott-good-loss",
+          "Gilbert-Elliott Good Loss",
+          "The Probability a buffer is lost in the good state",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_GOOD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      ARG_GILBERT_ELLIOTT_BAD_LOSS,
+      g_param_spec_float ("gilbert-elliott-bad-loss",
+          "Gilbert-Elliott Bad Loss",
+          "The Probability a buffer is lost in the bad state",
+          0.0, 1.0, DEFAULT_GILBERT_ELLIOTT_BAD_LOSS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, ARG_SEED,
+      g_param_spec_uint ("seed", "Seed",
+          "Seed of the random number generator, set again every time the "
+          "element starts so runs can be repeated (0 = random)",
+          0, G_MAXUINT, DEFAULT_SEED,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 }
 
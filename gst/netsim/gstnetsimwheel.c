@@ -0,0 +1,339 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstnetsimwheel.h"
+
+/* Four levels of 256 slots. Level 0 holds the timers expiring within the
+ * current block of 256 ticks, one slot per tick, level 1 the ones within the
+ * current block of 65536 ticks, one slot per 256 ticks, and so on. Timers
+ * more than 2^32 blocks away wait in the overflow list. Whenever the
+ * current time enters a new block, the matching slot of the level above is
+ * cascaded down */
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+typedef struct _GstNetSimTimer GstNetSimTimer;
+
+struct _GstNetSimTimer
+{
+  GstNetSimTimer *next;
+  guint64 expiry;
+  gpointer data;
+};
+
+typedef struct
+{
+  GstNetSimTimer *head;
+  GstNetSimTimer *tail;
+} GstNetSimTimerList;
+
+struct _GstNetSimWheel
+{
+  guint64 now;
+
+  GstNetSimTimerList slots[WHEEL_LEVELS][WHEEL_SLOTS];
+  guint32 occupied[WHEEL_LEVELS][WHEEL_SLOTS / 32];
+
+  /* timers that were already expired when added or cascaded */
+  GstNetSimTimerList ready;
+  GstNetSimTimerList overflow;
+
+  /* timers in the slots and in the overflow list */
+  guint n_pending;
+  guint n_ready;
+};
+
+static void
+timer_list_append (GstNetSimTimerList * list, GstNetSimTimer * timer)
+{
+  timer->next = NULL;
+  if (list->tail)
+    list->tail->next = timer;
+  else
+    list->head = timer;
+  list->tail = timer;
+}
+
+static GstNetSimTimer *
+timer_list_steal (GstNetSimTimerList * list)
+{
+  GstNetSimTimer *head = list->head;
+
+  list->head = list->tail = NULL;
+
+  return head;
+}
+
+static guint64
+timer_list_get_min_expiry (GstNetSimTimerList * list)
+{
+  GstNetSimTimer *timer;
+  guint64 expiry = G_MAXUINT64;
+
+  for (timer = list->head; timer; timer = timer->next)
+    expiry = MIN (expiry, timer->expiry);
+
+  return expiry;
+}
+
+GstNetSimWheel *
+gst_net_sim_wheel_new (guint64 now)
+{
+  GstNetSimWheel *wheel = g_new0 (GstNetSimWheel, 1);
+
+  wheel->now = now;
+
+  return wheel;
+}
+
+static void
+timer_list_free (GstNetSimTimerList * list, GDestroyNotify notify)
+{
+  GstNetSimTimer *timer = timer_list_steal (list);
+
+  while (timer) {
+    GstNetSimTimer *next = timer->next;
+
+    if (notify)
+      notify (timer->data);
+    g_slice_free (GstNetSimTimer, timer);
+    timer = next;
+  }
+}
+
+void
+gst_net_sim_wheel_free (GstNetSimWheel * wheel, GDestroyNotify notify)
+{
+  guint level, slot;
+
+  timer_list_free (&wheel->ready, notify);
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      timer_list_free (&wheel->slots[level][slot], notify);
+  timer_list_free (&wheel->overflow, notify);
+
+  g_free (wheel);
+}
+
+static void
+gst_net_sim_wheel_insert (GstNetSimWheel * wheel, GstNetSimTimer * timer)
+{
+  guint level;
+
+  if (timer->expiry <= wheel->now) {
+    timer_list_append (&wheel->ready, timer);
+    wheel->n_ready++;
+    return;
+  }
+
+  wheel->n_pending++;
+  for (level = 0; level < WHEEL_LEVELS; level++) {
+    guint shift = (level + 1) * WHEEL_BITS;
+
+    if ((timer->expiry >> shift) == (wheel->now >> shift)) {
+      guint slot = (timer->expiry >> (level * WHEEL_BITS)) & WHEEL_MASK;
+
+      timer_list_append (&wheel->slots[level][slot], timer);
+      wheel->occupied[level][slot / 32] |= 1u << (slot % 32);
+      return;
+    }
+  }
+
+  timer_list_append (&wheel->overflow, timer);
+}
+
+void
+gst_net_sim_wheel_add (GstNetSimWheel * wheel, guint64 expiry, gpointer data)
+{
+  GstNetSimTimer *timer = g_slice_new (GstNetSimTimer);
+
+  timer->expiry = expiry;
+  timer->data = data;
+  gst_net_sim_wheel_insert (wheel, timer);
+}
+
+/* Returns the first occupied slot of @level from @from on, or -1 */
+static gint
+gst_net_sim_wheel_find_slot (GstNetSimWheel * wheel, guint level, guint from)
+{
+  guint word;
+
+  for (word = from / 32; word < WHEEL_SLOTS / 32; word++) {
+    guint32 bits = wheel->occupied[level][word];
+
+    if (word == from / 32)
+      bits &= G_MAXUINT32 << (from % 32);
+    if (bits)
+      return word * 32 + g_bit_nth_lsf (bits, -1);
+  }
+
+  return -1;
+}
+
+static GstNetSimTimer *
+gst_net_sim_wheel_steal_slot (GstNetSimWheel * wheel, guint level,
+    guint slot)
+{
+  wheel->occupied[level][slot / 32] &= ~(1u << (slot % 32));
+
+  return timer_list_steal (&wheel->slots[level][slot]);
+}
+
+static void
+gst_net_sim_wheel_reinsert (GstNetSimWheel * wheel, GstNetSimTimer * timer)
+{
+  while (timer) {
+    GstNetSimTimer *next = timer->next;
+
+    wheel->n_pending--;
+    gst_net_sim_wheel_insert (wheel, timer);
+    timer = next;
+  }
+}
+
+/* Called when the current time entered a new block of level 0 */
+static void
+gst_net_sim_wheel_cascade (GstNetSimWheel * wheel)
+{
+  guint level, top;
+
+  /* all levels below the first non-zero index entered a new block too */
+  for (top = 1; top < WHEEL_LEVELS; top++)
+    if ((wheel->now >> (top * WHEEL_BITS)) & WHEEL_MASK)
+      break;
+
+  if (top == WHEEL_LEVELS) {
+    gst_net_sim_wheel_reinsert (wheel, timer_list_steal (&wheel->overflow));
+    top = WHEEL_LEVELS - 1;
+  }
+
+  for (level = top; level > 0; level--) {
+    guint slot = (wheel->now >> (level * WHEEL_BITS)) & WHEEL_MASK;
+
+    gst_net_sim_wheel_reinsert (wheel,
+        gst_net_sim_wheel_steal_slot (wheel, level, slot));
+  }
+}
+
+/* Returns the number of expired timers */
+static guint
+gst_net_sim_wheel_expire (GstNetSimTimer * timer, GQueue * expired)
+{
+  guint n = 0;
+
+  while (timer) {
+    GstNetSimTimer *next = timer->next;
+
+    g_queue_push_tail (expired, timer->data);
+    g_slice_free (GstNetSimTimer, timer);
+    timer = next;
+    n++;
+  }
+
+  return n;
+}
+
+/* Moves the time forward to @now and appends the data of the timers that
+ * expired on the way to @expired, in expiry order */
+void
+gst_net_sim_wheel_advance (GstNetSimWheel * wheel, guint64 now,
+    GQueue * expired)
+{
+  for (;;) {
+    guint64 block;
+    gint slot;
+
+    if (wheel->n_ready > 0) {
+      gst_net_sim_wheel_expire (timer_list_steal (&wheel->ready), expired);
+      wheel->n_ready = 0;
+    }
+
+    if (wheel->n_pending == 0 || wheel->now >= now)
+      break;
+
+    block = wheel->now & ~(guint64) WHEEL_MASK;
+    slot = gst_net_sim_wheel_find_slot (wheel, 0, wheel->now & WHEEL_MASK);
+    if (slot >= 0) {
+      if (block + slot > now)
+        break;
+
+      wheel->now = block + slot;
+      wheel->n_pending -=
+          gst_net_sim_wheel_expire (gst_net_sim_wheel_steal_slot (wheel, 0,
+              slot), expired);
+      continue;
+    }
+
+    if (block + WHEEL_SLOTS > now)
+      break;
+
+    wheel->now = block + WHEEL_SLOTS;
+    gst_net_sim_wheel_cascade (wheel);
+  }
+
+  wheel->now = MAX (wheel->now, now);
+}
+
+gboolean
+gst_net_sim_wheel_get_next_expiry (GstNetSimWheel * wheel, guint64 * expiry)
+{
+  guint level;
+
+  if (wheel->n_ready > 0) {
+    *expiry = wheel->now;
+    return TRUE;
+  }
+
+  if (wheel->n_pending == 0)
+    return FALSE;
+
+  /* the current slot of the higher levels is always empty, so the first
+   * occupied slot found holds the next timer */
+  for (level = 0; level < WHEEL_LEVELS; level++) {
+    guint from = (wheel->now >> (level * WHEEL_BITS)) & WHEEL_MASK;
+    gint slot;
+
+    if (level > 0)
+      from++;
+    if (from >= WHEEL_SLOTS)
+      continue;
+
+    slot = gst_net_sim_wheel_find_slot (wheel, level, from);
+    if (slot >= 0) {
+      *expiry = timer_list_get_min_expiry (&wheel->slots[level][slot]);
+      return TRUE;
+    }
+  }
+
+  *expiry = timer_list_get_min_expiry (&wheel->overflow);
+  return TRUE;
+}
+
+guint
+gst_net_sim_wheel_get_n_timers (GstNetSimWheel * wheel)
+{
+  return wheel->n_pending + wheel->n_ready;
+}
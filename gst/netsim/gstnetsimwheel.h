@@ -0,0 +1,53 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __GST_NET_SIM_WHEEL_H__
+#define __GST_NET_SIM_WHEEL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Hierarchical timer wheel with a resolution of one tick (netsim uses
+ * microseconds). Adding a timer and expiring it are O(1); timers with the
+ * same expiry time expire in the order they were added. Not MT safe. */
+typedef struct _GstNetSimWheel GstNetSimWheel;
+
+GstNetSimWheel * gst_net_sim_wheel_new (guint64 now);
+
+void     gst_net_sim_wheel_free (GstNetSimWheel * wheel,
+                                 GDestroyNotify notify);
+
+void     gst_net_sim_wheel_add (GstNetSimWheel * wheel,
+                                guint64 expiry,
+                                gpointer data);
+
+gboolean gst_net_sim_wheel_get_next_expiry (GstNetSimWheel * wheel,
+                                            guint64 * expiry);
+
+void     gst_net_sim_wheel_advance (GstNetSimWheel * wheel,
+                                    guint64 now,
+                                    GQueue * expired);
+
+guint    gst_net_sim_wheel_get_n_timers (GstNetSimWheel * wheel);
+
+G_END_DECLS
+
+#endif /* __GST_NET_SIM_WHEEL_H__ */
@@ -253,7 +253,8 @@ gst_rtp_onvif_timestamp_class_init (GstRtpOnvifTimestampClass * klass)
   g_object_class_install_property (gobject_class, PROP_SET_E_BIT,
       g_param_spec_boolean ("set-e-bit", "Set 'E' bit",
           "If the element should set the 'E' bit as defined in the ONVIF RTP "
-          "extension. This increases latency by one packet",
+          "extension. This increases latency by one packet, or by one access "
+          "unit for buffer lists",
           DEFAULT_SET_E_BIT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   /* register pads */
@@ -316,7 +317,7 @@ gst_rtp_onvif_timestamp_sink_event (GstPad * pad, GstObject * parent,
       /* if the "set-e-bit" property is set, an offset event might mark the
        * stream as discontinued. We need to check if the currently cached buffer
        * needs the e-bit before it's pushed */
-      if (self->buffer != NULL && self->prop_set_e_bit &&
+      if ((self->buffer || self->list) && self->prop_set_e_bit &&
           gst_event_has_name (event, GST_NTP_OFFSET_EVENT_NAME)) {
         gboolean discont;
         if (parse_event_ntp_offset (self, event, NULL, &discont)) {
@@ -429,16 +430,11 @@ gst_rtp_onvif_timestamp_init (GstRtpOnvifTimestamp * self)
 #define EXTENSION_ID 0xABAC
 #define EXTENSION_SIZE 3
 
+/* Makes sure the ntp-offset is known and a time segment was received, this
+ * only needs to be done once for all the buffers of a list */
 static gboolean
-handle_buffer (GstRtpOnvifTimestamp * self, GstBuffer * buf)
+check_ntp_offset_and_segment (GstRtpOnvifTimestamp * self)
 {
-  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  guint8 *data;
-  guint16 bits;
-  guint wordlen;
-  guint64 time;
-  guint8 field = 0;
-
   if (!GST_CLOCK_TIME_IS_VALID (self->ntp_offset)) {
     GstClock *clock = gst_element_get_clock (GST_ELEMENT (self));
 
@@ -476,6 +472,19 @@ handle_buffer (GstRtpOnvifTimestamp * self, GstBuffer * buf)
     return FALSE;
   }
 
+  return TRUE;
+}
+
+static gboolean
+write_extension (GstRtpOnvifTimestamp * self, GstBuffer * buf)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 *data;
+  guint16 bits;
+  guint wordlen;
+  guint64 time;
+  guint8 field = 0;
+
   if (!gst_rtp_buffer_map (buf, GST_MAP_READWRITE, &rtp)) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         ("Failed to map RTP buffer"), (NULL));
@@ -562,10 +571,102 @@ done:
   return TRUE;
 }
 
+static gboolean
+handle_buffer (GstRtpOnvifTimestamp * self, GstBuffer * buf)
+{
+  if (!check_ntp_offset_and_segment (self))
+    return FALSE;
+
+  return write_extension (self, buf);
+}
+
+/* the marker bit is set on the last packet of an access unit */
+static gboolean
+buffer_has_marker (GstBuffer * buf)
+{
+  guint8 byte;
+
+  return gst_buffer_extract (buf, 1, &byte, 1) == 1 && (byte & 0x80);
+}
+
+/* Returns the index of the first buffer of the last access unit in @list */
+static guint
+find_last_access_unit (GstBufferList * list)
+{
+  guint i, len, start = 0;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i + 1 < len; i++) {
+    if (buffer_has_marker (gst_buffer_list_get (list, i)))
+      start = i + 1;
+  }
+
+  return start;
+}
+
+typedef struct
+{
+  GstRtpOnvifTimestamp *self;
+  /* first buffer of the last access unit, which gets the E-bit */
+  guint last;
+  gboolean set_e_bit;
+  /* if the current buffer starts an access unit */
+  gboolean first;
+  gboolean ret;
+} HandleListData;
+
+static gboolean
+handle_buffer_from_list (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  HandleListData *data = user_data;
+  gboolean first = data->first;
+
+  /* the next buffer starts an access unit if this one ends one */
+  data->first = buffer_has_marker (*buffer);
+
+  if (!first)
+    return TRUE;
+
+  if (idx == data->last)
+    data->self->set_e_bit = data->set_e_bit;
+
+  *buffer = gst_buffer_make_writable (*buffer);
+  if (!write_extension (data->self, *buffer)) {
+    data->ret = FALSE;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Sets the extension on the first buffer of every access unit of the list,
+ * in place unless the buffers are shared */
+static gboolean
+handle_buffer_list (GstRtpOnvifTimestamp * self, GstBufferList ** list)
+{
+  HandleListData data;
+
+  if (!check_ntp_offset_and_segment (self))
+    return FALSE;
+
+  data.self = self;
+  data.set_e_bit = self->set_e_bit;
+  data.last = data.set_e_bit ? find_last_access_unit (*list) : 0;
+  data.first = TRUE;
+  data.ret = TRUE;
+  self->set_e_bit = FALSE;
+
+  *list = gst_buffer_list_make_writable (*list);
+  gst_buffer_list_foreach (*list, handle_buffer_from_list, &data);
+
+  return data.ret;
+}
+
 /* @buf: (transfer full) */
 static GstFlowReturn
 handle_and_push_buffer (GstRtpOnvifTimestamp * self, GstBuffer * buf)
 {
+  buf = gst_buffer_make_writable (buf);
   if (!handle_buffer (self, buf)) {
     gst_buffer_unref (buf);
     return GST_FLOW_ERROR;
@@ -594,15 +695,11 @@ gst_rtp_onvif_timestamp_chain (GstPad * pad, GstObject * parent,
   return result;
 }
 
-/* @buf: (transfer full) */
+/* @list: (transfer full) */
 static GstFlowReturn
 handle_and_push_buffer_list (GstRtpOnvifTimestamp * self, GstBufferList * list)
 {
-  GstBuffer *buf;
-
-  /* Set the extension on the *first* buffer */
-  buf = gst_buffer_list_get (list, 0);
-  if (!handle_buffer (self, buf)) {
+  if (!handle_buffer_list (self, &list)) {
     gst_buffer_list_unref (list);
     return GST_FLOW_ERROR;
   }
@@ -619,6 +716,7 @@ gst_rtp_onvif_timestamp_chain_list (GstPad * pad, GstObject * parent,
 {
   GstRtpOnvifTimestamp *self = GST_RTP_ONVIF_TIMESTAMP (parent);
   GstFlowReturn result = GST_FLOW_OK;
+  guint i, len, last;
 
   if (!self->prop_set_e_bit) {
     return handle_and_push_buffer_list (self, list);
@@ -627,6 +725,26 @@ gst_rtp_onvif_timestamp_chain_list (GstPad * pad, GstObject * parent,
   /* send any previously cached item(s), this leaves an empty queue */
   result = send_cached_buffer_and_events (self);
 
+  /* nothing can come between the access units of a list, so only the last
+   * one may need the E-bit. Push the others right away */
+  last = find_last_access_unit (list);
+  if (last > 0 && result == GST_FLOW_OK) {
+    GstBufferList *head = list;
+
+    len = gst_buffer_list_length (head);
+    list = gst_buffer_list_new_sized (len - last);
+    for (i = last; i < len; i++)
+      gst_buffer_list_add (list, gst_buffer_ref (gst_buffer_list_get (head,
+                  i)));
+
+    head = gst_buffer_list_make_writable (head);
+    gst_buffer_list_remove (head, last, len - last);
+
+    GST_DEBUG_OBJECT (self, "pushing %u buffers, caching %u", last,
+        len - last);
+    result = handle_and_push_buffer_list (self, head);
+  }
+
   /* enqueue the new item, as the only item in the queue */
   self->list = list;
   return result;
@@ -26,6 +26,10 @@
  * #GstPcapParse:src-port and #GstPcapParse:dst-port to restrict which packets
  * should be included.
  *
+ * Both pcap and pcapng dumps are understood. UDP and TCP over IPv4 and IPv6
+ * are extracted, also from VLAN tagged Ethernet frames. The source and
+ * destination IP filters only match IPv4 packets.
+ *
  * ## Example pipelines
  * |[
  * gst-launch-1.0 filesrc location=h264crasher.pcap ! pcapparse ! rtph264depay
@@ -66,6 +70,13 @@ enum
   PROP_TS_OFFSET
 };
 
+/* a pcapng interface description */
+typedef struct
+{
+  GstPcapParseLinktype linktype;
+  guint64 ts_resolution;
+} GstPcapParseInterface;
+
 GST_DEBUG_CATEGORY_STATIC (gst_pcap_parse_debug);
 #define GST_CAT_DEFAULT gst_pcap_parse_debug
 
@@ -88,6 +99,7 @@ static GstStateChangeReturn
 gst_pcap_parse_change_state (GstElement * element, GstStateChange transition);
 
 static void gst_pcap_parse_reset (GstPcapParse * self);
+static void gst_pcap_parse_update_filter (GstPcapParse * self);
 
 static GstFlowReturn gst_pcap_parse_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
@@ -171,8 +183,11 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->src_port = -1;
   self->dst_port = -1;
   self->offset = -1;
+  gst_pcap_parse_update_filter (self);
 
   self->adapter = gst_adapter_new ();
+  self->interfaces = g_array_new (FALSE, FALSE,
+      sizeof (GstPcapParseInterface));
 
   gst_pcap_parse_reset (self);
 }
@@ -183,6 +198,7 @@ gst_pcap_parse_finalize (GObject * object)
   GstPcapParse *self = GST_PCAP_PARSE (object);
 
   g_object_unref (self->adapter);
+  g_array_free (self->interfaces, TRUE);
   if (self->caps)
     gst_caps_unref (self->caps);
 
@@ -259,18 +275,22 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_SRC_IP:
       set_ip_address_from_string (&self->src_ip, g_value_get_string (value));
+      gst_pcap_parse_update_filter (self);
       break;
 
     case PROP_DST_IP:
       set_ip_address_from_string (&self->dst_ip, g_value_get_string (value));
+      gst_pcap_parse_update_filter (self);
       break;
 
     case PROP_SRC_PORT:
       self->src_port = g_value_get_int (value);
+      gst_pcap_parse_update_filter (self);
       break;
 
     case PROP_DST_PORT:
       self->dst_port = g_value_get_int (value);
+      gst_pcap_parse_update_filter (self);
       break;
 
     case PROP_CAPS:
@@ -308,8 +328,10 @@ static void
 gst_pcap_parse_reset (GstPcapParse * self)
 {
   self->initialized = FALSE;
+  self->format = PCAP_PARSE_FORMAT_PCAP;
   self->swap_endian = FALSE;
-  self->cur_packet_size = -1;
+  self->ts_resolution = GST_SECOND / GST_USECOND;
+  g_array_set_size (self->interfaces, 0);
   self->cur_ts = GST_CLOCK_TIME_NONE;
   self->base_ts = GST_CLOCK_TIME_NONE;
   self->newsegment_sent = FALSE;
@@ -333,121 +355,495 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
   }
 }
 
+static guint16
+gst_pcap_parse_read_uint16 (GstPcapParse * self, const guint8 * p)
+{
+  guint16 val = *((guint16 *) p);
+
+  if (self->swap_endian)
+    return GUINT16_SWAP_LE_BE (val);
+  else
+    return val;
+}
+
+#define PCAP_HEADER_LEN         24
+#define PCAP_RECORD_HEADER_LEN  16
+
+#define PCAPNG_BLOCK_MIN_LEN    12
+#define PCAPNG_BLOCK_SHB        0x0a0d0d0a
+#define PCAPNG_BLOCK_IDB        0x00000001
+#define PCAPNG_BLOCK_SPB        0x00000003
+#define PCAPNG_BLOCK_EPB        0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_OPT_IF_TSRESOL   9
+
 #define ETH_HEADER_LEN    14
 #define SLL_HEADER_LEN    16
+#define VLAN_TAG_LEN       4
 #define IP_HEADER_MIN_LEN 20
+#define IPV6_HEADER_LEN   40
 #define UDP_HEADER_LEN     8
 
+#define ETH_TYPE_IPV4     0x0800
+#define ETH_TYPE_IPV6     0x86dd
+#define ETH_TYPE_VLAN     0x8100
+#define ETH_TYPE_QINQ     0x88a8
+
 #define IP_PROTO_UDP      17
 #define IP_PROTO_TCP      6
 
+static void
+gst_pcap_parse_update_filter (GstPcapParse * self)
+{
+  guint32 addrs[2] = { 0, 0 };
+  guint32 addr_masks[2] = { 0, 0 };
+  guint16 ports[2] = { 0, 0 };
+  guint16 port_masks[2] = { 0, 0 };
+
+  /* same layout as the source and destination fields of the IPv4 and
+   * TCP/UDP headers */
+  if (self->src_ip >= 0) {
+    addrs[0] = self->src_ip;
+    addr_masks[0] = G_MAXUINT32;
+  }
+  if (self->dst_ip >= 0) {
+    addrs[1] = self->dst_ip;
+    addr_masks[1] = G_MAXUINT32;
+  }
+  if (self->src_port >= 0) {
+    ports[0] = g_htons (self->src_port);
+    port_masks[0] = G_MAXUINT16;
+  }
+  if (self->dst_port >= 0) {
+    ports[1] = g_htons (self->dst_port);
+    port_masks[1] = G_MAXUINT16;
+  }
+
+  memcpy (&self->ip_match, addrs, sizeof (addrs));
+  memcpy (&self->ip_mask, addr_masks, sizeof (addr_masks));
+  memcpy (&self->port_match, ports, sizeof (ports));
+  memcpy (&self->port_mask, port_masks, sizeof (port_masks));
+}
 
 static gboolean
 gst_pcap_parse_scan_frame (GstPcapParse * self,
+    GstPcapParseLinktype linktype,
     const guint8 * buf,
     gint buf_size, const guint8 ** payload, gint * payload_size)
 {
+  const guint8 *buf_end = buf + buf_size;
   const guint8 *buf_ip = 0;
   const guint8 *buf_proto;
   guint16 eth_type;
   guint8 b;
-  guint8 ip_header_size;
+  guint ip_header_size;
   guint8 ip_protocol;
-  guint32 ip_src_addr;
-  guint32 ip_dst_addr;
-  guint16 src_port;
-  guint16 dst_port;
+  guint64 ip_addrs;
+  guint32 ports;
   guint16 len;
 
-  switch (self->linktype) {
+  switch (linktype) {
     case LINKTYPE_ETHER:
       if (buf_size < ETH_HEADER_LEN + IP_HEADER_MIN_LEN + UDP_HEADER_LEN)
         return FALSE;
 
-      eth_type = GUINT16_FROM_BE (*((guint16 *) (buf + 12)));
+      eth_type = GST_READ_UINT16_BE (buf + 12);
       buf_ip = buf + ETH_HEADER_LEN;
+
+      /* skip 802.1Q and 802.1ad tags */
+      while (eth_type == ETH_TYPE_VLAN || eth_type == ETH_TYPE_QINQ) {
+        if (buf_ip + VLAN_TAG_LEN + IP_HEADER_MIN_LEN > buf_end)
+          return FALSE;
+        eth_type = GST_READ_UINT16_BE (buf_ip + 2);
+        buf_ip += VLAN_TAG_LEN;
+      }
       break;
     case LINKTYPE_SLL:
       if (buf_size < SLL_HEADER_LEN + IP_HEADER_MIN_LEN + UDP_HEADER_LEN)
         return FALSE;
 
-      eth_type = GUINT16_FROM_BE (*((guint16 *) (buf + 14)));
+      eth_type = GST_READ_UINT16_BE (buf + 14);
       buf_ip = buf + SLL_HEADER_LEN;
       break;
     case LINKTYPE_RAW:
       if (buf_size < IP_HEADER_MIN_LEN + UDP_HEADER_LEN)
         return FALSE;
 
-      eth_type = 0x800;         /* This is fine since IPv4/IPv6 is parse elsewhere */
+      /* the IP version tells */
       buf_ip = buf;
+      eth_type = ((buf_ip[0] >> 4) == 6) ? ETH_TYPE_IPV6 : ETH_TYPE_IPV4;
       break;
 
     default:
       return FALSE;
   }
 
-  if (eth_type != 0x800)
-    return FALSE;
-
   b = *buf_ip;
-  if (((b >> 4) & 0x0f) != 4)
-    return FALSE;
-
-  ip_header_size = (b & 0x0f) * 4;
-  if (buf_ip + ip_header_size > buf + buf_size)
+  if (eth_type == ETH_TYPE_IPV4 && ((b >> 4) & 0x0f) == 4) {
+    ip_header_size = (b & 0x0f) * 4;
+    if (ip_header_size < IP_HEADER_MIN_LEN)
+      return FALSE;
+    ip_protocol = *(buf_ip + 9);
+    memcpy (&ip_addrs, buf_ip + 12, sizeof (ip_addrs));
+  } else if (eth_type == ETH_TYPE_IPV6 && ((b >> 4) & 0x0f) == 6) {
+    /* the address filter only knows IPv4 addresses */
+    if (self->ip_mask != 0)
+      return FALSE;
+    /* extension headers are not followed */
+    ip_header_size = IPV6_HEADER_LEN;
+    ip_protocol = *(buf_ip + 6);
+    ip_addrs = 0;
+  } else {
     return FALSE;
+  }
 
-  ip_protocol = *(buf_ip + 9);
   GST_LOG_OBJECT (self, "ip proto %d", (gint) ip_protocol);
 
   if (ip_protocol != IP_PROTO_UDP && ip_protocol != IP_PROTO_TCP)
     return FALSE;
 
-  /* ip info */
-  ip_src_addr = *((guint32 *) (buf_ip + 12));
-  ip_dst_addr = *((guint32 *) (buf_ip + 16));
   buf_proto = buf_ip + ip_header_size;
+  if (buf_proto + UDP_HEADER_LEN > buf_end)
+    return FALSE;
 
-  /* ok for tcp and udp */
-  src_port = GUINT16_FROM_BE (*((guint16 *) (buf_proto + 0)));
-  dst_port = GUINT16_FROM_BE (*((guint16 *) (buf_proto + 2)));
+  /* filter as configured, the source and destination ports are at the same
+   * place for tcp and udp */
+  memcpy (&ports, buf_proto, sizeof (ports));
+  if (((ip_addrs ^ self->ip_match) & self->ip_mask) != 0 ||
+      ((ports ^ self->port_match) & self->port_mask) != 0)
+    return FALSE;
 
   /* extract some params and data according to protocol */
   if (ip_protocol == IP_PROTO_UDP) {
-    len = GUINT16_FROM_BE (*((guint16 *) (buf_proto + 4)));
-    if (len < UDP_HEADER_LEN || buf_proto + len > buf + buf_size)
+    len = GST_READ_UINT16_BE (buf_proto + 4);
+    if (len < UDP_HEADER_LEN || buf_proto + len > buf_end)
       return FALSE;
 
     *payload = buf_proto + UDP_HEADER_LEN;
     *payload_size = len - UDP_HEADER_LEN;
   } else {
-    if (buf_proto + 12 >= buf + buf_size)
+    if (buf_proto + 12 >= buf_end)
       return FALSE;
     len = (buf_proto[12] >> 4) * 4;
-    if (buf_proto + len > buf + buf_size)
+    if (buf_proto + len > buf_end)
       return FALSE;
 
     /* all remaining data following tcp header is payload */
     *payload = buf_proto + len;
-    *payload_size = self->cur_packet_size - (buf_proto - buf) - len;
+    *payload_size = buf_end - *payload;
   }
 
-  /* but still filter as configured */
-  if (self->src_ip >= 0 && ip_src_addr != self->src_ip)
-    return FALSE;
+  return TRUE;
+}
 
-  if (self->dst_ip >= 0 && ip_dst_addr != self->dst_ip)
-    return FALSE;
+static void
+gst_pcap_parse_read_interface (GstPcapParse * self, const guint8 * block,
+    guint block_len)
+{
+  GstPcapParseInterface iface;
+  const guint8 *opt = block + 16;
+  const guint8 *opt_end = block + block_len - 4;
+
+  if (block_len < 20)
+    return;
+
+  iface.linktype = gst_pcap_parse_read_uint16 (self, block + 8);
+  iface.ts_resolution = GST_SECOND / GST_USECOND;
+
+  while (opt + 4 <= opt_end) {
+    guint16 code = gst_pcap_parse_read_uint16 (self, opt);
+    guint16 len = gst_pcap_parse_read_uint16 (self, opt + 2);
 
-  if (self->src_port >= 0 && src_port != self->src_port)
+    if (code == 0 || opt + 4 + len > opt_end)
+      break;
+
+    if (code == PCAPNG_OPT_IF_TSRESOL && len >= 1) {
+      guint8 tsresol = opt[4];
+
+      /* a negative power of two or of ten */
+      if ((tsresol & 0x80) && (tsresol & 0x7f) < 64) {
+        iface.ts_resolution = G_GUINT64_CONSTANT (1) << (tsresol & 0x7f);
+      } else if (!(tsresol & 0x80) && tsresol < 20) {
+        iface.ts_resolution = 1;
+        while (tsresol--)
+          iface.ts_resolution *= 10;
+      }
+    }
+
+    opt += 4 + GST_ROUND_UP_4 (len);
+  }
+
+  GST_DEBUG_OBJECT (self, "interface %u: linktype %u, %" G_GUINT64_FORMAT
+      " ticks per second", self->interfaces->len, iface.linktype,
+      iface.ts_resolution);
+  g_array_append_val (self->interfaces, iface);
+}
+
+/* Gets the length of the record starting at @data, FALSE if @size bytes
+ * are not enough to tell */
+static gboolean
+gst_pcap_parse_get_record_length (GstPcapParse * self, const guint8 * data,
+    gsize size, guint64 * length)
+{
+  if (self->format == PCAP_PARSE_FORMAT_PCAP) {
+    if (size < PCAP_RECORD_HEADER_LEN)
+      return FALSE;
+
+    *length = PCAP_RECORD_HEADER_LEN + gst_pcap_parse_read_uint32 (self,
+        data + 8);
+  } else {
+    guint32 length32;
+
+    if (size < PCAPNG_BLOCK_MIN_LEN)
+      return FALSE;
+
+    length32 = *((guint32 *) (data + 4));
+    /* a new section can change the byte order */
+    if (*((guint32 *) data) == PCAPNG_BLOCK_SHB) {
+      if (*((guint32 *) (data + 8)) != PCAPNG_BYTE_ORDER_MAGIC)
+        length32 = GUINT32_SWAP_LE_BE (length32);
+    } else if (self->swap_endian) {
+      length32 = GUINT32_SWAP_LE_BE (length32);
+    }
+    *length = length32;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_pcap_parse_check_record_length (GstPcapParse * self, guint64 length)
+{
+  if (self->format == PCAP_PARSE_FORMAT_PCAPNG &&
+      (length < PCAPNG_BLOCK_MIN_LEN || length % 4 != 0)) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Invalid pcapng block length %" G_GUINT64_FORMAT, length));
     return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Parses the complete record (a pcap packet record or a pcapng block) at
+ * @data, returns TRUE with the location of the payload if it holds a
+ * packet that passes the filter */
+static gboolean
+gst_pcap_parse_scan_record (GstPcapParse * self, const guint8 * data,
+    guint size, guint * payload_offset, gint * payload_size)
+{
+  GstPcapParseLinktype linktype;
+  const guint8 *frame;
+  const guint8 *payload;
+  guint frame_size;
+
+  if (self->format == PCAP_PARSE_FORMAT_PCAP) {
+    guint32 ts_sec;
+    guint32 ts_frac;
+
+    ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
+    ts_frac = gst_pcap_parse_read_uint32 (self, data + 4);
+    /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
+
+    self->cur_ts = ts_sec * GST_SECOND +
+        ts_frac * (GST_SECOND / self->ts_resolution);
+
+    linktype = self->linktype;
+    frame = data + PCAP_RECORD_HEADER_LEN;
+    frame_size = size - PCAP_RECORD_HEADER_LEN;
+  } else {
+    const GstPcapParseInterface *iface = NULL;
+
+    /* the section header block type reads the same in both byte orders */
+    switch (gst_pcap_parse_read_uint32 (self, data)) {
+      case PCAPNG_BLOCK_SHB:
+        self->swap_endian =
+            *((guint32 *) (data + 8)) != PCAPNG_BYTE_ORDER_MAGIC;
+        g_array_set_size (self->interfaces, 0);
+        GST_DEBUG_OBJECT (self, "new section, swap endian %d",
+            self->swap_endian);
+        return FALSE;
+      case PCAPNG_BLOCK_IDB:
+        gst_pcap_parse_read_interface (self, data, size);
+        return FALSE;
+      case PCAPNG_BLOCK_EPB:{
+        guint32 if_id;
+        guint32 caplen;
+        guint64 ts;
+
+        if (size < 32)
+          return FALSE;
+
+        if_id = gst_pcap_parse_read_uint32 (self, data + 8);
+        caplen = gst_pcap_parse_read_uint32 (self, data + 20);
+        if (caplen > size - 32 || if_id >= self->interfaces->len)
+          return FALSE;
+
+        iface = &g_array_index (self->interfaces, GstPcapParseInterface,
+            if_id);
+        ts = ((guint64) gst_pcap_parse_read_uint32 (self, data + 12) << 32) |
+            gst_pcap_parse_read_uint32 (self, data + 16);
+        self->cur_ts = gst_util_uint64_scale (ts, GST_SECOND,
+            iface->ts_resolution);
+
+        frame = data + 28;
+        frame_size = caplen;
+        break;
+      }
+      case PCAPNG_BLOCK_SPB:{
+        guint32 orig_len;
+
+        if (size < 16 || self->interfaces->len == 0)
+          return FALSE;
+
+        iface = &g_array_index (self->interfaces, GstPcapParseInterface, 0);
+        orig_len = gst_pcap_parse_read_uint32 (self, data + 8);
+        self->cur_ts = GST_CLOCK_TIME_NONE;
+
+        frame = data + 12;
+        frame_size = MIN (orig_len, size - 16);
+        break;
+      }
+      default:
+        return FALSE;
+    }
 
-  if (self->dst_port >= 0 && dst_port != self->dst_port)
+    linktype = iface->linktype;
+  }
+
+  GST_LOG_OBJECT (self, "examining packet size %u", frame_size);
+
+  if (frame_size == 0 || !gst_pcap_parse_scan_frame (self, linktype, frame,
+          frame_size, &payload, payload_size))
     return FALSE;
 
+  *payload_offset = payload - data;
+
   return TRUE;
 }
 
+/* Scans the complete records at the start of @buf and adds the payloads
+ * that pass the filter to @list. Returns the number of bytes scanned */
+static gsize
+gst_pcap_parse_scan_buffer (GstPcapParse * self, GstBuffer * buf,
+    GstBufferList ** list, GstFlowReturn * ret)
+{
+  GstMapInfo map;
+  gsize offset = 0;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("Failed to map input buffer"));
+    *ret = GST_FLOW_ERROR;
+    return 0;
+  }
+
+  while (offset < map.size) {
+    guint64 length;
+    guint payload_offset;
+    gint payload_size;
+
+    if (!gst_pcap_parse_get_record_length (self, map.data + offset,
+            map.size - offset, &length))
+      break;
+
+    if (!gst_pcap_parse_check_record_length (self, length)) {
+      *ret = GST_FLOW_ERROR;
+      break;
+    }
+
+    if (length > map.size - offset)
+      break;
+
+    if (gst_pcap_parse_scan_record (self, map.data + offset, length,
+            &payload_offset, &payload_size)) {
+      GstBuffer *out_buf;
+
+      /* the payload shares the memory of @buf, which is part of a single
+       * pushed buffer or a record gathered into one memory, so the RTP
+       * depayloaders find the complete RTP header in the first memory */
+      if (payload_size > 0) {
+        out_buf = gst_buffer_copy_region (buf, GST_BUFFER_COPY_MEMORY,
+            offset + payload_offset, payload_size);
+      } else {
+        out_buf = gst_buffer_new ();
+      }
+
+      if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+        if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
+          self->base_ts = self->cur_ts;
+        if (self->offset >= 0) {
+          self->cur_ts -= self->base_ts;
+          self->cur_ts += self->offset;
+        }
+      }
+      GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
+
+      if (*list == NULL)
+        *list = gst_buffer_list_new ();
+      gst_buffer_list_add (*list, out_buf);
+    }
+
+    offset += length;
+  }
+
+  gst_buffer_unmap (buf, &map);
+
+  return offset;
+}
+
+static GstFlowReturn
+gst_pcap_parse_read_header (GstPcapParse * self)
+{
+  const guint8 *data;
+  guint32 magic;
+  guint32 linktype;
+  guint16 major_version;
+
+  data = gst_adapter_map (self->adapter, PCAP_HEADER_LEN);
+
+  magic = *((guint32 *) data);
+  major_version = *((guint16 *) (data + 4));
+  linktype = *((guint32 *) (data + 20));
+  gst_adapter_unmap (self->adapter);
+
+  if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+    self->swap_endian = FALSE;
+  } else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
+    self->swap_endian = TRUE;
+    magic = GUINT32_SWAP_LE_BE (magic);
+    major_version = GUINT16_SWAP_LE_BE (major_version);
+    linktype = GUINT32_SWAP_LE_BE (linktype);
+  } else {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("File is not a libpcap file, magic is %X", magic));
+    return GST_FLOW_ERROR;
+  }
+
+  if (major_version != 2) {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("File is not a libpcap major version 2, but %u", major_version));
+    return GST_FLOW_ERROR;
+  }
+
+  if (linktype != LINKTYPE_ETHER && linktype != LINKTYPE_SLL &&
+      linktype != LINKTYPE_RAW) {
+    GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+        ("Only dumps of type Ethernet, raw IP or Linux Cooked (SLL) "
+            "understood; type %d unknown", linktype));
+    return GST_FLOW_ERROR;
+  }
+
+  GST_DEBUG_OBJECT (self, "linktype %u", linktype);
+  self->linktype = linktype;
+  /* nanosecond instead of microsecond timestamps */
+  self->ts_resolution = (magic == 0xa1b23c4d) ? GST_SECOND : GST_SECOND /
+      GST_USECOND;
+
+  gst_adapter_flush (self->adapter, PCAP_HEADER_LEN);
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
@@ -458,146 +854,102 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   gst_adapter_push (self->adapter, buffer);
 
   while (ret == GST_FLOW_OK) {
-    gint avail;
+    gsize avail;
+    gsize header_size;
     const guint8 *data;
+    guint64 length;
+    GstBuffer *buf;
+    gboolean have_length;
 
     avail = gst_adapter_available (self->adapter);
 
-    if (self->initialized) {
-      if (self->cur_packet_size >= 0) {
-        if (avail < self->cur_packet_size)
-          break;
-
-        if (self->cur_packet_size > 0) {
-          const guint8 *payload_data;
-          gint payload_size;
-
-          data = gst_adapter_map (self->adapter, self->cur_packet_size);
-
-          GST_LOG_OBJECT (self, "examining packet size %" G_GINT64_FORMAT,
-              self->cur_packet_size);
-
-          if (gst_pcap_parse_scan_frame (self, data, self->cur_packet_size,
-                  &payload_data, &payload_size)) {
-            GstBuffer *out_buf;
-            guintptr offset = payload_data - data;
-
-            gst_adapter_unmap (self->adapter);
-            gst_adapter_flush (self->adapter, offset);
-            /* we don't use _take_buffer_fast() on purpose here, we need a
-             * buffer with a single memory, since the RTP depayloaders expect
-             * the complete RTP header to be in the first memory if there are
-             * multiple ones and we can't guarantee that with _fast() */
-            if (payload_size > 0) {
-              out_buf = gst_adapter_take_buffer (self->adapter, payload_size);
-            } else {
-              out_buf = gst_buffer_new ();
-            }
-            gst_adapter_flush (self->adapter,
-                self->cur_packet_size - offset - payload_size);
-
-            if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-              if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
-                self->base_ts = self->cur_ts;
-              if (self->offset >= 0) {
-                self->cur_ts -= self->base_ts;
-                self->cur_ts += self->offset;
-              }
-            }
-            GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
-
-
-            if (list == NULL)
-              list = gst_buffer_list_new ();
-            gst_buffer_list_add (list, out_buf);
-          } else {
-            gst_adapter_unmap (self->adapter);
-            gst_adapter_flush (self->adapter, self->cur_packet_size);
-          }
-        }
-
-        self->cur_packet_size = -1;
-      } else {
-        guint32 ts_sec;
-        guint32 ts_usec;
-        guint32 incl_len;
-
-        if (avail < 16)
-          break;
-
-        data = gst_adapter_map (self->adapter, 16);
-
-        ts_sec = gst_pcap_parse_read_uint32 (self, data + 0);
-        ts_usec = gst_pcap_parse_read_uint32 (self, data + 4);
-        incl_len = gst_pcap_parse_read_uint32 (self, data + 8);
-        /* orig_len = gst_pcap_parse_read_uint32 (self, data + 12); */
+    if (!self->initialized) {
+      if (avail < 4)
+        break;
 
+      data = gst_adapter_map (self->adapter, 4);
+      /* the pcapng section header block is the same in both byte orders
+       * and gets parsed like any other block */
+      if (*((guint32 *) data) == PCAPNG_BLOCK_SHB) {
         gst_adapter_unmap (self->adapter);
-        gst_adapter_flush (self->adapter, 16);
-
-        self->cur_ts = ts_sec * GST_SECOND + ts_usec * GST_USECOND;
-        self->cur_packet_size = incl_len;
+        GST_DEBUG_OBJECT (self, "pcapng file");
+        self->format = PCAP_PARSE_FORMAT_PCAPNG;
+        self->initialized = TRUE;
+        continue;
       }
-    } else {
-      guint32 magic;
-      guint32 linktype;
-      guint16 major_version;
+      gst_adapter_unmap (self->adapter);
 
-      if (avail < 24)
+      if (avail < PCAP_HEADER_LEN)
         break;
 
-      data = gst_adapter_map (self->adapter, 24);
+      ret = gst_pcap_parse_read_header (self);
+      if (ret != GST_FLOW_OK)
+        break;
 
-      magic = *((guint32 *) data);
-      major_version = *((guint16 *) (data + 4));
-      linktype = *((guint32 *) (data + 20));
-      gst_adapter_unmap (self->adapter);
+      self->format = PCAP_PARSE_FORMAT_PCAP;
+      self->initialized = TRUE;
+      continue;
+    }
 
-      if (magic == 0xa1b2c3d4) {
-        self->swap_endian = FALSE;
-      } else if (magic == 0xd4c3b2a1) {
-        self->swap_endian = TRUE;
-        major_version = GUINT16_SWAP_LE_BE (major_version);
-        linktype = GUINT32_SWAP_LE_BE (linktype);
-      } else {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap file, magic is %X", magic));
-        ret = GST_FLOW_ERROR;
-        goto out;
-      }
+    /* scan all the records that are complete in the first buffer of the
+     * adapter in one go. _get_buffer() returns a sub-buffer of it here, so
+     * the payloads share its memory like with _take_buffer() before */
+    avail = gst_adapter_available_fast (self->adapter);
+    if (avail > 0) {
+      gsize scanned;
+
+      buf = gst_adapter_get_buffer (self->adapter, avail);
+      scanned = gst_pcap_parse_scan_buffer (self, buf, &list, &ret);
+      gst_buffer_unref (buf);
+
+      if (scanned > 0)
+        gst_adapter_flush (self->adapter, scanned);
+      if (scanned > 0 || ret != GST_FLOW_OK)
+        continue;
+    }
 
-      if (major_version != 2) {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap major version 2, but %u", major_version));
-        ret = GST_FLOW_ERROR;
-        goto out;
-      }
+    /* the next record spans several buffers, gather it */
+    avail = gst_adapter_available (self->adapter);
+    header_size = (self->format == PCAP_PARSE_FORMAT_PCAP) ?
+        PCAP_RECORD_HEADER_LEN : PCAPNG_BLOCK_MIN_LEN;
+    if (avail < header_size)
+      break;
 
-      if (linktype != LINKTYPE_ETHER && linktype != LINKTYPE_SLL &&
-          linktype != LINKTYPE_RAW) {
-        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("Only dumps of type Ethernet, raw IP or Linux Cooked (SLL) "
-                "understood; type %d unknown", linktype));
-        ret = GST_FLOW_ERROR;
-        goto out;
-      }
+    data = gst_adapter_map (self->adapter, header_size);
+    have_length = gst_pcap_parse_get_record_length (self, data, header_size,
+        &length);
+    gst_adapter_unmap (self->adapter);
 
-      GST_DEBUG_OBJECT (self, "linktype %u", linktype);
-      self->linktype = linktype;
+    if (!have_length)
+      break;
 
-      gst_adapter_flush (self->adapter, 24);
-      self->initialized = TRUE;
+    if (!gst_pcap_parse_check_record_length (self, length)) {
+      ret = GST_FLOW_ERROR;
+      break;
     }
+
+    if (avail < length)
+      break;
+
+    buf = gst_adapter_take_buffer (self->adapter, length);
+    gst_pcap_parse_scan_buffer (self, buf, &list, &ret);
+    gst_buffer_unref (buf);
   }
 
+  if (ret != GST_FLOW_OK)
+    goto out;
+
   if (list) {
-    if (!self->newsegment_sent && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+    if (!self->newsegment_sent) {
       GstSegment segment;
 
       if (self->caps)
         gst_pad_set_caps (self->src_pad, self->caps);
+      /* pcapng simple packet blocks have no timestamp, start the segment
+       * at 0 if no packet had one yet */
       gst_segment_init (&segment, GST_FORMAT_TIME);
-      segment.start = self->base_ts;
+      if (GST_CLOCK_TIME_IS_VALID (self->base_ts))
+        segment.start = self->base_ts;
       gst_pad_push_event (self->src_pad, gst_event_new_segment (&segment));
       self->newsegment_sent = TRUE;
     }
@@ -45,6 +45,12 @@ typedef enum
   PCAP_PARSE_STATE_PARSING,
 } GstPcapParseState;
 
+typedef enum
+{
+  PCAP_PARSE_FORMAT_PCAP,
+  PCAP_PARSE_FORMAT_PCAPNG,
+} GstPcapParseFormat;
+
 typedef enum
 {
   LINKTYPE_ETHER  = 1,
@@ -74,14 +80,25 @@ struct _GstPcapParse
   GstCaps *caps;
   gint64 offset;
 
+  /* filter compiled from the properties, matched against the addresses and
+   * ports of a packet in network byte order */
+  guint64 ip_mask;
+  guint64 ip_match;
+  guint32 port_mask;
+  guint32 port_match;
+
   /* state */
   GstAdapter * adapter;
   gboolean initialized;
+  GstPcapParseFormat format;
   gboolean swap_endian;
-  gint64 cur_packet_size;
   GstClockTime cur_ts;
   GstClockTime base_ts;
   GstPcapParseLinktype linktype;
+  /* ticks per second of the record timestamps */
+  guint64 ts_resolution;
+  /* pcapng interfaces of the current section */
+  GArray *interfaces;
 
   gboolean newsegment_sent;
 };
@@ -37,11 +37,17 @@ GST_DEBUG_CATEGORY (h264_parse_debug);
 #define GST_CAT_DEFAULT h264_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_BUILD_INDEX          FALSE
+#define DEFAULT_INDEX_LOCATION       NULL
+#define DEFAULT_SEI_ONLY             FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_BUILD_INDEX,
+  PROP_INDEX_LOCATION,
+  PROP_SEI_ONLY
 };
 
 enum
@@ -112,6 +118,8 @@ static GstCaps *gst_h264_parse_get_caps (GstBaseParse * parse,
 static gboolean gst_h264_parse_event (GstBaseParse * parse, GstEvent * event);
 static gboolean gst_h264_parse_src_event (GstBaseParse * parse,
     GstEvent * event);
+static gboolean gst_h264_parse_src_query (GstBaseParse * parse,
+    GstQuery * query);
 static void gst_h264_parse_update_src_caps (GstH264Parse * h264parse,
     GstCaps * caps);
 
@@ -137,6 +145,26 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_BUILD_INDEX,
+      g_param_spec_boolean ("build-index", "Build index",
+          "Record the byte offset and timestamp of keyframes, to write them "
+          "to index-location when stopping", DEFAULT_BUILD_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Keyframe index sidecar file. If it exists when starting, it is "
+          "used to seek without scanning the stream",
+          DEFAULT_INDEX_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SEI_ONLY,
+      g_param_spec_boolean ("sei-only", "SEI only",
+          "Only parse what is needed to split the stream and to extract the "
+          "SEI user data and time codes. Slice headers are not parsed, so "
+          "only IDR pictures are marked as keyframes and field pictures are "
+          "not detected", DEFAULT_SEI_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -147,6 +175,7 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
   parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_h264_parse_get_caps);
   parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_h264_parse_event);
   parse_class->src_event = GST_DEBUG_FUNCPTR (gst_h264_parse_src_event);
+  parse_class->src_query = GST_DEBUG_FUNCPTR (gst_h264_parse_src_query);
 
   gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
   gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
@@ -161,6 +190,8 @@ static void
 gst_h264_parse_init (GstH264Parse * h264parse)
 {
   h264parse->frame_out = gst_adapter_new ();
+  h264parse->index = gst_video_parse_index_new ();
+  h264parse->user_data = gst_video_parse_user_data_new ();
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h264parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h264parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h264parse));
@@ -176,6 +207,9 @@ gst_h264_parse_finalize (GObject * object)
   GstH264Parse *h264parse = GST_H264_PARSE (object);
 
   g_object_unref (h264parse->frame_out);
+  gst_video_parse_index_free (h264parse->index);
+  gst_video_parse_user_data_free (h264parse->user_data);
+  g_free (h264parse->index_location);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -197,6 +231,7 @@ gst_h264_parse_reset_frame (GstH264Parse * h264parse)
   h264parse->frame_start = FALSE;
   h264parse->aud_insert = TRUE;
   gst_adapter_clear (h264parse->frame_out);
+  gst_video_parse_user_data_clear (h264parse->user_data);
 }
 
 static void
@@ -261,6 +296,7 @@ static gboolean
 gst_h264_parse_start (GstBaseParse * parse)
 {
   GstH264Parse *h264parse = GST_H264_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "start");
   gst_h264_parse_reset (h264parse);
@@ -275,6 +311,12 @@ gst_h264_parse_start (GstBaseParse * parse)
 
   gst_base_parse_set_min_frame_size (parse, 6);
 
+  GST_OBJECT_LOCK (h264parse);
+  location = g_strdup (h264parse->index_location);
+  GST_OBJECT_UNLOCK (h264parse);
+  gst_video_parse_index_start (h264parse->index, parse, location);
+  g_free (location);
+
   return TRUE;
 }
 
@@ -282,12 +324,21 @@ static gboolean
 gst_h264_parse_stop (GstBaseParse * parse)
 {
   GstH264Parse *h264parse = GST_H264_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "stop");
   gst_h264_parse_reset (h264parse);
 
   gst_h264_nal_parser_free (h264parse->nalparser);
 
+  if (h264parse->build_index) {
+    GST_OBJECT_LOCK (h264parse);
+    location = g_strdup (h264parse->index_location);
+    GST_OBJECT_UNLOCK (h264parse);
+    gst_video_parse_index_stop (h264parse->index, parse, location);
+    g_free (location);
+  }
+
   return TRUE;
 }
 
@@ -417,33 +468,43 @@ gst_h264_parse_negotiate (GstH264Parse * h264parse, gint in_format,
     gst_caps_unref (caps);
 }
 
+static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* Returns a buffer holding the @size bytes of NAL data at @offset in @src,
+ * prefixed as required by @format. The NAL data is not copied, the returned
+ * buffer only adds a small prefix memory in front of the memory of @src */
 static GstBuffer *
-gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
-    guint size)
+gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format,
+    GstBuffer * src, guint offset, guint size)
 {
   GstBuffer *buf;
+  GstMemory *mem;
+  GstMapInfo map;
   guint nl = h264parse->nal_length_size;
-  guint32 tmp;
 
   GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H264_PARSE_FORMAT_AVC
       || format == GST_H264_PARSE_FORMAT_AVC3) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    guint32 tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+
+    mem = gst_allocator_alloc (NULL, nl, NULL);
+    gst_memory_map (mem, &map, GST_MAP_WRITE);
+    memcpy (map.data, &tmp, nl);
+    gst_memory_unmap (mem, &map);
   } else {
     /* HACK: nl should always be 4 here, otherwise this won't work. 
      * There are legit cases where nl in avc stream is 2, but byte-stream
      * SC is still always 4 bytes. */
-    nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (gpointer) start_code, sizeof (start_code), 0, sizeof (start_code),
+        NULL, NULL);
   }
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
-  gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
 
-  return buf;
+  return gst_buffer_append_region (buf, gst_buffer_ref (src), offset, size);
 }
 
 static void
@@ -516,6 +577,60 @@ _nal_name (GstH264NalUnitType nal_type)
 }
 #endif
 
+/* Queues the clock timestamps of a picture timing SEI as time codes,
+ * with the field they apply to as given by Table D-1 */
+static void
+gst_h264_parse_process_clock_timestamps (GstH264Parse * h264parse,
+    GstH264PicTiming * pic_timing)
+{
+  guint i;
+
+  for (i = 0; i < 3; i++) {
+    GstH264ClockTimestamp *tim = &pic_timing->clock_timestamp[i];
+    GstVideoTimeCodeFlags flags = GST_VIDEO_TIME_CODE_FLAGS_NONE;
+    guint field_count;
+
+    if (!pic_timing->clock_timestamp_flag[i])
+      continue;
+
+    switch (pic_timing->pic_struct) {
+      case GST_H264_SEI_PIC_STRUCT_TOP_FIELD:
+        field_count = 1;
+        break;
+      case GST_H264_SEI_PIC_STRUCT_BOTTOM_FIELD:
+        field_count = 2;
+        break;
+      case GST_H264_SEI_PIC_STRUCT_TOP_BOTTOM:
+        field_count = i + 1;
+        break;
+      case GST_H264_SEI_PIC_STRUCT_BOTTOM_TOP:
+        field_count = 2 - i;
+        break;
+      case GST_H264_SEI_PIC_STRUCT_TOP_BOTTOM_TOP:
+        field_count = i == 1 ? 2 : 1;
+        break;
+      case GST_H264_SEI_PIC_STRUCT_BOTTOM_TOP_BOTTOM:
+        field_count = i == 1 ? 1 : 2;
+        break;
+      default:
+        field_count = 0;
+        break;
+    }
+
+    /* ct_type 1 is interlaced, counting_type 4 drops frame numbers */
+    if (tim->ct_type == 1)
+      flags |= GST_VIDEO_TIME_CODE_FLAGS_INTERLACED;
+    if (tim->counting_type == 4)
+      flags |= GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME;
+
+    gst_video_parse_user_data_add_time_code (h264parse->user_data, flags,
+        tim->hours_flag ? tim->hours_value : 0,
+        tim->minutes_flag ? tim->minutes_value : 0,
+        tim->seconds_flag ? tim->seconds_value : 0,
+        tim->n_frames / (1 + tim->nuit_field_based_flag), field_count);
+  }
+}
+
 static void
 gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
 {
@@ -540,10 +655,26 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
             sei.payload.pic_timing.pic_struct_present_flag;
         h264parse->sei_cpb_removal_delay =
             sei.payload.pic_timing.cpb_removal_delay;
-        if (h264parse->sei_pic_struct_pres_flag)
+        if (h264parse->sei_pic_struct_pres_flag) {
           h264parse->sei_pic_struct = sei.payload.pic_timing.pic_struct;
+          gst_h264_parse_process_clock_timestamps (h264parse,
+              &sei.payload.pic_timing);
+        }
         GST_LOG_OBJECT (h264parse, "pic timing updated");
         break;
+      case GST_H264_SEI_REGISTERED_USER_DATA:
+        gst_video_parse_user_data_add_registered (h264parse->user_data,
+            sei.payload.registered_user_data.country_code,
+            sei.payload.registered_user_data.country_code_extension,
+            sei.payload.registered_user_data.data,
+            sei.payload.registered_user_data.size);
+        break;
+      case GST_H264_SEI_USER_DATA_UNREGISTERED:
+        gst_video_parse_user_data_add_unregistered (h264parse->user_data,
+            sei.payload.user_data_unregistered.uuid,
+            sei.payload.user_data_unregistered.data,
+            sei.payload.user_data_unregistered.size);
+        break;
       case GST_H264_SEI_BUF_PERIOD:
         if (h264parse->ts_trn_nb == GST_CLOCK_TIME_NONE ||
             h264parse->dts == GST_CLOCK_TIME_NONE)
@@ -698,9 +829,11 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   g_array_free (messages, TRUE);
 }
 
-/* caller guarantees 2 bytes of nal payload */
+/* caller guarantees 2 bytes of nal payload.
+ * nalu->data is the mapped data of @buffer */
 static gboolean
-gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
+gst_h264_parse_process_nal (GstH264Parse * h264parse, GstBuffer * buffer,
+    GstH264NalUnit * nalu)
 {
   guint nal_type;
   GstH264PPS pps = { 0, };
@@ -830,7 +963,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       GST_DEBUG_OBJECT (h264parse, "frame start: %i", h264parse->frame_start);
       if (nal_type == GST_H264_NAL_SLICE_EXT && !GST_H264_IS_MVC_NALU (nalu))
         break;
-      {
+      if (h264parse->sei_only) {
+        /* keyframes can only be told by the NAL type without the header */
+        if (nal_type == GST_H264_NAL_SLICE_IDR)
+          h264parse->keyframe |= TRUE;
+        h264parse->state |= GST_H264_PARSE_STATE_GOT_SLICE;
+      } else {
         GstH264SliceHdr slice;
 
         pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
@@ -893,8 +1031,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format, buffer,
+        nalu->offset, nalu->size);
     gst_adapter_push (h264parse->frame_out, buf);
   }
   return TRUE;
@@ -992,7 +1130,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h264_parse_process_nal (h264parse, &nalu);
+    gst_h264_parse_process_nal (h264parse, buffer, &nalu);
 
     /* dispatch per NALU if needed */
     if (h264parse->split_packetized) {
@@ -1230,7 +1368,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h264_parse_process_nal (h264parse, &nalu)) {
+    if (!gst_h264_parse_process_nal (h264parse, buffer, &nalu)) {
       GST_WARNING_OBJECT (h264parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2145,7 +2283,8 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    /* the collected NALs share the input memory, keep it that way */
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2160,12 +2299,8 @@ static GstFlowReturn
 gst_h264_parse_push_codec_buffer (GstH264Parse * h264parse,
     GstBuffer * nal, GstClockTime ts)
 {
-  GstMapInfo map;
-
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  nal = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-      map.data, map.size);
-  gst_buffer_unmap (nal, &map);
+  nal = gst_h264_parse_wrap_nal (h264parse, h264parse->format, nal, 0,
+      gst_buffer_get_size (nal));
 
   GST_BUFFER_TIMESTAMP (nal) = ts;
   GST_BUFFER_DURATION (nal) = 0;
@@ -2295,60 +2430,39 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
       }
     }
   } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
+    /* insert config NALs into AU, the AU data itself is not copied */
     GstBuffer *new_buf;
-    const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h264parse->nal_length_size;
-    gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
+    new_buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, 0,
+        h264parse->idr_pos);
     GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
     for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
       if ((codec_nal = h264parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_wrap_nal (h264parse, h264parse->format, codec_nal,
+                0, gst_buffer_get_size (codec_nal)));
         send_done = TRUE;
       }
     }
     for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
       if ((codec_nal = h264parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
         GST_DEBUG_OBJECT (h264parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+        new_buf = gst_buffer_append (new_buf,
+            gst_h264_parse_wrap_nal (h264parse, h264parse->format, codec_nal,
+                0, gst_buffer_get_size (codec_nal)));
         send_done = TRUE;
       }
     }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
+    new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+        h264parse->idr_pos, -1);
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
     GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
     gst_buffer_replace (&frame->out_buffer, new_buf);
     gst_buffer_unref (new_buf);
-    /* some result checking seems to make some compilers happy */
-    if (G_UNLIKELY (!ok)) {
-      GST_ERROR_OBJECT (h264parse, "failed to insert SPS/PPS");
-    }
   }
 
   return send_done;
@@ -2363,6 +2477,9 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 
   h264parse = GST_H264_PARSE (parse);
 
+  if (h264parse->build_index)
+    gst_video_parse_index_add_frame (h264parse->index, frame);
+
   if (!h264parse->sent_codec_tag) {
     GstTagList *taglist;
     GstCaps *caps;
@@ -2503,6 +2620,9 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   }
 #endif
 
+  gst_video_parse_user_data_attach (h264parse->user_data, frame,
+      h264parse->fps_num, h264parse->fps_den);
+
   gst_h264_parse_reset_frame (h264parse);
 
   return GST_FLOW_OK;
@@ -2641,7 +2761,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, codec_data, &nalu);
       off = nalu.offset + nalu.size;
     }
 
@@ -2660,7 +2780,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, codec_data, &nalu);
       off = nalu.offset + nalu.size;
     }
 
@@ -2908,6 +3028,20 @@ gst_h264_parse_src_event (GstBaseParse * parse, GstEvent * event)
   return res;
 }
 
+static gboolean
+gst_h264_parse_src_query (GstBaseParse * parse, GstQuery * query)
+{
+  GstH264Parse *h264parse = GST_H264_PARSE (parse);
+  gboolean res;
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->src_query (parse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_SEEKING)
+    gst_video_parse_index_update_seeking_query (h264parse->index, parse, query);
+
+  return res;
+}
+
 static void
 gst_h264_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -2920,6 +3054,18 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_BUILD_INDEX:
+      parse->build_index = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_SEI_ONLY:
+      parse->sei_only = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2938,6 +3084,17 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_BUILD_INDEX:
+      g_value_set_boolean (value, parse->build_index);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_SEI_ONLY:
+      g_value_set_boolean (value, parse->sei_only);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -30,6 +30,9 @@
 #include <gst/codecparsers/gsth264parser.h>
 #include <gst/video/video.h>
 
+#include "gstvideoparseindex.h"
+#include "gstvideoparseuserdata.h"
+
 G_BEGIN_DECLS
 
 typedef struct _H264Params H264Params;
@@ -120,6 +123,15 @@ struct _GstH264Parse
 
   /* props */
   gint interval;
+  gboolean build_index;
+  gchar *index_location;
+  gboolean sei_only;
+
+  /* keyframe index */
+  GstVideoParseIndex *index;
+
+  /* user data and time codes of the current AU */
+  GstVideoParseUserData *user_data;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
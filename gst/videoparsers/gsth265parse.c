@@ -33,11 +33,17 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_BUILD_INDEX          FALSE
+#define DEFAULT_INDEX_LOCATION       NULL
+#define DEFAULT_SEI_ONLY             FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_BUILD_INDEX,
+  PROP_INDEX_LOCATION,
+  PROP_SEI_ONLY
 };
 
 enum
@@ -92,6 +98,8 @@ static GstCaps *gst_h265_parse_get_caps (GstBaseParse * parse,
 static gboolean gst_h265_parse_event (GstBaseParse * parse, GstEvent * event);
 static gboolean gst_h265_parse_src_event (GstBaseParse * parse,
     GstEvent * event);
+static gboolean gst_h265_parse_src_query (GstBaseParse * parse,
+    GstQuery * query);
 
 static void
 gst_h265_parse_class_init (GstH265ParseClass * klass)
@@ -113,6 +121,26 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "will be multiplexed in the data stream when detected.) (0 = disabled)",
           0, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BUILD_INDEX,
+      g_param_spec_boolean ("build-index", "Build index",
+          "Record the byte offset and timestamp of keyframes, to write them "
+          "to index-location when stopping", DEFAULT_BUILD_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Keyframe index sidecar file. If it exists when starting, it is "
+          "used to seek without scanning the stream",
+          DEFAULT_INDEX_LOCATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SEI_ONLY,
+      g_param_spec_boolean ("sei-only", "SEI only",
+          "Only parse what is needed to split the stream and to extract the "
+          "SEI user data and time codes. Slice headers are not parsed, so "
+          "only IRAP pictures are marked as keyframes", DEFAULT_SEI_ONLY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -123,6 +151,7 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
   parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_h265_parse_get_caps);
   parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_h265_parse_event);
   parse_class->src_event = GST_DEBUG_FUNCPTR (gst_h265_parse_src_event);
+  parse_class->src_query = GST_DEBUG_FUNCPTR (gst_h265_parse_src_query);
 
   gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
   gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
@@ -137,6 +166,8 @@ static void
 gst_h265_parse_init (GstH265Parse * h265parse)
 {
   h265parse->frame_out = gst_adapter_new ();
+  h265parse->index = gst_video_parse_index_new ();
+  h265parse->user_data = gst_video_parse_user_data_new ();
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h265parse));
@@ -149,6 +180,9 @@ gst_h265_parse_finalize (GObject * object)
   GstH265Parse *h265parse = GST_H265_PARSE (object);
 
   g_object_unref (h265parse->frame_out);
+  gst_video_parse_index_free (h265parse->index);
+  gst_video_parse_user_data_free (h265parse->user_data);
+  g_free (h265parse->index_location);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -168,6 +202,7 @@ gst_h265_parse_reset_frame (GstH265Parse * h265parse)
   h265parse->keyframe = FALSE;
   h265parse->header = FALSE;
   gst_adapter_clear (h265parse->frame_out);
+  gst_video_parse_user_data_clear (h265parse->user_data);
 }
 
 static void
@@ -208,6 +243,7 @@ static gboolean
 gst_h265_parse_start (GstBaseParse * parse)
 {
   GstH265Parse *h265parse = GST_H265_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "start");
   gst_h265_parse_reset (h265parse);
@@ -216,6 +252,12 @@ gst_h265_parse_start (GstBaseParse * parse)
 
   gst_base_parse_set_min_frame_size (parse, 7);
 
+  GST_OBJECT_LOCK (h265parse);
+  location = g_strdup (h265parse->index_location);
+  GST_OBJECT_UNLOCK (h265parse);
+  gst_video_parse_index_start (h265parse->index, parse, location);
+  g_free (location);
+
   return TRUE;
 }
 
@@ -224,6 +266,7 @@ gst_h265_parse_stop (GstBaseParse * parse)
 {
   guint i;
   GstH265Parse *h265parse = GST_H265_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "stop");
   gst_h265_parse_reset (h265parse);
@@ -237,6 +280,14 @@ gst_h265_parse_stop (GstBaseParse * parse)
 
   gst_h265_parser_free (h265parse->nalparser);
 
+  if (h265parse->build_index) {
+    GST_OBJECT_LOCK (h265parse);
+    location = g_strdup (h265parse->index_location);
+    GST_OBJECT_UNLOCK (h265parse);
+    gst_video_parse_index_stop (h265parse->index, parse, location);
+    g_free (location);
+  }
+
   return TRUE;
 }
 
@@ -362,33 +413,43 @@ gst_h265_parse_negotiate (GstH265Parse * h265parse, gint in_format,
     gst_caps_unref (caps);
 }
 
+static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* Returns a buffer holding the @size bytes of NAL data at @offset in @src,
+ * prefixed as required by @format. The NAL data is not copied, the returned
+ * buffer only adds a small prefix memory in front of the memory of @src */
 static GstBuffer *
-gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
-    guint size)
+gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format,
+    GstBuffer * src, guint offset, guint size)
 {
   GstBuffer *buf;
+  GstMemory *mem;
+  GstMapInfo map;
   guint nl = h265parse->nal_length_size;
-  guint32 tmp;
 
   GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
   if (format == GST_H265_PARSE_FORMAT_HVC1
       || format == GST_H265_PARSE_FORMAT_HEV1) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+    guint32 tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+
+    mem = gst_allocator_alloc (NULL, nl, NULL);
+    gst_memory_map (mem, &map, GST_MAP_WRITE);
+    memcpy (map.data, &tmp, nl);
+    gst_memory_unmap (mem, &map);
   } else {
     /* HACK: nl should always be 4 here, otherwise this won't work.
      * There are legit cases where nl in hevc stream is 2, but byte-stream
      * SC is still always 4 bytes. */
-    nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (gpointer) start_code, sizeof (start_code), 0, sizeof (start_code),
+        NULL, NULL);
   }
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
-  gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
 
-  return buf;
+  return gst_buffer_append_region (buf, gst_buffer_ref (src), offset, size);
 }
 
 static void
@@ -485,9 +546,79 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
-/* caller guarantees 2 bytes of nal payload */
 static void
-gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
+gst_h265_parse_process_time_code (GstH265Parse * h265parse,
+    GstH265TimeCode * tc)
+{
+  guint i;
+
+  for (i = 0; i < tc->num_clock_ts; i++) {
+    GstVideoTimeCodeFlags flags = GST_VIDEO_TIME_CODE_FLAGS_NONE;
+
+    if (!tc->clock_timestamp_flag[i])
+      continue;
+
+    /* counting_type 4 drops frame numbers */
+    if (tc->counting_type[i] == 4)
+      flags |= GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME;
+    if (tc->num_clock_ts > 1)
+      flags |= GST_VIDEO_TIME_CODE_FLAGS_INTERLACED;
+
+    gst_video_parse_user_data_add_time_code (h265parse->user_data, flags,
+        tc->hours_flag[i] ? tc->hours_value[i] : 0,
+        tc->minutes_flag[i] ? tc->minutes_value[i] : 0,
+        tc->seconds_flag[i] ? tc->seconds_value[i] : 0,
+        tc->n_frames[i] / (1 + tc->units_field_based_flag[i]),
+        tc->num_clock_ts > 1 ? i + 1 : 0);
+  }
+}
+
+static void
+gst_h265_parse_process_sei (GstH265Parse * h265parse, GstH265NalUnit * nalu)
+{
+  GstH265SEIMessage *sei;
+  GstH265ParserResult pres;
+  GArray *messages;
+  guint i;
+
+  pres = gst_h265_parser_parse_sei (h265parse->nalparser, nalu, &messages);
+  if (pres != GST_H265_PARSER_OK)
+    GST_WARNING_OBJECT (h265parse, "failed to parse one or more SEI message");
+
+  /* Even if pres != GST_H265_PARSER_OK, some message could have been parsed and
+   * stored in messages.
+   */
+  for (i = 0; i < messages->len; i++) {
+    sei = &g_array_index (messages, GstH265SEIMessage, i);
+    switch (sei->payloadType) {
+      case GST_H265_SEI_REGISTERED_USER_DATA:
+        gst_video_parse_user_data_add_registered (h265parse->user_data,
+            sei->payload.registered_user_data.country_code,
+            sei->payload.registered_user_data.country_code_extension,
+            sei->payload.registered_user_data.data,
+            sei->payload.registered_user_data.size);
+        break;
+      case GST_H265_SEI_USER_DATA_UNREGISTERED:
+        gst_video_parse_user_data_add_unregistered (h265parse->user_data,
+            sei->payload.user_data_unregistered.uuid,
+            sei->payload.user_data_unregistered.data,
+            sei->payload.user_data_unregistered.size);
+        break;
+      case GST_H265_SEI_TIME_CODE:
+        gst_h265_parse_process_time_code (h265parse, &sei->payload.time_code);
+        break;
+      default:
+        break;
+    }
+  }
+  g_array_free (messages, TRUE);
+}
+
+/* caller guarantees 2 bytes of nal payload.
+ * nalu->data is the mapped data of @buffer */
+static void
+gst_h265_parse_process_nal (GstH265Parse * h265parse, GstBuffer * buffer,
+    GstH265NalUnit * nalu)
 {
   GstH265PPS pps = { 0, };
   GstH265SPS sps = { 0, };
@@ -583,7 +714,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       break;
     case GST_H265_NAL_PREFIX_SEI:
     case GST_H265_NAL_SUFFIX_SEI:
-      /*Fixme: parse sei messages */
+      gst_h265_parse_process_sei (h265parse, nalu);
       /* mark SEI pos */
       if (h265parse->sei_pos == -1) {
         if (h265parse->transform)
@@ -611,25 +742,30 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_SLICE_IDR_W_RADL:
     case GST_H265_NAL_SLICE_IDR_N_LP:
     case GST_H265_NAL_SLICE_CRA_NUT:
-    {
-      GstH265SliceHdr slice;
+      if (h265parse->sei_only) {
+        /* keyframes can only be told by the NAL type without the header */
+        if (nal_type >= GST_H265_NAL_SLICE_BLA_W_LP &&
+            nal_type <= GST_H265_NAL_SLICE_CRA_NUT)
+          h265parse->keyframe |= TRUE;
+      } else {
+        GstH265SliceHdr slice;
 
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+        pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
 
-      if (pres == GST_H265_PARSER_OK) {
-        if (GST_H265_IS_I_SLICE (&slice))
-          h265parse->keyframe |= TRUE;
-      }
-      if (slice.first_slice_segment_in_pic_flag == 1)
-        GST_DEBUG_OBJECT (h265parse,
-            "frame start, first_slice_segment_in_pic_flag = 1");
+        if (pres == GST_H265_PARSER_OK) {
+          if (GST_H265_IS_I_SLICE (&slice))
+            h265parse->keyframe |= TRUE;
+        }
+        if (slice.first_slice_segment_in_pic_flag == 1)
+          GST_DEBUG_OBJECT (h265parse,
+              "frame start, first_slice_segment_in_pic_flag = 1");
 
-      GST_DEBUG_OBJECT (h265parse,
-          "parse result %d, first slice_segment: %u, slice type: %u",
-          pres, slice.first_slice_segment_in_pic_flag, slice.type);
+        GST_DEBUG_OBJECT (h265parse,
+            "parse result %d, first slice_segment: %u, slice type: %u",
+            pres, slice.first_slice_segment_in_pic_flag, slice.type);
 
-      gst_h265_slice_hdr_free (&slice);
-    }
+        gst_h265_slice_hdr_free (&slice);
+      }
 
       is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
           && (nal_type <= GST_H265_NAL_SLICE_CRA_NUT)) ? TRUE : FALSE;
@@ -666,8 +802,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format, buffer,
+        nalu->offset, nalu->size);
     gst_adapter_push (h265parse->frame_out, buf);
   }
 }
@@ -758,7 +894,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h265_parse_process_nal (h265parse, &nalu);
+    gst_h265_parse_process_nal (h265parse, buffer, &nalu);
 
     /* dispatch per NALU if needed */
     if (h265parse->split_packetized) {
@@ -976,7 +1112,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
         nalu.type == GST_H265_NAL_SPS ||
         nalu.type == GST_H265_NAL_PPS ||
         (h265parse->have_sps && h265parse->have_pps)) {
-      gst_h265_parse_process_nal (h265parse, &nalu);
+      gst_h265_parse_process_nal (h265parse, buffer, &nalu);
     } else {
       GST_WARNING_OBJECT (h265parse,
           "no SPS/PPS yet, nal Type: %d %s, Size: %u will be dropped",
@@ -1654,7 +1790,8 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    /* the collected NALs share the input memory, keep it that way */
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -1669,12 +1806,8 @@ static GstFlowReturn
 gst_h265_parse_push_codec_buffer (GstH265Parse * h265parse, GstBuffer * nal,
     GstClockTime ts)
 {
-  GstMapInfo map;
-
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  nal = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-      map.data, map.size);
-  gst_buffer_unmap (nal, &map);
+  nal = gst_h265_parse_wrap_nal (h265parse, h265parse->format, nal, 0,
+      gst_buffer_get_size (nal));
 
   GST_BUFFER_TIMESTAMP (nal) = ts;
   GST_BUFFER_DURATION (nal) = 0;
@@ -1792,6 +1925,9 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 
   h265parse = GST_H265_PARSE (parse);
 
+  if (h265parse->build_index)
+    gst_video_parse_index_add_frame (h265parse->index, frame);
+
   if (!h265parse->sent_codec_tag) {
     GstTagList *taglist;
     GstCaps *caps;
@@ -1892,71 +2028,42 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
             }
           }
         } else {
-          /* insert config NALs into AU */
-          GstByteWriter bw;
+          /* insert config NALs into AU, the AU data itself is not copied */
           GstBuffer *new_buf;
-          const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
-          const gint nls = 4 - h265parse->nal_length_size;
-          gboolean ok;
 
-          gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer),
-              FALSE);
-          ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
+          new_buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, 0,
+              h265parse->idr_pos);
           GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
           for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
             if ((codec_nal = h265parse->vps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting VPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+                      codec_nal, 0, gst_buffer_get_size (codec_nal)));
               h265parse->last_report = new_ts;
             }
           }
           for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
             if ((codec_nal = h265parse->sps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting SPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+                      codec_nal, 0, gst_buffer_get_size (codec_nal)));
               h265parse->last_report = new_ts;
             }
           }
           for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
             if ((codec_nal = h265parse->pps_nals[i])) {
-              gsize nal_size = gst_buffer_get_size (codec_nal);
               GST_DEBUG_OBJECT (h265parse, "inserting PPS nal");
-              if (bs) {
-                ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-              } else {
-                ok &= gst_byte_writer_put_uint32_be (&bw,
-                    (nal_size << (nls * 8)));
-                ok &= gst_byte_writer_set_pos (&bw,
-                    gst_byte_writer_get_pos (&bw) - nls);
-              }
-              ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
+              new_buf = gst_buffer_append (new_buf,
+                  gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+                      codec_nal, 0, gst_buffer_get_size (codec_nal)));
               h265parse->last_report = new_ts;
             }
           }
-          ok &=
-              gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
+          new_buf = gst_buffer_append_region (new_buf, gst_buffer_ref (buffer),
+              h265parse->idr_pos, -1);
           /* collect result and push */
-          new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
           gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0,
               -1);
           /* should already be keyframe/IDR, but it may not have been,
@@ -1964,10 +2071,6 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
           gst_buffer_replace (&frame->out_buffer, new_buf);
           gst_buffer_unref (new_buf);
-          /* some result checking seems to make some compilers happy */
-          if (G_UNLIKELY (!ok)) {
-            GST_ERROR_OBJECT (h265parse, "failed to insert SPS/PPS");
-          }
         }
       }
       /* we pushed whatever we had */
@@ -1978,6 +2081,9 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     }
   }
 
+  gst_video_parse_user_data_attach (h265parse->user_data, frame,
+      h265parse->fps_num, h265parse->fps_den);
+
   gst_h265_parse_reset_frame (h265parse);
 
   return GST_FLOW_OK;
@@ -2068,7 +2174,7 @@ gst_h265_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
           goto hvcc_too_small;
         }
 
-        gst_h265_parse_process_nal (h265parse, &nalu);
+        gst_h265_parse_process_nal (h265parse, codec_data, &nalu);
         off = nalu.offset + nalu.size;
       }
     }
@@ -2290,6 +2396,20 @@ gst_h265_parse_src_event (GstBaseParse * parse, GstEvent * event)
   return res;
 }
 
+static gboolean
+gst_h265_parse_src_query (GstBaseParse * parse, GstQuery * query)
+{
+  GstH265Parse *h265parse = GST_H265_PARSE (parse);
+  gboolean res;
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->src_query (parse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_SEEKING)
+    gst_video_parse_index_update_seeking_query (h265parse->index, parse, query);
+
+  return res;
+}
+
 static void
 gst_h265_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -2301,6 +2421,18 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_uint (value);
       break;
+    case PROP_BUILD_INDEX:
+      parse->build_index = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_SEI_ONLY:
+      parse->sei_only = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2318,6 +2450,17 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, parse->interval);
       break;
+    case PROP_BUILD_INDEX:
+      g_value_set_boolean (value, parse->build_index);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_SEI_ONLY:
+      g_value_set_boolean (value, parse->sei_only);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -25,6 +25,9 @@
 #include <gst/base/gstbaseparse.h>
 #include <gst/codecparsers/gsth265parser.h>
 
+#include "gstvideoparseindex.h"
+#include "gstvideoparseuserdata.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_H265_PARSE \
@@ -89,6 +92,15 @@ struct _GstH265Parse
 
   /* props */
   guint interval;
+  gboolean build_index;
+  gchar *index_location;
+  gboolean sei_only;
+
+  /* keyframe index */
+  GstVideoParseIndex *index;
+
+  /* user data and time codes of the current AU */
+  GstVideoParseUserData *user_data;
 
   gboolean sent_codec_tag;
 
@@ -54,12 +54,16 @@ GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
 /* Properties */
 #define DEFAULT_PROP_DROP       TRUE
 #define DEFAULT_PROP_GOP_SPLIT  FALSE
+#define DEFAULT_PROP_BUILD_INDEX FALSE
+#define DEFAULT_PROP_INDEX_LOCATION NULL
 
 enum
 {
   PROP_0,
   PROP_DROP,
-  PROP_GOP_SPLIT
+  PROP_GOP_SPLIT,
+  PROP_BUILD_INDEX,
+  PROP_INDEX_LOCATION
 };
 
 #define parent_class gst_mpegv_parse_parent_class
@@ -78,11 +82,14 @@ static GstFlowReturn gst_mpegv_parse_pre_push_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame);
 static gboolean gst_mpegv_parse_sink_query (GstBaseParse * parse,
     GstQuery * query);
+static gboolean gst_mpegv_parse_src_query (GstBaseParse * parse,
+    GstQuery * query);
 
 static void gst_mpegv_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_mpegv_parse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_mpegv_parse_finalize (GObject * object);
 
 static void
 gst_mpegv_parse_set_property (GObject * object, guint property_id,
@@ -97,6 +104,15 @@ gst_mpegv_parse_set_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       parse->gop_split = g_value_get_boolean (value);
       break;
+    case PROP_BUILD_INDEX:
+      parse->build_index = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -115,6 +131,14 @@ gst_mpegv_parse_get_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       g_value_set_boolean (value, parse->gop_split);
       break;
+    case PROP_BUILD_INDEX:
+      g_value_set_boolean (value, parse->build_index);
+      break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -134,6 +158,7 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
 
   gobject_class->set_property = gst_mpegv_parse_set_property;
   gobject_class->get_property = gst_mpegv_parse_get_property;
+  gobject_class->finalize = gst_mpegv_parse_finalize;
 
   g_object_class_install_property (gobject_class, PROP_DROP,
       g_param_spec_boolean ("drop", "drop",
@@ -146,6 +171,19 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
           "Split frame when encountering GOP", DEFAULT_PROP_GOP_SPLIT,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_BUILD_INDEX,
+      g_param_spec_boolean ("build-index", "Build index",
+          "Record the byte offset and timestamp of keyframes, to write them "
+          "to index-location when stopping", DEFAULT_PROP_BUILD_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Keyframe index sidecar file. If it exists when starting, it is "
+          "used to seek without scanning the stream",
+          DEFAULT_PROP_INDEX_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &sink_template);
 
@@ -166,18 +204,31 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
   parse_class->pre_push_frame =
       GST_DEBUG_FUNCPTR (gst_mpegv_parse_pre_push_frame);
   parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_query);
+  parse_class->src_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_src_query);
 }
 
 static void
 gst_mpegv_parse_init (GstMpegvParse * parse)
 {
   parse->config_flags = FLAG_NONE;
+  parse->index = gst_video_parse_index_new ();
 
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (parse));
 }
 
+static void
+gst_mpegv_parse_finalize (GObject * object)
+{
+  GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (object);
+
+  gst_video_parse_index_free (mpvparse->index);
+  g_free (mpvparse->index_location);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_mpegv_parse_reset_frame (GstMpegvParse * mpvparse)
 {
@@ -236,10 +287,25 @@ gst_mpegv_parse_sink_query (GstBaseParse * parse, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_mpegv_parse_src_query (GstBaseParse * parse, GstQuery * query)
+{
+  gboolean res;
+  GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->src_query (parse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_SEEKING)
+    gst_video_parse_index_update_seeking_query (mpvparse->index, parse, query);
+
+  return res;
+}
+
 static gboolean
 gst_mpegv_parse_start (GstBaseParse * parse)
 {
   GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "start");
 
@@ -247,6 +313,12 @@ gst_mpegv_parse_start (GstBaseParse * parse)
   /* at least this much for a valid frame */
   gst_base_parse_set_min_frame_size (parse, 6);
 
+  GST_OBJECT_LOCK (mpvparse);
+  location = g_strdup (mpvparse->index_location);
+  GST_OBJECT_UNLOCK (mpvparse);
+  gst_video_parse_index_start (mpvparse->index, parse, location);
+  g_free (location);
+
   return TRUE;
 }
 
@@ -254,11 +326,20 @@ static gboolean
 gst_mpegv_parse_stop (GstBaseParse * parse)
 {
   GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+  gchar *location;
 
   GST_DEBUG_OBJECT (parse, "stop");
 
   gst_mpegv_parse_reset (mpvparse);
 
+  if (mpvparse->build_index) {
+    GST_OBJECT_LOCK (mpvparse);
+    location = g_strdup (mpvparse->index_location);
+    GST_OBJECT_UNLOCK (mpvparse);
+    gst_video_parse_index_stop (mpvparse->index, parse, location);
+    g_free (location);
+  }
+
   return TRUE;
 }
 
@@ -939,6 +1020,9 @@ gst_mpegv_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   GstMpegVideoPictureExt *pic_ext = NULL;
   GstMpegVideoQuantMatrixExt *quant_ext = NULL;
 
+  if (mpvparse->build_index)
+    gst_video_parse_index_add_frame (mpvparse->index, frame);
+
   /* tag sending done late enough in hook to ensure pending events
    * have already been sent */
 
@@ -30,6 +30,8 @@
 
 #include <gst/codecparsers/gstmpegvideoparser.h>
 
+#include "gstvideoparseindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGVIDEO_PARSE            (gst_mpegv_parse_get_type())
@@ -90,6 +92,11 @@ struct _GstMpegvParse {
   /* properties */
   gboolean drop;
   gboolean gop_split;
+  gboolean build_index;
+  gchar *index_location;
+
+  /* keyframe index */
+  GstVideoParseIndex *index;
 
   int fps_num;
   int fps_den;
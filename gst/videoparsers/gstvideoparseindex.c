@@ -0,0 +1,346 @@
+/* GStreamer video parsers keyframe index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gstvideoparseindex.h"
+
+GST_DEBUG_CATEGORY_STATIC (video_parse_index_debug);
+#define GST_CAT_DEFAULT video_parse_index_debug
+
+/* first line of the sidecar files, followed by one
+ * "<byte offset> <timestamp in ns>" line per keyframe */
+#define INDEX_FILE_HEADER "# GStreamer video parser keyframe index v1"
+
+typedef struct
+{
+  guint64 offset;
+  GstClockTime ts;
+} GstVideoParseIndexEntry;
+
+struct _GstVideoParseIndex
+{
+  GMutex lock;
+  GArray *entries;              /* GstVideoParseIndexEntry, sorted by ts */
+};
+
+GstVideoParseIndex *
+gst_video_parse_index_new (void)
+{
+  GstVideoParseIndex *index;
+
+  GST_DEBUG_CATEGORY_INIT (video_parse_index_debug, "videoparseindex", 0,
+      "video parsers keyframe index");
+
+  index = g_slice_new (GstVideoParseIndex);
+  g_mutex_init (&index->lock);
+  index->entries = g_array_new (FALSE, FALSE,
+      sizeof (GstVideoParseIndexEntry));
+
+  return index;
+}
+
+void
+gst_video_parse_index_free (GstVideoParseIndex * index)
+{
+  g_array_free (index->entries, TRUE);
+  g_mutex_clear (&index->lock);
+  g_slice_free (GstVideoParseIndex, index);
+}
+
+void
+gst_video_parse_index_clear (GstVideoParseIndex * index)
+{
+  g_mutex_lock (&index->lock);
+  g_array_set_size (index->entries, 0);
+  g_mutex_unlock (&index->lock);
+}
+
+guint
+gst_video_parse_index_get_n_entries (GstVideoParseIndex * index)
+{
+  guint n;
+
+  g_mutex_lock (&index->lock);
+  n = index->entries->len;
+  g_mutex_unlock (&index->lock);
+
+  return n;
+}
+
+/* returns the position of the first entry with a timestamp after @ts.
+ * Must be called with the lock taken */
+static guint
+gst_video_parse_index_upper_bound (GstVideoParseIndex * index,
+    GstClockTime ts)
+{
+  guint lo = 0, hi = index->entries->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (index->entries, GstVideoParseIndexEntry, mid).ts <= ts)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+void
+gst_video_parse_index_add (GstVideoParseIndex * index, guint64 offset,
+    GstClockTime ts)
+{
+  GstVideoParseIndexEntry entry = { offset, ts };
+  guint pos;
+
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (ts));
+
+  g_mutex_lock (&index->lock);
+  /* keyframes are usually seen in order, so this is mostly an append */
+  pos = gst_video_parse_index_upper_bound (index, ts);
+  if (pos > 0 &&
+      g_array_index (index->entries, GstVideoParseIndexEntry, pos - 1).ts ==
+      ts) {
+    /* seen before, e.g. after seeking back */
+    g_mutex_unlock (&index->lock);
+    return;
+  }
+  g_array_insert_val (index->entries, pos, entry);
+  g_mutex_unlock (&index->lock);
+
+  GST_LOG ("added keyframe at offset %" G_GUINT64_FORMAT ", ts %"
+      GST_TIME_FORMAT, offset, GST_TIME_ARGS (ts));
+}
+
+/* Finds the last keyframe at or before @ts */
+gboolean
+gst_video_parse_index_lookup (GstVideoParseIndex * index, GstClockTime ts,
+    guint64 * offset, GstClockTime * entry_ts)
+{
+  GstVideoParseIndexEntry *entry;
+  guint pos;
+
+  g_mutex_lock (&index->lock);
+  pos = gst_video_parse_index_upper_bound (index, ts);
+  if (pos == 0) {
+    g_mutex_unlock (&index->lock);
+    return FALSE;
+  }
+
+  entry = &g_array_index (index->entries, GstVideoParseIndexEntry, pos - 1);
+  if (offset)
+    *offset = entry->offset;
+  if (entry_ts)
+    *entry_ts = entry->ts;
+  g_mutex_unlock (&index->lock);
+
+  return TRUE;
+}
+
+gboolean
+gst_video_parse_index_save (GstVideoParseIndex * index,
+    const gchar * location, GError ** error)
+{
+  GString *s;
+  gboolean ret;
+  guint i;
+
+  s = g_string_new (INDEX_FILE_HEADER "\n");
+
+  g_mutex_lock (&index->lock);
+  for (i = 0; i < index->entries->len; i++) {
+    GstVideoParseIndexEntry *entry =
+        &g_array_index (index->entries, GstVideoParseIndexEntry, i);
+
+    g_string_append_printf (s, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+        "\n", entry->offset, entry->ts);
+  }
+  g_mutex_unlock (&index->lock);
+
+  ret = g_file_set_contents (location, s->str, s->len, error);
+  g_string_free (s, TRUE);
+
+  GST_DEBUG ("saved keyframe index to %s: %d", location, ret);
+
+  return ret;
+}
+
+gboolean
+gst_video_parse_index_load (GstVideoParseIndex * index,
+    const gchar * location, GError ** error)
+{
+  gchar *contents;
+  gchar **lines;
+  guint i;
+
+  if (!g_file_get_contents (location, &contents, NULL, error))
+    return FALSE;
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  if (lines[0] == NULL || strcmp (lines[0], INDEX_FILE_HEADER) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s is not a keyframe index file", location);
+    g_strfreev (lines);
+    return FALSE;
+  }
+
+  for (i = 1; lines[i]; i++) {
+    guint64 offset, ts;
+    gchar *end;
+
+    if (lines[i][0] == '\0')
+      continue;
+
+    offset = g_ascii_strtoull (lines[i], &end, 10);
+    if (end == lines[i] || *end != ' ')
+      goto invalid;
+    ts = g_ascii_strtoull (end + 1, &end, 10);
+    if (*end != '\0' || !GST_CLOCK_TIME_IS_VALID (ts))
+      goto invalid;
+
+    gst_video_parse_index_add (index, offset, ts);
+  }
+  g_strfreev (lines);
+
+  GST_DEBUG ("loaded %u keyframes from %s",
+      gst_video_parse_index_get_n_entries (index), location);
+
+  return TRUE;
+
+invalid:
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+      "invalid entry on line %u of %s", i + 1, location);
+  g_strfreev (lines);
+  return FALSE;
+}
+
+/* To be called from the start vfunc. Resets @index and loads it from the
+ * sidecar file at @location, if any. The loaded entries are also handed to
+ * the base class index, which is what it uses to find the byte offset to
+ * start from when seeking, so seeks no longer need to scan the stream */
+void
+gst_video_parse_index_start (GstVideoParseIndex * index, GstBaseParse * parse,
+    const gchar * location)
+{
+  GError *err = NULL;
+  guint i;
+
+  gst_video_parse_index_clear (index);
+
+  if (location == NULL || !g_file_test (location, G_FILE_TEST_EXISTS))
+    return;
+
+  if (!gst_video_parse_index_load (index, location, &err)) {
+    GST_WARNING_OBJECT (parse, "could not load keyframe index: %s",
+        err->message);
+    g_clear_error (&err);
+    gst_video_parse_index_clear (index);
+    return;
+  }
+
+  g_mutex_lock (&index->lock);
+  for (i = 0; i < index->entries->len; i++) {
+    GstVideoParseIndexEntry *entry =
+        &g_array_index (index->entries, GstVideoParseIndexEntry, i);
+
+    gst_base_parse_add_index_entry (parse, entry->offset, entry->ts, TRUE,
+        TRUE);
+  }
+  g_mutex_unlock (&index->lock);
+}
+
+/* To be called from the stop vfunc. Writes @index to the sidecar file at
+ * @location, if any */
+void
+gst_video_parse_index_stop (GstVideoParseIndex * index, GstBaseParse * parse,
+    const gchar * location)
+{
+  GError *err = NULL;
+
+  if (location == NULL || gst_video_parse_index_get_n_entries (index) == 0)
+    return;
+
+  if (!gst_video_parse_index_save (index, location, &err)) {
+    GST_ELEMENT_WARNING (parse, RESOURCE, OPEN_WRITE,
+        ("Could not write keyframe index"), ("%s", err->message));
+    g_clear_error (&err);
+  }
+}
+
+/* Records @frame if it is a keyframe with a known position and timestamp.
+ * To be called from pre_push_frame, when timestamps are final */
+void
+gst_video_parse_index_add_frame (GstVideoParseIndex * index,
+    GstBaseParseFrame * frame)
+{
+  GstBuffer *buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
+  GstClockTime ts;
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT) ||
+      frame->offset == (guint64) - 1)
+    return;
+
+  ts = GST_BUFFER_PTS (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    ts = GST_BUFFER_DTS (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  gst_video_parse_index_add (index, frame->offset, ts);
+}
+
+/* When the base class can't tell the stream is seekable, e.g. because its
+ * duration is unknown, but there is an index and upstream can seek in bytes,
+ * seeking is possible within the indexed range */
+void
+gst_video_parse_index_update_seeking_query (GstVideoParseIndex * index,
+    GstBaseParse * parse, GstQuery * query)
+{
+  GstFormat format;
+  gboolean seekable;
+  GstClockTime last_ts;
+  GstQuery *peer_query;
+
+  gst_query_parse_seeking (query, &format, &seekable, NULL, NULL);
+  if (format != GST_FORMAT_TIME || seekable)
+    return;
+
+  if (!gst_video_parse_index_lookup (index, GST_CLOCK_TIME_NONE - 1, NULL,
+          &last_ts))
+    return;
+
+  peer_query = gst_query_new_seeking (GST_FORMAT_BYTES);
+  if (gst_pad_peer_query (GST_BASE_PARSE_SINK_PAD (parse), peer_query))
+    gst_query_parse_seeking (peer_query, NULL, &seekable, NULL, NULL);
+  gst_query_unref (peer_query);
+
+  if (seekable) {
+    GST_DEBUG_OBJECT (parse, "seekable using the keyframe index, up to %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (last_ts));
+    gst_query_set_seeking (query, GST_FORMAT_TIME, TRUE, 0, last_ts);
+  }
+}
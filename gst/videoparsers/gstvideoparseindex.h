@@ -0,0 +1,73 @@
+/* GStreamer video parsers keyframe index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_PARSE_INDEX_H__
+#define __GST_VIDEO_PARSE_INDEX_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+
+G_BEGIN_DECLS
+
+/* Byte offset / timestamp index of the keyframes seen by a parser, sorted by
+ * timestamp. All functions are MT safe. */
+typedef struct _GstVideoParseIndex GstVideoParseIndex;
+
+GstVideoParseIndex * gst_video_parse_index_new (void);
+
+void     gst_video_parse_index_free (GstVideoParseIndex * index);
+
+void     gst_video_parse_index_clear (GstVideoParseIndex * index);
+
+guint    gst_video_parse_index_get_n_entries (GstVideoParseIndex * index);
+
+void     gst_video_parse_index_add (GstVideoParseIndex * index,
+                                    guint64 offset,
+                                    GstClockTime ts);
+
+gboolean gst_video_parse_index_lookup (GstVideoParseIndex * index,
+                                       GstClockTime ts,
+                                       guint64 * offset,
+                                       GstClockTime * entry_ts);
+
+gboolean gst_video_parse_index_save (GstVideoParseIndex * index,
+                                     const gchar * location,
+                                     GError ** error);
+
+gboolean gst_video_parse_index_load (GstVideoParseIndex * index,
+                                     const gchar * location,
+                                     GError ** error);
+
+void     gst_video_parse_index_start (GstVideoParseIndex * index,
+                                      GstBaseParse * parse,
+                                      const gchar * location);
+
+void     gst_video_parse_index_stop (GstVideoParseIndex * index,
+                                     GstBaseParse * parse,
+                                     const gchar * location);
+
+void     gst_video_parse_index_add_frame (GstVideoParseIndex * index,
+                                          GstBaseParseFrame * frame);
+
+void     gst_video_parse_index_update_seeking_query (GstVideoParseIndex * index,
+                                                     GstBaseParse * parse,
+                                                     GstQuery * query);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_PARSE_INDEX_H__ */
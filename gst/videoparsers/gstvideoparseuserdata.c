@@ -0,0 +1,197 @@
+/* GStreamer video parsers SEI user data and time codes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstvideoparseuserdata.h"
+
+GST_DEBUG_CATEGORY_STATIC (video_parse_user_data_debug);
+#define GST_CAT_DEFAULT video_parse_user_data_debug
+
+typedef struct
+{
+  GstSEIUserDataType type;
+  guint8 country_code;
+  guint8 country_code_extension;
+  guint8 uuid[16];
+  guint8 *data;
+  gsize size;
+} GstVideoParseUserDataMessage;
+
+typedef struct
+{
+  GstVideoTimeCodeFlags flags;
+  guint hours, minutes, seconds, frames;
+  guint field_count;
+} GstVideoParseTimeCode;
+
+struct _GstVideoParseUserData
+{
+  GArray *messages;             /* GstVideoParseUserDataMessage */
+  GArray *time_codes;           /* GstVideoParseTimeCode */
+};
+
+static void
+gst_video_parse_user_data_message_clear (GstVideoParseUserDataMessage * msg)
+{
+  g_free (msg->data);
+}
+
+GstVideoParseUserData *
+gst_video_parse_user_data_new (void)
+{
+  GstVideoParseUserData *user_data;
+
+  GST_DEBUG_CATEGORY_INIT (video_parse_user_data_debug, "videoparseuserdata",
+      0, "video parsers SEI user data");
+
+  user_data = g_slice_new (GstVideoParseUserData);
+  user_data->messages = g_array_new (FALSE, FALSE,
+      sizeof (GstVideoParseUserDataMessage));
+  g_array_set_clear_func (user_data->messages,
+      (GDestroyNotify) gst_video_parse_user_data_message_clear);
+  user_data->time_codes = g_array_new (FALSE, FALSE,
+      sizeof (GstVideoParseTimeCode));
+
+  return user_data;
+}
+
+void
+gst_video_parse_user_data_free (GstVideoParseUserData * user_data)
+{
+  g_array_free (user_data->messages, TRUE);
+  g_array_free (user_data->time_codes, TRUE);
+  g_slice_free (GstVideoParseUserData, user_data);
+}
+
+/* To be called whenever the access unit being parsed is dropped or
+ * pushed */
+void
+gst_video_parse_user_data_clear (GstVideoParseUserData * user_data)
+{
+  g_array_set_size (user_data->messages, 0);
+  g_array_set_size (user_data->time_codes, 0);
+}
+
+void
+gst_video_parse_user_data_add_registered (GstVideoParseUserData * user_data,
+    guint8 country_code, guint8 country_code_extension, const guint8 * data,
+    gsize size)
+{
+  GstVideoParseUserDataMessage msg = { GST_SEI_USER_DATA_REGISTERED, };
+
+  msg.country_code = country_code;
+  msg.country_code_extension = country_code_extension;
+  msg.data = g_memdup (data, size);
+  msg.size = size;
+  g_array_append_val (user_data->messages, msg);
+
+  GST_LOG ("registered user data, country code 0x%02x, %" G_GSIZE_FORMAT
+      " bytes", country_code, size);
+}
+
+void
+gst_video_parse_user_data_add_unregistered (GstVideoParseUserData *
+    user_data, const guint8 uuid[16], const guint8 * data, gsize size)
+{
+  GstVideoParseUserDataMessage msg = { GST_SEI_USER_DATA_UNREGISTERED, };
+
+  memcpy (msg.uuid, uuid, sizeof (msg.uuid));
+  msg.data = g_memdup (data, size);
+  msg.size = size;
+  g_array_append_val (user_data->messages, msg);
+
+  GST_LOG ("unregistered user data, %" G_GSIZE_FORMAT " bytes", size);
+}
+
+void
+gst_video_parse_user_data_add_time_code (GstVideoParseUserData * user_data,
+    GstVideoTimeCodeFlags flags, guint hours, guint minutes, guint seconds,
+    guint frames, guint field_count)
+{
+  GstVideoParseTimeCode tc;
+
+  tc.flags = flags;
+  tc.hours = hours;
+  tc.minutes = minutes;
+  tc.seconds = seconds;
+  tc.frames = frames;
+  tc.field_count = field_count;
+  g_array_append_val (user_data->time_codes, tc);
+
+  GST_LOG ("time code %02u:%02u:%02u:%02u, field %u", hours, minutes,
+      seconds, frames, field_count);
+}
+
+gboolean
+gst_video_parse_user_data_is_empty (GstVideoParseUserData * user_data)
+{
+  return user_data->messages->len == 0 && user_data->time_codes->len == 0;
+}
+
+/* Adds the pending user data and time codes as metas to the buffer of
+ * @frame and clears them. To be called from pre_push_frame. Time codes are
+ * dropped if the framerate is unknown */
+void
+gst_video_parse_user_data_attach (GstVideoParseUserData * user_data,
+    GstBaseParseFrame * frame, gint fps_num, gint fps_den)
+{
+  GstBuffer *buffer;
+  guint i;
+
+  if (gst_video_parse_user_data_is_empty (user_data))
+    return;
+
+  if (frame->out_buffer) {
+    buffer = frame->out_buffer = gst_buffer_make_writable (frame->out_buffer);
+  } else {
+    buffer = frame->buffer = gst_buffer_make_writable (frame->buffer);
+  }
+
+  for (i = 0; i < user_data->messages->len; i++) {
+    GstVideoParseUserDataMessage *msg =
+        &g_array_index (user_data->messages, GstVideoParseUserDataMessage, i);
+
+    if (msg->type == GST_SEI_USER_DATA_REGISTERED)
+      gst_buffer_add_sei_registered_user_data_meta (buffer, msg->country_code,
+          msg->country_code_extension, msg->data, msg->size);
+    else
+      gst_buffer_add_sei_unregistered_user_data_meta (buffer, msg->uuid,
+          msg->data, msg->size);
+  }
+
+  if (fps_num > 0 && fps_den > 0) {
+    for (i = 0; i < user_data->time_codes->len; i++) {
+      GstVideoParseTimeCode *tc =
+          &g_array_index (user_data->time_codes, GstVideoParseTimeCode, i);
+
+      gst_buffer_add_video_time_code_meta_full (buffer, fps_num, fps_den,
+          NULL, tc->flags, tc->hours, tc->minutes, tc->seconds, tc->frames,
+          tc->field_count);
+    }
+  } else if (user_data->time_codes->len > 0) {
+    GST_DEBUG ("dropping %u time codes, framerate unknown",
+        user_data->time_codes->len);
+  }
+
+  gst_video_parse_user_data_clear (user_data);
+}
@@ -0,0 +1,67 @@
+/* GStreamer video parsers SEI user data and time codes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_PARSE_USER_DATA_H__
+#define __GST_VIDEO_PARSE_USER_DATA_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+#include <gst/video/video.h>
+#include <gst/codecparsers/gstseiuserdatameta.h>
+
+G_BEGIN_DECLS
+
+/* User data SEI messages and time codes found in the access unit being
+ * parsed, waiting to be attached as metas to its buffer */
+typedef struct _GstVideoParseUserData GstVideoParseUserData;
+
+GstVideoParseUserData * gst_video_parse_user_data_new (void);
+
+void     gst_video_parse_user_data_free (GstVideoParseUserData * user_data);
+
+void     gst_video_parse_user_data_clear (GstVideoParseUserData * user_data);
+
+void     gst_video_parse_user_data_add_registered (GstVideoParseUserData * user_data,
+                                                   guint8 country_code,
+                                                   guint8 country_code_extension,
+                                                   const guint8 * data,
+                                                   gsize size);
+
+void     gst_video_parse_user_data_add_unregistered (GstVideoParseUserData * user_data,
+                                                     const guint8 uuid[16],
+                                                     const guint8 * data,
+                                                     gsize size);
+
+void     gst_video_parse_user_data_add_time_code (GstVideoParseUserData * user_data,
+                                                  GstVideoTimeCodeFlags flags,
+                                                  guint hours,
+                                                  guint minutes,
+                                                  guint seconds,
+                                                  guint frames,
+                                                  guint field_count);
+
+gboolean gst_video_parse_user_data_is_empty (GstVideoParseUserData * user_data);
+
+void     gst_video_parse_user_data_attach (GstVideoParseUserData * user_data,
+                                           GstBaseParseFrame * frame,
+                                           gint fps_num,
+                                           gint fps_den);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_PARSE_USER_DATA_H__ */
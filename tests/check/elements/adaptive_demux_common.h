@@ -115,6 +115,10 @@ typedef struct _GstAdaptiveDemuxTestCase
   GstEvent *seek_event;
   gboolean seeked;
 
+  /* properties to set on the demuxer before starting the seek test
+   * (optional), the structure name is ignored */
+  GstStructure *demux_properties;
+
   gpointer signal_context;
 } GstAdaptiveDemuxTestCase;
 
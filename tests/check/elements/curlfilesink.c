@@ -6,6 +6,8 @@
 #include <glib/gstdio.h>
 #include <curl/curl.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -334,6 +336,163 @@ GST_START_TEST (test_two_files)
 
 GST_END_TEST;
 
+GST_START_TEST (test_queued_files)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GstStructure *stats;
+  const gchar *location = "file:///tmp/";
+  gchar *file_name1 = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  gchar *file_name2 = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  const gchar *file_line1 = "line 1\r\n";
+  const gchar *file_line2 = "line 2\r\n";
+  const gchar *file_line3 = "line 3\r\n";
+  const gchar *expected_file_content1 = "line 1\r\n" "line 2\r\n";
+  const gchar *expected_file_content2 = "line 3\r\n" "line 1\r\n";
+  guint64 bytes_sent = 0;
+  guint64 buffers_sent = 0;
+  guint64 buffers_dropped = 0;
+
+  sink = setup_curlfilesink ();
+
+  g_object_set (G_OBJECT (sink), "location", location, NULL);
+  g_object_set (G_OBJECT (sink), "file-name", file_name1, NULL);
+  /* room for two lines, the transfer thread keeps up with that when
+   * writing to a local file */
+  g_object_set (G_OBJECT (sink), "max-queue-bytes", 16, NULL);
+
+  /* start playing */
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  /* the file name change is queued along with the buffers, so the buffers
+   * pushed before it end up in the first file even if still queued */
+  test_set_and_play_buffer (file_line1);
+  test_set_and_play_buffer (file_line2);
+  g_object_set (G_OBJECT (sink), "file-name", file_name2, NULL);
+  test_set_and_play_buffer (file_line3);
+  test_set_and_play_buffer (file_line1);
+
+  /* eos sends whatever is still queued */
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "bytes-sent", &bytes_sent));
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-sent",
+          &buffers_sent));
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-dropped",
+          &buffers_dropped));
+  fail_unless_equals_uint64 (bytes_sent, 4 * strlen (file_line1));
+  fail_unless_equals_uint64 (buffers_sent, 4);
+  fail_unless_equals_uint64 (buffers_dropped, 0);
+  gst_structure_free (stats);
+
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_caps_unref (caps);
+  cleanup_curlfilesink (sink);
+
+  /* verify file contents */
+  test_verify_file_data ("/tmp", file_name1, expected_file_content1);
+  test_verify_file_data ("/tmp", file_name2, expected_file_content2);
+}
+
+GST_END_TEST;
+
+static guint
+get_queued_bytes (GstElement * sink)
+{
+  GstStructure *stats;
+  guint queued_bytes = 0;
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "queued-bytes", &queued_bytes));
+  gst_structure_free (stats);
+
+  return queued_bytes;
+}
+
+/* Uploads into a fifo that nobody reads from yet. The transfer thread takes
+ * the first buffer and then blocks opening the fifo, so the following
+ * buffers stay in the queue until the fifo is opened for reading. */
+static void
+test_leaky_queue (const gchar * leaky, const gchar * expected_file_content)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  GstStructure *stats;
+  gchar *file_name = g_strdup_printf ("curlfilesink_%d", g_random_int ());
+  gchar *path = g_build_filename ("/tmp", file_name, NULL);
+  gchar res_file_content[64];
+  guint64 buffers_dropped = 0;
+  gssize len;
+  gint fd;
+
+  fail_unless (mkfifo (path, 0600) == 0);
+
+  sink = setup_curlfilesink ();
+
+  g_object_set (G_OBJECT (sink), "location", "file:///tmp/", NULL);
+  g_object_set (G_OBJECT (sink), "file-name", file_name, NULL);
+  /* room for two lines */
+  g_object_set (G_OBJECT (sink), "max-queue-bytes", 16, NULL);
+  gst_util_set_object_arg (G_OBJECT (sink), "leaky", leaky);
+
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+  caps = gst_caps_from_string ("application/x-gst-check");
+  gst_check_setup_events (srcpad, sink, caps, GST_FORMAT_BYTES);
+
+  test_set_and_play_buffer ("line 1\r\n");
+  while (get_queued_bytes (sink) > 0)
+    g_usleep (G_USEC_PER_SEC / 100);
+
+  /* the queue is full after the third line, the fourth one makes it leak */
+  test_set_and_play_buffer ("line 2\r\n");
+  test_set_and_play_buffer ("line 3\r\n");
+  test_set_and_play_buffer ("line 4\r\n");
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-dropped",
+          &buffers_dropped));
+  fail_unless_equals_uint64 (buffers_dropped, 1);
+  gst_structure_free (stats);
+
+  /* let the transfer thread open the fifo and send what is queued */
+  fd = g_open (path, O_RDONLY | O_NONBLOCK, 0);
+  fail_unless (fd >= 0);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_eos ()));
+
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  len = read (fd, res_file_content, sizeof (res_file_content) - 1);
+  fail_unless (len >= 0);
+  res_file_content[len] = '\0';
+  fail_unless_equals_string (res_file_content, expected_file_content);
+  close (fd);
+
+  gst_caps_unref (caps);
+  cleanup_curlfilesink (sink);
+
+  g_unlink (path);
+  g_free (path);
+  g_free (file_name);
+}
+
+GST_START_TEST (test_leaky_upstream)
+{
+  test_leaky_queue ("upstream", "line 1\r\n" "line 2\r\n" "line 3\r\n");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_leaky_downstream)
+{
+  test_leaky_queue ("downstream", "line 1\r\n" "line 3\r\n" "line 4\r\n");
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_create_dirs)
 {
   GstElement *sink;
@@ -446,6 +605,9 @@ curlsink_suite (void)
   tcase_add_test (tc_chain, test_one_file);
   tcase_add_test (tc_chain, test_one_big_file);
   tcase_add_test (tc_chain, test_two_files);
+  tcase_add_test (tc_chain, test_queued_files);
+  tcase_add_test (tc_chain, test_leaky_upstream);
+  tcase_add_test (tc_chain, test_leaky_downstream);
   tcase_add_test (tc_chain, test_missing_path);
   tcase_add_test (tc_chain, test_create_dirs);
 
@@ -22,6 +22,7 @@
 #undef GST_CAT_DEFAULT
 
 #include <gst/check/gstcheck.h>
+#include <math.h>
 
 GST_DEBUG_CATEGORY (gst_dash_demux_debug);
 
@@ -2115,6 +2116,55 @@ GST_START_TEST (dash_mpdparser_adapt_repr_segmentTemplate_inherit)
 }
 
 GST_END_TEST;
+
+/*
+ * Test parsing SegmentTemplate availabilityTimeOffset, used for low-latency
+ * chunked delivery, with inheritance
+ */
+GST_START_TEST (dash_mpdparser_segmentTemplate_availabilityTimeOffset)
+{
+  GstPeriodNode *periodNode;
+  GstAdaptationSetNode *adaptationSet;
+  GstRepresentationNode *representation;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">"
+      "  <Period duration=\"PT0H5M0.000S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <SegmentTemplate availabilityTimeOffset=\"1.5\""
+      "                       initialization=\"init.mp4\"/>"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.m4s\" duration=\"2\"/>"
+      "      </Representation>"
+      "      <Representation id=\"2\" bandwidth=\"500000\">"
+      "        <SegmentTemplate availabilityTimeOffset=\"INF\""
+      "                         media=\"$Number$.m4s\" duration=\"2\"/>"
+      "  </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMpdClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  periodNode = (GstPeriodNode *) mpdclient->mpd_node->Periods->data;
+  adaptationSet = (GstAdaptationSetNode *) periodNode->AdaptationSets->data;
+  assert_equals_float (adaptationSet->SegmentTemplate->availabilityTimeOffset,
+      1.5);
+  representation = (GstRepresentationNode *)
+      adaptationSet->Representations->data;
+  assert_equals_float (representation->SegmentTemplate->availabilityTimeOffset,
+      1.5);
+  representation = (GstRepresentationNode *)
+      adaptationSet->Representations->next->data;
+  fail_unless (isinf (representation->SegmentTemplate->availabilityTimeOffset));
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test parsing Period AdaptationSet SegmentTemplate attributes with
  * inheritance
@@ -5834,6 +5884,8 @@ dash_suite (void)
       dash_mpdparser_period_adaptationSet_representationBase_framePacking);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_adapt_repr_segmentTemplate_inherit);
+  tcase_add_test (tc_simpleMPD,
+      dash_mpdparser_segmentTemplate_availabilityTimeOffset);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_period_adaptationSet_representationBase_audioChannelConfiguration);
   tcase_add_test (tc_simpleMPD,
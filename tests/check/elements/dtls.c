@@ -0,0 +1,259 @@
+/* GStreamer
+ *
+ * unit test for dtlsenc and dtlsdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#define N_MESSAGES 4096
+#define MESSAGE_SIZE 200
+#define BATCH_SIZE 16
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint keys;
+  guint received;
+  guint datagrams;
+  gboolean in_order;
+} LoopbackData;
+
+static LoopbackData data;
+
+static void
+on_key_received (GstElement * enc, gpointer user_data)
+{
+  g_mutex_lock (&data.lock);
+  data.keys++;
+  g_cond_broadcast (&data.cond);
+  g_mutex_unlock (&data.lock);
+}
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  g_mutex_lock (&data.lock);
+  if (map.size != MESSAGE_SIZE ||
+      GST_READ_UINT32_BE (map.data) != data.received)
+    data.in_order = FALSE;
+  data.received++;
+  g_cond_broadcast (&data.cond);
+  g_mutex_unlock (&data.lock);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static GstPadProbeReturn
+count_datagrams (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  guint n = 1;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    n = gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+
+  g_mutex_lock (&data.lock);
+  data.datagrams += n;
+  g_mutex_unlock (&data.lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstBuffer *
+create_message (guint seq)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, MESSAGE_SIZE, NULL);
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  memset (map.data, seq & 0xff, map.size);
+  GST_WRITE_UINT32_BE (map.data, seq);
+  gst_buffer_unmap (buffer, &map);
+
+  return buffer;
+}
+
+/* Sends N_MESSAGES from a client dtlsenc to a server dtlsdec, with the
+ * handshake going over a second encoder/decoder pair the other way round */
+static void
+run_loopback (gint max_datagram_size, gboolean use_lists)
+{
+  static guint run = 0;
+  GstElement *pipeline, *client_enc, *client_dec, *server_enc, *server_dec;
+  GstElement *sink;
+  GstPad *srcpad, *pad, *peer;
+  gchar *client_id, *server_id;
+  gint64 start, elapsed, end_time;
+  guint i, j;
+
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+  data.keys = 0;
+  data.received = 0;
+  data.datagrams = 0;
+  data.in_order = TRUE;
+
+  client_id = g_strdup_printf ("loopback-client-%u", run);
+  server_id = g_strdup_printf ("loopback-server-%u", run);
+  run++;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  client_dec = gst_check_setup_element ("dtlsdec");
+  g_object_set (client_dec, "connection-id", client_id, NULL);
+  server_dec = gst_check_setup_element ("dtlsdec");
+  g_object_set (server_dec, "connection-id", server_id, NULL);
+
+  client_enc = gst_check_setup_element ("dtlsenc");
+  g_object_set (client_enc, "connection-id", client_id, "is-client", TRUE,
+      "max-datagram-size", max_datagram_size, NULL);
+  server_enc = gst_check_setup_element ("dtlsenc");
+  g_object_set (server_enc, "connection-id", server_id, NULL);
+
+  sink = gst_check_setup_element ("fakesink");
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), client_enc, client_dec, server_enc,
+      server_dec, sink, NULL);
+  fail_unless (gst_element_link (client_enc, server_dec));
+  fail_unless (gst_element_link (server_enc, client_dec));
+
+  pad = gst_element_get_request_pad (server_dec, "src");
+  peer = gst_element_get_static_pad (sink, "sink");
+  fail_unless_equals_int (gst_pad_link (pad, peer), GST_PAD_LINK_OK);
+  gst_object_unref (peer);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (server_dec, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_datagrams, NULL, NULL);
+  gst_object_unref (pad);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_set_active (srcpad, TRUE);
+  pad = gst_element_get_request_pad (client_enc, "sink");
+  fail_unless_equals_int (gst_pad_link (srcpad, pad), GST_PAD_LINK_OK);
+  gst_object_unref (pad);
+
+  g_signal_connect (client_enc, "on-key-received",
+      G_CALLBACK (on_key_received), NULL);
+  g_signal_connect (server_enc, "on-key-received",
+      G_CALLBACK (on_key_received), NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), NULL);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&data.lock);
+  while (data.keys < 2)
+    fail_unless (g_cond_wait_until (&data.cond, &data.lock, end_time));
+  /* only count the datagrams carrying the messages */
+  data.datagrams = 0;
+  g_mutex_unlock (&data.lock);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_MESSAGES; i += BATCH_SIZE) {
+    if (use_lists) {
+      GstBufferList *list = gst_buffer_list_new_sized (BATCH_SIZE);
+
+      for (j = 0; j < BATCH_SIZE; j++)
+        gst_buffer_list_add (list, create_message (i + j));
+      fail_unless_equals_int (gst_pad_push_list (srcpad, list), GST_FLOW_OK);
+    } else {
+      for (j = 0; j < BATCH_SIZE; j++)
+        fail_unless_equals_int (gst_pad_push (srcpad, create_message (i + j)),
+            GST_FLOW_OK);
+    }
+  }
+
+  end_time = g_get_monotonic_time () + 30 * G_TIME_SPAN_SECOND;
+  g_mutex_lock (&data.lock);
+  while (data.received < N_MESSAGES)
+    fail_unless (g_cond_wait_until (&data.cond, &data.lock, end_time));
+  g_mutex_unlock (&data.lock);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  GST_INFO ("sent %u messages in %u datagrams in %" G_GINT64_FORMAT
+      " us, %" G_GINT64_FORMAT " messages/s", N_MESSAGES, data.datagrams,
+      elapsed, N_MESSAGES * G_USEC_PER_SEC / elapsed);
+
+  fail_unless (data.in_order);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  g_free (client_id);
+  g_free (server_id);
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+}
+
+GST_START_TEST (test_loopback)
+{
+  run_loopback (0, FALSE);
+
+  fail_unless (data.datagrams >= N_MESSAGES);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_loopback_list)
+{
+  run_loopback (0, TRUE);
+
+  fail_unless (data.datagrams >= N_MESSAGES);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_loopback_coalesce)
+{
+  run_loopback (1200, TRUE);
+
+  /* a few records fit into every datagram */
+  fail_unless (data.datagrams < N_MESSAGES / 2);
+}
+
+GST_END_TEST;
+
+static Suite *
+dtls_suite (void)
+{
+  Suite *s = suite_create ("dtls");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+  tcase_add_test (tc_chain, test_loopback);
+  tcase_add_test (tc_chain, test_loopback_list);
+  tcase_add_test (tc_chain, test_loopback_coalesce);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dtls);
@@ -401,6 +401,83 @@ GST_START_TEST (test_streamheader)
 
 GST_END_TEST;
 
+/* pushes @packet as several buffers of @chunk_size bytes */
+static GstFlowReturn
+gdpdepay_push_in_chunks (GstBuffer * packet, gsize chunk_size)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gsize size = gst_buffer_get_size (packet);
+  gsize offset;
+
+  for (offset = 0; offset < size && ret == GST_FLOW_OK; offset += chunk_size)
+    ret = gst_pad_push (mysrcpad, gst_buffer_copy_region (packet,
+            GST_BUFFER_COPY_MEMORY, offset, MIN (chunk_size, size - offset)));
+
+  return ret;
+}
+
+static void
+check_payload_crc (gboolean check_crc)
+{
+  GstElement *gdpdepay;
+  GstBuffer *buffer, *packet;
+  GstCaps *caps;
+
+  gdpdepay = setup_gdpdepay ();
+  g_object_set (gdpdepay, "check-crc", check_crc, NULL);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_new_empty_simple ("application/x-gdp");
+  gst_check_setup_events (mysrcpad, gdpdepay, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  packet = gst_dp_payload_caps (caps, GST_DP_HEADER_FLAG_CRC);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (gdpdepay_push_in_chunks (packet, 7), GST_FLOW_OK);
+  gst_buffer_unref (packet);
+
+  /* the payload spans many input buffers */
+  buffer = gst_buffer_new_and_alloc (1000);
+  gst_buffer_memset (buffer, 0, 0xab, 1000);
+  packet = gst_dp_payload_buffer (buffer, GST_DP_HEADER_FLAG_CRC);
+  gst_buffer_unref (buffer);
+  fail_unless_equals_int (gdpdepay_push_in_chunks (packet, 7), GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 1);
+
+  /* corrupt one byte of the payload */
+  gst_buffer_memset (packet, GST_DP_HEADER_LENGTH + 500, 0x00, 1);
+  if (check_crc) {
+    fail_unless_equals_int (gdpdepay_push_in_chunks (packet, 7),
+        GST_FLOW_ERROR);
+    fail_unless_equals_int (g_list_length (buffers), 1);
+  } else {
+    fail_unless_equals_int (gdpdepay_push_in_chunks (packet, 7),
+        GST_FLOW_OK);
+    fail_unless_equals_int (g_list_length (buffers), 2);
+  }
+  gst_buffer_unref (packet);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  cleanup_gdpdepay (gdpdepay);
+}
+
+GST_START_TEST (test_payload_crc)
+{
+  check_payload_crc (TRUE);
+  check_payload_crc (FALSE);
+}
+
+GST_END_TEST;
+
 static Suite *
 gdpdepay_suite (void)
 {
@@ -411,6 +488,7 @@ gdpdepay_suite (void)
   tcase_add_test (tc_chain, test_audio_per_byte);
   tcase_add_test (tc_chain, test_audio_in_one_buffer);
   tcase_add_test (tc_chain, test_streamheader);
+  tcase_add_test (tc_chain, test_payload_crc);
 
   return s;
 }
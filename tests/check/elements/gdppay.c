@@ -557,6 +557,70 @@ GST_START_TEST (test_crc)
 GST_END_TEST;
 
 
+/* the byte at a time CRC gst_dp_crc() used to be */
+static guint16
+reference_crc (const guint8 * data, gsize length)
+{
+  guint16 crc_register = CRC_INIT;
+
+  while (length-- > 0)
+    crc_register = (guint16) ((crc_register << 8) ^
+        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *data++]);
+
+  return 0xffff ^ crc_register;
+}
+
+GST_START_TEST (test_crc_slicing)
+{
+  guint8 data[300], joined[310];
+  GstBufferList *list;
+  GstMapInfo maps[3];
+  GstBuffer *buffer;
+  guint offset, length, i;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = g_random_int () & 0xff;
+
+  /* all the alignments and tail lengths */
+  for (offset = 0; offset < 8; offset++) {
+    for (length = 1; length < 256; length++) {
+      fail_unless_equals_int (gst_dp_crc (data + offset, length),
+          reference_crc (data + offset, length));
+    }
+  }
+
+  /* split over several memories */
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, gst_memory_new_wrapped (0, data, 300,
+          0, 13, NULL, NULL));
+  gst_buffer_append_memory (buffer, gst_memory_new_wrapped (0, data, 300,
+          13, 100, NULL, NULL));
+  gst_buffer_append_memory (buffer, gst_memory_new_wrapped (0, data, 300,
+          113, 187, NULL, NULL));
+
+  for (i = 0; i < 3; i++)
+    gst_memory_map (gst_buffer_peek_memory (buffer, i), &maps[i],
+        GST_MAP_READ);
+  fail_unless_equals_int (gst_dp_crc_from_memory_maps (maps, 3),
+      reference_crc (data, 300));
+  for (i = 0; i < 3; i++)
+    gst_memory_unmap (maps[i].memory, &maps[i]);
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, buffer);
+  gst_buffer_list_add (list, gst_buffer_new_wrapped (g_memdup (data, 50),
+          50));
+  memcpy (joined, data, 300);
+  memcpy (joined + 300, data, 10);
+  fail_unless_equals_int (gst_dp_crc_from_buffer_list (list, 310),
+      reference_crc (joined, 310));
+  fail_unless_equals_int (gst_dp_crc_from_buffer_list (list, 200),
+      reference_crc (data, 200));
+  gst_buffer_list_unref (list);
+}
+
+GST_END_TEST;
+
 static Suite *
 gdppay_suite (void)
 {
@@ -569,6 +633,7 @@ gdppay_suite (void)
   tcase_add_test (tc_chain, test_first_no_new_segment);
   tcase_add_test (tc_chain, test_streamheader);
   tcase_add_test (tc_chain, test_crc);
+  tcase_add_test (tc_chain, test_crc_slicing);
 
   return s;
 }
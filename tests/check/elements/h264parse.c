@@ -24,6 +24,9 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
+#include <gst/codecparsers/gstseiuserdatameta.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/x-h264, parsed=(boolean)false"
@@ -89,6 +92,13 @@ static guint8 h264_sei_buffering_period[] = {
   0x00, 0x00, 0x00, 0x01, 0x06, 0x00, 0x01, 0xc0
 };
 
+/* SEI registered user data, ATSC A/53 closed captions */
+static guint8 h264_sei_a53_cc[] = {
+  0x00, 0x00, 0x00, 0x01, 0x06, 0x04, 0x0d, 0xb5,
+  0x00, 0x31, 0x47, 0x41, 0x39, 0x34, 0x03, 0xc1,
+  0xff, 0xfc, 0x94, 0xae, 0x80
+};
+
 /* combines to this codec-data */
 static guint8 h264_avc_codec_data[] = {
   0x01, 0x4d, 0x40, 0x15, 0xff, 0xe1, 0x00, 0x17,
@@ -462,6 +472,193 @@ h264parse_packetized_suite (void)
   return s;
 }
 
+/* size of the slice data appended to the IDR frame for the conversion test */
+#define LARGE_SLICE_SIZE (256 * 1024)
+
+/* checks that converting byte-stream to AVC keeps the slice data in the
+ * input memory instead of copying it */
+GST_START_TEST (test_parse_bs_to_avc_no_copy)
+{
+  GstHarness *h;
+  GstBuffer *in_buf, *out_buf;
+  GstMapInfo map;
+  guint8 *data, *slice;
+  gsize size, idr_size, offset;
+  gboolean shared = FALSE;
+  guint i;
+
+  idr_size = sizeof (h264_idrframe) - 4 + LARGE_SLICE_SIZE;
+  size = sizeof (h264_sps) + sizeof (h264_pps) + 4 + idr_size;
+  data = g_malloc (size);
+  offset = 0;
+  memcpy (data + offset, h264_sps, sizeof (h264_sps));
+  offset += sizeof (h264_sps);
+  memcpy (data + offset, h264_pps, sizeof (h264_pps));
+  offset += sizeof (h264_pps);
+  memcpy (data + offset, h264_idrframe, sizeof (h264_idrframe));
+  offset += sizeof (h264_idrframe);
+  slice = data + offset;
+  memset (slice, 0xaa, LARGE_SLICE_SIZE);
+  in_buf = gst_buffer_new_wrapped (data, size);
+
+  h = gst_harness_new ("h264parse");
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format=(string)byte-stream");
+  gst_harness_set_sink_caps_str (h,
+      "video/x-h264, stream-format=(string)avc, alignment=(string)au");
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_ref (in_buf)),
+      GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  out_buf = gst_harness_pull (h);
+  fail_unless (out_buf != NULL);
+
+  /* the IDR NAL is last, with its length instead of a start code */
+  gst_buffer_map (out_buf, &map, GST_MAP_READ);
+  fail_unless (map.size >= idr_size + 4);
+  fail_unless_equals_int (GST_READ_UINT32_BE (map.data + map.size - idr_size -
+          4), idr_size);
+  fail_unless (memcmp (map.data + map.size - idr_size, h264_idrframe + 4,
+          sizeof (h264_idrframe) - 4) == 0);
+  gst_buffer_unmap (out_buf, &map);
+
+  for (i = 0; i < gst_buffer_n_memory (out_buf); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (out_buf, i);
+
+    gst_memory_map (mem, &map, GST_MAP_READ);
+    if (map.data <= slice && map.data + map.size >= slice + LARGE_SLICE_SIZE)
+      shared = TRUE;
+    gst_memory_unmap (mem, &map);
+  }
+  fail_unless (shared, "slice data was copied");
+
+  gst_buffer_unref (out_buf);
+  gst_buffer_unref (in_buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* checks that keyframes are written to the index file when stopping */
+GST_START_TEST (test_parse_build_index)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  gchar *location, *contents, *expected;
+  gsize frame_size;
+  guint8 *data;
+  gint fd, i;
+
+  fd = g_file_open_tmp ("h264parse-index-XXXXXX", &location, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+  g_unlink (location);
+
+  frame_size = sizeof (h264_sps) + sizeof (h264_pps) + sizeof (h264_idrframe);
+
+  h = gst_harness_new ("h264parse");
+  g_object_set (h->element, "build-index", TRUE, "index-location", location,
+      NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format=(string)byte-stream, "
+      "alignment=(string)au");
+  gst_harness_set_sink_caps_str (h,
+      "video/x-h264, stream-format=(string)byte-stream, "
+      "alignment=(string)au");
+
+  for (i = 0; i < 2; i++) {
+    data = g_malloc (frame_size);
+    memcpy (data, h264_sps, sizeof (h264_sps));
+    memcpy (data + sizeof (h264_sps), h264_pps, sizeof (h264_pps));
+    memcpy (data + sizeof (h264_sps) + sizeof (h264_pps), h264_idrframe,
+        sizeof (h264_idrframe));
+    buf = gst_buffer_new_wrapped (data, frame_size);
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  gst_harness_teardown (h);
+
+  fail_unless (g_file_get_contents (location, &contents, NULL, NULL));
+  expected = g_strdup_printf ("# GStreamer video parser keyframe index v1\n"
+      "0 0\n%" G_GSIZE_FORMAT " %" G_GUINT64_FORMAT "\n", frame_size,
+      (guint64) (40 * GST_MSECOND));
+  fail_unless_equals_string (contents, expected);
+
+  g_free (expected);
+  g_free (contents);
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+/* checks that user data SEI messages are attached to their access unit in
+ * SEI only mode */
+GST_START_TEST (test_parse_sei_user_data)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstSEIUserDataMeta *meta;
+  gsize offset, size;
+  guint8 *data;
+
+  size = sizeof (h264_sps) + sizeof (h264_pps) + sizeof (h264_sei_a53_cc) +
+      sizeof (h264_idrframe);
+  data = g_malloc (size);
+  offset = 0;
+  memcpy (data + offset, h264_sps, sizeof (h264_sps));
+  offset += sizeof (h264_sps);
+  memcpy (data + offset, h264_pps, sizeof (h264_pps));
+  offset += sizeof (h264_pps);
+  memcpy (data + offset, h264_sei_a53_cc, sizeof (h264_sei_a53_cc));
+  offset += sizeof (h264_sei_a53_cc);
+  memcpy (data + offset, h264_idrframe, sizeof (h264_idrframe));
+
+  h = gst_harness_new ("h264parse");
+  g_object_set (h->element, "sei-only", TRUE, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264, stream-format=(string)byte-stream, "
+      "alignment=(string)au");
+  gst_harness_set_sink_caps_str (h,
+      "video/x-h264, stream-format=(string)byte-stream, "
+      "alignment=(string)au");
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new_wrapped (data,
+              size)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+
+  meta = gst_buffer_get_sei_user_data_meta (buf);
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->type, GST_SEI_USER_DATA_REGISTERED);
+  fail_unless_equals_int (meta->country_code, 0xb5);
+  fail_unless_equals_int (meta->size, 12);
+  fail_unless (memcmp (meta->data, h264_sei_a53_cc + 8, 12) == 0);
+
+  gst_buffer_unref (buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264parse_conversion_suite (void)
+{
+  Suite *s = suite_create (ctx_suite);
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_bs_to_avc_no_copy);
+  tcase_add_test (tc_chain, test_parse_build_index);
+  tcase_add_test (tc_chain, test_parse_sei_user_data);
+
+  return s;
+}
 
 /*
  * TODO:
@@ -560,5 +757,9 @@ main (int argc, char **argv)
   s = h264parse_packetized_suite ();
   nf += gst_check_run_suite (s, ctx_suite, __FILE__ "_packetized.c");
 
+  ctx_suite = "h264parse_conversion";
+  s = h264parse_conversion_suite ();
+  nf += gst_check_run_suite (s, ctx_suite, __FILE__ "_conversion.c");
+
   return nf;
 }
@@ -0,0 +1,178 @@
+/*
+ * GStreamer
+ *
+ * unit test for h265parse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <gst/codecparsers/gstseiuserdatameta.h>
+
+#define BYTE_STREAM_CAPS "video/x-h265, stream-format=(string)byte-stream, " \
+    "alignment=(string)au"
+
+/* 1280x720 Main profile, 30000/1001 fps */
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x5d, 0x95, 0x98, 0x09
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5d, 0xa0, 0x02,
+  0x80, 0x80, 0x2d, 0x16, 0x59, 0x59, 0xa4, 0x93, 0x2b, 0xc0, 0x5a, 0x70,
+  0x80, 0x00, 0x01, 0xf4, 0x80, 0x00, 0x3a, 0x98, 0x04
+};
+
+static const guint8 h265_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x72, 0xb4, 0x62, 0x40
+};
+
+/* prefix SEI time code 01:02:03:04, one clock timestamp */
+static const guint8 h265_sei_time_code[] = {
+  0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x88, 0x06, 0x60, 0x40, 0x20, 0x61,
+  0x04, 0x10, 0x80
+};
+
+/* prefix SEI registered user data, ATSC A/53 closed captions */
+static const guint8 h265_sei_a53_cc[] = {
+  0x00, 0x00, 0x00, 0x01, 0x4e, 0x01, 0x04, 0x0d, 0xb5, 0x00, 0x31, 0x47,
+  0x41, 0x39, 0x34, 0x03, 0xc1, 0xff, 0xfc, 0x94, 0xae, 0x80
+};
+
+/* IDR_W_RADL, first slice of an I picture, followed by dummy slice data */
+static const guint8 h265_idr_slice[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xac, 0xf0, 0xaf, 0x0b, 0x2c, 0x55,
+  0x99, 0x12, 0x7e, 0x48
+};
+
+/* Pushes the parameter sets, @sei and an IDR slice as one access unit
+ * and returns the output buffer */
+static GstBuffer *
+parse_access_unit (GstHarness * h, const guint8 * sei, gsize sei_size)
+{
+  GstBuffer *buf;
+  gsize offset, size;
+  guint8 *data;
+
+  size = sizeof (h265_vps) + sizeof (h265_sps) + sizeof (h265_pps) +
+      sei_size + sizeof (h265_idr_slice);
+  data = g_malloc (size);
+  offset = 0;
+  memcpy (data + offset, h265_vps, sizeof (h265_vps));
+  offset += sizeof (h265_vps);
+  memcpy (data + offset, h265_sps, sizeof (h265_sps));
+  offset += sizeof (h265_sps);
+  memcpy (data + offset, h265_pps, sizeof (h265_pps));
+  offset += sizeof (h265_pps);
+  memcpy (data + offset, sei, sei_size);
+  offset += sei_size;
+  memcpy (data + offset, h265_idr_slice, sizeof (h265_idr_slice));
+
+  gst_harness_set_src_caps_str (h, BYTE_STREAM_CAPS);
+  gst_harness_set_sink_caps_str (h, BYTE_STREAM_CAPS);
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new_wrapped (data,
+              size)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+
+  return buf;
+}
+
+/* checks that a time code SEI message ends up in a time code meta, using
+ * the framerate of the SPS */
+GST_START_TEST (test_parse_sei_time_code)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstVideoTimeCodeMeta *meta;
+
+  h = gst_harness_new ("h265parse");
+  buf = parse_access_unit (h, h265_sei_time_code,
+      sizeof (h265_sei_time_code));
+
+  meta = gst_buffer_get_video_time_code_meta (buf);
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->tc.config.fps_n, 30000);
+  fail_unless_equals_int (meta->tc.config.fps_d, 1001);
+  fail_unless_equals_int (meta->tc.config.flags,
+      GST_VIDEO_TIME_CODE_FLAGS_NONE);
+  fail_unless_equals_int (meta->tc.hours, 1);
+  fail_unless_equals_int (meta->tc.minutes, 2);
+  fail_unless_equals_int (meta->tc.seconds, 3);
+  fail_unless_equals_int (meta->tc.frames, 4);
+  fail_unless_equals_int (meta->tc.field_count, 0);
+
+  fail_unless (gst_buffer_get_sei_user_data_meta (buf) == NULL);
+
+  gst_buffer_unref (buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* checks that user data SEI messages are attached to their access unit,
+ * with and without SEI only mode */
+GST_START_TEST (test_parse_sei_user_data)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  GstSEIUserDataMeta *meta;
+  gboolean sei_only;
+
+  for (sei_only = FALSE; sei_only <= TRUE; sei_only++) {
+    h = gst_harness_new ("h265parse");
+    g_object_set (h->element, "sei-only", sei_only, NULL);
+    buf = parse_access_unit (h, h265_sei_a53_cc, sizeof (h265_sei_a53_cc));
+
+    meta = gst_buffer_get_sei_user_data_meta (buf);
+    fail_unless (meta != NULL);
+    fail_unless_equals_int (meta->type, GST_SEI_USER_DATA_REGISTERED);
+    fail_unless_equals_int (meta->country_code, 0xb5);
+    fail_unless_equals_int (meta->size, 12);
+    fail_unless (memcmp (meta->data, h265_sei_a53_cc + 9, 12) == 0);
+
+    fail_unless (gst_buffer_get_video_time_code_meta (buf) == NULL);
+
+    gst_buffer_unref (buf);
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parse_suite (void)
+{
+  Suite *s = suite_create ("h265parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_parse_sei_time_code);
+  tcase_add_test (tc_chain, test_parse_sei_user_data);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parse);
@@ -18,9 +18,22 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <gst/check/gstcheck.h>
 #include "adaptive_demux_common.h"
 
+#if defined(HAVE_OPENSSL)
+#include <openssl/evp.h>
+#elif defined(HAVE_NETTLE)
+#include <nettle/aes.h>
+#include <nettle/cbc.h>
+#else
+#include <gcrypt.h>
+#endif
+
 #define DEMUX_ELEMENT_NAME "hlsdemux"
 
 #define TS_PACKET_LEN 188
@@ -255,6 +268,119 @@ gst_hlsdemux_test_network_error_src_create (GstTestHTTPSrc * src,
       user_data);
 }
 
+#define CHUNK_SIZE (50 * TS_PACKET_LEN)
+#define CHUNK_INTERVAL (100 * GST_MSECOND)
+
+/* Emulates a server delivering a segment with chunked transfer encoding
+ * while it is being encoded: each chunk only becomes available
+ * CHUNK_INTERVAL after the previous one */
+static GstFlowReturn
+gst_hlsdemux_test_chunked_src_create (GstTestHTTPSrc * src,
+    guint64 offset,
+    guint length, GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstHlsDemuxTestInputData *input = (GstHlsDemuxTestInputData *) context;
+
+  if (g_str_has_suffix (input->uri, ".ts") && offset > 0
+      && (offset % CHUNK_SIZE) == 0)
+    g_usleep (GST_TIME_AS_USECONDS (CHUNK_INTERVAL));
+
+  return gst_hlsdemux_test_src_create (src, offset, length, retbuf, context,
+      user_data);
+}
+
+static guint64 chunked_fragment_bitrate;
+
+static void
+chunked_statistics_message (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  const GstStructure *s = gst_message_get_structure (msg);
+
+  if (gst_structure_has_name (s, "adaptive-streaming-statistics")) {
+    GstClockTime download_time;
+
+    fail_unless (gst_structure_get_clock_time (s, "fragment-download-time",
+            &download_time));
+    fail_unless (gst_structure_get_uint64 (s, "fragment-bitrate",
+            &chunked_fragment_bitrate));
+    /* the waits between chunks are at least 300ms */
+    fail_unless (download_time >= 3 * CHUNK_INTERVAL);
+  }
+}
+
+static void
+setup_low_latency (GstAdaptiveDemuxTestEngine * engine, gpointer user_data)
+{
+  GstBus *bus;
+
+  g_object_set (engine->demux, "low-latency", TRUE, NULL);
+
+  /* synchronously, as the main loop is stopped as soon as EOS is received */
+  bus = gst_pipeline_get_bus (GST_PIPELINE (engine->pipeline));
+  gst_bus_enable_sync_message_emission (bus);
+  g_signal_connect (bus, "sync-message::element",
+      G_CALLBACK (chunked_statistics_message), NULL);
+  gst_object_unref (bus);
+}
+
+/* Applies PKCS7 padding and encrypts @data with AES-128-CBC, the way an
+ * HLS server would encrypt a media segment */
+static GByteArray *
+encrypt_segment (const guint8 * key, const guint8 * iv, const guint8 * data,
+    guint length)
+{
+  GByteArray *encrypted;
+  guint8 *padded;
+  guint padded_length, pad;
+
+  pad = 16 - (length % 16);
+  padded_length = length + pad;
+  padded = g_malloc (padded_length);
+  memcpy (padded, data, length);
+  memset (padded + length, pad, pad);
+
+  encrypted = g_byte_array_sized_new (padded_length);
+  g_byte_array_set_size (encrypted, padded_length);
+
+#if defined(HAVE_OPENSSL)
+  {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new ();
+    int len = 0;
+
+    fail_unless (EVP_EncryptInit_ex (ctx, EVP_aes_128_cbc (), NULL, key, iv));
+    EVP_CIPHER_CTX_set_padding (ctx, 0);
+    fail_unless (EVP_EncryptUpdate (ctx, encrypted->data, &len, padded,
+            padded_length));
+    fail_unless_equals_int (len, padded_length);
+    EVP_CIPHER_CTX_free (ctx);
+  }
+#elif defined(HAVE_NETTLE)
+  {
+    struct CBC_CTX (struct aes_ctx, AES_BLOCK_SIZE) ctx;
+
+    aes_set_encrypt_key (&ctx.ctx, 16, key);
+    CBC_SET_IV (&ctx, iv);
+    CBC_ENCRYPT (&ctx, aes_encrypt, padded_length, encrypted->data, padded);
+  }
+#else
+  {
+    gcry_cipher_hd_t hd;
+
+    fail_if (gcry_cipher_open (&hd, GCRY_CIPHER_AES128, GCRY_CIPHER_MODE_CBC,
+            0));
+    fail_if (gcry_cipher_setkey (hd, key, 16));
+    fail_if (gcry_cipher_setiv (hd, iv, 16));
+    fail_if (gcry_cipher_encrypt (hd, encrypted->data, padded_length, padded,
+            padded_length));
+    gcry_cipher_close (hd);
+  }
+#endif
+
+  g_free (padded);
+
+  return encrypted;
+}
+
 /******************** Test specific code starts here **************************/
 
 /*
@@ -532,6 +658,72 @@ GST_START_TEST (testReverseSeekSnapAfterPosition)
 
 GST_END_TEST;
 
+/*
+ * Test seeking back with the fragment cache enabled. The seek happens while
+ * the second fragment is being downloaded, the first fragment must then be
+ * served from the cache instead of being downloaded again
+ *
+ */
+GST_START_TEST (testSeekBackFragmentCache)
+{
+  const guint segment_size = 60 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 2 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  GstTestHTTPSrcCallbacks http_src_callbacks = { 0 };
+  GstAdaptiveDemuxTestCase *engineTestData;
+  GstHlsDemuxTestCase hlsTestCase = { 0 };
+  GByteArray *mpeg_ts = NULL;
+  const GValue *requests;
+  guint i, first_fragment_requests = 0;
+
+  engineTestData = gst_adaptive_demux_test_case_new ();
+  mpeg_ts = setup_test_variables (__FUNCTION__, inputTestData, outputTestData,
+      &hlsTestCase, engineTestData, segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+
+  /* seek back to the start while the second fragment is being downloaded */
+  engineTestData->threshold_for_seek = segment_size + 20 * TS_PACKET_LEN;
+  engineTestData->seek_event =
+      gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, GST_SEEK_TYPE_SET, 0,
+      GST_SEEK_TYPE_NONE, 0);
+  engineTestData->demux_properties = gst_structure_new ("properties",
+      "fragment-cache-size", G_TYPE_UINT64, (guint64) 4 * segment_size, NULL);
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_seek (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 0; i < gst_value_array_get_size (requests); ++i) {
+    const GValue *uri = gst_value_array_get_value (requests, i);
+
+    if (g_strcmp0 (g_value_get_string (uri), inputTestData[1].uri) == 0)
+      first_fragment_requests++;
+  }
+  assert_equals_int (first_fragment_requests, 1);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static void
 testDownloadErrorMessageCallback (GstAdaptiveDemuxTestEngine * engine,
     GstMessage * msg, gpointer user_data)
@@ -724,6 +916,116 @@ GST_START_TEST (testFragmentDownloadError)
 
 GST_END_TEST;
 
+/*
+ * Test an AES-128 encrypted segment that is larger than what hlsdemux
+ * decrypts in one batch, so that both the threaded and the final
+ * synchronous decryption are used
+ *
+ */
+GST_START_TEST (testEncryptedSegment)
+{
+  const guint segment_size = 400 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXT-X-MEDIA-SEQUENCE:3\n"
+      "#EXT-X-KEY:METHOD=AES-128,URI=\"key.bin\"\n"
+      "#EXTINF:1,Test\n" "001.ts\n" "#EXT-X-ENDLIST\n";
+  const guint8 key[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+  };
+  /* without an explicit IV, the media sequence number is used */
+  const guint8 iv[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3 };
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/key.bin", key, sizeof (key)},
+    {"http://unit.test/001.ts", NULL, 0},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  GByteArray *encrypted;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  encrypted = encrypt_segment (key, iv, mpeg_ts->data, segment_size);
+  inputTestData[2].payload = encrypted->data;
+  inputTestData[2].size = encrypted->len;
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  g_byte_array_free (encrypted, TRUE);
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
+/*
+ * Test low-latency mode with a segment delivered in chunks with pauses
+ * in between. The bandwidth estimation must only account for the time
+ * spent transferring the chunks, not for the time spent waiting for the
+ * server to produce them
+ *
+ */
+GST_START_TEST (testLowLatencyChunkedSegment)
+{
+  const guint segment_size = 4 * CHUNK_SIZE;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  guint64 elapsed_bitrate;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  /* several buffers per chunk, so that there is some back-to-back transfer
+   * to measure */
+  gst_test_http_src_set_default_blocksize (10 * TS_PACKET_LEN);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_chunked_src_create;
+  engine_callbacks.pre_test = setup_low_latency;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  chunked_fragment_bitrate = 0;
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  /* bitrate the fragment would get if the pauses were counted */
+  elapsed_bitrate =
+      gst_util_uint64_scale (segment_size, 8 * GST_SECOND,
+      3 * CHUNK_INTERVAL);
+  fail_unless (chunked_fragment_bitrate > 4 * elapsed_bitrate,
+      "bitrate %" G_GUINT64_FORMAT " not above %" G_GUINT64_FORMAT,
+      chunked_fragment_bitrate, 4 * elapsed_bitrate);
+
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 static Suite *
 hls_demux_suite (void)
 {
@@ -735,6 +1037,8 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
+  tcase_add_test (tc_basicTest, testEncryptedSegment);
+  tcase_add_test (tc_basicTest, testLowLatencyChunkedSegment);
   tcase_add_test (tc_basicTest, testSeek);
   tcase_add_test (tc_basicTest, testSeekKeyUnitPosition);
   tcase_add_test (tc_basicTest, testSeekPosition);
@@ -743,6 +1047,7 @@ hls_demux_suite (void)
   tcase_add_test (tc_basicTest, testSeekSnapAfterPosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapBeforePosition);
   tcase_add_test (tc_basicTest, testReverseSeekSnapAfterPosition);
+  tcase_add_test (tc_basicTest, testSeekBackFragmentCache);
 
   tcase_add_unchecked_fixture (tc_basicTest, gst_adaptive_demux_test_setup,
       gst_adaptive_demux_test_teardown);
@@ -29,6 +29,7 @@
 #undef GST_CAT_DEFAULT
 #include "m3u8.h"
 #include "m3u8.c"
+#include "gstm3u8playlist.c"
 
 GST_DEBUG_CATEGORY (hls_debug);
 
@@ -539,6 +540,37 @@ GST_START_TEST (test_live_playlist)
 
 GST_END_TEST;
 
+/* Low-latency playback starts as close to the end of a live playlist as the
+ * requested distance allows */
+GST_START_TEST (test_live_playlist_start_distance)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+  assert_equals_int (pl->sequence, 2680);
+
+  gst_m3u8_set_live_start_distance (pl, 8 * GST_SECOND);
+  assert_equals_int (pl->sequence, 2683);
+  assert_equals_uint64 (pl->sequence_position, 24 * GST_SECOND);
+
+  gst_m3u8_set_live_start_distance (pl, 10 * GST_SECOND);
+  assert_equals_int (pl->sequence, 2682);
+  assert_equals_uint64 (pl->sequence_position, 16 * GST_SECOND);
+
+  gst_hls_master_playlist_unref (master);
+
+  /* the distance is also used when the playlist is first parsed */
+  pl = gst_m3u8_new ();
+  gst_m3u8_set_live_start_distance (pl, 1);
+  fail_unless (gst_m3u8_update (pl, g_strdup (LIVE_PLAYLIST)));
+  assert_equals_int (pl->sequence, 2683);
+  gst_m3u8_unref (pl);
+}
+
+GST_END_TEST;
+
 /* This test is for live sreams in which we pause the stream for more than the
  * DVR window and we resume playback. The playlist has rotated completely and
  * there is a jump in the media sequence that must be handled correctly. */
@@ -1395,6 +1427,60 @@ GST_START_TEST (test_stream_inf_tag)
 
 GST_END_TEST;
 
+/* Playlists written by hlssink with a sliding window are rendered
+ * incrementally, and must parse back as the same list of fragments */
+GST_START_TEST (test_playlist_writer_window)
+{
+  GstM3U8Playlist *writer;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file;
+  gchar *data;
+  guint i;
+
+  writer = gst_m3u8_playlist_new (3, 3, FALSE);
+  for (i = 0; i < 5; i++) {
+    gchar *url = g_strdup_printf ("segment%05u.ts", i);
+
+    fail_unless (gst_m3u8_playlist_add_entry (writer, url, NULL,
+            2 * GST_SECOND, i, i == 3));
+    g_free (url);
+  }
+
+  data = gst_m3u8_playlist_render (writer);
+  assert_equals_string (data, "#EXTM3U\n"
+      "#EXT-X-VERSION:3\n"
+      "#EXT-X-ALLOW-CACHE:NO\n"
+      "#EXT-X-MEDIA-SEQUENCE:2\n"
+      "#EXT-X-TARGETDURATION:2\n"
+      "\n"
+      "#EXTINF:2,\n"
+      "segment00002.ts\n"
+      "#EXT-X-DISCONTINUITY\n"
+      "#EXTINF:2,\n"
+      "segment00003.ts\n" "#EXTINF:2,\n" "segment00004.ts\n");
+  g_free (data);
+
+  writer->end_list = TRUE;
+  data = gst_m3u8_playlist_render (writer);
+  gst_m3u8_playlist_free (writer);
+
+  pl = gst_m3u8_new ();
+  gst_m3u8_set_uri (pl, "http://localhost/playlist.m3u8", NULL,
+      "playlist.m3u8");
+  fail_unless (gst_m3u8_update (pl, data));
+  assert_equals_int (gst_m3u8_is_live (pl), FALSE);
+  assert_equals_int (g_list_length (pl->files), 3);
+  file = GST_M3U8_MEDIA_FILE (g_list_first (pl->files)->data);
+  assert_equals_string (file->uri, "http://localhost/segment00002.ts");
+  assert_equals_int (file->sequence, 2);
+  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  assert_equals_int (file->discont, TRUE);
+  assert_equals_uint64 (gst_m3u8_get_duration (pl), 6 * GST_SECOND);
+  gst_m3u8_unref (pl);
+}
+
+GST_END_TEST;
+
 static Suite *
 hlsdemux_suite (void)
 {
@@ -1417,6 +1503,7 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_empty_lines_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist_rotated);
+  tcase_add_test (tc_m3u8, test_live_playlist_start_distance);
   tcase_add_test (tc_m3u8, test_playlist_with_doubles_duration);
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
@@ -1437,6 +1524,7 @@ hlsdemux_suite (void)
 #endif
   tcase_add_test (tc_m3u8, test_url_with_slash_query_param);
   tcase_add_test (tc_m3u8, test_stream_inf_tag);
+  tcase_add_test (tc_m3u8, test_playlist_writer_window);
   return s;
 }
 
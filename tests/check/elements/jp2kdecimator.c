@@ -0,0 +1,415 @@
+/* GStreamer
+ *
+ * unit test for jp2kdecimator
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+
+/* 64x64 image with 32x32 tiles, one component, two layers and one
+ * decomposition level. With the default precincts every tile has one
+ * packet per layer and resolution, in LRCP order */
+#define IMAGE_SIZE 64
+#define TILE_SIZE 32
+#define N_TILES 4
+#define N_LAYERS 2
+#define N_RESOLUTIONS 2
+#define N_PACKETS (N_LAYERS * N_RESOLUTIONS)
+
+#define SOP_SIZE 6
+/* SOT marker segment, including the marker */
+#define SOT_SIZE 12
+/* PLT marker segment with one byte per packet length */
+#define PLT_SIZE(n_packets) (2 + 2 + 1 + (n_packets))
+
+static guint
+packet_body_size (guint tile, guint packet)
+{
+  return 8 + tile + 3 * packet;
+}
+
+static guint8
+packet_body_byte (guint tile, guint packet, guint i)
+{
+  /* never 0xff, so no marker is found in the packet data */
+  return (0x10 * tile + packet + i) & 0x7f;
+}
+
+static void
+put_uint8 (GByteArray * data, guint8 v)
+{
+  g_byte_array_append (data, &v, 1);
+}
+
+static void
+put_uint16 (GByteArray * data, guint16 v)
+{
+  put_uint8 (data, v >> 8);
+  put_uint8 (data, v & 0xff);
+}
+
+static void
+put_uint32 (GByteArray * data, guint32 v)
+{
+  put_uint16 (data, v >> 16);
+  put_uint16 (data, v & 0xffff);
+}
+
+static guint
+input_tile_part_size (guint tile, gboolean plt)
+{
+  guint size = SOT_SIZE + 2;
+  guint p;
+
+  /* the packet lengths are split over two PLT segments */
+  if (plt)
+    size += 2 * PLT_SIZE (N_PACKETS / 2);
+
+  for (p = 0; p < N_PACKETS; p++)
+    size += SOP_SIZE + packet_body_size (tile, p);
+
+  return size;
+}
+
+/* Packets are delimited by SOP marker segments, and additionally indexed by
+ * PLT marker segments if @plt is set */
+static GstBuffer *
+create_codestream (gboolean tlm, gboolean plt)
+{
+  GByteArray *data = g_byte_array_new ();
+  guint t, p, i;
+  guint seqno = 0;
+  gsize size;
+
+  /* SOC */
+  put_uint16 (data, 0xff4f);
+
+  /* SIZ */
+  put_uint16 (data, 0xff51);
+  put_uint16 (data, 38 + 3);
+  put_uint16 (data, 0);
+  put_uint32 (data, IMAGE_SIZE);
+  put_uint32 (data, IMAGE_SIZE);
+  put_uint32 (data, 0);
+  put_uint32 (data, 0);
+  put_uint32 (data, TILE_SIZE);
+  put_uint32 (data, TILE_SIZE);
+  put_uint32 (data, 0);
+  put_uint32 (data, 0);
+  put_uint16 (data, 1);
+  put_uint8 (data, 7);
+  put_uint8 (data, 1);
+  put_uint8 (data, 1);
+
+  /* COD with SOP markers, LRCP, 64x64 code blocks, 5-3 wavelet */
+  put_uint16 (data, 0xff52);
+  put_uint16 (data, 12);
+  put_uint8 (data, 0x02);
+  put_uint8 (data, 0);
+  put_uint16 (data, N_LAYERS);
+  put_uint8 (data, 0);
+  put_uint8 (data, N_RESOLUTIONS - 1);
+  put_uint8 (data, 4);
+  put_uint8 (data, 4);
+  put_uint8 (data, 0);
+  put_uint8 (data, 1);
+
+  /* QCD without quantization, one exponent per subband */
+  put_uint16 (data, 0xff5c);
+  put_uint16 (data, 2 + 1 + 3 * (N_RESOLUTIONS - 1) + 1);
+  put_uint8 (data, 0x40);
+  for (i = 0; i < 3 * (N_RESOLUTIONS - 1) + 1; i++)
+    put_uint8 (data, 8 << 3);
+
+  /* TLM with 16 bit tile indices and 32 bit lengths */
+  if (tlm) {
+    put_uint16 (data, 0xff55);
+    put_uint16 (data, 2 + 2 + N_TILES * (2 + 4));
+    put_uint8 (data, 0);
+    put_uint8 (data, 0x60);
+    for (t = 0; t < N_TILES; t++) {
+      put_uint16 (data, t);
+      put_uint32 (data, input_tile_part_size (t, plt));
+    }
+  }
+
+  for (t = 0; t < N_TILES; t++) {
+    /* SOT */
+    put_uint16 (data, 0xff90);
+    put_uint16 (data, 10);
+    put_uint16 (data, t);
+    put_uint32 (data, input_tile_part_size (t, plt));
+    put_uint8 (data, 0);
+    put_uint8 (data, 1);
+
+    if (plt) {
+      for (i = 0; i < 2; i++) {
+        put_uint16 (data, 0xff58);
+        put_uint16 (data, PLT_SIZE (N_PACKETS / 2) - 2);
+        put_uint8 (data, i);
+        for (p = i * N_PACKETS / 2; p < (i + 1) * N_PACKETS / 2; p++)
+          put_uint8 (data, SOP_SIZE + packet_body_size (t, p));
+      }
+    }
+
+    /* SOD */
+    put_uint16 (data, 0xff93);
+
+    for (p = 0; p < N_PACKETS; p++) {
+      put_uint16 (data, 0xff91);
+      put_uint16 (data, 4);
+      put_uint16 (data, seqno++);
+      for (i = 0; i < packet_body_size (t, p); i++)
+        put_uint8 (data, packet_body_byte (t, p, i));
+    }
+  }
+
+  /* EOC */
+  put_uint16 (data, 0xffd9);
+
+  size = data->len;
+  return gst_buffer_new_wrapped (g_byte_array_free (data, FALSE), size);
+}
+
+static GstBuffer *
+decimate (GstBuffer * buf, guint n_threads)
+{
+  GstHarness *h = gst_harness_new ("jp2kdecimator");
+  GstBuffer *outbuf;
+
+  g_object_set (h->element, "max-layers", 1, "n-threads", n_threads, NULL);
+  gst_harness_set_src_caps_str (h, "image/x-jpc");
+
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (buf));
+  fail_unless (outbuf != NULL);
+
+  gst_harness_teardown (h);
+
+  return outbuf;
+}
+
+/* Only the packets of the first layer are kept, the others are replaced by
+ * an empty packet, which is a single zero byte after the SOP */
+static gboolean
+packet_is_kept (guint packet)
+{
+  return packet / N_RESOLUTIONS < 1;
+}
+
+static guint
+output_packet_size (guint tile, guint packet)
+{
+  return SOP_SIZE + (packet_is_kept (packet) ?
+      packet_body_size (tile, packet) : 1);
+}
+
+static guint
+output_tile_part_size (guint tile, gboolean plt)
+{
+  guint size = SOT_SIZE + 2;
+  guint p;
+
+  /* the decimated packet lengths go into a single PLT segment */
+  if (plt)
+    size += PLT_SIZE (N_PACKETS);
+
+  for (p = 0; p < N_PACKETS; p++)
+    size += output_packet_size (tile, p);
+
+  return size;
+}
+
+static void
+check_decimated_codestream (GstBuffer * buf, gboolean tlm, gboolean plt)
+{
+  GstMapInfo map;
+  const guint8 *data;
+  guint32 tlm_lengths[N_TILES];
+  gboolean have_tlm = FALSE;
+  guint t, p, i;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  data = map.data;
+
+  fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xff4f);
+  data += 2;
+
+  /* main header */
+  while (GST_READ_UINT16_BE (data) != 0xff90) {
+    guint16 marker = GST_READ_UINT16_BE (data);
+    guint16 length = GST_READ_UINT16_BE (data + 2);
+
+    fail_unless (data + 2 + length < map.data + map.size);
+
+    if (marker == 0xff55) {
+      fail_unless_equals_int (length, 2 + 2 + N_TILES * (2 + 4));
+      fail_unless_equals_int (data[5], 0x60);
+      for (t = 0; t < N_TILES; t++) {
+        fail_unless_equals_int (GST_READ_UINT16_BE (data + 6 + t * 6), t);
+        tlm_lengths[t] = GST_READ_UINT32_BE (data + 6 + t * 6 + 2);
+      }
+      have_tlm = TRUE;
+    }
+
+    data += 2 + length;
+  }
+  fail_unless_equals_int (have_tlm, tlm);
+
+  for (t = 0; t < N_TILES; t++) {
+    const guint8 *tile_part = data;
+    guint32 psot;
+
+    /* SOT */
+    fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xff90);
+    fail_unless_equals_int (GST_READ_UINT16_BE (data + 4), t);
+    psot = GST_READ_UINT32_BE (data + 6);
+    fail_unless_equals_int (psot, output_tile_part_size (t, plt));
+    if (tlm)
+      fail_unless_equals_int (tlm_lengths[t], psot);
+    data += SOT_SIZE;
+
+    if (plt) {
+      fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xff58);
+      fail_unless_equals_int (GST_READ_UINT16_BE (data + 2),
+          PLT_SIZE (N_PACKETS) - 2);
+      fail_unless_equals_int (data[4], 0);
+      for (p = 0; p < N_PACKETS; p++)
+        fail_unless_equals_int (data[5 + p], output_packet_size (t, p));
+      data += PLT_SIZE (N_PACKETS);
+    }
+
+    /* SOD */
+    fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xff93);
+    data += 2;
+
+    for (p = 0; p < N_PACKETS; p++) {
+      fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xff91);
+      fail_unless_equals_int (GST_READ_UINT16_BE (data + 4),
+          t * N_PACKETS + p);
+      data += SOP_SIZE;
+
+      if (packet_is_kept (p)) {
+        for (i = 0; i < packet_body_size (t, p); i++)
+          fail_unless_equals_int (data[i], packet_body_byte (t, p, i));
+        data += packet_body_size (t, p);
+      } else {
+        fail_unless_equals_int (data[0], 0);
+        data += 1;
+      }
+    }
+
+    fail_unless_equals_int (data - tile_part, psot);
+  }
+
+  fail_unless_equals_int (GST_READ_UINT16_BE (data), 0xffd9);
+  fail_unless_equals_int (data + 2 - map.data, map.size);
+
+  gst_buffer_unmap (buf, &map);
+}
+
+static void
+check_same_data (GstBuffer * buf, GstBuffer * expected)
+{
+  GstMapInfo map;
+
+  fail_unless_equals_int (gst_buffer_get_size (buf),
+      gst_buffer_get_size (expected));
+  fail_unless (gst_buffer_map (expected, &map, GST_MAP_READ));
+  fail_unless (gst_buffer_memcmp (buf, 0, map.data, map.size) == 0);
+  gst_buffer_unmap (expected, &map);
+}
+
+static void
+check_decimation (gboolean tlm, gboolean plt)
+{
+  GstBuffer *buf = create_codestream (tlm, plt);
+  GstBuffer *sequential, *parallel, *split, *written;
+  gsize half = gst_buffer_get_size (buf) / 2;
+
+  sequential = decimate (buf, 1);
+  parallel = decimate (buf, 4);
+
+  /* the kept packets of an input in a single memory are shared with the
+   * output, an input in several memories is written out completely */
+  split = gst_buffer_copy_region (buf, GST_BUFFER_COPY_MEMORY, 0, half);
+  split = gst_buffer_append_region (split, gst_buffer_ref (buf), half, -1);
+  fail_unless_equals_int (gst_buffer_n_memory (split), 2);
+  written = decimate (split, 1);
+
+  check_decimated_codestream (sequential, tlm, plt);
+
+  /* the tiles are decimated independently, so the result must not depend
+   * on the number of threads */
+  check_same_data (parallel, sequential);
+
+  /* sharing the packets must give the same codestream as writing it */
+  check_same_data (written, sequential);
+
+  gst_buffer_unref (sequential);
+  gst_buffer_unref (parallel);
+  gst_buffer_unref (written);
+  gst_buffer_unref (split);
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_decimate_tiles)
+{
+  check_decimation (FALSE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_decimate_tiles_tlm)
+{
+  check_decimation (TRUE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_decimate_tiles_plt)
+{
+  check_decimation (FALSE, TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_decimate_tiles_tlm_plt)
+{
+  check_decimation (TRUE, TRUE);
+}
+
+GST_END_TEST;
+
+static Suite *
+jp2kdecimator_suite (void)
+{
+  Suite *s = suite_create ("jp2kdecimator");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_decimate_tiles);
+  tcase_add_test (tc_chain, test_decimate_tiles_tlm);
+  tcase_add_test (tc_chain, test_decimate_tiles_plt);
+  tcase_add_test (tc_chain, test_decimate_tiles_tlm_plt);
+
+  return s;
+}
+
+GST_CHECK_MAIN (jp2kdecimator)
@@ -0,0 +1,331 @@
+/* GStreamer
+ *
+ * unit test for mpegpsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+/* One pack every 100ms, each with a single video PES packet whose PTS is
+ * the SCR of the pack. The first half of the stream has a much higher
+ * bitrate than the second half, so that interpolating offsets from SCRs
+ * misses and seeks need several steps to find a pack */
+#define N_PACKS 200
+#define SCR_BASE 90000
+#define SCR_STEP 9000
+#define PACK_SIZE(i) ((i) < N_PACKS / 2 ? 8000 : 500)
+#define PACK_HEADER_SIZE 14
+#define PES_HEADER_SIZE (6 + 3 + 5)
+
+static GstPad *mysrcpad, *mysinkpad, *demuxsrcpad;
+static GByteArray *ps_data;
+static GThread *seek_thread;
+static guint n_pulls;
+
+static GMutex lock;
+static GCond cond;
+static guint n_buffers;
+static gboolean flushing;
+static gboolean released;
+
+static GstStaticPadTemplate mysrctemplate =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/mpeg, mpegversion = (int) 2, "
+        "systemstream = (boolean) true"));
+
+static GstStaticPadTemplate mysinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void
+put_pack (GByteArray * data, guint64 scr, guint size)
+{
+  guint8 header[PACK_HEADER_SIZE + PES_HEADER_SIZE];
+  guint mux_rate = 2000;
+  guint payload = size - sizeof (header);
+  guint8 *pes = header + PACK_HEADER_SIZE;
+  guint len;
+
+  /* MPEG-2 pack header with a SCR extension of 0 and no stuffing */
+  GST_WRITE_UINT32_BE (header, 0x000001ba);
+  header[4] = 0x44 | ((scr >> 27) & 0x38) | ((scr >> 28) & 0x03);
+  header[5] = (scr >> 20) & 0xff;
+  header[6] = ((scr >> 12) & 0xf8) | 0x04 | ((scr >> 13) & 0x03);
+  header[7] = (scr >> 5) & 0xff;
+  header[8] = ((scr << 3) & 0xf8) | 0x04;
+  header[9] = 0x01;
+  header[10] = (mux_rate >> 14) & 0xff;
+  header[11] = (mux_rate >> 6) & 0xff;
+  header[12] = ((mux_rate << 2) & 0xfc) | 0x03;
+  header[13] = 0xf8;
+
+  /* video PES packet with a PTS */
+  GST_WRITE_UINT32_BE (pes, 0x000001e0);
+  GST_WRITE_UINT16_BE (pes + 4, 3 + 5 + payload);
+  pes[6] = 0x80;
+  pes[7] = 0x80;
+  pes[8] = 5;
+  pes[9] = 0x21 | ((scr >> 29) & 0x0e);
+  pes[10] = (scr >> 22) & 0xff;
+  pes[11] = ((scr >> 14) & 0xfe) | 0x01;
+  pes[12] = (scr >> 7) & 0xff;
+  pes[13] = ((scr << 1) & 0xfe) | 0x01;
+
+  g_byte_array_append (data, header, sizeof (header));
+  /* never contains a start code */
+  len = data->len;
+  g_byte_array_set_size (data, len + payload);
+  memset (data->data + len, 0xaa, payload);
+}
+
+static GByteArray *
+create_program_stream (void)
+{
+  GByteArray *data = g_byte_array_new ();
+  guint i;
+
+  for (i = 0; i < N_PACKS; i++)
+    put_pack (data, SCR_BASE + i * SCR_STEP, PACK_SIZE (i));
+
+  /* MPEG program end code */
+  g_byte_array_append (data, (const guint8 *) "\x00\x00\x01\xb9", 4);
+
+  return data;
+}
+
+static void
+_pad_added (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  fail_unless (gst_pad_link (pad, mysinkpad) == GST_PAD_LINK_OK);
+  demuxsrcpad = gst_object_ref (pad);
+}
+
+/* Blocks the streaming thread until the next flush, so that the demuxer
+ * doesn't index the whole stream while playing it */
+static GstFlowReturn
+_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+
+  g_mutex_lock (&lock);
+  n_buffers++;
+  g_cond_broadcast (&cond);
+  while (!flushing && !released)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+
+  return GST_FLOW_FLUSHING;
+}
+
+static gboolean
+_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&lock);
+      flushing = TRUE;
+      g_cond_broadcast (&cond);
+      g_mutex_unlock (&lock);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      g_mutex_lock (&lock);
+      flushing = FALSE;
+      g_mutex_unlock (&lock);
+      break;
+    default:
+      break;
+  }
+
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+_src_getrange (GstPad * pad, GstObject * parent, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  if (offset >= ps_data->len)
+    return GST_FLOW_EOS;
+  if (offset + length > ps_data->len)
+    length = ps_data->len - offset;
+
+  /* only the pulls done while seeking, not the ones of the streaming
+   * thread */
+  if (g_thread_self () == seek_thread)
+    n_pulls++;
+
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      ps_data->data + offset, length, 0, length, NULL, NULL);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  gboolean res = FALSE;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_DURATION:{
+      GstFormat fmt;
+
+      gst_query_parse_duration (query, &fmt, NULL);
+      if (fmt != GST_FORMAT_BYTES)
+        break;
+
+      gst_query_set_duration (query, fmt, ps_data->len);
+      res = TRUE;
+      break;
+    }
+    case GST_QUERY_SCHEDULING:{
+      gst_query_set_scheduling (query, GST_SCHEDULING_FLAG_SEEKABLE, 1, -1, 0);
+      gst_query_add_scheduling_mode (query, GST_PAD_MODE_PULL);
+      res = TRUE;
+      break;
+    }
+    default:
+      break;
+  }
+
+  return res;
+}
+
+/* Returns the number of pulls needed to seek to @position */
+static guint
+seek_to (GstClockTime position)
+{
+  n_pulls = 0;
+  fail_unless (gst_pad_send_event (demuxsrcpad,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, -1)));
+
+  return n_pulls;
+}
+
+/* Seeks to the same positions twice and returns how many pulls each pass
+ * needed */
+static void
+run_seek_test (gboolean build_index, guint * first_pass, guint * second_pass)
+{
+  static const GstClockTime positions[] = {
+    12 * GST_SECOND, 15 * GST_SECOND, 18 * GST_SECOND
+  };
+  GstElement *demux;
+  GstPad *sinkpad;
+  guint i;
+
+  n_buffers = 0;
+  flushing = released = FALSE;
+  seek_thread = g_thread_self ();
+  ps_data = create_program_stream ();
+
+  demux = gst_element_factory_make ("mpegpsdemux", NULL);
+  fail_unless (demux != NULL);
+  g_object_set (demux, "build-index", build_index, NULL);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (_pad_added), NULL);
+
+  mysinkpad = gst_pad_new_from_static_template (&mysinktemplate, "sink");
+  gst_pad_set_chain_function (mysinkpad, _sink_chain);
+  gst_pad_set_event_function (mysinkpad, _sink_event);
+  mysrcpad = gst_pad_new_from_static_template (&mysrctemplate, "src");
+  gst_pad_set_getrange_function (mysrcpad, _src_getrange);
+  gst_pad_set_query_function (mysrcpad, _src_query);
+
+  sinkpad = gst_element_get_static_pad (demux, "sink");
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  fail_unless_equals_int (gst_element_set_state (demux, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* the stream is set up once the first buffer arrives */
+  g_mutex_lock (&lock);
+  while (n_buffers == 0)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+  fail_unless (demuxsrcpad != NULL);
+
+  *first_pass = *second_pass = 0;
+  for (i = 0; i < G_N_ELEMENTS (positions); i++)
+    *first_pass += seek_to (positions[i]);
+  for (i = 0; i < G_N_ELEMENTS (positions); i++)
+    *second_pass += seek_to (positions[i]);
+
+  GST_INFO ("build-index %d: %u pulls for the first seeks, %u for the "
+      "second ones", build_index, *first_pass, *second_pass);
+
+  g_mutex_lock (&lock);
+  released = TRUE;
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&lock);
+
+  gst_element_set_state (demux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (demux);
+  gst_object_unref (demuxsrcpad);
+  demuxsrcpad = NULL;
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_byte_array_unref (ps_data);
+  ps_data = NULL;
+}
+
+GST_START_TEST (test_pull_seek_index)
+{
+  guint first_pass, second_pass;
+
+  run_seek_test (TRUE, &first_pass, &second_pass);
+
+  /* the SCRs found by the first seeks narrow down the later ones */
+  fail_unless (second_pass < first_pass);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pull_seek_no_index)
+{
+  guint first_pass, second_pass;
+
+  run_seek_test (FALSE, &first_pass, &second_pass);
+
+  /* without an index every seek starts from the ends of the stream again */
+  fail_unless_equals_int (second_pass, first_pass);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsdemux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pull_seek_index);
+  tcase_add_test (tc_chain, test_pull_seek_no_index);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsdemux);
@@ -184,7 +184,8 @@ _create_src_pad_pull (void)
   return mysrcpad;
 }
 
-GST_START_TEST (test_pull)
+static void
+run_pull_test (guint read_ahead_size)
 {
   GstStateChangeReturn sret;
   GstElement *mxfdemux;
@@ -196,6 +197,7 @@ GST_START_TEST (test_pull)
 
   mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
   fail_unless (mxfdemux != NULL);
+  g_object_set (mxfdemux, "read-ahead-size", read_ahead_size, NULL);
   g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
   sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
   fail_unless (sinkpad != NULL);
@@ -230,6 +232,20 @@ GST_START_TEST (test_pull)
   loop = NULL;
 }
 
+GST_START_TEST (test_pull)
+{
+  run_pull_test (0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pull_read_ahead)
+{
+  /* smaller than the file, so that some packets span two blocks, and not a
+   * multiple of the block alignment */
+  run_pull_test (6000);
+}
+
 GST_END_TEST;
 
 GST_START_TEST (test_push)
@@ -301,6 +317,7 @@ mxfdemux_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_read_ahead);
   tcase_add_test (tc_chain, test_push);
 
   return s;
@@ -21,6 +21,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
 static const gchar *
@@ -65,18 +66,13 @@ on_message_cb (GstBus * bus, GstMessage * message, gpointer user_data)
 }
 
 static void
-run_test (const gchar * pipeline_string)
+run_pipeline (GstElement * pipeline)
 {
-  GstElement *pipeline;
   GstBus *bus;
   GMainLoop *loop;
   OnMessageUserData omud = { NULL, };
   GstStateChangeReturn ret;
 
-  GST_DEBUG ("Testing pipeline '%s'", pipeline_string);
-
-  pipeline = gst_parse_launch (pipeline_string, NULL);
-  fail_unless (pipeline != NULL);
   g_object_set (G_OBJECT (pipeline), "async-handling", TRUE, NULL);
 
   loop = g_main_loop_new (NULL, FALSE);
@@ -101,12 +97,25 @@ run_test (const gchar * pipeline_string)
 
   fail_unless (omud.eos == TRUE);
 
-  gst_object_unref (pipeline);
   g_main_loop_unref (loop);
   gst_bus_remove_signal_watch (bus);
   gst_object_unref (bus);
 }
 
+static void
+run_test (const gchar * pipeline_string)
+{
+  GstElement *pipeline;
+
+  GST_DEBUG ("Testing pipeline '%s'", pipeline_string);
+
+  pipeline = gst_parse_launch (pipeline_string, NULL);
+  fail_unless (pipeline != NULL);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+}
+
 GST_START_TEST (test_mpeg2)
 {
   const gchar *mpeg2enc_name = get_mpeg2enc_element_name ();
@@ -265,6 +274,142 @@ GST_START_TEST (test_h264_raw_audio)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GByteArray *data;
+  gboolean have_footer;
+  gboolean have_rip;
+  /* number of essence elements in each body partition */
+  GArray *partition_frames;
+  guint n_frames;
+} GrowingFileData;
+
+static void
+on_mux_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  /* shared by partition packs and the random index pack */
+  static const guint8 partition_pack_ul[] = {
+    0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+    0x0d, 0x01, 0x02, 0x01, 0x01
+  };
+  static const guint8 essence_element_ul[] = {
+    0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x01,
+    0x0d, 0x01, 0x03, 0x01
+  };
+  GrowingFileData *d = user_data;
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (map.size >= 16
+      && memcmp (map.data, partition_pack_ul,
+          sizeof (partition_pack_ul)) == 0) {
+    switch (map.data[13]) {
+      case 0x03:
+        /* body partition */
+        if (!d->have_footer) {
+          if (d->partition_frames->len > 0 || d->n_frames > 0)
+            g_array_append_val (d->partition_frames, d->n_frames);
+          d->n_frames = 0;
+        }
+        break;
+      case 0x04:
+        /* footer partition */
+        if (!d->have_footer)
+          g_array_append_val (d->partition_frames, d->n_frames);
+        d->have_footer = TRUE;
+        break;
+      case 0x11:
+        /* random index pack */
+        if (d->have_footer)
+          d->have_rip = TRUE;
+        break;
+      default:
+        break;
+    }
+  } else if (!d->have_footer && map.size >= 16
+      && memcmp (map.data, essence_element_ul,
+          sizeof (essence_element_ul)) == 0) {
+    d->n_frames++;
+  }
+
+  /* everything before the footer partition is what a reader can see while
+   * the file is being written */
+  if (!d->have_footer)
+    g_byte_array_append (d->data, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+}
+
+static void
+on_demux_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  guint *n_frames = user_data;
+
+  (*n_frames)++;
+}
+
+GST_START_TEST (test_growing_file)
+{
+  GrowingFileData d = { NULL, FALSE, FALSE, NULL, 0 };
+  GstElement *pipeline, *sink;
+  gchar *location, *pipeline_str;
+  guint n_frames = 0, i;
+  gint fd;
+
+  pipeline = gst_parse_launch ("videotestsrc num-buffers=50 ! "
+      "video/x-raw,format=(string)v308,width=64,height=48,framerate=25/1 ! "
+      "mxfmux partition-interval=400000000 ! "
+      "fakesink name=sink signal-handoffs=true", NULL);
+  fail_unless (pipeline != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  d.data = g_byte_array_new ();
+  d.partition_frames = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_mux_handoff), &d);
+  gst_object_unref (sink);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+  fail_unless (d.have_footer);
+  fail_unless (d.have_rip);
+
+  /* 50 frames at 25fps with a new body partition every 400ms */
+  fail_unless_equals_int (d.partition_frames->len, 5);
+  for (i = 0; i < d.partition_frames->len; i++)
+    fail_unless_equals_int (g_array_index (d.partition_frames, guint, i), 10);
+  g_array_unref (d.partition_frames);
+
+  fd = g_file_open_tmp ("mxfmux-growing-XXXXXX.mxf", &location, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+  fail_unless (g_file_set_contents (location, (const gchar *) d.data->data,
+          d.data->len, NULL));
+  g_byte_array_unref (d.data);
+
+  /* the unfinished file has no footer, random index pack or final header
+   * metadata but is still playable */
+  pipeline_str =
+      g_strdup_printf ("filesrc location=\"%s\" ! mxfdemux name=demux "
+      "demux. ! fakesink name=sink signal-handoffs=true", location);
+  pipeline = gst_parse_launch (pipeline_str, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (pipeline_str);
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_demux_handoff),
+      &n_frames);
+  gst_object_unref (sink);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+
+  fail_unless_equals_int (n_frames, 50);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfmux_suite (void)
 {
@@ -281,6 +426,7 @@ mxfmux_suite (void)
   tcase_add_test (tc_chain, test_dnxhd_mp3);
   tcase_add_test (tc_chain, test_h264_raw_audio);
   tcase_add_test (tc_chain, test_multiple_av_streams);
+  tcase_add_test (tc_chain, test_growing_file);
 
   return s;
 }
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include <gst/check/gstharness.h>
 #include <gst/check/gstcheck.h>
 
@@ -49,6 +51,181 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_numbered_buffer (GstHarness * h, gsize size, guint64 offset)
+{
+  GstBuffer *buf = gst_harness_create_buffer (h, size);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  return buf;
+}
+
+/* Waits for the scheduler to wait on the clock and checks it waits until
+ * @time */
+static void
+crank_and_check_time (GstHarness * h, GstClockTime time)
+{
+  GstTestClock *testclock = gst_harness_get_testclock (h);
+  GstClockID id;
+
+  gst_test_clock_wait_for_next_pending_id (testclock, &id);
+  fail_unless_equals_uint64 (gst_clock_id_get_time (id), time);
+  gst_clock_id_unref (id);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  fail_unless_equals_uint64 (gst_clock_get_time (GST_CLOCK (testclock)),
+      time);
+
+  gst_object_unref (testclock);
+}
+
+GST_START_TEST (netsim_delay_accuracy)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=1.0 "
+      "min-delay=10 max-delay=10");
+  guint i;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 10; i++) {
+    GstClockTime now = i * (20 * GST_MSECOND + 137 * GST_USECOND);
+    GstBuffer *buf;
+
+    gst_harness_set_time (h, now);
+    fail_unless_equals_int (gst_harness_push (h,
+            create_numbered_buffer (h, 100, i)), GST_FLOW_OK);
+    fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+    /* released with microsecond precision */
+    crank_and_check_time (h, now + 10 * GST_MSECOND);
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_bandwidth_tail_drop)
+{
+  /* 800 kbps lets one 1000 byte packet through every 10 ms */
+  GstHarness *h = gst_harness_new_parse ("netsim max-kbps=800 queue-size=2");
+  GstBuffer *buf;
+  guint i;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+  gst_harness_set_time (h, 0);
+
+  for (i = 0; i < 5; i++)
+    fail_unless_equals_int (gst_harness_push (h,
+            create_numbered_buffer (h, 1000, i)), GST_FLOW_OK);
+
+  /* the first one goes through right away, the next two wait for the
+   * token bucket and the others don't fit in the queue */
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 1);
+  buf = gst_harness_pull (h);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), 0);
+  gst_buffer_unref (buf);
+
+  for (i = 1; i < 3; i++) {
+    crank_and_check_time (h, i * 10 * GST_MSECOND);
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 3);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static gchar *
+run_burst_loss (guint seed)
+{
+  GstHarness *h = gst_harness_new ("netsim");
+  GString *pattern = g_string_new (NULL);
+  guint i;
+
+  g_object_set (h->element, "seed", seed, "gilbert-elliott-p", 0.05,
+      "gilbert-elliott-r", 0.3, NULL);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  for (i = 0; i < 1000; i++) {
+    guint received = gst_harness_buffers_received (h);
+
+    fail_unless_equals_int (gst_harness_push (h,
+            create_numbered_buffer (h, 100, i)), GST_FLOW_OK);
+    g_string_append_c (pattern,
+        gst_harness_buffers_received (h) > received ? '.' : 'x');
+  }
+
+  gst_harness_teardown (h);
+
+  return g_string_free (pattern, FALSE);
+}
+
+GST_START_TEST (netsim_burst_loss_deterministic)
+{
+  gchar *pattern1 = run_burst_loss (42);
+  gchar *pattern2 = run_burst_loss (42);
+
+  /* the same seed loses the same packets */
+  fail_unless_equals_string (pattern1, pattern2);
+
+  /* losses come in bursts */
+  fail_unless (strstr (pattern1, "x") != NULL);
+  fail_unless (strstr (pattern1, "xx") != NULL);
+  fail_unless (strstr (pattern1, ".") != NULL);
+
+  g_free (pattern1);
+  g_free (pattern2);
+}
+
+GST_END_TEST;
+
+#define N_THROUGHPUT_PACKETS 50000
+
+GST_START_TEST (netsim_throughput)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=1.0 "
+      "min-delay=1 max-delay=50 allow-reordering=false seed=1");
+  gint64 start;
+  guint i;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* one second worth of packets at 50000 packets/s */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_THROUGHPUT_PACKETS; i++) {
+    gst_harness_set_time (h, i * (GST_SECOND / N_THROUGHPUT_PACKETS));
+    fail_unless_equals_int (gst_harness_push (h,
+            create_numbered_buffer (h, 100, i)), GST_FLOW_OK);
+  }
+  GST_INFO ("scheduled %u packets in %" G_GINT64_FORMAT " us",
+      N_THROUGHPUT_PACKETS, g_get_monotonic_time () - start);
+
+  gst_harness_set_time (h, 2 * GST_SECOND);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* all of them come out, in order */
+  for (i = 0; i < N_THROUGHPUT_PACKETS; i++) {
+    GstBuffer *buf = gst_harness_pull (h);
+
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buf), i);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -58,6 +235,10 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_delay_accuracy);
+  tcase_add_test (tc_chain, netsim_bandwidth_tail_drop);
+  tcase_add_test (tc_chain, netsim_burst_loss_deterministic);
+  tcase_add_test (tc_chain, netsim_throughput);
 
   return s;
 }
@@ -115,6 +115,253 @@ GST_START_TEST (test_parse_zerosize_frames)
 
 GST_END_TEST;
 
+static const guint8 pcapng_data[] = {
+  /* section header block, little endian */
+  0x0a, 0x0d, 0x0d, 0x0a, 0x1c, 0x00, 0x00, 0x00, 0x4d, 0x3c, 0x2b, 0x1a,
+  0x01, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x1c, 0x00, 0x00, 0x00,
+  /* interface description block, ethernet, nanosecond timestamps */
+  0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+  0x01, 0x00, 0x00, 0x00, 0xff, 0xff, 0x00, 0x00, 0x09, 0x00, 0x01, 0x00,
+  0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,
+  /* enhanced packet block with the frame of pcap_frame_with_eth_padding */
+  0x06, 0x00, 0x00, 0x00, 0x5c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x0d, 0x12, 0xd1, 0x14, 0x15, 0xcd, 0x71, 0x82, 0x3c, 0x00, 0x00, 0x00,
+  0x3c, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x29, 0xa6, 0x13, 0x41, 0x00, 0x0c,
+  0x29, 0xb2, 0x93, 0x7d, 0x08, 0x00, 0x45, 0x00, 0x00, 0x2c, 0x00, 0x00,
+  0x40, 0x00, 0x32, 0x11, 0x25, 0xb9, 0x52, 0xc5, 0x4d, 0xd6, 0xb9, 0x23,
+  0xc9, 0x49, 0x44, 0x66, 0x9f, 0xf2, 0x00, 0x18, 0x75, 0xe8, 0x80, 0xe3,
+  0x7c, 0xca, 0x79, 0xba, 0x09, 0xc0, 0x70, 0x6e, 0x8b, 0x33, 0x05, 0x0a,
+  0x00, 0xa0, 0x00, 0x00, 0x5c, 0x00, 0x00, 0x00
+};
+
+GST_START_TEST (test_parse_pcapng)
+{
+  GstBuffer *out_buf;
+  GstHarness *h;
+  gsize offset;
+
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+
+  /* in small pieces so that blocks span several buffers */
+  for (offset = 0; offset < sizeof (pcapng_data); offset += 7) {
+    gsize size = MIN (7, sizeof (pcapng_data) - offset);
+
+    fail_unless_equals_int (gst_harness_push (h,
+            gst_buffer_new_wrapped (g_memdup (pcapng_data + offset, size),
+                size)), GST_FLOW_OK);
+  }
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 1);
+  out_buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out_buf), 16);
+  fail_unless (gst_buffer_memcmp (out_buf, 0, pcap_frame_with_eth_padding +
+          pcap_frame_with_eth_padding_offset, 16) == 0);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf),
+      G_GUINT64_CONSTANT (1500000000123456789));
+
+  gst_buffer_unref (out_buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* the section header and interface description blocks of pcapng_data,
+ * followed by a simple packet block, which has no timestamp */
+static const guint pcapng_spb_header_size = 28 + 32;
+static const guint8 pcapng_spb[] = {
+  0x03, 0x00, 0x00, 0x00, 0x4c, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00,
+  0x00, 0x0c, 0x29, 0xa6, 0x13, 0x41, 0x00, 0x0c, 0x29, 0xb2, 0x93, 0x7d,
+  0x08, 0x00, 0x45, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x40, 0x00, 0x32, 0x11,
+  0x25, 0xb9, 0x52, 0xc5, 0x4d, 0xd6, 0xb9, 0x23, 0xc9, 0x49, 0x44, 0x66,
+  0x9f, 0xf2, 0x00, 0x18, 0x75, 0xe8, 0x80, 0xe3, 0x7c, 0xca, 0x79, 0xba,
+  0x09, 0xc0, 0x70, 0x6e, 0x8b, 0x33, 0x05, 0x0a, 0x00, 0xa0, 0x00, 0x00,
+  0x4c, 0x00, 0x00, 0x00
+};
+
+GST_START_TEST (test_parse_pcapng_simple_packet)
+{
+  GstBuffer *in_buf, *out_buf;
+  GstHarness *h;
+  GstCaps *caps;
+  GstEvent *event;
+  const GstSegment *segment;
+  guint8 *data;
+  gsize size;
+
+  h = gst_harness_new ("pcapparse");
+  caps = gst_caps_from_string ("application/x-rtp");
+  g_object_set (h->element, "caps", caps, NULL);
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+
+  size = pcapng_spb_header_size + sizeof (pcapng_spb);
+  data = g_malloc (size);
+  memcpy (data, pcapng_data, pcapng_spb_header_size);
+  memcpy (data + pcapng_spb_header_size, pcapng_spb, sizeof (pcapng_spb));
+  in_buf = gst_buffer_new_wrapped (data, size);
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 1);
+  out_buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out_buf), 16);
+  fail_unless (gst_buffer_memcmp (out_buf, 0, pcap_frame_with_eth_padding +
+          pcap_frame_with_eth_padding_offset, 16) == 0);
+  fail_if (GST_BUFFER_PTS_IS_VALID (out_buf));
+  gst_buffer_unref (out_buf);
+
+  /* caps and a time segment starting at 0 come before the first packet,
+   * even though it has no timestamp */
+  gst_caps_unref (caps);
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps != NULL);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          "application/x-rtp"));
+  gst_caps_unref (caps);
+
+  event = gst_pad_get_sticky_event (h->sinkpad, GST_EVENT_SEGMENT, 0);
+  fail_unless (event != NULL);
+  gst_event_parse_segment (event, &segment);
+  fail_unless_equals_int (segment->format, GST_FORMAT_TIME);
+  fail_unless_equals_uint64 (segment->start, 0);
+  gst_event_unref (event);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static const guint8 vlan_ipv6_frame[] = {
+  0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00,
+  0x46, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x81, 0x00, 0x00, 0x64, 0x86, 0xdd, 0x60, 0x00,
+  0x00, 0x00, 0x00, 0x0c, 0x11, 0x40, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+  0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+  0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e,
+  0x1f, 0x20, 0x13, 0x88, 0x13, 0x89, 0x00, 0x0c, 0x00, 0x00, 0x61, 0x62,
+  0x63, 0x64
+};
+
+static void
+push_vlan_ipv6_frame (GstHarness * h)
+{
+  GstBuffer *in_buf;
+
+  in_buf = gst_buffer_new_allocate (NULL,
+      sizeof (pcap_header) + sizeof (vlan_ipv6_frame), NULL);
+  gst_buffer_fill (in_buf, 0, pcap_header, sizeof (pcap_header));
+  gst_buffer_fill (in_buf, sizeof (pcap_header), vlan_ipv6_frame,
+      sizeof (vlan_ipv6_frame));
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+}
+
+GST_START_TEST (test_parse_vlan_ipv6)
+{
+  GstBuffer *out_buf;
+  GstHarness *h;
+
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  g_object_set (h->element, "dst-port", 5001, NULL);
+
+  push_vlan_ipv6_frame (h);
+
+  out_buf = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (out_buf), 4);
+  fail_unless (gst_buffer_memcmp (out_buf, 0, "abcd", 4) == 0);
+  gst_buffer_unref (out_buf);
+  gst_harness_teardown (h);
+
+  /* the address filter only matches IPv4 packets */
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  g_object_set (h->element, "dst-ip", "10.0.0.1", NULL);
+
+  push_vlan_ipv6_frame (h);
+
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+#define THROUGHPUT_PACKETS 50000
+#define THROUGHPUT_PAYLOAD_SIZE 172
+#define THROUGHPUT_RECORD_SIZE (16 + 14 + 20 + 8 + THROUGHPUT_PAYLOAD_SIZE)
+#define THROUGHPUT_CHUNK_SIZE 65536
+
+GST_START_TEST (test_parse_throughput)
+{
+  GstHarness *h;
+  GstBuffer *in_buf;
+  GstMapInfo map;
+  gsize size, offset;
+  gint64 start, elapsed;
+  guint i;
+
+  size = sizeof (pcap_header) + THROUGHPUT_PACKETS * THROUGHPUT_RECORD_SIZE;
+  in_buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (in_buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  memcpy (map.data, pcap_header, sizeof (pcap_header));
+  for (i = 0; i < THROUGHPUT_PACKETS; i++) {
+    guint8 *rec = map.data + sizeof (pcap_header) + i *
+        THROUGHPUT_RECORD_SIZE;
+    guint8 *ip = rec + 16 + 14;
+    guint8 *udp = ip + 20;
+
+    GST_WRITE_UINT32_LE (rec + 0, i / 50);
+    GST_WRITE_UINT32_LE (rec + 4, (i % 50) * 20000);
+    GST_WRITE_UINT32_LE (rec + 8, THROUGHPUT_RECORD_SIZE - 16);
+    GST_WRITE_UINT32_LE (rec + 12, THROUGHPUT_RECORD_SIZE - 16);
+    GST_WRITE_UINT16_BE (rec + 16 + 12, 0x0800);
+    ip[0] = 0x45;
+    ip[9] = 17;
+    GST_WRITE_UINT16_BE (udp + 0, 5000);
+    /* every other packet goes to the port we filter on */
+    GST_WRITE_UINT16_BE (udp + 2, (i % 2) ? 5006 : 5004);
+    GST_WRITE_UINT16_BE (udp + 4, 8 + THROUGHPUT_PAYLOAD_SIZE);
+    GST_WRITE_UINT32_BE (udp + 8, i);
+  }
+  gst_buffer_unmap (in_buf, &map);
+
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  g_object_set (h->element, "dst-port", 5004, NULL);
+
+  start = g_get_monotonic_time ();
+  for (offset = 0; offset < size; offset += THROUGHPUT_CHUNK_SIZE) {
+    GstBuffer *chunk = gst_buffer_copy_region (in_buf, GST_BUFFER_COPY_MEMORY,
+        offset, MIN (THROUGHPUT_CHUNK_SIZE, size - offset));
+
+    fail_unless_equals_int (gst_harness_push (h, chunk), GST_FLOW_OK);
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  GST_INFO ("parsed %u packets in %" G_GINT64_FORMAT " us, %" G_GINT64_FORMAT
+      " packets/s", THROUGHPUT_PACKETS, elapsed,
+      THROUGHPUT_PACKETS * G_USEC_PER_SEC / elapsed);
+
+  fail_unless_equals_int (gst_harness_buffers_received (h),
+      THROUGHPUT_PACKETS / 2);
+  for (i = 0; i < THROUGHPUT_PACKETS / 2; i++) {
+    GstBuffer *out_buf = gst_harness_pull (h);
+    guint8 seq[4];
+
+    fail_unless_equals_int (gst_buffer_get_size (out_buf),
+        THROUGHPUT_PAYLOAD_SIZE);
+    fail_unless_equals_int (gst_buffer_n_memory (out_buf), 1);
+    gst_buffer_extract (out_buf, 0, seq, 4);
+    fail_unless_equals_int (GST_READ_UINT32_BE (seq), i * 2);
+    gst_buffer_unref (out_buf);
+  }
+
+  gst_buffer_unref (in_buf);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 pcapparse_suite (void)
 {
@@ -133,6 +380,10 @@ pcapparse_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_parse_frames_with_eth_padding);
   tcase_add_test (tc_chain, test_parse_zerosize_frames);
+  tcase_add_test (tc_chain, test_parse_pcapng);
+  tcase_add_test (tc_chain, test_parse_pcapng_simple_packet);
+  tcase_add_test (tc_chain, test_parse_vlan_ipv6);
+  tcase_add_test (tc_chain, test_parse_throughput);
 
   return s;
 }
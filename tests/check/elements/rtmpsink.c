@@ -0,0 +1,567 @@
+/* GStreamer
+ *
+ * unit test for rtmpsink
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#define N_FRAMES 50
+#define KEYFRAME_SIZE 1000
+#define DELTA_SIZE 500
+#define AUDIO_SIZE 100
+
+static GstPad *mysrcpad;
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-flv"));
+
+static const guint8 flv_header[] = {
+  'F', 'L', 'V', 0x01, 0x05, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00
+};
+
+/* A stand-in for an RTMP server that accepts one publishing client and
+ * counts the audio and video messages it receives. It answers just enough
+ * of the connect/createStream/publish sequence for librtmp to start
+ * sending, and only starts the stream once publish_allowed is set */
+typedef struct
+{
+  GSocket *listener;
+  GThread *thread;
+  guint16 port;
+
+  GMutex lock;
+  GCond cond;
+  gboolean publish_allowed;
+  guint audio_tags;
+  guint keyframes;
+  guint delta_frames;
+} TestServer;
+
+typedef struct
+{
+  guint32 length;
+  guint8 type;
+  guint8 *body;
+  guint32 received;
+} ChunkStream;
+
+static gboolean
+read_all (GSocket * socket, guint8 * data, gsize size)
+{
+  while (size > 0) {
+    gssize n = g_socket_receive (socket, (gchar *) data, size, NULL, NULL);
+
+    if (n <= 0)
+      return FALSE;
+    data += n;
+    size -= n;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+write_all (GSocket * socket, const guint8 * data, gsize size)
+{
+  while (size > 0) {
+    gssize n = g_socket_send (socket, (const gchar *) data, size, NULL, NULL);
+
+    if (n <= 0)
+      return FALSE;
+    data += n;
+    size -= n;
+  }
+
+  return TRUE;
+}
+
+static void
+amf_add_key (GByteArray * array, const gchar * key)
+{
+  guint8 len[2];
+
+  GST_WRITE_UINT16_BE (len, strlen (key));
+  g_byte_array_append (array, len, 2);
+  g_byte_array_append (array, (const guint8 *) key, strlen (key));
+}
+
+static void
+amf_add_string (GByteArray * array, const gchar * str)
+{
+  guint8 marker = 0x02;
+
+  g_byte_array_append (array, &marker, 1);
+  amf_add_key (array, str);
+}
+
+static void
+amf_add_number (GByteArray * array, gdouble number)
+{
+  guint8 data[9];
+
+  data[0] = 0x00;
+  GST_WRITE_DOUBLE_BE (data + 1, number);
+  g_byte_array_append (array, data, 9);
+}
+
+static void
+amf_add_null (GByteArray * array)
+{
+  guint8 marker = 0x05;
+
+  g_byte_array_append (array, &marker, 1);
+}
+
+/* Sends a command message on chunk stream 3, in a single chunk */
+static gboolean
+send_command (GSocket * socket, GByteArray * body)
+{
+  guint8 header[12] = { 0x03, };
+
+  g_assert (body->len <= 128);
+
+  GST_WRITE_UINT24_BE (header + 4, body->len);
+  header[7] = 0x14;
+
+  return write_all (socket, header, sizeof (header)) &&
+      write_all (socket, body->data, body->len);
+}
+
+static gboolean
+handle_command (TestServer * server, GSocket * socket, const guint8 * body,
+    guint32 size)
+{
+  GByteArray *reply;
+  gchar *name;
+  gdouble txn = 0;
+  guint16 len;
+  gboolean ret = TRUE;
+
+  if (size < 3 || body[0] != 0x02)
+    return TRUE;
+
+  len = GST_READ_UINT16_BE (body + 1);
+  if (3 + len + 9 > size)
+    return TRUE;
+
+  name = g_strndup ((const gchar *) body + 3, len);
+  if (body[3 + len] == 0x00)
+    txn = GST_READ_DOUBLE_BE (body + 3 + len + 1);
+
+  reply = g_byte_array_new ();
+  if (g_str_equal (name, "connect")) {
+    amf_add_string (reply, "_result");
+    amf_add_number (reply, txn);
+    amf_add_null (reply);
+    amf_add_null (reply);
+  } else if (g_str_equal (name, "createStream")) {
+    amf_add_string (reply, "_result");
+    amf_add_number (reply, txn);
+    amf_add_null (reply);
+    amf_add_number (reply, 1);
+  } else if (g_str_equal (name, "publish")) {
+    static const guint8 object_end[] = { 0x00, 0x00, 0x09 };
+    guint8 marker = 0x03;
+
+    g_mutex_lock (&server->lock);
+    while (!server->publish_allowed)
+      g_cond_wait (&server->cond, &server->lock);
+    g_mutex_unlock (&server->lock);
+
+    amf_add_string (reply, "onStatus");
+    amf_add_number (reply, 0);
+    amf_add_null (reply);
+    g_byte_array_append (reply, &marker, 1);
+    amf_add_key (reply, "level");
+    amf_add_string (reply, "status");
+    amf_add_key (reply, "code");
+    amf_add_string (reply, "NetStream.Publish.Start");
+    g_byte_array_append (reply, object_end, sizeof (object_end));
+  }
+
+  if (reply->len > 0)
+    ret = send_command (socket, reply);
+
+  g_byte_array_unref (reply);
+  g_free (name);
+
+  return ret;
+}
+
+static gpointer
+server_thread (gpointer data)
+{
+  static const guint header_sizes[] = { 11, 7, 3, 0 };
+  TestServer *server = data;
+  ChunkStream streams[64];
+  guint32 chunk_size = 128;
+  guint8 c1[1536], s0s1[1537], header[15];
+  GSocket *socket;
+  guint i;
+
+  memset (streams, 0, sizeof (streams));
+
+  socket = g_socket_accept (server->listener, NULL, NULL);
+  if (socket == NULL)
+    return NULL;
+
+  /* C0 and C1 are answered with S0, S1 and S2 (an echo of C1), then C2 */
+  memset (s0s1, 0, sizeof (s0s1));
+  s0s1[0] = 0x03;
+  if (!read_all (socket, header, 1) || !read_all (socket, c1, sizeof (c1)) ||
+      !write_all (socket, s0s1, sizeof (s0s1)) ||
+      !write_all (socket, c1, sizeof (c1)) ||
+      !read_all (socket, c1, sizeof (c1)))
+    goto done;
+
+  for (;;) {
+    ChunkStream *cs;
+    guint fmt, csid;
+    guint32 n;
+
+    if (!read_all (socket, header, 1))
+      break;
+
+    fmt = header[0] >> 6;
+    csid = header[0] & 0x3f;
+    /* librtmp only uses the low chunk stream ids */
+    if (csid < 2)
+      break;
+    cs = &streams[csid];
+
+    if (!read_all (socket, header, header_sizes[fmt]))
+      break;
+    if (fmt <= 1) {
+      cs->length = GST_READ_UINT24_BE (header + 3);
+      cs->type = header[6];
+    }
+    /* extended timestamp */
+    if (fmt < 3 && GST_READ_UINT24_BE (header) == 0xffffff &&
+        !read_all (socket, header, 4))
+      break;
+
+    if (cs->received == 0)
+      cs->body = g_realloc (cs->body, MAX (cs->length, 1));
+
+    n = MIN (chunk_size, cs->length - cs->received);
+    if (!read_all (socket, cs->body + cs->received, n))
+      break;
+    cs->received += n;
+    if (cs->received < cs->length)
+      continue;
+    cs->received = 0;
+
+    switch (cs->type) {
+      case 0x01:
+        if (cs->length >= 4)
+          chunk_size = GST_READ_UINT32_BE (cs->body) & 0x7fffffff;
+        break;
+      case 0x14:
+        if (!handle_command (server, socket, cs->body, cs->length))
+          goto done;
+        break;
+      case 0x08:
+      case 0x09:
+        g_mutex_lock (&server->lock);
+        if (cs->type == 0x08)
+          server->audio_tags++;
+        else if (cs->length > 0 && (cs->body[0] >> 4) == 1)
+          server->keyframes++;
+        else
+          server->delta_frames++;
+        g_cond_broadcast (&server->cond);
+        g_mutex_unlock (&server->lock);
+        break;
+      default:
+        break;
+    }
+  }
+
+done:
+  for (i = 0; i < G_N_ELEMENTS (streams); i++)
+    g_free (streams[i].body);
+  g_object_unref (socket);
+
+  return NULL;
+}
+
+static TestServer *
+test_server_new (gboolean publish_allowed)
+{
+  TestServer *server = g_new0 (TestServer, 1);
+  GInetAddress *inet_address;
+  GSocketAddress *address;
+
+  g_mutex_init (&server->lock);
+  g_cond_init (&server->cond);
+  server->publish_allowed = publish_allowed;
+
+  server->listener = g_socket_new (G_SOCKET_FAMILY_IPV4,
+      G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL);
+  fail_unless (server->listener != NULL);
+
+  inet_address = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  address = g_inet_socket_address_new (inet_address, 0);
+  fail_unless (g_socket_bind (server->listener, address, TRUE, NULL));
+  fail_unless (g_socket_listen (server->listener, NULL));
+  g_object_unref (address);
+  g_object_unref (inet_address);
+
+  address = g_socket_get_local_address (server->listener, NULL);
+  fail_unless (address != NULL);
+  server->port =
+      g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (address));
+  g_object_unref (address);
+
+  server->thread = g_thread_new ("rtmp-test-server", server_thread, server);
+
+  return server;
+}
+
+static void
+test_server_allow_publish (TestServer * server)
+{
+  g_mutex_lock (&server->lock);
+  server->publish_allowed = TRUE;
+  g_cond_broadcast (&server->cond);
+  g_mutex_unlock (&server->lock);
+}
+
+static void
+test_server_wait (TestServer * server, guint audio_tags, guint keyframes,
+    guint delta_frames)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&server->lock);
+  while (server->audio_tags < audio_tags || server->keyframes < keyframes ||
+      server->delta_frames < delta_frames)
+    fail_unless (g_cond_wait_until (&server->cond, &server->lock, end_time));
+  fail_unless_equals_int (server->audio_tags, audio_tags);
+  fail_unless_equals_int (server->keyframes, keyframes);
+  fail_unless_equals_int (server->delta_frames, delta_frames);
+  g_mutex_unlock (&server->lock);
+}
+
+/* The sink must have closed the connection already */
+static void
+test_server_free (TestServer * server)
+{
+  g_thread_join (server->thread);
+  g_object_unref (server->listener);
+  g_mutex_clear (&server->lock);
+  g_cond_clear (&server->cond);
+  g_free (server);
+}
+
+static GstCaps *
+create_caps (void)
+{
+  GstCaps *caps = gst_caps_new_empty_simple ("video/x-flv");
+  GValue array = G_VALUE_INIT;
+  GValue value = G_VALUE_INIT;
+  GstBuffer *header;
+
+  header = gst_buffer_new_allocate (NULL, sizeof (flv_header), NULL);
+  gst_buffer_fill (header, 0, flv_header, sizeof (flv_header));
+  GST_BUFFER_FLAG_SET (header, GST_BUFFER_FLAG_HEADER);
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  g_value_init (&value, GST_TYPE_BUFFER);
+  gst_value_set_buffer (&value, header);
+  gst_value_array_append_value (&array, &value);
+  gst_structure_set_value (gst_caps_get_structure (caps, 0), "streamheader",
+      &array);
+
+  g_value_unset (&value);
+  g_value_unset (&array);
+  gst_buffer_unref (header);
+
+  return caps;
+}
+
+/* Creates an FLV tag with an AAC or H.264 body, as flvmux would */
+static GstBuffer *
+create_tag (guint8 type, guint32 ts, guint body_size, gboolean keyframe)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 11 + body_size + 4, NULL);
+  GstMapInfo map;
+
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0, map.size);
+  map.data[0] = type;
+  GST_WRITE_UINT24_BE (map.data + 1, body_size);
+  GST_WRITE_UINT24_BE (map.data + 4, ts & 0xffffff);
+  map.data[7] = ts >> 24;
+  if (type == 9)
+    map.data[11] = (keyframe ? 0x10 : 0x20) | 0x07;
+  else
+    map.data[11] = 0xaf;
+  GST_WRITE_UINT32_BE (map.data + 11 + body_size, 11 + body_size);
+  gst_buffer_unmap (buf, &map);
+
+  if (type == 9 && !keyframe)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buf;
+}
+
+static GstElement *
+setup_rtmpsink (TestServer * server)
+{
+  GstElement *sink;
+  GstCaps *caps;
+  gchar *location;
+
+  sink = gst_check_setup_element ("rtmpsink");
+  location = g_strdup_printf ("rtmp://127.0.0.1:%u/live/test", server->port);
+  g_object_set (sink, "location", location, "sync", FALSE, NULL);
+  g_free (location);
+
+  mysrcpad = gst_check_setup_src_pad (sink, &srctemplate);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  caps = create_caps ();
+  gst_check_setup_events (mysrcpad, sink, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  return sink;
+}
+
+static void
+cleanup_rtmpsink (GstElement * sink)
+{
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_check_teardown_src_pad (sink);
+  gst_check_teardown_element (sink);
+}
+
+/* Pushes a keyframe, then N_FRAMES times an audio tag and an inter frame */
+static void
+push_frames (void)
+{
+  guint i;
+
+  fail_unless_equals_int (gst_pad_push (mysrcpad, create_tag (9, 0,
+              KEYFRAME_SIZE, TRUE)), GST_FLOW_OK);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    fail_unless_equals_int (gst_pad_push (mysrcpad, create_tag (8, i * 20,
+                AUDIO_SIZE, TRUE)), GST_FLOW_OK);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, create_tag (9,
+                (i + 1) * 40, DELTA_SIZE, FALSE)), GST_FLOW_OK);
+  }
+}
+
+static void
+get_stats (GstElement * sink, guint64 * sent, guint64 * dropped,
+    guint64 * writes)
+{
+  GstStructure *stats;
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-sent", sent));
+  fail_unless (gst_structure_get_uint64 (stats, "buffers-dropped", dropped));
+  fail_unless (gst_structure_get_uint64 (stats, "writes", writes));
+  gst_structure_free (stats);
+}
+
+GST_START_TEST (test_write)
+{
+  TestServer *server = test_server_new (TRUE);
+  GstElement *sink = setup_rtmpsink (server);
+  guint64 sent, dropped, writes;
+
+  push_frames ();
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  test_server_wait (server, N_FRAMES, 1, N_FRAMES);
+
+  /* without a queue, every buffer is written on its own */
+  get_stats (sink, &sent, &dropped, &writes);
+  fail_unless_equals_uint64 (sent, 2 * N_FRAMES + 1);
+  fail_unless_equals_uint64 (dropped, 0);
+  fail_unless_equals_uint64 (writes, sent);
+
+  cleanup_rtmpsink (sink);
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_drop_delta)
+{
+  TestServer *server = test_server_new (FALSE);
+  GstElement *sink = setup_rtmpsink (server);
+  guint64 sent, dropped, writes;
+
+  /* the keyframe and the audio tags fit into the queue, the inter frames
+   * do not */
+  g_object_set (sink, "max-queue-bytes", 8192, NULL);
+  gst_util_set_object_arg (G_OBJECT (sink), "drop-policy", "delta");
+
+  /* the server does not let the stream start, so nothing can be written
+   * and render must not block */
+  push_frames ();
+
+  get_stats (sink, &sent, &dropped, &writes);
+  fail_unless_equals_uint64 (sent, 0);
+  fail_unless (dropped > 0);
+
+  test_server_allow_publish (server);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  test_server_wait (server, N_FRAMES, 1, N_FRAMES - dropped);
+
+  /* what was queued got written in batches */
+  get_stats (sink, &sent, &dropped, &writes);
+  fail_unless_equals_uint64 (sent + dropped, 2 * N_FRAMES + 1);
+  fail_unless (writes < sent);
+
+  GST_INFO ("sent %" G_GUINT64_FORMAT " buffers with %" G_GUINT64_FORMAT
+      " writes, dropped %" G_GUINT64_FORMAT, sent, writes, dropped);
+
+  cleanup_rtmpsink (sink);
+  test_server_free (server);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtmpsink_suite (void)
+{
+  Suite *s = suite_create ("rtmpsink");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_write);
+  tcase_add_test (tc_chain, test_drop_delta);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtmpsink);
@@ -757,6 +757,207 @@ GST_START_TEST (test_ntp_time)
 
 GST_END_TEST;
 
+#define FLAG_C (1 << 7)
+#define FLAG_E (1 << 6)
+#define FLAG_D (1 << 5)
+
+/* Create a list of @n_units access units of @unit_size packets each, with the
+ * marker bit set on the last packet of every unit */
+static GstBufferList *
+create_rtp_list (GstClockTime timestamp, guint n_units, guint unit_size)
+{
+  GstBufferList *list = gst_buffer_list_new_sized (n_units * unit_size);
+  guint i, j;
+
+  for (i = 0; i < n_units; i++) {
+    for (j = 0; j < unit_size; j++) {
+      GstBuffer *buffer = create_rtp_buffer (timestamp + i, j == 0);
+
+      if (j == unit_size - 1) {
+        GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+        fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_WRITE, &rtp));
+        gst_rtp_buffer_set_marker (&rtp, TRUE);
+        gst_rtp_buffer_unmap (&rtp);
+      }
+      gst_buffer_list_add (list, buffer);
+    }
+  }
+
+  return list;
+}
+
+/* Returns FALSE if @buffer has no extension */
+static gboolean
+get_extension_flags (GstBuffer * buffer, guint8 * flags)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  guint8 *data;
+  gboolean ret;
+
+  fail_unless (gst_rtp_buffer_map (buffer, GST_MAP_READ, &rtp));
+  ret = gst_rtp_buffer_get_extension_data (&rtp, NULL, (gpointer) & data,
+      NULL);
+  if (ret)
+    *flags = GST_READ_UINT8 (data + 8);
+  gst_rtp_buffer_unmap (&rtp);
+
+  return ret;
+}
+
+static void
+check_list_buffer (guint idx, gboolean has_extension, guint8 expected_flags)
+{
+  GstBuffer *buffer = g_list_nth_data (buffers, idx);
+  guint8 flags;
+
+  fail_unless (buffer != NULL);
+  fail_unless_equals_int (get_extension_flags (buffer, &flags),
+      has_extension);
+  if (has_extension)
+    fail_unless_equals_int (flags & (FLAG_C | FLAG_E | FLAG_D),
+        expected_flags);
+}
+
+GST_START_TEST (test_list_access_units)
+{
+  g_object_set (element, "ntp-offset", NTP_OFFSET, NULL);
+
+  ASSERT_SET_STATE (element, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+  gst_check_setup_events (mysrcpad, element, NULL, GST_FORMAT_TIME);
+
+  /* three access units of two packets */
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad,
+          create_rtp_list (TIMESTAMP, 3, 2)), GST_FLOW_OK);
+
+  /* the first packet of every unit has the extension */
+  fail_unless_equals_int (g_list_length (buffers), 6);
+  check_list_buffer (0, TRUE, FLAG_C | FLAG_D);
+  check_list_buffer (1, FALSE, 0);
+  check_list_buffer (2, TRUE, FLAG_C);
+  check_list_buffer (3, FALSE, 0);
+  check_list_buffer (4, TRUE, FLAG_C);
+  check_list_buffer (5, FALSE, 0);
+
+  ASSERT_SET_STATE (element, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_list_e_bit)
+{
+  g_object_set (element, "ntp-offset", NTP_OFFSET, "set-e-bit", TRUE, NULL);
+
+  ASSERT_SET_STATE (element, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+  gst_check_setup_events (mysrcpad, element, NULL, GST_FORMAT_TIME);
+
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad,
+          create_rtp_list (TIMESTAMP, 3, 2)), GST_FLOW_OK);
+
+  /* only the last access unit is held back */
+  fail_unless_equals_int (g_list_length (buffers), 4);
+  check_list_buffer (0, TRUE, FLAG_C | FLAG_D);
+  check_list_buffer (2, TRUE, FLAG_C);
+
+  /* a discontinuity ends the contiguous section with the cached unit */
+  fail_unless (gst_pad_push_event (mysrcpad,
+          create_ntp_offset_event (NTP_OFFSET, TRUE)));
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad,
+          create_rtp_list (TIMESTAMP + 3, 1, 2)), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 6);
+  check_list_buffer (4, TRUE, FLAG_C | FLAG_E);
+  check_list_buffer (5, FALSE, 0);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless_equals_int (g_list_length (buffers), 8);
+  check_list_buffer (6, TRUE, FLAG_C | FLAG_E | FLAG_D);
+  check_list_buffer (7, FALSE, 0);
+
+  ASSERT_SET_STATE (element, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+}
+
+GST_END_TEST;
+
+#define THROUGHPUT_LISTS 4000
+#define THROUGHPUT_UNITS 4
+#define THROUGHPUT_UNIT_SIZE 8
+
+static guint throughput_packets;
+static guint throughput_extensions;
+
+static gboolean
+count_extension (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  guint8 flags;
+
+  throughput_packets++;
+  if (get_extension_flags (*buffer, &flags))
+    throughput_extensions++;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+count_and_drop (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        count_extension, NULL);
+  } else {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    count_extension (&buffer, 0, NULL);
+  }
+
+  return GST_PAD_PROBE_DROP;
+}
+
+GST_START_TEST (test_list_throughput)
+{
+  GstBufferList **lists;
+  gint64 start, elapsed;
+  guint i, n_packets;
+
+  n_packets = THROUGHPUT_LISTS * THROUGHPUT_UNITS * THROUGHPUT_UNIT_SIZE;
+  lists = g_new (GstBufferList *, THROUGHPUT_LISTS);
+  for (i = 0; i < THROUGHPUT_LISTS; i++)
+    lists[i] = create_rtp_list (TIMESTAMP + i * THROUGHPUT_UNITS,
+        THROUGHPUT_UNITS, THROUGHPUT_UNIT_SIZE);
+
+  throughput_packets = 0;
+  throughput_extensions = 0;
+  gst_pad_add_probe (mysinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_and_drop, NULL, NULL);
+
+  g_object_set (element, "ntp-offset", NTP_OFFSET, "set-e-bit", TRUE, NULL);
+
+  ASSERT_SET_STATE (element, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+  gst_check_setup_events (mysrcpad, element, NULL, GST_FORMAT_TIME);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < THROUGHPUT_LISTS; i++)
+    fail_unless_equals_int (gst_pad_push_list (mysrcpad, lists[i]),
+        GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  GST_INFO ("handled %u packets in %" G_GINT64_FORMAT " us, %"
+      G_GINT64_FORMAT " packets/s", n_packets, elapsed,
+      n_packets * G_USEC_PER_SEC / elapsed);
+
+  fail_unless_equals_int (throughput_packets, n_packets);
+  fail_unless_equals_int (throughput_extensions,
+      THROUGHPUT_LISTS * THROUGHPUT_UNITS);
+
+  ASSERT_SET_STATE (element, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  g_free (lists);
+}
+
+GST_END_TEST;
+
 static Suite *
 onviftimestamp_suite (void)
 {
@@ -775,6 +976,9 @@ onviftimestamp_suite (void)
   tcase_add_test (tc_general, test_reusable_element_e_bit);
   tcase_add_test (tc_general, test_ntp_offset_event);
   tcase_add_test (tc_general, test_ntp_time);
+  tcase_add_test (tc_general, test_list_access_units);
+  tcase_add_test (tc_general, test_list_e_bit);
+  tcase_add_test (tc_general, test_list_throughput);
 
   tc_events = tcase_create ("events");
   suite_add_tcase (s, tc_events);
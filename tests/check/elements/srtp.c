@@ -204,6 +204,220 @@ GST_START_TEST (test_roc)
 
 GST_END_TEST;
 
+#define TEST_SSRC 1356955624
+#define TEST_PAYLOAD_SIZE 160
+
+static GstBuffer *
+create_rtp_buffer (guint32 ssrc, guint16 seqnum)
+{
+  guint8 *data = g_malloc0 (12 + TEST_PAYLOAD_SIZE);
+
+  data[0] = 0x80;
+  data[1] = 8;
+  GST_WRITE_UINT16_BE (data + 2, seqnum);
+  GST_WRITE_UINT32_BE (data + 4, seqnum * TEST_PAYLOAD_SIZE);
+  GST_WRITE_UINT32_BE (data + 8, ssrc);
+  memset (data + 12, seqnum & 0xff, TEST_PAYLOAD_SIZE);
+
+  return gst_buffer_new_wrapped (data, 12 + TEST_PAYLOAD_SIZE);
+}
+
+GST_START_TEST (test_decode_buffer_list)
+{
+  GstHarness *enc_h, *dec_h;
+  GstBufferList *list;
+  GstMapInfo map;
+  guint16 i;
+
+  enc_h = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0",
+      "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (enc_h->element), "key",
+      "012345678901234567890123456789012345678901234567890123456789");
+  gst_harness_set_src_caps_str (enc_h,
+      "application/x-rtp, payload=(int)8, ssrc=(uint)1356955624");
+
+  dec_h = gst_harness_new_with_padnames ("srtpdec", "rtp_sink", "rtp_src");
+  gst_harness_set_src_caps_str (dec_h,
+      "application/x-srtp, payload=(int)8, ssrc=(uint)1356955624, srtp-key=(buffer)012345678901234567890123456789012345678901234567890123456789, srtp-cipher=(string)aes-128-icm, srtp-auth=(string)hmac-sha1-80, srtcp-cipher=(string)aes-128-icm, srtcp-auth=(string)hmac-sha1-80");
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_harness_push_and_pull (enc_h,
+        create_rtp_buffer (TEST_SSRC, i));
+
+    fail_unless (buf != NULL);
+    fail_unless (gst_buffer_get_size (buf) > 12 + TEST_PAYLOAD_SIZE);
+    gst_buffer_list_add (list, buf);
+  }
+  /* a packet that fails authentication is dropped from the list */
+  gst_buffer_list_insert (list, 5, create_rtp_buffer (TEST_SSRC, 100));
+
+  fail_unless_equals_int (gst_pad_push_list (dec_h->srcpad, list),
+      GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (dec_h), 10);
+
+  for (i = 0; i < 10; i++) {
+    GstBuffer *buf = gst_harness_pull (dec_h);
+    GstBuffer *expected = create_rtp_buffer (TEST_SSRC, i);
+
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    fail_unless (gst_buffer_memcmp (expected, 0, map.data, map.size) == 0);
+    fail_unless_equals_int (map.size, 12 + TEST_PAYLOAD_SIZE);
+    gst_buffer_unmap (buf, &map);
+
+    gst_buffer_unref (expected);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (enc_h);
+  gst_harness_teardown (dec_h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_protect_in_place)
+{
+  GstHarness *h;
+  GstQuery *query;
+  GstCaps *caps;
+  GstAllocationParams params;
+  GstBuffer *buf, *outbuf;
+  GstMapInfo map;
+  guint8 *data;
+
+  h = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0", "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (h->element), "key",
+      "012345678901234567890123456789012345678901234567890123456789");
+  gst_harness_set_src_caps_str (h,
+      "application/x-rtp, payload=(int)8, ssrc=(uint)1356955624");
+
+  /* downstream's answer is kept */
+  gst_allocation_params_init (&params);
+  params.align = 15;
+  gst_harness_set_propose_allocator (h, gst_allocator_find (NULL), &params);
+
+  /* upstream is asked to leave room for the trailer */
+  caps = gst_caps_from_string ("application/x-rtp");
+  query = gst_query_new_allocation (caps, TRUE);
+  fail_unless (gst_pad_peer_query (h->srcpad, query));
+  fail_unless (gst_query_get_n_allocation_params (query) > 0);
+  gst_query_parse_nth_allocation_param (query, 0, NULL, &params);
+  fail_unless (params.padding > 0);
+  fail_unless_equals_int (params.align, 15);
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+
+  /* and then the packet is protected in the same memory */
+  buf = create_rtp_buffer (TEST_SSRC, 0);
+  outbuf = gst_buffer_new_allocate (NULL, gst_buffer_get_size (buf), &params);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  gst_buffer_extract (buf, 0, map.data, map.size);
+  data = map.data;
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (buf);
+
+  outbuf = gst_harness_push_and_pull (h, outbuf);
+  fail_unless (outbuf != NULL);
+  fail_unless (gst_buffer_get_size (outbuf) > 12 + TEST_PAYLOAD_SIZE);
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  fail_unless (map.data == data);
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+
+  /* packets without room are still protected */
+  outbuf = gst_harness_push_and_pull (h, create_rtp_buffer (TEST_SSRC, 1));
+  fail_unless (outbuf != NULL);
+  fail_unless (gst_buffer_get_size (outbuf) > 12 + TEST_PAYLOAD_SIZE);
+  gst_buffer_unref (outbuf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+#define N_PARALLEL_PACKETS 1000
+
+typedef struct
+{
+  GstHarness *h;
+  guint32 ssrc;
+  GstFlowReturn ret;
+} PushPacketsData;
+
+static gpointer
+push_packets_thread (gpointer user_data)
+{
+  PushPacketsData *data = user_data;
+  guint16 i;
+
+  /* the check macros only work from the main thread, the result is
+   * checked there */
+  data->ret = GST_FLOW_OK;
+  for (i = 0; i < N_PARALLEL_PACKETS && data->ret == GST_FLOW_OK; i++)
+    data->ret = gst_harness_push (data->h, create_rtp_buffer (data->ssrc, i));
+
+  return NULL;
+}
+
+/* packets of different SSRCs can be protected from several threads at
+ * the same time */
+GST_START_TEST (test_protect_parallel)
+{
+  GstHarness *h[4];
+  GThread *threads[4];
+  PushPacketsData data[4];
+  GstStructure *stats;
+  const GValue *streams;
+  guint i;
+
+  h[0] = gst_harness_new_with_padnames ("srtpenc", "rtp_sink_0",
+      "rtp_src_0");
+  gst_util_set_object_arg (G_OBJECT (h[0]->element), "key",
+      "012345678901234567890123456789012345678901234567890123456789");
+  for (i = 1; i < G_N_ELEMENTS (h); i++) {
+    gchar *sink_name = g_strdup_printf ("rtp_sink_%u", i);
+    gchar *src_name = g_strdup_printf ("rtp_src_%u", i);
+
+    h[i] = gst_harness_new_with_element (h[0]->element, sink_name, src_name);
+    g_free (sink_name);
+    g_free (src_name);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (h); i++) {
+    gchar *caps = g_strdup_printf ("application/x-rtp, payload=(int)8, "
+        "ssrc=(uint)%u", 1000 + i);
+
+    gst_harness_set_src_caps_str (h[i], caps);
+    g_free (caps);
+
+    data[i].h = h[i];
+    data[i].ssrc = 1000 + i;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (h); i++)
+    threads[i] = g_thread_new ("push", push_packets_thread, &data[i]);
+  for (i = 0; i < G_N_ELEMENTS (h); i++)
+    g_thread_join (threads[i]);
+
+  for (i = 0; i < G_N_ELEMENTS (h); i++)
+    fail_unless_equals_int (data[i].ret, GST_FLOW_OK);
+
+  for (i = 0; i < G_N_ELEMENTS (h); i++)
+    fail_unless_equals_int (gst_harness_buffers_received (h[i]),
+        N_PARALLEL_PACKETS);
+
+  g_object_get (h[0]->element, "stats", &stats, NULL);
+  streams = gst_structure_get_value (stats, "streams");
+  fail_unless_equals_int (gst_value_array_get_size (streams),
+      G_N_ELEMENTS (h));
+  gst_structure_free (stats);
+
+  for (i = 0; i < G_N_ELEMENTS (h); i++)
+    gst_harness_teardown (h[i]);
+}
+
+GST_END_TEST;
+
 static Suite *
 srtp_suite (void)
 {
@@ -214,6 +428,9 @@ srtp_suite (void)
   tcase_add_test (tc_chain, test_create_and_unref);
   tcase_add_test (tc_chain, test_play);
   tcase_add_test (tc_chain, test_roc);
+  tcase_add_test (tc_chain, test_decode_buffer_list);
+  tcase_add_test (tc_chain, test_protect_in_place);
+  tcase_add_test (tc_chain, test_protect_parallel);
 
   return s;
 }
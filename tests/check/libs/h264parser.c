@@ -144,6 +144,17 @@ static guint8 slice_eoseq_slice[] = {
   0x00, 0x00, 0x00, 0x01, 0x0b
 };
 
+static guint8 h264_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x40, 0x15,
+  0xec, 0xa4, 0xbf, 0x2e, 0x02, 0x20, 0x00, 0x00,
+  0x03, 0x00, 0x2e, 0xe6, 0xb2, 0x80, 0x01, 0xe2,
+  0xc5, 0xb2, 0xc0
+};
+
+static guint8 h264_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xec, 0xb2
+};
+
 GST_START_TEST (test_h264_parse_slice_dpa)
 {
   GstH264ParserResult res;
@@ -211,6 +222,79 @@ GST_START_TEST (test_h264_parse_slice_eoseq_slice)
 
 GST_END_TEST;
 
+static void
+parse_sps_pps (GstH264NalParser * parser, GstH264SPS * sps, GstH264PPS * pps)
+{
+  GstH264NalUnit nalu;
+
+  assert_equals_int (gst_h264_parser_identify_nalu_unchecked (parser,
+          h264_sps, 0, sizeof (h264_sps), &nalu), GST_H264_PARSER_OK);
+  assert_equals_int (gst_h264_parser_parse_sps (parser, &nalu, sps, TRUE),
+      GST_H264_PARSER_OK);
+  assert_equals_int (gst_h264_parser_identify_nalu_unchecked (parser,
+          h264_pps, 0, sizeof (h264_pps), &nalu), GST_H264_PARSER_OK);
+  assert_equals_int (gst_h264_parser_parse_pps (parser, &nalu, pps),
+      GST_H264_PARSER_OK);
+}
+
+GST_START_TEST (test_h264_parse_param_sets_snapshot)
+{
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  GstH264NalParserSnapshot *empty, *full;
+  GstH264SPS sps, sps2;
+  GstH264PPS pps, pps2;
+
+  empty = gst_h264_nal_parser_snapshot (parser);
+
+  parse_sps_pps (parser, &sps, &pps);
+  fail_unless (parser->sps[0].valid);
+  fail_unless (parser->pps[0].valid);
+  fail_unless (parser->pps[0].sequence == &parser->sps[0]);
+
+  /* parameter sets sent again are taken from the stored copies */
+  parse_sps_pps (parser, &sps2, &pps2);
+  assert_equals_int (sps2.id, sps.id);
+  assert_equals_int (sps2.width, sps.width);
+  assert_equals_int (sps2.height, sps.height);
+  assert_equals_int (pps2.id, pps.id);
+  fail_unless (pps2.sequence == pps.sequence);
+  fail_unless (parser->last_sps == &parser->sps[0]);
+  fail_unless (parser->last_pps == &parser->pps[0]);
+  gst_h264_sps_clear (&sps2);
+  gst_h264_pps_clear (&pps2);
+
+  full = gst_h264_nal_parser_snapshot (parser);
+
+  gst_h264_nal_parser_restore (parser, empty);
+  fail_if (parser->sps[0].valid);
+  fail_if (parser->pps[0].valid);
+  fail_unless (parser->last_sps == NULL);
+  fail_unless (parser->last_pps == NULL);
+
+  gst_h264_nal_parser_restore (parser, full);
+  fail_unless (parser->sps[0].valid);
+  fail_unless (parser->pps[0].valid);
+  assert_equals_int (parser->sps[0].width, sps.width);
+  assert_equals_int (parser->sps[0].height, sps.height);
+  fail_unless (parser->pps[0].sequence == &parser->sps[0]);
+  fail_unless (parser->last_sps == &parser->sps[0]);
+  fail_unless (parser->last_pps == &parser->pps[0]);
+
+  /* and are still recognized after a restore */
+  parse_sps_pps (parser, &sps2, &pps2);
+  assert_equals_int (sps2.width, sps.width);
+  gst_h264_sps_clear (&sps2);
+  gst_h264_pps_clear (&pps2);
+
+  gst_h264_sps_clear (&sps);
+  gst_h264_pps_clear (&pps);
+  gst_h264_nal_parser_snapshot_free (empty);
+  gst_h264_nal_parser_snapshot_free (full);
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -221,6 +305,7 @@ h264parser_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
+  tcase_add_test (tc_chain, test_h264_parse_param_sets_snapshot);
 
   return s;
 }
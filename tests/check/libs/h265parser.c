@@ -0,0 +1,149 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+/* 1280x720 Main profile, 30000/1001 fps */
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x5d, 0x95, 0x98, 0x09
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5d, 0xa0, 0x02,
+  0x80, 0x80, 0x2d, 0x16, 0x59, 0x59, 0xa4, 0x93, 0x2b, 0xc0, 0x5a, 0x70,
+  0x80, 0x00, 0x01, 0xf4, 0x80, 0x00, 0x3a, 0x98, 0x04
+};
+
+static const guint8 h265_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x72, 0xb4, 0x62, 0x40
+};
+
+static void
+parse_param_sets (GstH265Parser * parser, GstH265VPS * vps, GstH265SPS * sps,
+    GstH265PPS * pps)
+{
+  GstH265NalUnit nalu;
+
+  assert_equals_int (gst_h265_parser_identify_nalu_unchecked (parser,
+          h265_vps, 0, sizeof (h265_vps), &nalu), GST_H265_PARSER_OK);
+  assert_equals_int (nalu.type, GST_H265_NAL_VPS);
+  assert_equals_int (gst_h265_parser_parse_vps (parser, &nalu, vps),
+      GST_H265_PARSER_OK);
+  assert_equals_int (gst_h265_parser_identify_nalu_unchecked (parser,
+          h265_sps, 0, sizeof (h265_sps), &nalu), GST_H265_PARSER_OK);
+  assert_equals_int (nalu.type, GST_H265_NAL_SPS);
+  assert_equals_int (gst_h265_parser_parse_sps (parser, &nalu, sps, TRUE),
+      GST_H265_PARSER_OK);
+  assert_equals_int (gst_h265_parser_identify_nalu_unchecked (parser,
+          h265_pps, 0, sizeof (h265_pps), &nalu), GST_H265_PARSER_OK);
+  assert_equals_int (nalu.type, GST_H265_NAL_PPS);
+  assert_equals_int (gst_h265_parser_parse_pps (parser, &nalu, pps),
+      GST_H265_PARSER_OK);
+}
+
+GST_START_TEST (test_h265_parse_param_sets_snapshot)
+{
+  GstH265Parser *const parser = gst_h265_parser_new ();
+  GstH265ParserSnapshot *empty, *full;
+  GstH265VPS vps, vps2;
+  GstH265SPS sps, sps2;
+  GstH265PPS pps, pps2;
+
+  empty = gst_h265_parser_snapshot (parser);
+
+  parse_param_sets (parser, &vps, &sps, &pps);
+  fail_unless (parser->vps[0].valid);
+  fail_unless (parser->sps[0].valid);
+  fail_unless (parser->pps[0].valid);
+  fail_unless (parser->sps[0].vps == &parser->vps[0]);
+  fail_unless (parser->pps[0].sps == &parser->sps[0]);
+  assert_equals_int (sps.width, 1280);
+  assert_equals_int (sps.height, 720);
+
+  /* parameter sets sent again are taken from the stored copies */
+  parse_param_sets (parser, &vps2, &sps2, &pps2);
+  assert_equals_int (vps2.id, vps.id);
+  assert_equals_int (sps2.id, sps.id);
+  assert_equals_int (sps2.width, sps.width);
+  assert_equals_int (sps2.height, sps.height);
+  assert_equals_int (sps2.fps_num, sps.fps_num);
+  assert_equals_int (sps2.fps_den, sps.fps_den);
+  assert_equals_int (pps2.id, pps.id);
+  fail_unless (sps2.vps == sps.vps);
+  fail_unless (pps2.sps == pps.sps);
+  fail_unless (parser->last_vps == &parser->vps[0]);
+  fail_unless (parser->last_sps == &parser->sps[0]);
+  fail_unless (parser->last_pps == &parser->pps[0]);
+
+  full = gst_h265_parser_snapshot (parser);
+
+  gst_h265_parser_restore (parser, empty);
+  fail_if (parser->vps[0].valid);
+  fail_if (parser->sps[0].valid);
+  fail_if (parser->pps[0].valid);
+  fail_unless (parser->last_vps == NULL);
+  fail_unless (parser->last_sps == NULL);
+  fail_unless (parser->last_pps == NULL);
+
+  gst_h265_parser_restore (parser, full);
+  fail_unless (parser->vps[0].valid);
+  fail_unless (parser->sps[0].valid);
+  fail_unless (parser->pps[0].valid);
+  assert_equals_int (parser->sps[0].width, sps.width);
+  assert_equals_int (parser->sps[0].height, sps.height);
+  fail_unless (parser->sps[0].vps == &parser->vps[0]);
+  fail_unless (parser->pps[0].sps == &parser->sps[0]);
+  fail_unless (parser->last_vps == &parser->vps[0]);
+  fail_unless (parser->last_sps == &parser->sps[0]);
+  fail_unless (parser->last_pps == &parser->pps[0]);
+
+  /* and are still recognized after a restore */
+  parse_param_sets (parser, &vps2, &sps2, &pps2);
+  assert_equals_int (sps2.width, sps.width);
+  fail_unless (pps2.sps == &parser->sps[0]);
+
+  /* a snapshot can be restored more than once */
+  gst_h265_parser_restore (parser, empty);
+  fail_if (parser->sps[0].valid);
+  gst_h265_parser_restore (parser, full);
+  fail_unless (parser->sps[0].valid);
+
+  gst_h265_parser_snapshot_free (empty);
+  gst_h265_parser_snapshot_free (full);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parser_suite (void)
+{
+  Suite *s = suite_create ("H265 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_parse_param_sets_snapshot);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parser);
@@ -163,6 +163,98 @@ GST_START_TEST (test_mis_identified_datas)
 
 GST_END_TEST;
 
+#define N_GOPS 100
+#define SLICE_SIZE 15000
+
+static void
+append_picture (GByteArray * stream, guint tsn, guint pic_type)
+{
+  static const guint8 picture_ext[] = {
+    0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x80, 0x00
+  };
+  guint8 hdr[9] = { 0x00, 0x00, 0x01, 0x00, };
+  guint8 *slice;
+
+  GST_WRITE_UINT32_BE (hdr + 4,
+      (tsn << 22) | (pic_type << 19) | (0xffff << 3) | 0x7);
+  hdr[8] = 0xff;
+  g_byte_array_append (stream, hdr, sizeof (hdr));
+  g_byte_array_append (stream, picture_ext, sizeof (picture_ext));
+
+  slice = g_malloc (SLICE_SIZE);
+  memset (slice, 0xff, SLICE_SIZE);
+  slice[0] = slice[1] = 0x00;
+  slice[2] = slice[3] = 0x01;
+  g_byte_array_append (stream, slice, SLICE_SIZE);
+  g_free (slice);
+}
+
+GST_START_TEST (test_mpeg_parse_frames)
+{
+  static const guint pic_types[] = {
+    GST_MPEG_VIDEO_PICTURE_TYPE_I, GST_MPEG_VIDEO_PICTURE_TYPE_P,
+    GST_MPEG_VIDEO_PICTURE_TYPE_B
+  };
+  static const guint tsns[] = { 0, 2, 1 };
+  GByteArray *stream = g_byte_array_new ();
+  GArray *frames, *parallel_frames;
+  guint i, j, total = 0;
+
+  /* sequence header, sequence extension and GOP, then I, P and B pictures
+   * each with a picture extension and a slice */
+  for (i = 0; i < N_GOPS; i++) {
+    g_byte_array_append (stream, mpeg2_seq + 12, 30);
+    for (j = 0; j < 3; j++)
+      append_picture (stream, tsns[j], pic_types[j]);
+  }
+
+  frames = gst_mpeg_video_parse_frames (stream->data, stream->len, 1);
+  fail_unless_equals_int (frames->len, N_GOPS * 3);
+
+  for (i = 0; i < frames->len; i++) {
+    GstMpegVideoFrameInfo *frame =
+        &g_array_index (frames, GstMpegVideoFrameInfo, i);
+
+    fail_unless_equals_int (frame->offset, total);
+    fail_unless_equals_int (frame->pic_type, pic_types[i % 3]);
+    fail_unless_equals_int (frame->tsn, tsns[i % 3]);
+    fail_unless_equals_int (frame->picture_structure,
+        GST_MPEG_VIDEO_PICTURE_STRUCTURE_FRAME);
+    fail_unless_equals_int (frame->sequence_header, i % 3 == 0);
+    fail_unless_equals_int (frame->gop, i % 3 == 0);
+    total += frame->size;
+  }
+  fail_unless_equals_int (total, stream->len);
+
+  /* the ranges parsed in parallel don't start on picture boundaries, but
+   * the result must be the same */
+  parallel_frames = gst_mpeg_video_parse_frames (stream->data, stream->len,
+      4);
+  fail_unless_equals_int (parallel_frames->len, frames->len);
+  for (i = 0; i < frames->len; i++) {
+    GstMpegVideoFrameInfo *frame =
+        &g_array_index (frames, GstMpegVideoFrameInfo, i);
+    GstMpegVideoFrameInfo *parallel_frame =
+        &g_array_index (parallel_frames, GstMpegVideoFrameInfo, i);
+
+    fail_unless_equals_int (parallel_frame->offset, frame->offset);
+    fail_unless_equals_int (parallel_frame->size, frame->size);
+    fail_unless_equals_int (parallel_frame->pic_type, frame->pic_type);
+    fail_unless_equals_int (parallel_frame->tsn, frame->tsn);
+    fail_unless_equals_int (parallel_frame->picture_structure,
+        frame->picture_structure);
+    fail_unless_equals_int (parallel_frame->sequence_header,
+        frame->sequence_header);
+    fail_unless_equals_int (parallel_frame->gop, frame->gop);
+  }
+
+  g_array_free (parallel_frames, TRUE);
+  g_array_free (frames, TRUE);
+  g_byte_array_free (stream, TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegvideoparsers_suite (void)
 {
@@ -175,6 +267,7 @@ mpegvideoparsers_suite (void)
   tcase_add_test (tc_chain, test_mpeg_parse_sequence_header);
   tcase_add_test (tc_chain, test_mpeg_parse_sequence_extension);
   tcase_add_test (tc_chain, test_mis_identified_datas);
+  tcase_add_test (tc_chain, test_mpeg_parse_frames);
 
   return s;
 }
@@ -0,0 +1,291 @@
+/* GStreamer unit test for the URI downloader library
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/uridownloader/gsturidownloader.h>
+
+#include "../elements/test_http_src.h"
+
+#define RESOURCE_SIZE 10000
+#define N_REQUESTS 12
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint completed;
+  guint failed;
+  guint reused;
+  /* whether the sources of the slow host may deliver their data */
+  gboolean release_slow;
+  /* GstTestHTTPSrc instances that served each host */
+  GHashTable *sources_a;
+  GHashTable *sources_b;
+} FetchTestData;
+
+static FetchTestData test_data;
+
+/* context of the sources that block until release_slow is set */
+static gint slow_context;
+
+static gboolean
+test_src_start (GstTestHTTPSrc * src, const gchar * uri,
+    GstTestHTTPSrcInput * input_data, gpointer user_data)
+{
+  GHashTable *sources;
+
+  input_data->context = NULL;
+  if (g_str_has_prefix (uri, "http://slow.unit.test/")) {
+    input_data->context = &slow_context;
+    input_data->size = RESOURCE_SIZE;
+    return TRUE;
+  }
+
+  /* with or without the default port */
+  if (g_str_has_prefix (uri, "http://a.unit.test/")
+      || g_str_has_prefix (uri, "http://a.unit.test:80/"))
+    sources = test_data.sources_a;
+  else if (g_str_has_prefix (uri, "http://b.unit.test/"))
+    sources = test_data.sources_b;
+  else
+    return FALSE;
+
+  g_mutex_lock (&test_data.lock);
+  g_hash_table_add (sources, src);
+  g_mutex_unlock (&test_data.lock);
+
+  input_data->size = RESOURCE_SIZE;
+  return TRUE;
+}
+
+static GstFlowReturn
+test_src_create (GstTestHTTPSrc * src, guint64 offset, guint length,
+    GstBuffer ** retbuf, gpointer context, gpointer user_data)
+{
+  GstBuffer *buf;
+  GstMapInfo info;
+  guint i;
+
+  if (context == &slow_context) {
+    g_mutex_lock (&test_data.lock);
+    while (!test_data.release_slow)
+      g_cond_wait (&test_data.cond, &test_data.lock);
+    g_mutex_unlock (&test_data.lock);
+  }
+
+  buf = gst_buffer_new_allocate (NULL, length, NULL);
+  gst_buffer_map (buf, &info, GST_MAP_WRITE);
+  for (i = 0; i < length; i++)
+    info.data[i] = (offset + i) & 0xff;
+  gst_buffer_unmap (buf, &info);
+  *retbuf = buf;
+
+  return GST_FLOW_OK;
+}
+
+static void
+fetch_done (GstUriDownloader * downloader, GstFragment * fragment,
+    const GError * error, gpointer user_data)
+{
+  g_mutex_lock (&test_data.lock);
+  if (fragment) {
+    GstBuffer *buffer = gst_fragment_get_buffer (fragment);
+    GstMapInfo info;
+    guint i;
+
+    fail_unless (buffer != NULL);
+    gst_buffer_map (buffer, &info, GST_MAP_READ);
+    fail_unless_equals_int (info.size, RESOURCE_SIZE);
+    for (i = 0; i < info.size; i++)
+      fail_unless_equals_int (info.data[i], i & 0xff);
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+
+    fail_unless (fragment->completed);
+    fail_unless (fragment->download_first_byte_time >=
+        fragment->download_start_time);
+    fail_unless (fragment->download_stop_time >=
+        fragment->download_first_byte_time);
+    if (fragment->reused_source)
+      test_data.reused++;
+    g_object_unref (fragment);
+  } else {
+    fail_unless (error != NULL);
+    test_data.failed++;
+  }
+  test_data.completed++;
+  g_cond_broadcast (&test_data.cond);
+  g_mutex_unlock (&test_data.lock);
+}
+
+static void
+wait_for_requests (guint n_requests)
+{
+  g_mutex_lock (&test_data.lock);
+  while (test_data.completed < n_requests)
+    g_cond_wait (&test_data.cond, &test_data.lock);
+  g_mutex_unlock (&test_data.lock);
+}
+
+static void
+setup (void)
+{
+  GstTestHTTPSrcCallbacks callbacks = { 0 };
+
+  fail_unless (gst_test_http_src_register_plugin (gst_registry_get (),
+          "testhttpsrc"));
+  callbacks.src_start = test_src_start;
+  callbacks.src_create = test_src_create;
+  gst_test_http_src_install_callbacks (&callbacks, NULL);
+  gst_test_http_src_set_default_blocksize (1024);
+
+  g_mutex_init (&test_data.lock);
+  g_cond_init (&test_data.cond);
+  test_data.completed = test_data.failed = test_data.reused = 0;
+  test_data.release_slow = FALSE;
+  test_data.sources_a = g_hash_table_new (NULL, NULL);
+  test_data.sources_b = g_hash_table_new (NULL, NULL);
+}
+
+static void
+teardown (void)
+{
+  gst_test_http_src_install_callbacks (NULL, NULL);
+  gst_test_http_src_set_default_blocksize (0);
+
+  g_hash_table_unref (test_data.sources_a);
+  g_hash_table_unref (test_data.sources_b);
+  g_mutex_clear (&test_data.lock);
+  g_cond_clear (&test_data.cond);
+}
+
+GST_START_TEST (test_fetch_async_persistent_sources)
+{
+  GstUriDownloader *downloader;
+  guint i;
+
+  downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_max_connections_per_host (downloader, 2);
+
+  for (i = 0; i < N_REQUESTS; i++) {
+    gchar *uri;
+
+    /* giving the default port explicitly still uses the same connections */
+    if (i % 3 == 0)
+      uri = g_strdup_printf ("http://b.unit.test/%u.ts", i);
+    else if (i % 2)
+      uri = g_strdup_printf ("http://a.unit.test:80/%u.ts", i);
+    else
+      uri = g_strdup_printf ("http://a.unit.test/%u.ts", i);
+
+    gst_uri_downloader_fetch_uri_async (downloader, uri, NULL, FALSE, FALSE,
+        TRUE, 0, -1, fetch_done, NULL, NULL);
+    g_free (uri);
+  }
+  wait_for_requests (N_REQUESTS);
+
+  fail_unless_equals_int (test_data.failed, 0);
+
+  /* every host is served by at most two persistent source elements, which
+   * are re-used for all the other requests */
+  fail_unless (g_hash_table_size (test_data.sources_a) <= 2);
+  fail_unless (g_hash_table_size (test_data.sources_b) <= 2);
+  fail_unless (test_data.reused >= N_REQUESTS - 4);
+
+  gst_object_unref (downloader);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fetch_async_slow_host)
+{
+  GstUriDownloader *downloader;
+  guint i;
+
+  downloader = gst_uri_downloader_new ();
+  gst_uri_downloader_set_max_connections_per_host (downloader, 1);
+
+  /* more requests to a stalled host than there are threads to run them */
+  for (i = 0; i < 2 * N_REQUESTS; i++) {
+    gchar *uri = g_strdup_printf ("http://slow.unit.test/%u.ts", i);
+
+    gst_uri_downloader_fetch_uri_async (downloader, uri, NULL, FALSE, FALSE,
+        TRUE, 0, -1, fetch_done, NULL, NULL);
+    g_free (uri);
+  }
+
+  /* the stalled host doesn't hold up requests to other hosts */
+  gst_uri_downloader_fetch_uri_async (downloader, "http://a.unit.test/1.ts",
+      NULL, FALSE, FALSE, TRUE, 0, -1, fetch_done, NULL, NULL);
+  wait_for_requests (1);
+  fail_unless_equals_int (test_data.failed, 0);
+  fail_unless_equals_int (g_hash_table_size (test_data.sources_a), 1);
+
+  g_mutex_lock (&test_data.lock);
+  test_data.release_slow = TRUE;
+  g_cond_broadcast (&test_data.cond);
+  g_mutex_unlock (&test_data.lock);
+
+  wait_for_requests (2 * N_REQUESTS + 1);
+  fail_unless_equals_int (test_data.failed, 0);
+
+  gst_object_unref (downloader);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_fetch_async_not_found)
+{
+  GstUriDownloader *downloader;
+
+  downloader = gst_uri_downloader_new ();
+
+  gst_uri_downloader_fetch_uri_async (downloader,
+      "http://c.unit.test/missing.ts", NULL, FALSE, FALSE, TRUE, 0, -1,
+      fetch_done, NULL, NULL);
+  gst_uri_downloader_fetch_uri_async (downloader, "http://a.unit.test/1.ts",
+      NULL, FALSE, FALSE, TRUE, 0, -1, fetch_done, NULL, NULL);
+  wait_for_requests (2);
+
+  fail_unless_equals_int (test_data.failed, 1);
+
+  gst_object_unref (downloader);
+}
+
+GST_END_TEST;
+
+static Suite *
+uridownloader_suite (void)
+{
+  Suite *s = suite_create ("uridownloader");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, teardown);
+  tcase_add_test (tc_chain, test_fetch_async_persistent_sources);
+  tcase_add_test (tc_chain, test_fetch_async_slow_host);
+  tcase_add_test (tc_chain, test_fetch_async_not_found);
+
+  return s;
+}
+
+GST_CHECK_MAIN (uridownloader);